@@ -168,6 +168,7 @@ typedef struct OptionsContext {
     int thread_queue_size;
     int input_sync_ref;
     int find_stream_info;
+    const char *analyze_af;
 
     SpecifierOptList ts_scale;
     SpecifierOptList dump_attachment;
@@ -40,6 +40,9 @@
 
 #include "libavformat/avformat.h"
 
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
 typedef struct DemuxStream {
     InputStream              ist;
 
@@ -135,6 +138,9 @@ typedef struct Demuxer {
     int                   read_started;
     int                   nb_streams_used;
     int                   nb_streams_finished;
+
+    /* options to open the input again with for -analyze_af */
+    AVDictionary         *analyze_opts;
 } Demuxer;
 
 typedef struct DemuxThreadContext {
@@ -869,6 +875,7 @@ void ifile_close(InputFile **pf)
     avformat_close_input(&f->ctx);
 
     av_packet_free(&d->pkt_heartbeat);
+    av_dict_free(&d->analyze_opts);
 
     av_freep(pf);
 }
@@ -1570,6 +1577,258 @@ static const AVClass input_file_class = {
     .category   = AV_CLASS_CATEGORY_DEMUXER,
 };
 
+static int analysis_graph_init(Demuxer *d, const char *graph_desc,
+                               const AVFrame *frame, AVRational tb, int64_t start_pts,
+                               AVFilterGraph **pgraph, AVFilterContext **psrc,
+                               AVFilterContext **psink)
+{
+    AVFilterGraph *graph;
+    AVFilterContext *src, *sink, *last;
+    AVBufferSrcParameters *par;
+    AVFilterInOut *inputs, *outputs;
+    int ret;
+
+    graph = *pgraph = avfilter_graph_alloc();
+    if (!graph)
+        return AVERROR(ENOMEM);
+
+    src = avfilter_graph_alloc_filter(graph, avfilter_get_by_name("abuffer"), "in");
+    par = av_buffersrc_parameters_alloc();
+    if (!src || !par) {
+        av_free(par);
+        return AVERROR(ENOMEM);
+    }
+    par->format      = frame->format;
+    par->sample_rate = frame->sample_rate;
+    par->time_base   = tb;
+    ret = av_channel_layout_copy(&par->ch_layout, &frame->ch_layout);
+    if (ret >= 0)
+        ret = av_buffersrc_parameters_set(src, par);
+    av_channel_layout_uninit(&par->ch_layout);
+    av_free(par);
+    if (ret < 0)
+        return ret;
+    ret = avfilter_init_dict(src, NULL);
+    if (ret < 0)
+        return ret;
+    last = src;
+
+    /* drop the samples decoded before the seek point */
+    if (start_pts != AV_NOPTS_VALUE) {
+        AVFilterContext *trim;
+        char args[64];
+
+        snprintf(args, sizeof(args), "start_pts=%"PRId64, start_pts);
+        ret = avfilter_graph_create_filter(&trim, avfilter_get_by_name("atrim"),
+                                           "trim", args, NULL, graph);
+        if (ret < 0)
+            return ret;
+        ret = avfilter_link(last, 0, trim, 0);
+        if (ret < 0)
+            return ret;
+        last = trim;
+    }
+
+    ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("abuffersink"),
+                                       "out", NULL, NULL, graph);
+    if (ret < 0)
+        return ret;
+
+    outputs = avfilter_inout_alloc();
+    inputs  = avfilter_inout_alloc();
+    if (!outputs || !inputs) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = last;
+    inputs->name        = av_strdup("out");
+    inputs->filter_ctx  = sink;
+    if (!outputs->name || !inputs->name) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    ret = avfilter_graph_parse_ptr(graph, graph_desc, &inputs, &outputs, NULL);
+    if (ret < 0) {
+        av_log(d, AV_LOG_ERROR, "Error parsing the analysis filtergraph '%s'\n",
+               graph_desc);
+        goto fail;
+    }
+    ret = avfilter_graph_config(graph, NULL);
+
+    *psrc  = src;
+    *psink = sink;
+fail:
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    return ret;
+}
+
+static int analysis_graph_drain(AVFilterContext *sink, AVFrame *frame)
+{
+    int ret;
+
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0)
+        av_frame_unref(frame);
+
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+/**
+ * Decode the best audio stream of the input through graph_desc, typically
+ * to measure it. The input is opened a second time for this pass, so the
+ * demuxer used for the transcoding is left in the state of a fresh open.
+ * Only the audio packets are demuxed, the samples before trim_ts are not
+ * analyzed, and the pass stops at end_ts.
+ *
+ * @param format_opts options the input was opened with
+ * @param seek_ts     timestamp the input was seeked to, AV_NOPTS_VALUE if
+ *                    it was not
+ */
+static int analyze_audio(Demuxer *d, const char *graph_desc,
+                         const char *filename, AVDictionary *format_opts,
+                         int64_t seek_ts, int64_t trim_ts, int64_t end_ts)
+{
+    AVFormatContext *ic = NULL;
+    AVDictionary *opts = NULL;
+    const AVCodec *codec;
+    AVCodecContext *dec = NULL;
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *src = NULL, *sink = NULL;
+    AVPacket *pkt = NULL;
+    AVFrame *frame = NULL;
+    AVStream *st;
+    int idx, ret, eof = 0;
+
+    /* the input cannot be read twice otherwise */
+    if (!d->f.ctx->pb || !(d->f.ctx->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+        av_log(d, AV_LOG_ERROR, "-analyze_af requires a seekable input\n");
+        return AVERROR(EINVAL);
+    }
+
+    ic = avformat_alloc_context();
+    if (!ic)
+        return AVERROR(ENOMEM);
+    ic->flags              = d->f.ctx->flags & AVFMT_FLAG_BITEXACT;
+    ic->interrupt_callback = int_cb;
+
+    ret = av_dict_copy(&opts, format_opts, 0);
+    if (ret >= 0)
+        ret = avformat_open_input(&ic, filename, d->f.ctx->iformat, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        av_log(d, AV_LOG_ERROR, "Error opening the input for the analysis: %s\n",
+               av_err2str(ret));
+        return ret;
+    }
+
+    ret = avformat_find_stream_info(ic, NULL);
+    if (ret < 0)
+        goto finish;
+
+    if (seek_ts != AV_NOPTS_VALUE) {
+        ret = avformat_seek_file(ic, -1, INT64_MIN, seek_ts, seek_ts, 0);
+        if (ret < 0)
+            goto finish;
+    }
+
+    ret = idx = av_find_best_stream(ic, AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0);
+    if (idx < 0) {
+        av_log(d, AV_LOG_ERROR, "No decodable audio stream to analyze\n");
+        goto finish;
+    }
+    st = ic->streams[idx];
+
+    pkt     = av_packet_alloc();
+    frame   = av_frame_alloc();
+    dec     = avcodec_alloc_context3(codec);
+    if (!pkt || !frame || !dec) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    ret = avcodec_parameters_to_context(dec, st->codecpar);
+    if (ret < 0)
+        goto finish;
+    dec->pkt_timebase = st->time_base;
+    ret = avcodec_open2(dec, codec, NULL);
+    if (ret < 0)
+        goto finish;
+
+    for (int i = 0; i < ic->nb_streams; i++) {
+        if (i != idx)
+            ic->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    av_log(d, AV_LOG_INFO, "Analyzing stream #%d:%d\n", d->f.index, idx);
+
+    while (!eof) {
+        ret = av_read_frame(ic, pkt);
+        if (ret == AVERROR(EAGAIN)) {
+            av_usleep(10000);
+            continue;
+        }
+        if (ret == AVERROR_EOF)
+            eof = 1;
+        else if (ret < 0)
+            goto finish;
+        else if (pkt->stream_index != idx) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        ret = avcodec_send_packet(dec, eof ? NULL : pkt);
+        av_packet_unref(pkt);
+        if (ret < 0 && ret != AVERROR_INVALIDDATA)
+            goto finish;
+
+        while ((ret = avcodec_receive_frame(dec, frame)) >= 0) {
+            frame->pts = frame->best_effort_timestamp;
+            if (end_ts != INT64_MAX && frame->pts != AV_NOPTS_VALUE &&
+                av_compare_ts(frame->pts, st->time_base, end_ts, AV_TIME_BASE_Q) >= 0) {
+                av_frame_unref(frame);
+                eof = 1;
+                break;
+            }
+
+            if (!graph) {
+                ret = analysis_graph_init(d, graph_desc, frame, st->time_base,
+                                          trim_ts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE :
+                                          av_rescale_q(trim_ts, AV_TIME_BASE_Q, st->time_base),
+                                          &graph, &src, &sink);
+                if (ret < 0)
+                    goto finish;
+            }
+            ret = av_buffersrc_add_frame_flags(src, frame, AV_BUFFERSRC_FLAG_PUSH);
+            if (ret >= 0)
+                ret = analysis_graph_drain(sink, frame);
+            if (ret < 0)
+                goto finish;
+        }
+        if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto finish;
+    }
+
+    ret = 0;
+    if (graph) {
+        ret = av_buffersrc_add_frame(src, NULL);
+        if (ret >= 0)
+            ret = analysis_graph_drain(sink, frame);
+    }
+
+finish:
+    if (ret < 0)
+        av_log(d, AV_LOG_ERROR, "Error analyzing the audio: %s\n", av_err2str(ret));
+    /* freeing the graph lets the filters report their results */
+    avfilter_graph_free(&graph);
+    avcodec_free_context(&dec);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avformat_close_input(&ic);
+    return ret < 0 ? ret : 0;
+}
+
 static Demuxer *demux_alloc(void)
 {
     Demuxer *d = allocate_array_elem(&input_files, sizeof(*d), &nb_input_files);
@@ -1592,7 +1851,7 @@ int ifile_open(const OptionsContext *o, const char *filename, Scheduler *sch)
     AVFormatContext *ic;
     const AVInputFormat *file_iformat = NULL;
     int err, ret = 0;
-    int64_t timestamp;
+    int64_t timestamp, seek_timestamp;
     AVDictionary *opts_used = NULL;
     const char*    video_codec_name = NULL;
     const char*    audio_codec_name = NULL;
@@ -1723,6 +1982,14 @@ int ifile_open(const OptionsContext *o, const char *filename, Scheduler *sch)
         av_dict_set(&o->g->format_opts, "scan_all_pmts", "1", AV_DICT_DONT_OVERWRITE);
         scan_all_pmts_set = 1;
     }
+    /* the analysis pass opens the input again with the same options */
+    if (o->analyze_af) {
+        ret = av_dict_copy(&d->analyze_opts, o->g->format_opts, 0);
+        if (ret < 0) {
+            avformat_free_context(ic);
+            return ret;
+        }
+    }
     /* open the input file with generic avformat function */
     err = avformat_open_input(&ic, filename, file_iformat, &o->g->format_opts);
     if (err < 0) {
@@ -1800,10 +2067,11 @@ int ifile_open(const OptionsContext *o, const char *filename, Scheduler *sch)
     /* add the stream start time */
     if (!o->seek_timestamp && ic->start_time != AV_NOPTS_VALUE)
         timestamp += ic->start_time;
+    seek_timestamp = start_time != AV_NOPTS_VALUE ? timestamp :
+                     ic->start_time != AV_NOPTS_VALUE ? ic->start_time : 0;
 
     /* if seeking requested, we execute it */
     if (start_time != AV_NOPTS_VALUE) {
-        int64_t seek_timestamp = timestamp;
 
         if (!(ic->iformat->flags & AVFMT_SEEK_TO_PTS)) {
             int dts_heuristic = 0;
@@ -1825,6 +2093,17 @@ int ifile_open(const OptionsContext *o, const char *filename, Scheduler *sch)
         }
     }
 
+    if (o->analyze_af) {
+        ret = analyze_audio(d, o->analyze_af, filename, d->analyze_opts,
+                            start_time != AV_NOPTS_VALUE ? seek_timestamp : AV_NOPTS_VALUE,
+                            start_time != AV_NOPTS_VALUE ? timestamp      : AV_NOPTS_VALUE,
+                            recording_time == INT64_MAX ? INT64_MAX :
+                            timestamp + recording_time);
+        av_dict_free(&d->analyze_opts);
+        if (ret < 0)
+            return ret;
+    }
+
     f->start_time = start_time;
     d->recording_time = recording_time;
     f->input_sync_ref = o->input_sync_ref;
@@ -1766,6 +1766,9 @@ const OptionDef options[] = {
     { "find_stream_info",    OPT_TYPE_BOOL, OPT_INPUT | OPT_EXPERT | OPT_OFFSET,
         { .off = OFFSET(find_stream_info) },
         "read and decode the streams to fill missing information with heuristics" },
+    { "analyze_af",          OPT_TYPE_STRING, OPT_INPUT | OPT_EXPERT | OPT_OFFSET,
+        { .off = OFFSET(analyze_af) },
+        "run the audio through a filtergraph before transcoding", "filter_graph" },
     { "bits_per_raw_sample", OPT_TYPE_INT, OPT_EXPERT | OPT_PERSTREAM | OPT_OUTPUT,
         { .off = OFFSET(bits_per_raw_sample) },
         "set the number of bits per raw sample", "number" },
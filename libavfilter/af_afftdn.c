@@ -29,6 +29,7 @@
 #include "avfilter.h"
 #include "audio.h"
 #include "filters.h"
+#include "formats.h"
 
 #define C       (M_LN10 * 0.1)
 #define SOLVE_SIZE (5)
@@ -64,24 +65,31 @@ enum NoiseType {
     NB_NOISE
 };
 
+enum PrecisionType {
+    AUTO_PRECISION,
+    FLOAT_PRECISION,
+    DOUBLE_PRECISION,
+    NB_PRECISION
+};
+
 typedef struct DeNoiseChannel {
     double      band_noise[NB_PROFILE_BANDS];
     double      noise_band_auto_var[NB_PROFILE_BANDS];
     double      noise_band_sample[NB_PROFILE_BANDS];
-    double     *amt;
+    void       *amt;
     double     *band_amt;
     double     *band_excit;
-    double     *gain;
-    double     *smoothed_gain;
-    double     *prior;
+    void       *gain;
+    void       *smoothed_gain;
+    void       *prior;
     double     *prior_band_excit;
-    double     *clean_data;
-    double     *noisy_data;
+    void       *clean_data;
+    void       *noisy_data;
     double     *out_samples;
     double     *spread_function;
-    double     *abs_var;
+    void       *abs_var;
     double     *rel_var;
-    double     *min_abs_var;
+    void       *min_abs_var;
     void       *fft_in;
     void       *fft_out;
     AVTXContext *fft, *ifft;
@@ -109,6 +117,7 @@ typedef struct AudioFFTDeNoiseContext {
     int     format;
     size_t  sample_size;
     size_t  complex_sample_size;
+    size_t  bin_size;
 
     float   noise_reduction;
     float   noise_floor;
@@ -123,6 +132,7 @@ typedef struct AudioFFTDeNoiseContext {
     int     gain_smooth;
     float   band_multiplier;
     float   floor_offset;
+    int     precision;
 
     int     channels;
     int     sample_noise;
@@ -216,6 +226,10 @@ static const AVOption afftdn_options[] = {
     {  "end",     "stop",                 0,                       AV_OPT_TYPE_CONST,  {.i64 = SAMPLE_STOP},   0,  0, AFR, .unit = "sample" },
     { "gain_smooth", "set gain smooth radius",OFFSET(gain_smooth), AV_OPT_TYPE_INT,    {.i64 = 0},             0, 50, AFR },
     { "gs",          "set gain smooth radius",OFFSET(gain_smooth), AV_OPT_TYPE_INT,    {.i64 = 0},             0, 50, AFR },
+    { "precision", "set processing precision",OFFSET(precision),   AV_OPT_TYPE_INT,    {.i64 = AUTO_PRECISION},0,  NB_PRECISION-1, AF, .unit = "precision" },
+    {  "auto",    "set auto processing precision",                  0, AV_OPT_TYPE_CONST, {.i64 = AUTO_PRECISION},   0, 0, AF, .unit = "precision" },
+    {  "float",   "set single-floating point processing precision", 0, AV_OPT_TYPE_CONST, {.i64 = FLOAT_PRECISION},  0, 0, AF, .unit = "precision" },
+    {  "double",  "set double-floating point processing precision", 0, AV_OPT_TYPE_CONST, {.i64 = DOUBLE_PRECISION}, 0, 0, AF, .unit = "precision" },
     { NULL }
 };
 
@@ -309,179 +323,14 @@ static double limit_gain(double a, double b)
     return 1.0;
 }
 
-static void spectral_flatness(AudioFFTDeNoiseContext *s, const double *const spectral,
-                              double floor, int len, double *rnum, double *rden)
-{
-    double num = 0., den = 0.;
-    int size = 0;
-
-    for (int n = 0; n < len; n++) {
-        const double v = spectral[n];
-        if (v > floor) {
-            num += log(v);
-            den += v;
-            size++;
-        }
-    }
-
-    size = FFMAX(size, 1);
-
-    num /= size;
-    den /= size;
-
-    num = exp(num);
-
-    *rnum = num;
-    *rden = den;
-}
-
 static void set_parameters(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch, int update_var, int update_auto_var);
 
-static double floor_offset(const double *S, int size, double mean)
-{
-    double offset = 0.0;
-
-    for (int n = 0; n < size; n++) {
-        const double p = S[n] - mean;
-
-        offset = fmax(offset, fabs(p));
-    }
-
-    return offset / mean;
-}
-
-static void process_frame(AVFilterContext *ctx,
-                          AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
-                          double *prior, double *prior_band_excit, int track_noise)
-{
-    AVFilterLink *outlink = ctx->outputs[0];
-    FilterLink      *outl = ff_filter_link(outlink);
-    const double *abs_var = dnch->abs_var;
-    const double ratio = outl->frame_count_out ? s->ratio : 1.0;
-    const double rratio = 1. - ratio;
-    const int *bin2band = s->bin2band;
-    double *noisy_data = dnch->noisy_data;
-    double *band_excit = dnch->band_excit;
-    double *band_amt = dnch->band_amt;
-    double *smoothed_gain = dnch->smoothed_gain;
-    AVComplexDouble *fft_data_dbl = dnch->fft_out;
-    AVComplexFloat *fft_data_flt = dnch->fft_out;
-    double *gain = dnch->gain;
-
-    for (int i = 0; i < s->bin_count; i++) {
-        double sqr_new_gain, new_gain, power, mag, mag_abs_var, new_mag_abs_var;
-
-        switch (s->format) {
-        case AV_SAMPLE_FMT_FLTP:
-            noisy_data[i] = mag = hypot(fft_data_flt[i].re, fft_data_flt[i].im);
-            break;
-        case AV_SAMPLE_FMT_DBLP:
-            noisy_data[i] = mag = hypot(fft_data_dbl[i].re, fft_data_dbl[i].im);
-            break;
-        default:
-            av_assert0(0);
-        }
-
-        power = mag * mag;
-        mag_abs_var = power / abs_var[i];
-        new_mag_abs_var = ratio * prior[i] + rratio * fmax(mag_abs_var - 1.0, 0.0);
-        new_gain = new_mag_abs_var / (1.0 + new_mag_abs_var);
-        sqr_new_gain = new_gain * new_gain;
-        prior[i] = mag_abs_var * sqr_new_gain;
-        dnch->clean_data[i] = power * sqr_new_gain;
-        gain[i] = new_gain;
-    }
-
-    if (track_noise) {
-        double flatness, num, den;
-
-        spectral_flatness(s, noisy_data, s->floor, s->bin_count, &num, &den);
-
-        flatness = num / den;
-        if (flatness > 0.8) {
-            const double offset = s->floor_offset * floor_offset(noisy_data, s->bin_count, den);
-            const double new_floor = av_clipd(10.0 * log10(den) - 100.0 + offset, -90., -20.);
-
-            dnch->noise_floor = 0.1 * new_floor + dnch->noise_floor * 0.9;
-            set_parameters(s, dnch, 1, 1);
-        }
-    }
-
-    for (int i = 0; i < s->number_of_bands; i++) {
-        band_excit[i] = 0.0;
-        band_amt[i] = 0.0;
-    }
+#define DEPTH 32
+#include "afftdn_template.c"
 
-    for (int i = 0; i < s->bin_count; i++)
-        band_excit[bin2band[i]] += dnch->clean_data[i];
-
-    for (int i = 0; i < s->number_of_bands; i++) {
-        band_excit[i] = fmax(band_excit[i],
-                             s->band_alpha[i] * band_excit[i] +
-                             s->band_beta[i] * prior_band_excit[i]);
-        prior_band_excit[i] = band_excit[i];
-    }
-
-    for (int j = 0, i = 0; j < s->number_of_bands; j++) {
-        for (int k = 0; k < s->number_of_bands; k++) {
-            band_amt[j] += dnch->spread_function[i++] * band_excit[k];
-        }
-    }
-
-    for (int i = 0; i < s->bin_count; i++)
-        dnch->amt[i] = band_amt[bin2band[i]];
-
-    for (int i = 0; i < s->bin_count; i++) {
-        if (dnch->amt[i] > abs_var[i]) {
-            gain[i] = 1.0;
-        } else if (dnch->amt[i] > dnch->min_abs_var[i]) {
-            const double limit = sqrt(abs_var[i] / dnch->amt[i]);
-
-            gain[i] = limit_gain(gain[i], limit);
-        } else {
-            gain[i] = limit_gain(gain[i], dnch->max_gain);
-        }
-    }
-
-    memcpy(smoothed_gain, gain, s->bin_count * sizeof(*smoothed_gain));
-    if (s->gain_smooth > 0) {
-        const int r = s->gain_smooth;
-
-        for (int i = r; i < s->bin_count - r; i++) {
-            const double gc = gain[i];
-            double num = 0., den = 0.;
-
-            for (int j = -r; j <= r; j++) {
-                const double g = gain[i + j];
-                const double d = 1. - fabs(g - gc);
-
-                num += g * d;
-                den += d;
-            }
-
-            smoothed_gain[i] = num / den;
-        }
-    }
-
-    switch (s->format) {
-    case AV_SAMPLE_FMT_FLTP:
-        for (int i = 0; i < s->bin_count; i++) {
-            const float new_gain = smoothed_gain[i];
-
-            fft_data_flt[i].re *= new_gain;
-            fft_data_flt[i].im *= new_gain;
-        }
-        break;
-    case AV_SAMPLE_FMT_DBLP:
-        for (int i = 0; i < s->bin_count; i++) {
-            const double new_gain = smoothed_gain[i];
-
-            fft_data_dbl[i].re *= new_gain;
-            fft_data_dbl[i].im *= new_gain;
-        }
-        break;
-    }
-}
+#undef DEPTH
+#define DEPTH 64
+#include "afftdn_template.c"
 
 static double freq2bark(double x)
 {
@@ -609,9 +458,22 @@ static void set_parameters(AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch, int
     if (update_var) {
         set_band_parameters(s, dnch);
 
-        for (int i = 0; i < s->bin_count; i++) {
-            dnch->abs_var[i] = fmax(dnch->max_var * dnch->rel_var[i], 1.0);
-            dnch->min_abs_var[i] = dnch->gain_scale * dnch->abs_var[i];
+        if (s->precision == FLOAT_PRECISION) {
+            float *abs_var = dnch->abs_var;
+            float *min_abs_var = dnch->min_abs_var;
+
+            for (int i = 0; i < s->bin_count; i++) {
+                abs_var[i] = fmax(dnch->max_var * dnch->rel_var[i], 1.0);
+                min_abs_var[i] = dnch->gain_scale * abs_var[i];
+            }
+        } else {
+            double *abs_var = dnch->abs_var;
+            double *min_abs_var = dnch->min_abs_var;
+
+            for (int i = 0; i < s->bin_count; i++) {
+                abs_var[i] = fmax(dnch->max_var * dnch->rel_var[i], 1.0);
+                min_abs_var[i] = dnch->gain_scale * abs_var[i];
+            }
         }
     }
 }
@@ -654,6 +516,7 @@ static int config_input(AVFilterLink *inlink)
         scale = &dscale;
         break;
     }
+    s->bin_size = s->precision == FLOAT_PRECISION ? sizeof(float) : sizeof(double);
 
     s->dnch = av_calloc(inlink->ch_layout.nb_channels, sizeof(*s->dnch));
     if (!s->dnch)
@@ -743,19 +606,19 @@ static int config_input(AVFilterLink *inlink)
 
         reduce_mean(dnch->band_noise);
 
-        dnch->amt = av_calloc(s->bin_count, sizeof(*dnch->amt));
+        dnch->amt = av_calloc(s->bin_count, s->bin_size);
         dnch->band_amt = av_calloc(s->number_of_bands, sizeof(*dnch->band_amt));
         dnch->band_excit = av_calloc(s->number_of_bands, sizeof(*dnch->band_excit));
-        dnch->gain = av_calloc(s->bin_count, sizeof(*dnch->gain));
-        dnch->smoothed_gain = av_calloc(s->bin_count, sizeof(*dnch->smoothed_gain));
-        dnch->prior = av_calloc(s->bin_count, sizeof(*dnch->prior));
+        dnch->gain = av_calloc(s->bin_count, s->bin_size);
+        dnch->smoothed_gain = av_calloc(s->bin_count, s->bin_size);
+        dnch->prior = av_calloc(s->bin_count, s->bin_size);
         dnch->prior_band_excit = av_calloc(s->number_of_bands, sizeof(*dnch->prior_band_excit));
-        dnch->clean_data = av_calloc(s->bin_count, sizeof(*dnch->clean_data));
-        dnch->noisy_data = av_calloc(s->bin_count, sizeof(*dnch->noisy_data));
+        dnch->clean_data = av_calloc(s->bin_count, s->bin_size);
+        dnch->noisy_data = av_calloc(s->bin_count, s->bin_size);
         dnch->out_samples = av_calloc(s->buffer_length, sizeof(*dnch->out_samples));
-        dnch->abs_var = av_calloc(s->bin_count, sizeof(*dnch->abs_var));
+        dnch->abs_var = av_calloc(s->bin_count, s->bin_size);
         dnch->rel_var = av_calloc(s->bin_count, sizeof(*dnch->rel_var));
-        dnch->min_abs_var = av_calloc(s->bin_count, sizeof(*dnch->min_abs_var));
+        dnch->min_abs_var = av_calloc(s->bin_count, s->bin_size);
         dnch->fft_in = av_calloc(s->fft_length2, s->sample_size);
         dnch->fft_out = av_calloc(s->fft_length2 + 1, s->complex_sample_size);
         ret = av_tx_init(&dnch->fft, &dnch->tx_fn, tx_type, 0, s->fft_length2, scale, 0);
@@ -1082,10 +945,16 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
 
         dnch->tx_fn(dnch->fft, dnch->fft_out, dnch->fft_in, s->sample_size);
 
-        process_frame(ctx, s, dnch,
-                      dnch->prior,
-                      dnch->prior_band_excit,
-                      s->track_noise);
+        if (s->precision == FLOAT_PRECISION)
+            process_frame_float(ctx, s, dnch,
+                                dnch->prior,
+                                dnch->prior_band_excit,
+                                s->track_noise);
+        else
+            process_frame_double(ctx, s, dnch,
+                                 dnch->prior,
+                                 dnch->prior_band_excit,
+                                 s->track_noise);
 
         dnch->itx_fn(dnch->ifft, dnch->fft_in, dnch->fft_out, s->complex_sample_size);
 
@@ -1355,6 +1224,21 @@ static int process_command(AVFilterContext *ctx, const char *cmd, const char *ar
     return 0;
 }
 
+static int query_formats(const AVFilterContext *ctx,
+                         AVFilterFormatsConfig **cfg_in,
+                         AVFilterFormatsConfig **cfg_out)
+{
+    const AudioFFTDeNoiseContext *s = ctx->priv;
+    static const enum AVSampleFormat sample_fmts[NB_PRECISION][3] = {
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP, AV_SAMPLE_FMT_NONE },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_NONE },
+        { AV_SAMPLE_FMT_DBLP, AV_SAMPLE_FMT_NONE },
+    };
+
+    return ff_set_common_formats_from_list2(ctx, cfg_in, cfg_out,
+                                            sample_fmts[s->precision]);
+}
+
 static const AVFilterPad inputs[] = {
     {
         .name         = "default",
@@ -1372,7 +1256,7 @@ const AVFilter ff_af_afftdn = {
     .uninit          = uninit,
     FILTER_INPUTS(inputs),
     FILTER_OUTPUTS(ff_audio_default_filterpad),
-    FILTER_SAMPLEFMTS(AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP),
+    FILTER_QUERY_FUNC2(query_formats),
     .process_command = process_command,
     .flags           = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
                        AVFILTER_FLAG_SLICE_THREADS,
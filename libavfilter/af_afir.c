@@ -118,6 +118,10 @@ typedef struct AudioFIRContext {
     int max_part_size;
     int64_t pts;
 
+    void *seg_out;
+    unsigned int seg_out_size;
+    int seg_out_stride;
+
     AudioFIRDSPContext afirdsp;
     AVFloatDSPContext *fdsp;
 } AudioFIRContext;
@@ -165,9 +169,56 @@ static int fir_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
+static int fir_segments(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFIRContext *s = ctx->priv;
+    AVFrame *out = arg;
+    const int nb_segments = s->nb_segments[s->selir];
+    const int nb_items = s->nb_channels * nb_segments;
+    const int start = (nb_items * jobnr) / nb_jobs;
+    const int end = (nb_items * (jobnr+1)) / nb_jobs;
+
+    for (int i = start; i < end; i++) {
+        switch (s->format) {
+        case AV_SAMPLE_FMT_FLTP:
+            fir_frame_segment_float(s, out, i / nb_segments, i % nb_segments);
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            fir_frame_segment_double(s, out, i / nb_segments, i % nb_segments);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static int fir_sum_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFIRContext *s = ctx->priv;
+    AVFrame *out = arg;
+    const int start = (out->ch_layout.nb_channels * jobnr) / nb_jobs;
+    const int end = (out->ch_layout.nb_channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++) {
+        switch (s->format) {
+        case AV_SAMPLE_FMT_FLTP:
+            fir_frame_sum_float(s, out, ch);
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            fir_frame_sum_double(s, out, ch);
+            break;
+        }
+    }
+
+    return 0;
+}
+
 static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    const int nb_channels = outlink->ch_layout.nb_channels;
+    const int nb_segments = s->nb_segments[s->selir];
     AVFrame *out;
 
     out = ff_get_audio_buffer(outlink, in->nb_samples);
@@ -179,8 +230,29 @@ static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
     out->pts = s->pts = in->pts;
 
     s->in = in;
-    ff_filter_execute(ctx, fir_channels, out, NULL,
-                      FFMIN(outlink->ch_layout.nb_channels, ff_filter_get_nb_threads(ctx)));
+    if (nb_threads > nb_channels && nb_segments > 1 &&
+        !ctx->is_disabled && !s->prev_is_disabled && s->prev_selir == s->selir) {
+        /* not enough channels to keep the threads busy, so run the
+         * segments of each channel in parallel too */
+        const int bps = av_get_bytes_per_sample(s->format);
+
+        s->seg_out_stride = FFALIGN(out->nb_samples, av_cpu_max_align() / bps);
+        av_fast_malloc(&s->seg_out, &s->seg_out_size,
+                       (nb_segments - 1) * nb_channels * (size_t)s->seg_out_stride * bps);
+        if (!s->seg_out) {
+            av_frame_free(&in);
+            av_frame_free(&out);
+            return AVERROR(ENOMEM);
+        }
+
+        ff_filter_execute(ctx, fir_segments, out, NULL,
+                          FFMIN(nb_channels * nb_segments, nb_threads));
+        ff_filter_execute(ctx, fir_sum_channels, out, NULL,
+                          FFMIN(nb_channels, nb_threads));
+    } else {
+        ff_filter_execute(ctx, fir_channels, out, NULL,
+                          FFMIN(nb_channels, nb_threads));
+    }
     s->prev_is_disabled = ctx->is_disabled;
 
     av_frame_free(&in);
@@ -304,6 +376,27 @@ static void uninit_segment(AVFilterContext *ctx, AudioFIRSegment *seg)
         av_frame_free(&seg->coeff);
 }
 
+static int convert_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioFIRContext *s = ctx->priv;
+    const int selir = *(int *)arg;
+    const int start = (s->nb_channels * jobnr) / nb_jobs;
+    const int end = (s->nb_channels * (jobnr+1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++) {
+        switch (s->format) {
+        case AV_SAMPLE_FMT_FLTP:
+            convert_ir_channel_float(ctx, s, ch, selir);
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            convert_ir_channel_double(ctx, s, ch, selir);
+            break;
+        }
+    }
+
+    return 0;
+}
+
 static int convert_coeffs(AVFilterContext *ctx, int selir)
 {
     AudioFIRContext *s = ctx->priv;
@@ -382,29 +475,6 @@ skip:
             for (int ch = 0; ch < s->nb_channels; ch++)
                 s->ch_gain[ch] = gain;
         }
-
-        for (int ch = 0; ch < s->nb_channels; ch++) {
-            const float *tsrc = (const float *)s->ir[selir]->extended_data[!s->one2many * ch];
-            float *time = (float *)s->norm_ir[selir]->extended_data[ch];
-
-            memcpy(time, tsrc, sizeof(*time) * nb_taps);
-            for (int i = FFMAX(1, s->length * nb_taps); i < nb_taps; i++)
-                time[i] = 0;
-
-            ir_scale_float(ctx, s, nb_taps, ch, time, s->ch_gain[ch]);
-
-            for (int n = 0; n < s->nb_segments[selir]; n++) {
-                AudioFIRSegment *seg = &s->seg[selir][n];
-
-                if (!seg->coeff)
-                    seg->coeff = ff_get_audio_buffer(ctx->inputs[0], seg->nb_partitions * seg->coeff_size * 2);
-                if (!seg->coeff)
-                    return AVERROR(ENOMEM);
-
-                for (int i = 0; i < seg->nb_partitions; i++)
-                    convert_channel_float(ctx, s, ch, seg, i, selir);
-            }
-        }
         break;
     case AV_SAMPLE_FMT_DBLP:
         for (int ch = 0; ch < s->nb_channels; ch++) {
@@ -422,32 +492,21 @@ skip:
             for (int ch = 0; ch < s->nb_channels; ch++)
                 s->ch_gain[ch] = gain;
         }
+        break;
+    }
 
-        for (int ch = 0; ch < s->nb_channels; ch++) {
-            const double *tsrc = (const double *)s->ir[selir]->extended_data[!s->one2many * ch];
-            double *time = (double *)s->norm_ir[selir]->extended_data[ch];
-
-            memcpy(time, tsrc, sizeof(*time) * nb_taps);
-            for (int i = FFMAX(1, s->length * nb_taps); i < nb_taps; i++)
-                time[i] = 0;
-
-            ir_scale_double(ctx, s, nb_taps, ch, time, s->ch_gain[ch]);
-
-            for (int n = 0; n < s->nb_segments[selir]; n++) {
-                AudioFIRSegment *seg = &s->seg[selir][n];
-
-                if (!seg->coeff)
-                    seg->coeff = ff_get_audio_buffer(ctx->inputs[0], seg->nb_partitions * seg->coeff_size * 2);
-                if (!seg->coeff)
-                    return AVERROR(ENOMEM);
+    for (int n = 0; n < s->nb_segments[selir]; n++) {
+        AudioFIRSegment *seg = &s->seg[selir][n];
 
-                for (int i = 0; i < seg->nb_partitions; i++)
-                    convert_channel_double(ctx, s, ch, seg, i, selir);
-            }
-        }
-        break;
+        if (!seg->coeff)
+            seg->coeff = ff_get_audio_buffer(ctx->inputs[0], seg->nb_partitions * seg->coeff_size * 2);
+        if (!seg->coeff)
+            return AVERROR(ENOMEM);
     }
 
+    ff_filter_execute(ctx, convert_channels, &selir, NULL,
+                      FFMIN(s->nb_channels, ff_filter_get_nb_threads(ctx)));
+
     s->have_coeffs[selir] = 1;
 
     return 0;
@@ -641,6 +700,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->fdsp);
     av_freep(&s->ch_gain);
     av_freep(&s->loading);
+    av_freep(&s->seg_out);
 
     for (int i = 0; i < s->nb_irs; i++) {
         for (int j = 0; j < s->nb_segments[i]; j++)
@@ -20,6 +20,10 @@
 
 /* http://k.ylo.ph/2016/04/04/loudnorm.html */
 
+#include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
+#include "libavutil/file.h"
+#include "libavutil/file_open.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "avfilter.h"
@@ -27,12 +31,14 @@
 #include "formats.h"
 #include "audio.h"
 #include "ebur128.h"
+#include "ebur128dsp.h"
 
 enum FrameType {
     FIRST_FRAME,
     INNER_FRAME,
     FINAL_FRAME,
     LINEAR_MODE,
+    MEASURE_MODE,
     FRAME_NB
 };
 
@@ -64,6 +70,10 @@ typedef struct LoudNormContext {
     int linear;
     int dual_mono;
     enum PrintFormat print_format;
+    int measure;
+    char *stats_file_str;
+    char *measured_file_str;
+    FILE *stats_file;
 
     double *buf;
     int buf_size;
@@ -95,6 +105,10 @@ typedef struct LoudNormContext {
 
     FFEBUR128State *r128_in;
     FFEBUR128State *r128_out;
+
+    /* true peak of the input in measure mode */
+    FFEBUR128TruePeak tp;
+    double true_peak;
 } LoudNormContext;
 
 #define OFFSET(x) offsetof(LoudNormContext, x)
@@ -121,6 +135,9 @@ static const AVOption loudnorm_options[] = {
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, .unit = "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, .unit = "print_format" },
     {     "summary",      0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  SUMMARY},  0,         0,  FLAGS, .unit = "print_format" },
+    { "measure",          "only measure the input",            OFFSET(measure),          AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
+    { "stats_file",       "set file where to write the stats", OFFSET(stats_file_str),   AV_OPT_TYPE_STRING,  {.str =  NULL},     0,         0,  FLAGS },
+    { "measured_file",    "set file to read the measured values from", OFFSET(measured_file_str), AV_OPT_TYPE_STRING, {.str = NULL}, 0,     0,  FLAGS },
     { NULL }
 };
 
@@ -408,6 +425,19 @@ static void true_peak_limiter(LoudNormContext *s, double *out, int nb_samples, i
     }
 }
 
+/* in is NULL to flush the detector */
+static void measure_true_peak(LoudNormContext *s, const AVFrame *in)
+{
+    for (int c = 0; c < s->channels; c++) {
+        const double peak = in ?
+            ff_ebur128_true_peak_channel(&s->tp, c, (const double *)in->data[0] + c,
+                                         s->channels, in->nb_samples) :
+            ff_ebur128_true_peak_channel(&s->tp, c, NULL, 0, FF_EBUR128_TP_TAPS + 3);
+
+        s->true_peak = FFMAX(s->true_peak, peak);
+    }
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -422,6 +452,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     double gain, gain_next, env_global, env_shortterm,
     global, shortterm, lra, relative_threshold;
 
+    if (s->frame_type == MEASURE_MODE) {
+        ff_ebur128_add_frames_double(s->r128_in, (const double *)in->data[0], in->nb_samples);
+        measure_true_peak(s, in);
+        return ff_filter_frame(outlink, in);
+    }
+
     if (av_frame_is_writable(in)) {
         out = in;
     } else {
@@ -686,7 +722,7 @@ static int activate(AVFilterContext *ctx)
 
     FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
 
-    if (s->frame_type != LINEAR_MODE) {
+    if (s->frame_type != LINEAR_MODE && s->frame_type != MEASURE_MODE) {
         int nb_samples;
 
         if (s->frame_type == FIRST_FRAME) {
@@ -710,7 +746,7 @@ static int activate(AVFilterContext *ctx)
                 s->pts[i] = in->pts + i * nb_samples;
         } else if (s->frame_type == LINEAR_MODE) {
             s->pts[0] = in->pts;
-        } else {
+        } else if (s->frame_type != MEASURE_MODE) {
             s->pts[FF_ARRAY_ELEMS(s->pts) - 1] = in->pts;
         }
         ret = filter_frame(inlink, in);
@@ -744,7 +780,9 @@ static int query_formats(const AVFilterContext *ctx,
     if (ret < 0)
         return ret;
 
-    if (s->frame_type != LINEAR_MODE) {
+    /* the true peak limiter needs the input at 192 kHz, the true peak is
+     * measured at any rate */
+    if (s->frame_type != LINEAR_MODE && s->frame_type != MEASURE_MODE) {
         return ff_set_common_samplerates_from_list2(ctx, cfg_in, cfg_out, input_srate);
     }
     return 0;
@@ -768,6 +806,13 @@ static int config_input(AVFilterLink *inlink)
         ff_ebur128_set_channel(s->r128_out, 0, FF_EBUR128_DUAL_MONO);
     }
 
+    if (s->frame_type == MEASURE_MODE) {
+        int ret = ff_ebur128_true_peak_init(&s->tp, inlink->ch_layout.nb_channels,
+                                            inlink->sample_rate);
+        if (ret < 0)
+            return ret;
+    }
+
     s->buf_size = frame_size(inlink->sample_rate, 3000) * inlink->ch_layout.nb_channels;
     s->buf = av_malloc_array(s->buf_size, sizeof(*s->buf));
     if (!s->buf)
@@ -798,11 +843,83 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
+static int read_measured_file(AVFilterContext *ctx)
+{
+    static const struct {
+        const char *key;
+        int offset;
+    } fields[] = {
+        { "\"input_i\"",      OFFSET(measured_i)      },
+        { "\"input_tp\"",     OFFSET(measured_tp)     },
+        { "\"input_lra\"",    OFFSET(measured_lra)    },
+        { "\"input_thresh\"", OFFSET(measured_thresh) },
+    };
+    LoudNormContext *s = ctx->priv;
+    uint8_t *buf;
+    size_t size;
+    char *str;
+    int ret;
+
+    ret = av_file_map(s->measured_file_str, &buf, &size, 0, ctx);
+    if (ret < 0)
+        return ret;
+    str = av_strndup((const char *)buf, size);
+    av_file_unmap(buf, size);
+    if (!str)
+        return AVERROR(ENOMEM);
+
+    /* the file has the format of the json stats */
+    for (int i = 0; i < FF_ARRAY_ELEMS(fields); i++) {
+        const char *p = strstr(str, fields[i].key);
+        double value;
+
+        if (!p || sscanf(p + strlen(fields[i].key), " : \"%lf\"", &value) != 1) {
+            av_log(ctx, AV_LOG_ERROR, "Missing %s in %s\n",
+                   fields[i].key, s->measured_file_str);
+            av_free(str);
+            return AVERROR_INVALIDDATA;
+        }
+        /* silent or too short inputs are left to the dynamic mode */
+        if (isfinite(value))
+            *(double *)((uint8_t *)s + fields[i].offset) = value;
+    }
+
+    av_free(str);
+    return 0;
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     LoudNormContext *s = ctx->priv;
+    int ret;
+
     s->frame_type = FIRST_FRAME;
 
+    if (s->stats_file_str) {
+        if (!strcmp(s->stats_file_str, "-")) {
+            s->stats_file = stdout;
+        } else {
+            s->stats_file = avpriv_fopen_utf8(s->stats_file_str, "w");
+            if (!s->stats_file) {
+                int err = AVERROR(errno);
+                av_log(ctx, AV_LOG_ERROR, "Could not open stats file %s: %s\n",
+                       s->stats_file_str, av_err2str(err));
+                return err;
+            }
+        }
+    }
+
+    if (s->measure) {
+        s->frame_type = MEASURE_MODE;
+        return 0;
+    }
+
+    if (s->measured_file_str) {
+        ret = read_measured_file(ctx);
+        if (ret < 0)
+            return ret;
+    }
+
     if (s->linear) {
         double offset, offset_tp;
         offset    = s->target_i - s->measured_i;
@@ -822,10 +939,15 @@ static av_cold int init(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     LoudNormContext *s = ctx->priv;
+    /* the audio is passed through unchanged when only measuring */
+    FFEBUR128State *r128_out = s->frame_type == MEASURE_MODE ? s->r128_in : s->r128_out;
+    const char *type = s->frame_type == MEASURE_MODE ? "none" :
+                       s->frame_type == LINEAR_MODE  ? "linear" : "dynamic";
     double i_in, i_out, lra_in, lra_out, thresh_in, thresh_out, tp_in, tp_out;
+    AVBPrint json;
     int c;
 
-    if (!s->r128_in || !s->r128_out)
+    if (!s->r128_in || !r128_out)
         goto end;
 
     ff_ebur128_loudness_range(s->r128_in, &lra_in);
@@ -838,45 +960,58 @@ static av_cold void uninit(AVFilterContext *ctx)
             tp_in = tmp;
     }
 
-    ff_ebur128_loudness_range(s->r128_out, &lra_out);
-    ff_ebur128_loudness_global(s->r128_out, &i_out);
-    ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
+    ff_ebur128_loudness_range(r128_out, &lra_out);
+    ff_ebur128_loudness_global(r128_out, &i_out);
+    ff_ebur128_relative_threshold(r128_out, &thresh_out);
     for (c = 0; c < s->channels; c++) {
         double tmp;
-        ff_ebur128_sample_peak(s->r128_out, c, &tmp);
+        ff_ebur128_sample_peak(r128_out, c, &tmp);
         if ((c == 0) || (tmp > tp_out))
             tp_out = tmp;
     }
 
+    if (s->tp.buf) {
+        measure_true_peak(s, NULL);
+        tp_in = tp_out = s->true_peak;
+    }
+
+    av_bprint_init(&json, 0, AV_BPRINT_SIZE_AUTOMATIC);
+    av_bprintf(&json,
+        "{\n"
+        "\t\"input_i\" : \"%.2f\",\n"
+        "\t\"input_tp\" : \"%.2f\",\n"
+        "\t\"input_lra\" : \"%.2f\",\n"
+        "\t\"input_thresh\" : \"%.2f\",\n"
+        "\t\"output_i\" : \"%.2f\",\n"
+        "\t\"output_tp\" : \"%+.2f\",\n"
+        "\t\"output_lra\" : \"%.2f\",\n"
+        "\t\"output_thresh\" : \"%.2f\",\n"
+        "\t\"normalization_type\" : \"%s\",\n"
+        "\t\"target_offset\" : \"%.2f\"\n"
+        "}\n",
+        i_in,
+        20. * log10(tp_in),
+        lra_in,
+        thresh_in,
+        i_out,
+        20. * log10(tp_out),
+        lra_out,
+        thresh_out,
+        type,
+        s->target_i - i_out
+    );
+
+    if (s->stats_file) {
+        fputs(json.str, s->stats_file);
+        fflush(s->stats_file);
+    }
+
     switch(s->print_format) {
     case NONE:
         break;
 
     case JSON:
-        av_log(ctx, AV_LOG_INFO,
-            "\n{\n"
-            "\t\"input_i\" : \"%.2f\",\n"
-            "\t\"input_tp\" : \"%.2f\",\n"
-            "\t\"input_lra\" : \"%.2f\",\n"
-            "\t\"input_thresh\" : \"%.2f\",\n"
-            "\t\"output_i\" : \"%.2f\",\n"
-            "\t\"output_tp\" : \"%+.2f\",\n"
-            "\t\"output_lra\" : \"%.2f\",\n"
-            "\t\"output_thresh\" : \"%.2f\",\n"
-            "\t\"normalization_type\" : \"%s\",\n"
-            "\t\"target_offset\" : \"%.2f\"\n"
-            "}\n",
-            i_in,
-            20. * log10(tp_in),
-            lra_in,
-            thresh_in,
-            i_out,
-            20. * log10(tp_out),
-            lra_out,
-            thresh_out,
-            s->frame_type == LINEAR_MODE ? "linear" : "dynamic",
-            s->target_i - i_out
-        );
+        av_log(ctx, AV_LOG_INFO, "\n%s", json.str);
         break;
 
     case SUMMARY:
@@ -902,11 +1037,13 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "Linear" : "Dynamic",
+            s->frame_type == MEASURE_MODE ? "None" :
+            s->frame_type == LINEAR_MODE  ? "Linear" : "Dynamic",
             s->target_i - i_out
         );
         break;
     }
+    av_bprint_finalize(&json, NULL);
 
 end:
     if (s->r128_in)
@@ -916,6 +1053,10 @@ end:
     av_freep(&s->limiter_buf);
     av_freep(&s->prev_smp);
     av_freep(&s->buf);
+    ff_ebur128_true_peak_uninit(&s->tp);
+    if (s->stats_file && s->stats_file != stdout)
+        fclose(s->stats_file);
+    s->stats_file = NULL;
 }
 
 static const AVFilterPad avfilter_af_loudnorm_inputs[] = {
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2018 The FFmpeg Project
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#undef ftype
+#undef FABS
+#undef SAMPLE_FORMAT
+#if DEPTH == 32
+#define SAMPLE_FORMAT float
+#define ftype float
+#define FABS fabsf
+#else
+#define SAMPLE_FORMAT double
+#define ftype double
+#define FABS fabs
+#endif
+
+#define fn3(a,b)   a##_##b
+#define fn2(a,b)   fn3(a,b)
+#define fn(a)      fn2(a, SAMPLE_FORMAT)
+
+static void fn(spectral_flatness)(AudioFFTDeNoiseContext *s, const ftype *const spectral,
+                                  double floor, int len, double *rnum, double *rden)
+{
+    double num = 0., den = 0.;
+    int size = 0;
+
+    for (int n = 0; n < len; n++) {
+        const double v = spectral[n];
+        if (v > floor) {
+            num += log(v);
+            den += v;
+            size++;
+        }
+    }
+
+    size = FFMAX(size, 1);
+
+    num /= size;
+    den /= size;
+
+    num = exp(num);
+
+    *rnum = num;
+    *rden = den;
+}
+
+static double fn(floor_offset)(const ftype *S, int size, double mean)
+{
+    double offset = 0.0;
+
+    for (int n = 0; n < size; n++) {
+        const double p = S[n] - mean;
+
+        offset = fmax(offset, fabs(p));
+    }
+
+    return offset / mean;
+}
+
+static void fn(process_frame)(AVFilterContext *ctx,
+                              AudioFFTDeNoiseContext *s, DeNoiseChannel *dnch,
+                              ftype *prior, double *prior_band_excit, int track_noise)
+{
+    AVFilterLink *outlink = ctx->outputs[0];
+    FilterLink      *outl = ff_filter_link(outlink);
+    const ftype *abs_var = dnch->abs_var;
+    const ftype *min_abs_var = dnch->min_abs_var;
+    const ftype ratio = outl->frame_count_out ? s->ratio : 1.0;
+    const ftype rratio = 1. - ratio;
+    const int *bin2band = s->bin2band;
+    ftype *noisy_data = dnch->noisy_data;
+    ftype *clean_data = dnch->clean_data;
+    double *band_excit = dnch->band_excit;
+    double *band_amt = dnch->band_amt;
+    ftype *smoothed_gain = dnch->smoothed_gain;
+    ftype *gain = dnch->gain;
+    ftype *amt = dnch->amt;
+#if DEPTH == 32
+    /* single precision processing always runs on float transforms */
+    AVComplexFloat *fft_data = dnch->fft_out;
+
+    for (int i = 0; i < s->bin_count; i++) {
+        const float power = fft_data[i].re * fft_data[i].re +
+                            fft_data[i].im * fft_data[i].im;
+
+        noisy_data[i] = sqrtf(power);
+        clean_data[i] = power;
+    }
+#else
+    AVComplexDouble *fft_data_dbl = dnch->fft_out;
+    AVComplexFloat *fft_data_flt = dnch->fft_out;
+
+    switch (s->format) {
+    case AV_SAMPLE_FMT_FLTP:
+        for (int i = 0; i < s->bin_count; i++)
+            noisy_data[i] = hypot(fft_data_flt[i].re, fft_data_flt[i].im);
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        for (int i = 0; i < s->bin_count; i++)
+            noisy_data[i] = hypot(fft_data_dbl[i].re, fft_data_dbl[i].im);
+        break;
+    default:
+        av_assert0(0);
+    }
+
+    for (int i = 0; i < s->bin_count; i++)
+        clean_data[i] = noisy_data[i] * noisy_data[i];
+#endif
+
+    /* the prior and gain estimation has no dependency between bins */
+    for (int i = 0; i < s->bin_count; i++) {
+        const ftype power = clean_data[i];
+        const ftype mag_abs_var = power / abs_var[i];
+        const ftype new_mag_abs_var = ratio * prior[i] + rratio * FFMAX(mag_abs_var - 1, 0);
+        const ftype new_gain = new_mag_abs_var / (1 + new_mag_abs_var);
+        const ftype sqr_new_gain = new_gain * new_gain;
+
+        prior[i] = mag_abs_var * sqr_new_gain;
+        clean_data[i] = power * sqr_new_gain;
+        gain[i] = new_gain;
+    }
+
+    if (track_noise) {
+        double flatness, num, den;
+
+        fn(spectral_flatness)(s, noisy_data, s->floor, s->bin_count, &num, &den);
+
+        flatness = num / den;
+        if (flatness > 0.8) {
+            const double offset = s->floor_offset * fn(floor_offset)(noisy_data, s->bin_count, den);
+            const double new_floor = av_clipd(10.0 * log10(den) - 100.0 + offset, -90., -20.);
+
+            dnch->noise_floor = 0.1 * new_floor + dnch->noise_floor * 0.9;
+            set_parameters(s, dnch, 1, 1);
+        }
+    }
+
+    for (int i = 0; i < s->number_of_bands; i++) {
+        band_excit[i] = 0.0;
+        band_amt[i] = 0.0;
+    }
+
+    for (int i = 0; i < s->bin_count; i++)
+        band_excit[bin2band[i]] += clean_data[i];
+
+    for (int i = 0; i < s->number_of_bands; i++) {
+        band_excit[i] = fmax(band_excit[i],
+                             s->band_alpha[i] * band_excit[i] +
+                             s->band_beta[i] * prior_band_excit[i]);
+        prior_band_excit[i] = band_excit[i];
+    }
+
+    for (int j = 0, i = 0; j < s->number_of_bands; j++) {
+        for (int k = 0; k < s->number_of_bands; k++) {
+            band_amt[j] += dnch->spread_function[i++] * band_excit[k];
+        }
+    }
+
+    for (int i = 0; i < s->bin_count; i++)
+        amt[i] = band_amt[bin2band[i]];
+
+#if DEPTH == 32
+    /* branchless form of the double precision limiting below: the masking
+     * is clipped between the minimum and absolute variance, which gives a
+     * limit of max_gain at the bottom and a gain of 1 at the top */
+    for (int i = 0; i < s->bin_count; i++) {
+        const float a = gain[i];
+        const float b = sqrtf(abs_var[i] / FFMIN(FFMAX(amt[i], min_abs_var[i]), abs_var[i]));
+        const float above = (b * a - 1.f) / (b + a - 2.f);
+        const float below = (b * a - 2.f * a + 1.f) / (b - a);
+
+        gain[i] = a > 1.f ? above : a < 1.f ? below : 1.f;
+    }
+#else
+    for (int i = 0; i < s->bin_count; i++) {
+        if (amt[i] > abs_var[i]) {
+            gain[i] = 1.0;
+        } else if (amt[i] > min_abs_var[i]) {
+            const double limit = sqrt(abs_var[i] / amt[i]);
+
+            gain[i] = limit_gain(gain[i], limit);
+        } else {
+            gain[i] = limit_gain(gain[i], dnch->max_gain);
+        }
+    }
+#endif
+
+    if (s->gain_smooth > 0) {
+        const int r = s->gain_smooth;
+
+        memcpy(smoothed_gain, gain, s->bin_count * sizeof(*smoothed_gain));
+        for (int i = r; i < s->bin_count - r; i++) {
+            const ftype gc = gain[i];
+            ftype num = 0., den = 0.;
+
+            for (int j = -r; j <= r; j++) {
+                const ftype g = gain[i + j];
+                const ftype d = 1. - FABS(g - gc);
+
+                num += g * d;
+                den += d;
+            }
+
+            smoothed_gain[i] = num / den;
+        }
+        gain = smoothed_gain;
+    }
+
+#if DEPTH == 32
+    for (int i = 0; i < s->bin_count; i++) {
+        fft_data[i].re *= gain[i];
+        fft_data[i].im *= gain[i];
+    }
+#else
+    switch (s->format) {
+    case AV_SAMPLE_FMT_FLTP:
+        for (int i = 0; i < s->bin_count; i++) {
+            const float new_gain = gain[i];
+
+            fft_data_flt[i].re *= new_gain;
+            fft_data_flt[i].im *= new_gain;
+        }
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        for (int i = 0; i < s->bin_count; i++) {
+            const double new_gain = gain[i];
+
+            fft_data_dbl[i].re *= new_gain;
+            fft_data_dbl[i].im *= new_gain;
+        }
+        break;
+    }
+#endif
+}
@@ -120,6 +120,27 @@ static void fn(convert_channel)(AVFilterContext *ctx, AudioFIRContext *s, int ch
     av_log(ctx, AV_LOG_DEBUG, "input_offset: %d\n", seg->input_offset);
 }
 
+static void fn(convert_ir_channel)(AVFilterContext *ctx, AudioFIRContext *s,
+                                   int ch, int selir)
+{
+    const int nb_taps = s->ir[selir]->nb_samples;
+    const ftype *tsrc = (const ftype *)s->ir[selir]->extended_data[!s->one2many * ch];
+    ftype *time = (ftype *)s->norm_ir[selir]->extended_data[ch];
+
+    memcpy(time, tsrc, sizeof(*time) * nb_taps);
+    for (int i = FFMAX(1, s->length * nb_taps); i < nb_taps; i++)
+        time[i] = 0;
+
+    fn(ir_scale)(ctx, s, nb_taps, ch, time, s->ch_gain[ch]);
+
+    for (int n = 0; n < s->nb_segments[selir]; n++) {
+        AudioFIRSegment *seg = &s->seg[selir][n];
+
+        for (int i = 0; i < seg->nb_partitions; i++)
+            fn(convert_channel)(ctx, s, ch, seg, i, selir);
+    }
+}
+
 static void fn(fir_fadd)(AudioFIRContext *s, ftype *dst, const ftype *src, int nb_samples)
 {
     if ((nb_samples & 15) == 0 && nb_samples >= 8) {
@@ -134,101 +155,100 @@ static void fn(fir_fadd)(AudioFIRContext *s, ftype *dst, const ftype *src, int n
     }
 }
 
-static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffset, int offset, int selir)
+/* add the output of one segment of the partitioned convolution for
+ * nb_samples input samples to ptr */
+static void fn(fir_segment)(AudioFIRContext *s, AudioFIRSegment *seg, int ch,
+                            const ftype *in, ftype *ptr, int nb_samples)
 {
-    AudioFIRContext *s = ctx->priv;
-    const ftype *in = (const ftype *)s->in->extended_data[ch] + ioffset;
-    ftype *blockout, *ptr = (ftype *)out->extended_data[ch] + offset;
     const int min_part_size = s->min_part_size;
-    const int nb_samples = FFMIN(min_part_size, out->nb_samples - offset);
-    const int nb_segments = s->nb_segments[selir];
     const float dry_gain = s->dry_gain;
-    const float wet_gain = s->wet_gain;
-
-    for (int segment = 0; segment < nb_segments; segment++) {
-        AudioFIRSegment *seg = &s->seg[selir][segment];
-        ftype *src = (ftype *)seg->input->extended_data[ch];
-        ftype *dst = (ftype *)seg->output->extended_data[ch];
-        ftype *sumin = (ftype *)seg->sumin->extended_data[ch];
-        ftype *sumout = (ftype *)seg->sumout->extended_data[ch];
-        ftype *tempin = (ftype *)seg->tempin->extended_data[ch];
-        ftype *buf = (ftype *)seg->buffer->extended_data[ch];
-        int *output_offset = &seg->output_offset[ch];
-        const int nb_partitions = seg->nb_partitions;
-        const int input_offset = seg->input_offset;
-        const int part_size = seg->part_size;
-        int j;
-
-        seg->part_index[ch] = seg->part_index[ch] % nb_partitions;
-        if (dry_gain == 1.f) {
-            memcpy(src + input_offset, in, nb_samples * sizeof(*src));
-        } else if (min_part_size >= 8) {
+    ftype *blockout;
+    ftype *src = (ftype *)seg->input->extended_data[ch];
+    ftype *dst = (ftype *)seg->output->extended_data[ch];
+    ftype *sumin = (ftype *)seg->sumin->extended_data[ch];
+    ftype *sumout = (ftype *)seg->sumout->extended_data[ch];
+    ftype *tempin = (ftype *)seg->tempin->extended_data[ch];
+    ftype *buf = (ftype *)seg->buffer->extended_data[ch];
+    int *output_offset = &seg->output_offset[ch];
+    const int nb_partitions = seg->nb_partitions;
+    const int input_offset = seg->input_offset;
+    const int part_size = seg->part_size;
+    int j;
+
+    seg->part_index[ch] = seg->part_index[ch] % nb_partitions;
+    if (dry_gain == 1.f) {
+        memcpy(src + input_offset, in, nb_samples * sizeof(*src));
+    } else if (min_part_size >= 8) {
 #if DEPTH == 32
-            s->fdsp->vector_fmul_scalar(src + input_offset, in, dry_gain, FFALIGN(nb_samples, 4));
+        s->fdsp->vector_fmul_scalar(src + input_offset, in, dry_gain, FFALIGN(nb_samples, 4));
 #else
-            s->fdsp->vector_dmul_scalar(src + input_offset, in, dry_gain, FFALIGN(nb_samples, 8));
+        s->fdsp->vector_dmul_scalar(src + input_offset, in, dry_gain, FFALIGN(nb_samples, 8));
 #endif
-        } else {
-            ftype *src2 = src + input_offset;
-            for (int n = 0; n < nb_samples; n++)
-                src2[n] = in[n] * dry_gain;
-        }
+    } else {
+        ftype *src2 = src + input_offset;
+        for (int n = 0; n < nb_samples; n++)
+            src2[n] = in[n] * dry_gain;
+    }
 
-        output_offset[0] += min_part_size;
-        if (output_offset[0] >= part_size) {
-            output_offset[0] = 0;
-        } else {
-            memmove(src, src + min_part_size, (seg->input_size - min_part_size) * sizeof(*src));
+    output_offset[0] += min_part_size;
+    if (output_offset[0] >= part_size) {
+        output_offset[0] = 0;
+    } else {
+        memmove(src, src + min_part_size, (seg->input_size - min_part_size) * sizeof(*src));
 
-            dst += output_offset[0];
-            fn(fir_fadd)(s, ptr, dst, nb_samples);
-            continue;
-        }
+        dst += output_offset[0];
+        fn(fir_fadd)(s, ptr, dst, nb_samples);
+        return;
+    }
 
-        memset(sumin, 0, sizeof(*sumin) * seg->fft_length);
+    memset(sumin, 0, sizeof(*sumin) * seg->fft_length);
 
-        blockout = (ftype *)seg->blockout->extended_data[ch] + seg->part_index[ch] * seg->block_size;
-        memset(tempin + part_size, 0, sizeof(*tempin) * (seg->block_size - part_size));
-        memcpy(tempin, src, sizeof(*src) * part_size);
-        seg->tx_fn(seg->tx[ch], blockout, tempin, sizeof(ftype));
+    blockout = (ftype *)seg->blockout->extended_data[ch] + seg->part_index[ch] * seg->block_size;
+    memset(tempin + part_size, 0, sizeof(*tempin) * (seg->block_size - part_size));
+    memcpy(tempin, src, sizeof(*src) * part_size);
+    seg->tx_fn(seg->tx[ch], blockout, tempin, sizeof(ftype));
 
-        j = seg->part_index[ch];
-        for (int i = 0; i < nb_partitions; i++) {
-            const int input_partition = j;
-            const int coeff_partition = i;
-            const int coffset = coeff_partition * seg->coeff_size;
-            const ftype *blockout = (const ftype *)seg->blockout->extended_data[ch] + input_partition * seg->block_size;
-            const ctype *coeff = ((const ctype *)seg->coeff->extended_data[ch]) + coffset;
+    j = seg->part_index[ch];
+    for (int i = 0; i < nb_partitions; i++) {
+        const int input_partition = j;
+        const int coeff_partition = i;
+        const int coffset = coeff_partition * seg->coeff_size;
+        const ftype *blockout = (const ftype *)seg->blockout->extended_data[ch] + input_partition * seg->block_size;
+        const ctype *coeff = ((const ctype *)seg->coeff->extended_data[ch]) + coffset;
 
-            if (j == 0)
-                j = nb_partitions;
-            j--;
+        if (j == 0)
+            j = nb_partitions;
+        j--;
 
 #if DEPTH == 32
-            s->afirdsp.fcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
+        s->afirdsp.fcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
 #else
-            s->afirdsp.dcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
+        s->afirdsp.dcmul_add(sumin, blockout, (const ftype *)coeff, part_size);
 #endif
-        }
+    }
 
-        seg->itx_fn(seg->itx[ch], sumout, sumin, sizeof(ctype));
+    seg->itx_fn(seg->itx[ch], sumout, sumin, sizeof(ctype));
 
-        fn(fir_fadd)(s, buf, sumout, part_size);
-        memcpy(dst, buf, part_size * sizeof(*dst));
-        memcpy(buf, sumout + part_size, part_size * sizeof(*buf));
+    fn(fir_fadd)(s, buf, sumout, part_size);
+    memcpy(dst, buf, part_size * sizeof(*dst));
+    memcpy(buf, sumout + part_size, part_size * sizeof(*buf));
 
-        fn(fir_fadd)(s, ptr, dst, nb_samples);
+    fn(fir_fadd)(s, ptr, dst, nb_samples);
 
-        if (part_size != min_part_size)
-            memmove(src, src + min_part_size, (seg->input_size - min_part_size) * sizeof(*src));
+    if (part_size != min_part_size)
+        memmove(src, src + min_part_size, (seg->input_size - min_part_size) * sizeof(*src));
 
-        seg->part_index[ch] = (seg->part_index[ch] + 1) % nb_partitions;
-    }
+    seg->part_index[ch] = (seg->part_index[ch] + 1) % nb_partitions;
+}
+
+static void fn(fir_wet_gain)(AudioFIRContext *s, ftype *ptr, int nb_samples)
+{
+    const float wet_gain = s->wet_gain;
 
     if (wet_gain == 1.f)
-        return 0;
+        return;
 
-    if (min_part_size >= 8) {
+    if (s->min_part_size >= 8) {
 #if DEPTH == 32
         s->fdsp->vector_fmul_scalar(ptr, ptr, wet_gain, FFALIGN(nb_samples, 4));
 #else
@@ -238,10 +258,65 @@ static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffs
         for (int n = 0; n < nb_samples; n++)
             ptr[n] *= wet_gain;
     }
+}
+
+static int fn(fir_quantum)(AVFilterContext *ctx, AVFrame *out, int ch, int ioffset, int offset, int selir)
+{
+    AudioFIRContext *s = ctx->priv;
+    const ftype *in = (const ftype *)s->in->extended_data[ch] + ioffset;
+    ftype *ptr = (ftype *)out->extended_data[ch] + offset;
+    const int nb_samples = FFMIN(s->min_part_size, out->nb_samples - offset);
+    const int nb_segments = s->nb_segments[selir];
+
+    for (int segment = 0; segment < nb_segments; segment++)
+        fn(fir_segment)(s, &s->seg[selir][segment], ch, in, ptr, nb_samples);
+
+    fn(fir_wet_gain)(s, ptr, nb_samples);
 
     return 0;
 }
 
+/* run one segment of a channel over the whole frame, the output of all
+ * segments but the first one goes to a separate buffer summed afterwards */
+static void fn(fir_frame_segment)(AudioFIRContext *s, AVFrame *out, int ch, int segment)
+{
+    const int min_part_size = s->min_part_size;
+    const int nb_samples = out->nb_samples;
+    AudioFIRSegment *seg = &s->seg[s->selir][segment];
+    const ftype *in = (const ftype *)s->in->extended_data[ch];
+    ftype *ptr = (ftype *)out->extended_data[ch];
+
+    if (segment > 0) {
+        ptr = (ftype *)s->seg_out + ((segment - 1) * s->nb_channels + ch) * (size_t)s->seg_out_stride;
+        memset(ptr, 0, nb_samples * sizeof(*ptr));
+    }
+
+    for (int offset = 0; offset < nb_samples; offset += min_part_size)
+        fn(fir_segment)(s, seg, ch, in + offset, ptr + offset,
+                        FFMIN(min_part_size, nb_samples - offset));
+}
+
+/* sum the segments in the same order as fir_quantum() */
+static void fn(fir_frame_sum)(AudioFIRContext *s, AVFrame *out, int ch)
+{
+    const int min_part_size = s->min_part_size;
+    const int nb_segments = s->nb_segments[s->selir];
+    ftype *dst = (ftype *)out->extended_data[ch];
+
+    for (int offset = 0; offset < out->nb_samples; offset += min_part_size) {
+        const int nb_samples = FFMIN(min_part_size, out->nb_samples - offset);
+
+        for (int segment = 1; segment < nb_segments; segment++) {
+            const ftype *src = (const ftype *)s->seg_out +
+                               ((segment - 1) * s->nb_channels + ch) * (size_t)s->seg_out_stride;
+
+            fn(fir_fadd)(s, dst + offset, src + offset, nb_samples);
+        }
+
+        fn(fir_wet_gain)(s, dst + offset, nb_samples);
+    }
+}
+
 static void fn(fir_quantums)(AVFilterContext *ctx, AudioFIRContext *s, AVFrame *out,
                              int min_part_size, int ch, int offset,
                              int prev_selir, int selir)
@@ -116,6 +116,12 @@ typedef struct FFFilterContext {
     double *var_values;
 
     struct AVFilterCommand *command_queue;
+
+    /**
+     * Set on the conversion filters inserted by the graph when the formats
+     * of two linked filters could not be merged.
+     */
+    int auto_inserted;
 } FFFilterContext;
 
 static inline FFFilterContext *fffilterctx(AVFilterContext *ctx)
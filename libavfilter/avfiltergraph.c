@@ -539,6 +539,7 @@ static int query_formats(AVFilterGraph *graph, void *log_ctx)
                     return ret;
                 if ((ret = avfilter_insert_filter(link, convert, 0, 0)) < 0)
                     return ret;
+                fffilterctx(convert)->auto_inserted = 1;
 
                 if ((ret = filter_query_formats(convert)) < 0)
                     return ret;
@@ -1168,6 +1169,97 @@ static void swap_sample_fmts(AVFilterGraph *graph)
 
 }
 
+static int sample_fmt_conv_cost(enum AVSampleFormat dst_fmt, enum AVSampleFormat src_fmt)
+{
+    return dst_fmt == src_fmt ? 0 : 1 + get_fmt_score(dst_fmt, src_fmt);
+}
+
+/**
+ * Cost of the sample format conversions done by all the filters touching
+ * the formats list fmts, if fmt is picked for it.
+ */
+static int sample_fmts_cost(AVFilterGraph *graph, const AVFilterFormats *fmts, int fmt)
+{
+    int i, j, k, cost = 0;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        for (j = 0; j < filter->nb_inputs; j++) {
+            const AVFilterFormats *in = filter->inputs[j]->outcfg.formats;
+
+            if (filter->inputs[j]->type != AVMEDIA_TYPE_AUDIO || !in || !in->nb_formats)
+                continue;
+
+            for (k = 0; k < filter->nb_outputs; k++) {
+                const AVFilterFormats *out = filter->outputs[k]->incfg.formats;
+
+                if (filter->outputs[k]->type != AVMEDIA_TYPE_AUDIO ||
+                    !out || !out->nb_formats || in == out || (in != fmts && out != fmts))
+                    continue;
+                cost += sample_fmt_conv_cost(out == fmts ? fmt : out->formats[0],
+                                             in  == fmts ? fmt : in ->formats[0]);
+            }
+        }
+    }
+
+    return cost;
+}
+
+/**
+ * Choose the sample formats of all the audio links together, so that the
+ * conversions done by the inserted converters and by the filters changing
+ * the format cost the least over the whole graph. Every formats list shared
+ * by a set of links is a variable, the lists are updated one at a time until
+ * the total cost does not decrease anymore, starting from the choice made by
+ * swap_sample_fmts(). Ties keep the current choice.
+ */
+static void choose_sample_fmts(AVFilterGraph *graph)
+{
+    int i, j, k, iter, changed = 1;
+
+    for (iter = 0; iter < 16 && changed; iter++) {
+        changed = 0;
+        for (i = 0; i < graph->nb_filters; i++) {
+            AVFilterContext *filter = graph->filters[i];
+
+            for (j = 0; j < filter->nb_outputs; j++) {
+                AVFilterFormats *fmts = filter->outputs[j]->incfg.formats;
+                int best = 0, best_cost;
+
+                if (filter->outputs[j]->type != AVMEDIA_TYPE_AUDIO ||
+                    !fmts || fmts->nb_formats < 2)
+                    continue;
+
+                best_cost = sample_fmts_cost(graph, fmts, fmts->formats[0]);
+                for (k = 1; k < fmts->nb_formats && best_cost; k++) {
+                    int cost = sample_fmts_cost(graph, fmts, fmts->formats[k]);
+                    if (cost < best_cost) {
+                        best      = k;
+                        best_cost = cost;
+                    }
+                }
+                if (best) {
+                    FFSWAP(int, fmts->formats[0], fmts->formats[best]);
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        for (j = 0; j < filter->nb_outputs; j++) {
+            AVFilterFormats *fmts = filter->outputs[j]->incfg.formats;
+
+            if (filter->outputs[j]->type == AVMEDIA_TYPE_AUDIO &&
+                fmts && fmts->nb_formats > 1)
+                fmts->nb_formats = 1;
+        }
+    }
+}
+
 static int pick_formats(AVFilterGraph *graph)
 {
     int i, j, ret;
@@ -1220,6 +1312,47 @@ static int pick_formats(AVFilterGraph *graph)
     return 0;
 }
 
+/**
+ * Log the format conversions done by the filters inserted during the
+ * negotiation.
+ */
+static void report_conversions(AVFilterGraph *graph, void *log_ctx)
+{
+    int i, nb_conversions = 0;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        AVFilterLink *inlink, *outlink;
+
+        if (!fffilterctx(filter)->auto_inserted)
+            continue;
+        inlink  = filter->inputs[0];
+        outlink = filter->outputs[0];
+        nb_conversions++;
+
+        if (outlink->type == AVMEDIA_TYPE_AUDIO) {
+            char in_layout[64], out_layout[64];
+
+            av_channel_layout_describe(&inlink->ch_layout,  in_layout,  sizeof(in_layout));
+            av_channel_layout_describe(&outlink->ch_layout, out_layout, sizeof(out_layout));
+            av_log(graph, AV_LOG_VERBOSE,
+                   "'%s' inserted between '%s' and '%s': %s %dHz %s -> %s %dHz %s\n",
+                   filter->name, inlink->src->name, outlink->dst->name,
+                   av_get_sample_fmt_name(inlink->format),  inlink->sample_rate,  in_layout,
+                   av_get_sample_fmt_name(outlink->format), outlink->sample_rate, out_layout);
+        } else {
+            av_log(graph, AV_LOG_VERBOSE,
+                   "'%s' inserted between '%s' and '%s': %s -> %s\n",
+                   filter->name, inlink->src->name, outlink->dst->name,
+                   av_get_pix_fmt_name(inlink->format), av_get_pix_fmt_name(outlink->format));
+        }
+    }
+
+    if (nb_conversions)
+        av_log(graph, AV_LOG_VERBOSE, "%d conversion filter(s) inserted\n",
+               nb_conversions);
+}
+
 /**
  * Configure the formats of all the links in the graph.
  */
@@ -1244,10 +1377,13 @@ static int graph_config_formats(AVFilterGraph *graph, void *log_ctx)
     swap_sample_fmts(graph);
     swap_samplerates(graph);
     swap_channel_layouts(graph);
+    choose_sample_fmts(graph);
 
     if ((ret = pick_formats(graph)) < 0)
         return ret;
 
+    report_conversions(graph, log_ctx);
+
     return 0;
 }
 
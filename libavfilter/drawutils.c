@@ -546,6 +546,19 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
                     right, hband, hsub + vsub, xm);
 }
 
+/* blend_line_hv() for a 8 bits mask without subsampling, plain C that only
+ * skips the subsampling logic of the generic path */
+static void blend_line_mask8(uint8_t *dst, int dst_delta,
+                             unsigned src, unsigned alpha,
+                             const uint8_t *mask, int w)
+{
+    for (int x = 0; x < w; x++) {
+        unsigned a = mask[x] * alpha;
+        *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+        dst += dst_delta;
+    }
+}
+
 void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                    uint8_t *dst[], int dst_linesize[], int dst_w, int dst_h,
                    const uint8_t *mask,  int mask_linesize, int mask_w, int mask_h,
@@ -607,7 +620,16 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                 p += dst_linesize[plane];
                 m += top * mask_linesize;
             }
-            if (depth <= 8) {
+            if (depth <= 8 && l2depth == 3 &&
+                !draw->hsub[plane] && !draw->vsub[plane]) {
+                for (y = 0; y < h_sub; y++) {
+                    blend_line_mask8(p, draw->pixelstep[plane],
+                                     color->comp[plane].u8[index], alpha,
+                                     m + xm0, w_sub);
+                    p += dst_linesize[plane];
+                    m += mask_linesize;
+                }
+            } else if (depth <= 8) {
                 for (y = 0; y < h_sub; y++) {
                     blend_line_hv(p, draw->pixelstep[plane],
                                   color->comp[plane].u8[index], alpha,
@@ -337,30 +337,38 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
         }                                                                          \
     }                                                                              \
     for (c = 0; c < st->channels; ++c) {                                           \
+        const double *a = st->d->a, *b = st->d->b;                                 \
+        const type *src = srcs[c] + src_index;                                     \
+        double *v;                                                                 \
+        double v0, v1, v2, v3, v4;                                                 \
         int ci = st->d->channel_map[c] - 1;                                        \
         if (ci < 0) continue;                                                      \
         else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
+        /* keep the filter state in registers */                                   \
+        v = st->d->v[ci];                                                          \
+        v1 = v[1]; v2 = v[2]; v3 = v[3]; v4 = v[4];                                \
         for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
+            v0 = (double) (src[i * stride] / scaling_factor)                       \
+                         - a[1] * v1                                               \
+                         - a[2] * v2                                               \
+                         - a[3] * v3                                               \
+                         - a[4] * v4;                                              \
             audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
+                           b[0] * v0                                               \
+                         + b[1] * v1                                               \
+                         + b[2] * v2                                               \
+                         + b[3] * v3                                               \
+                         + b[4] * v4;                                              \
+            v4 = v3;                                                               \
+            v3 = v2;                                                               \
+            v2 = v1;                                                               \
+            v1 = v0;                                                               \
         }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
+        v[0] = v1;                                                                 \
+        v[4] = fabs(v4) < DBL_MIN ? 0.0 : v4;                                      \
+        v[3] = fabs(v3) < DBL_MIN ? 0.0 : v3;                                      \
+        v[2] = fabs(v2) < DBL_MIN ? 0.0 : v2;                                      \
+        v[1] = fabs(v1) < DBL_MIN ? 0.0 : v1;                                      \
     }                                                                              \
 }
 EBUR128_FILTER(double, 1.0)
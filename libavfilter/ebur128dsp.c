@@ -0,0 +1,202 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/error.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+#include "ebur128dsp.h"
+
+/* samples kept for each channel by the true peak detector */
+#define TP_BUF_SIZE 1024
+
+/* ITU-R BS.1770-4 Annex 2, 4 times over-sampling filter, one phase per row */
+static const double tp_coeffs[4][FF_EBUR128_TP_TAPS] = {
+    {  0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000,
+      -0.0594482421875,  0.1373291015625,  0.9721679687500, -0.1022949218750,
+       0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+    { -0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250,
+      -0.1665039062500,  0.4650878906250,  0.7797851562500, -0.2003173828125,
+       0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+    { -0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000,
+      -0.2003173828125,  0.7797851562500,  0.4650878906250, -0.1665039062500,
+       0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+    { -0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750,
+      -0.1022949218750,  0.9721679687500,  0.1373291015625, -0.0594482421875,
+       0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750 },
+};
+
+static void filter_channels_c(const double *coeffs, double *state,
+                              const double *samples, ptrdiff_t stride,
+                              double *const *cache_400, double *const *cache_3000,
+                              int nb_channels, int nb_samples)
+{
+    const double b0 = coeffs[FF_EBUR128_PRE_B0], b1 = coeffs[FF_EBUR128_PRE_B1];
+    const double b2 = coeffs[FF_EBUR128_PRE_B2], a1 = coeffs[FF_EBUR128_PRE_A1];
+    const double a2 = coeffs[FF_EBUR128_PRE_A2];
+    const double rlb_a1 = coeffs[FF_EBUR128_RLB_A1], rlb_a2 = coeffs[FF_EBUR128_RLB_A2];
+
+    for (int ch = 0; ch < nb_channels; ch++) {
+        const double *src = samples + ch;
+        double *c400  = cache_400 [ch];
+        double *c3000 = cache_3000[ch];
+        double x1 = FF_EBUR128_STATE(state, ch, FF_EBUR128_X1);
+        double x2 = FF_EBUR128_STATE(state, ch, FF_EBUR128_X2);
+        double y1 = FF_EBUR128_STATE(state, ch, FF_EBUR128_Y1);
+        double y2 = FF_EBUR128_STATE(state, ch, FF_EBUR128_Y2);
+        double z1 = FF_EBUR128_STATE(state, ch, FF_EBUR128_Z1);
+        double z2 = FF_EBUR128_STATE(state, ch, FF_EBUR128_Z2);
+        double sum_400  = FF_EBUR128_STATE(state, ch, FF_EBUR128_SUM_400);
+        double sum_3000 = FF_EBUR128_STATE(state, ch, FF_EBUR128_SUM_3000);
+
+        for (int i = 0; i < nb_samples; i++) {
+            const double x0 = src[i * stride];
+            const double y0 = x0 * b0 + x1 * b1 + x2 * b2 - y1 * a1 - y2 * a2;
+            const double z0 = y0 - 2.0 * y1 + y2 - z1 * rlb_a1 - z2 * rlb_a2;
+            const double bin = z0 * z0;
+
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = y0;
+            z2 = z1;
+            z1 = z0;
+
+            /* add the new value, and remove the oldest one of the window */
+            sum_400  = sum_400  + bin - c400 [i];
+            sum_3000 = sum_3000 + bin - c3000[i];
+            c400 [i] = bin;
+            c3000[i] = bin;
+        }
+
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_X1) = x1;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_X2) = x2;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_Y1) = y1;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_Y2) = y2;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_Z1) = z1;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_Z2) = z2;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_SUM_400)  = sum_400;
+        FF_EBUR128_STATE(state, ch, FF_EBUR128_SUM_3000) = sum_3000;
+    }
+}
+
+static double find_peak_c(const double *src, int nb_samples,
+                          const double *coeffs, int nb_phases)
+{
+    double peak = 0.0;
+
+    for (int i = 0; i < nb_samples; i++) {
+        for (int p = 0; p < nb_phases; p++) {
+            const double *c = coeffs + p * FF_EBUR128_TP_TAPS;
+            double sum = 0.0;
+
+            for (int k = 0; k < FF_EBUR128_TP_TAPS; k++)
+                sum += src[i + k] * c[k];
+            peak = FFMAX(peak, fabs(sum));
+        }
+    }
+
+    return peak;
+}
+
+av_cold void ff_ebur128_dsp_init(FFEBUR128DSPContext *dsp)
+{
+    dsp->filter_channels = filter_channels_c;
+    dsp->find_peak       = find_peak_c;
+
+#if ARCH_X86
+    ff_ebur128_dsp_init_x86(dsp);
+#endif
+}
+
+av_cold int ff_ebur128_true_peak_init(FFEBUR128TruePeak *tp, int nb_channels, int sample_rate)
+{
+    memset(tp, 0, sizeof(*tp));
+    ff_ebur128_dsp_init(&tp->dsp);
+    tp->nb_channels = nb_channels;
+
+    if (sample_rate < 96000) {
+        tp->nb_phases = 4;
+        memcpy(tp->coeffs, tp_coeffs, sizeof(tp_coeffs));
+    } else if (sample_rate < 192000) {
+        tp->nb_phases = 2;
+        memcpy(tp->coeffs,                      tp_coeffs[0], sizeof(tp_coeffs[0]));
+        memcpy(tp->coeffs + FF_EBUR128_TP_TAPS, tp_coeffs[2], sizeof(tp_coeffs[2]));
+    } else {
+        /* the samples themselves */
+        tp->nb_phases = 1;
+        tp->coeffs[FF_EBUR128_TP_TAPS / 2 - 1] = 1.0;
+    }
+
+    tp->buf     = av_calloc(nb_channels, TP_BUF_SIZE * sizeof(*tp->buf));
+    tp->buf_len = av_calloc(nb_channels, sizeof(*tp->buf_len));
+    if (!tp->buf || !tp->buf_len)
+        return AVERROR(ENOMEM);
+
+    /* the signal starts after silence */
+    for (int ch = 0; ch < nb_channels; ch++)
+        tp->buf_len[ch] = FF_EBUR128_TP_TAPS - 1;
+
+    return 0;
+}
+
+av_cold void ff_ebur128_true_peak_uninit(FFEBUR128TruePeak *tp)
+{
+    av_freep(&tp->buf);
+    av_freep(&tp->buf_len);
+}
+
+double ff_ebur128_true_peak_channel(FFEBUR128TruePeak *tp, int ch,
+                                    const double *samples, ptrdiff_t stride,
+                                    int nb_samples)
+{
+    double *buf = tp->buf + ch * TP_BUF_SIZE;
+    int len = tp->buf_len[ch];
+    double peak = 0.0;
+
+    while (nb_samples > 0) {
+        const int n = FFMIN(nb_samples, TP_BUF_SIZE - len);
+        int nb_out;
+
+        if (samples) {
+            for (int i = 0; i < n; i++)
+                buf[len + i] = samples[i * stride];
+            samples += n * stride;
+        } else {
+            memset(buf + len, 0, n * sizeof(*buf));
+        }
+        len        += n;
+        nb_samples -= n;
+
+        /* interpolate between the samples with enough samples after them,
+         * and keep the others for the next call */
+        nb_out = (len - (FF_EBUR128_TP_TAPS - 1)) & ~3;
+        if (nb_out > 0) {
+            peak = FFMAX(peak, tp->dsp.find_peak(buf, nb_out, tp->coeffs, tp->nb_phases));
+            len -= nb_out;
+            memmove(buf, buf + nb_out, len * sizeof(*buf));
+        }
+    }
+    tp->buf_len[ch] = len;
+
+    return peak;
+}
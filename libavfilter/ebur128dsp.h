@@ -0,0 +1,138 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * ITU-R BS.1770 K-weighting filter and true peak detector, shared by the
+ * ebur128 and loudnorm filters.
+ */
+
+#ifndef AVFILTER_EBUR128DSP_H
+#define AVFILTER_EBUR128DSP_H
+
+#include <stddef.h>
+
+/**
+ * Coefficients of the K-weighting filter: the pre-filter b0, b1, b2, a1,
+ * a2, then the RLB filter a1, a2. The numerator of the RLB filter is
+ * always 1, -2, 1.
+ */
+enum {
+    FF_EBUR128_PRE_B0,
+    FF_EBUR128_PRE_B1,
+    FF_EBUR128_PRE_B2,
+    FF_EBUR128_PRE_A1,
+    FF_EBUR128_PRE_A2,
+    FF_EBUR128_RLB_A1,
+    FF_EBUR128_RLB_A2,
+    FF_EBUR128_NB_COEFFS,
+};
+
+/**
+ * State of the K-weighting filter of a channel, and sums of the last
+ * entries of its integration windows.
+ */
+enum {
+    FF_EBUR128_X1,
+    FF_EBUR128_X2,
+    FF_EBUR128_Y1,
+    FF_EBUR128_Y2,
+    FF_EBUR128_Z1,
+    FF_EBUR128_Z2,
+    FF_EBUR128_SUM_400,
+    FF_EBUR128_SUM_3000,
+    FF_EBUR128_NB_STATES,
+};
+
+/**
+ * The states are stored by pairs of channels, so that two channels can be
+ * filtered together: each value of a pair is followed by the same value
+ * of the other channel.
+ */
+#define FF_EBUR128_STATE(state, ch, var) \
+    (state)[((ch) >> 1) * 2 * FF_EBUR128_NB_STATES + (var) * 2 + ((ch) & 1)]
+
+/** number of taps of each phase of the true peak over-sampling filter */
+#define FF_EBUR128_TP_TAPS 12
+
+typedef struct FFEBUR128DSPContext {
+    /**
+     * Apply the K-weighting filter to nb_samples samples of nb_channels
+     * channels, and add the squares of the results to their integration
+     * windows, replacing the oldest entries.
+     *
+     * @param coeffs     FF_EBUR128_NB_COEFFS filter coefficients
+     * @param state      states of the channels, starting with the first
+     *                   channel of a pair
+     * @param samples    first sample of the first channel
+     * @param stride     distance between two samples of a channel
+     * @param cache_400  for each channel, the entries of the 400ms window
+     *                   to replace
+     * @param cache_3000 for each channel, the entries of the 3s window to
+     *                   replace
+     */
+    void (*filter_channels)(const double *coeffs, double *state,
+                            const double *samples, ptrdiff_t stride,
+                            double *const *cache_400, double *const *cache_3000,
+                            int nb_channels, int nb_samples);
+
+    /**
+     * Interpolate nb_phases values between each of nb_samples samples, and
+     * return the largest absolute value.
+     *
+     * @param src        nb_samples + FF_EBUR128_TP_TAPS - 1 samples
+     * @param nb_samples multiple of 4
+     * @param coeffs     FF_EBUR128_TP_TAPS coefficients for each phase
+     */
+    double (*find_peak)(const double *src, int nb_samples,
+                        const double *coeffs, int nb_phases);
+} FFEBUR128DSPContext;
+
+void ff_ebur128_dsp_init(FFEBUR128DSPContext *dsp);
+void ff_ebur128_dsp_init_x86(FFEBUR128DSPContext *dsp);
+
+/**
+ * True peak detector following ITU-R BS.1770-4 Annex 2, which over-samples
+ * the signal 4 times below 96kHz, and 2 times below 192kHz.
+ */
+typedef struct FFEBUR128TruePeak {
+    FFEBUR128DSPContext dsp;
+    int nb_channels;
+    int nb_phases;
+    double coeffs[4 * FF_EBUR128_TP_TAPS];
+    double *buf;                    ///< last samples of each channel
+    int *buf_len;                   ///< number of samples in buf for each channel
+} FFEBUR128TruePeak;
+
+int ff_ebur128_true_peak_init(FFEBUR128TruePeak *tp, int nb_channels, int sample_rate);
+void ff_ebur128_true_peak_uninit(FFEBUR128TruePeak *tp);
+
+/**
+ * Add nb_samples samples to a channel of the detector, and return the true
+ * peak of the samples it could interpolate. A few samples are kept for the
+ * next call.
+ *
+ * @param samples samples of the channel, or NULL to add silence, which with
+ *                FF_EBUR128_TP_TAPS + 3 samples flushes the detector
+ * @param stride  distance between two samples of the channel
+ */
+double ff_ebur128_true_peak_channel(FFEBUR128TruePeak *tp, int ch,
+                                    const double *samples, ptrdiff_t stride,
+                                    int nb_samples);
+
+#endif /* AVFILTER_EBUR128DSP_H */
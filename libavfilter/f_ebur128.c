@@ -37,8 +37,8 @@
 #include "libavutil/xga_font_data.h"
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
-#include "libswresample/swresample.h"
 #include "avfilter.h"
+#include "ebur128dsp.h"
 #include "filters.h"
 #include "formats.h"
 #include "video.h"
@@ -63,9 +63,9 @@ struct hist_entry {
 
 struct integrator {
     double **cache;                 ///< window of filtered samples (N ms)
+    double **cache_cur;             ///< entry at cache_pos of the cache of each channel
     int cache_pos;                  ///< focus on the last added bin in the cache array
     int cache_size;
-    double *sum;                    ///< sum of the last N ms filtered samples (cache content)
     int filled;                     ///< 1 if the cache is completely filled, 0 otherwise
     double rel_threshold;           ///< relative threshold
     double sum_kept_powers;         ///< sum of the powers (weighted sums) above absolute threshold
@@ -85,11 +85,7 @@ typedef struct EBUR128Context {
     double sample_peak;             ///< global sample peak
     double *sample_peaks;           ///< sample peaks per channel
     double *true_peaks_per_frame;   ///< true peaks in a frame per channel
-#if CONFIG_SWRESAMPLE
-    SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
-    double *swr_buf;                ///< resampled audio data for true peak metering
-    int swr_linesize;
-#endif
+    FFEBUR128TruePeak tp;           ///< true peak detector
 
     /* video  */
     int do_video;                   ///< 1 if video output enabled, 0 otherwise
@@ -113,15 +109,10 @@ typedef struct EBUR128Context {
     int idx_insample;               ///< current sample position of processed samples in single input frame
     AVFrame *insamples;             ///< input samples reference, updated regularly
 
-    /* Filter caches.
-     * The mult by 3 in the following is for X[i], X[i-1] and X[i-2] */
-    double *x;                      ///< 3 input samples cache for each channel
-    double *y;                      ///< 3 pre-filter samples cache for each channel
-    double *z;                      ///< 3 RLB-filter samples cache for each channel
-    double pre_b[3];                ///< pre-filter numerator coefficients
-    double pre_a[3];                ///< pre-filter denominator coefficients
-    double rlb_b[3];                ///< rlb-filter numerator coefficients
-    double rlb_a[3];                ///< rlb-filter denominator coefficients
+    /* K-weighting filter */
+    FFEBUR128DSPContext dsp;
+    double coeffs[FF_EBUR128_NB_COEFFS]; ///< pre-filter and RLB-filter coefficients
+    double *state;                  ///< filter states and window sums of each channel, see FF_EBUR128_STATE()
 
     struct integrator i400;         ///< 400ms integrator, used for Momentary loudness  (M), and Integrated loudness (I)
     struct integrator i3000;        ///<    3s integrator, used for Short term loudness (S), and Loudness Range      (LRA)
@@ -141,6 +132,11 @@ typedef struct EBUR128Context {
     int scale;                      ///< display scale type of statistics
 } EBUR128Context;
 
+typedef struct ThreadData {
+    const double *samples;
+    int nb_samples;
+} ThreadData;
+
 enum {
     PEAK_MODE_NONE          = 0,
     PEAK_MODE_SAMPLES_PEAKS = 1<<1,
@@ -406,28 +402,24 @@ static int config_audio_input(AVFilterLink *inlink)
 
     double a0 = 1.0 + K / Q + K * K;
 
-    ebur128->pre_b[0] = (Vh + Vb * K / Q + K * K) / a0;
-    ebur128->pre_b[1] = 2.0 * (K * K - Vh) / a0;
-    ebur128->pre_b[2] = (Vh - Vb * K / Q + K * K) / a0;
-    ebur128->pre_a[1] = 2.0 * (K * K - 1.0) / a0;
-    ebur128->pre_a[2] = (1.0 - K / Q + K * K) / a0;
+    ebur128->coeffs[FF_EBUR128_PRE_B0] = (Vh + Vb * K / Q + K * K) / a0;
+    ebur128->coeffs[FF_EBUR128_PRE_B1] = 2.0 * (K * K - Vh) / a0;
+    ebur128->coeffs[FF_EBUR128_PRE_B2] = (Vh - Vb * K / Q + K * K) / a0;
+    ebur128->coeffs[FF_EBUR128_PRE_A1] = 2.0 * (K * K - 1.0) / a0;
+    ebur128->coeffs[FF_EBUR128_PRE_A2] = (1.0 - K / Q + K * K) / a0;
 
     f0 = 38.13547087602444;
     Q = 0.5003270373238773;
     K = tan(M_PI * f0 / (double)inlink->sample_rate);
 
-    ebur128->rlb_b[0] = 1.0;
-    ebur128->rlb_b[1] = -2.0;
-    ebur128->rlb_b[2] = 1.0;
-    ebur128->rlb_a[1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
-    ebur128->rlb_a[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+    /* the numerator of the RLB-filter is 1, -2, 1 */
+    ebur128->coeffs[FF_EBUR128_RLB_A1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+    ebur128->coeffs[FF_EBUR128_RLB_A2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
 
     /* Force 100ms framing in case of metadata injection: the frames must have
      * a granularity of the window overlap to be accurately exploited.
-     * As for the true peaks mode, it just simplifies the resampling buffer
-     * allocation and the lookup in it (since sample buffers differ in size, it
-     * can be more complex to integrate in the one-sample loop of
-     * filter_frame()). */
+     * As for the true peaks mode, it keeps the true peaks of each frame in
+     * step with the loudness computed every 100ms. */
     if (ebur128->metadata || (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS))
         ebur128->nb_samples = FFMAX(inlink->sample_rate / 10, 1);
     return 0;
@@ -446,22 +438,21 @@ static int config_audio_output(AVFilterLink *outlink)
                    AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
 
     ebur128->nb_channels  = nb_channels;
-    ebur128->x            = av_calloc(nb_channels, 3 * sizeof(*ebur128->x));
-    ebur128->y            = av_calloc(nb_channels, 3 * sizeof(*ebur128->y));
-    ebur128->z            = av_calloc(nb_channels, 3 * sizeof(*ebur128->z));
+    ebur128->state        = av_calloc((nb_channels + 1) / 2,
+                                      2 * FF_EBUR128_NB_STATES * sizeof(*ebur128->state));
     ebur128->ch_weighting = av_calloc(nb_channels, sizeof(*ebur128->ch_weighting));
-    if (!ebur128->ch_weighting || !ebur128->x || !ebur128->y || !ebur128->z)
+    if (!ebur128->ch_weighting || !ebur128->state)
         return AVERROR(ENOMEM);
 
 #define I400_BINS(x)  ((x) * 4 / 10)
 #define I3000_BINS(x) ((x) * 3)
 
-    ebur128->i400.sum = av_calloc(nb_channels, sizeof(*ebur128->i400.sum));
-    ebur128->i3000.sum = av_calloc(nb_channels, sizeof(*ebur128->i3000.sum));
-    ebur128->i400.cache = av_calloc(nb_channels, sizeof(*ebur128->i400.cache));
-    ebur128->i3000.cache = av_calloc(nb_channels, sizeof(*ebur128->i3000.cache));
-    if (!ebur128->i400.sum || !ebur128->i3000.sum ||
-        !ebur128->i400.cache || !ebur128->i3000.cache)
+    ebur128->i400.cache      = av_calloc(nb_channels, sizeof(*ebur128->i400.cache));
+    ebur128->i3000.cache     = av_calloc(nb_channels, sizeof(*ebur128->i3000.cache));
+    ebur128->i400.cache_cur  = av_calloc(nb_channels, sizeof(*ebur128->i400.cache_cur));
+    ebur128->i3000.cache_cur = av_calloc(nb_channels, sizeof(*ebur128->i3000.cache_cur));
+    if (!ebur128->i400.cache || !ebur128->i3000.cache ||
+        !ebur128->i400.cache_cur || !ebur128->i3000.cache_cur)
         return AVERROR(ENOMEM);
 
     for (i = 0; i < nb_channels; i++) {
@@ -475,10 +466,9 @@ static int config_audio_output(AVFilterLink *outlink)
             ebur128->ch_weighting[i] = 1.0;
         }
 
-        if (!ebur128->ch_weighting[i])
-            continue;
-
-        /* bins buffer for the two integration window (400ms and 3s) */
+        /* bins buffer for the two integration window (400ms and 3s), also
+         * filled for the channels without weight, to filter all the
+         * channels in pairs */
         ebur128->i400.cache_size = I400_BINS(outlink->sample_rate);
         ebur128->i3000.cache_size = I3000_BINS(outlink->sample_rate);
         ebur128->i400.cache[i]  = av_calloc(ebur128->i400.cache_size,  sizeof(*ebur128->i400.cache[0]));
@@ -487,31 +477,16 @@ static int config_audio_output(AVFilterLink *outlink)
             return AVERROR(ENOMEM);
     }
 
-#if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
-        int ret;
+        int ret = ff_ebur128_true_peak_init(&ebur128->tp, nb_channels, outlink->sample_rate);
+        if (ret < 0)
+            return ret;
 
-        ebur128->swr_buf    = av_malloc_array(nb_channels, 19200 * sizeof(double));
         ebur128->true_peaks = av_calloc(nb_channels, sizeof(*ebur128->true_peaks));
         ebur128->true_peaks_per_frame = av_calloc(nb_channels, sizeof(*ebur128->true_peaks_per_frame));
-        ebur128->swr_ctx    = swr_alloc();
-        if (!ebur128->swr_buf || !ebur128->true_peaks ||
-            !ebur128->true_peaks_per_frame || !ebur128->swr_ctx)
+        if (!ebur128->true_peaks || !ebur128->true_peaks_per_frame)
             return AVERROR(ENOMEM);
-
-        av_opt_set_chlayout(ebur128->swr_ctx, "in_chlayout",    &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "in_sample_fmt", outlink->format, 0);
-
-        av_opt_set_chlayout(ebur128->swr_ctx, "out_chlayout",    &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
-
-        ret = swr_init(ebur128->swr_ctx);
-        if (ret < 0)
-            return ret;
     }
-#endif
 
     if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
         ebur128->sample_peaks = av_calloc(nb_channels, sizeof(*ebur128->sample_peaks));
@@ -555,12 +530,6 @@ static av_cold int init(AVFilterContext *ctx)
             ebur128->loglevel = AV_LOG_INFO;
     }
 
-    if (!CONFIG_SWRESAMPLE && (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS)) {
-        av_log(ctx, AV_LOG_ERROR,
-               "True-peak mode requires libswresample to be performed\n");
-        return AVERROR(EINVAL);
-    }
-
     // if meter is  +9 scale, scale range is from -18 LU to  +9 LU (or 3*9)
     // if meter is +18 scale, scale range is from -36 LU to +18 LU (or 3*18)
     ebur128->scale_range = 3 * ebur128->meter;
@@ -573,6 +542,8 @@ static av_cold int init(AVFilterContext *ctx)
     ebur128->integrated_loudness = ABS_THRES;
     ebur128->loudness_range = 0;
 
+    ff_ebur128_dsp_init(&ebur128->dsp);
+
     /* insert output pads */
     if (ebur128->do_video) {
         pad = (AVFilterPad){
@@ -626,6 +597,55 @@ static int gate_update(struct integrator *integ, double power,
     return gate_hist_pos;
 }
 
+static int true_peaks_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    ThreadData *td = arg;
+    const int nb_channels = ebur128->nb_channels;
+    const int start = (nb_channels *  jobnr     ) / nb_jobs;
+    const int end   = (nb_channels * (jobnr + 1)) / nb_jobs;
+
+    for (int ch = start; ch < end; ch++) {
+        const double peak = ff_ebur128_true_peak_channel(&ebur128->tp, ch, td->samples + ch,
+                                                         nb_channels, td->nb_samples);
+
+        ebur128->true_peaks_per_frame[ch] = peak;
+        ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], peak);
+    }
+
+    return 0;
+}
+
+/* apply the K-weighting filter to a group of channels starting on a pair of
+ * channels, and add the samples to the integration windows */
+static int filter_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    EBUR128Context *ebur128 = ctx->priv;
+    ThreadData *td = arg;
+    const int nb_channels = ebur128->nb_channels;
+    const int nb_pairs = (nb_channels + 1) / 2;
+    const int start = 2 * ((nb_pairs *  jobnr     ) / nb_jobs);
+    const int end   = FFMIN(2 * ((nb_pairs * (jobnr + 1)) / nb_jobs), nb_channels);
+
+    if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
+        for (int ch = start; ch < end; ch++) {
+            const double *samples = td->samples + ch;
+            double peak = ebur128->sample_peaks[ch];
+
+            for (int i = 0; i < td->nb_samples; i++)
+                peak = FFMAX(peak, fabs(samples[i * nb_channels]));
+            ebur128->sample_peaks[ch] = peak;
+        }
+    }
+
+    ebur128->dsp.filter_channels(ebur128->coeffs, ebur128->state + start * FF_EBUR128_NB_STATES,
+                                 td->samples + start, nb_channels,
+                                 ebur128->i400.cache_cur + start, ebur128->i3000.cache_cur + start,
+                                 end - start, td->nb_samples);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 {
     int i, ch, idx_insample, ret;
@@ -634,82 +654,54 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     const int nb_channels = ebur128->nb_channels;
     const int nb_samples  = insamples->nb_samples;
     const double *samples = (double *)insamples->data[0];
+    /* the loudness is computed every 100ms */
+    const int period = inlink->sample_rate / 10;
     AVFrame *pic;
 
-#if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS && ebur128->idx_insample == 0) {
-        const double *swr_samples = ebur128->swr_buf;
-        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
-                              (const uint8_t **)insamples->data, nb_samples);
-        if (ret < 0)
-            return ret;
-        for (ch = 0; ch < nb_channels; ch++)
-            ebur128->true_peaks_per_frame[ch] = 0.0;
-        for (idx_insample = 0; idx_insample < ret; idx_insample++) {
-            for (ch = 0; ch < nb_channels; ch++) {
-                ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], fabs(*swr_samples));
-                ebur128->true_peaks_per_frame[ch] = FFMAX(ebur128->true_peaks_per_frame[ch],
-                                                          fabs(*swr_samples));
-                swr_samples++;
-            }
-        }
+        ThreadData td = { .samples = samples, .nb_samples = nb_samples };
+
+        ff_filter_execute(ctx, true_peaks_slice, &td, NULL,
+                          FFMIN(nb_channels, ff_filter_get_nb_threads(ctx)));
     }
-#endif
 
     for (idx_insample = ebur128->idx_insample; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos;
-        const int bin_id_3000 = ebur128->i3000.cache_pos;
-
-#define MOVE_TO_NEXT_CACHED_ENTRY(time) do {                \
-    ebur128->i##time.cache_pos++;                           \
-    if (ebur128->i##time.cache_pos ==                       \
+        /* process the samples up to the next loudness computation */
+        const int nb_period = period > ebur128->sample_count ?
+                              FFMIN(nb_samples - idx_insample, period - ebur128->sample_count) :
+                              nb_samples - idx_insample;
+
+#define MOVE_TO_NEXT_CACHED_ENTRY(time, n) do {             \
+    ebur128->i##time.cache_pos += n;                        \
+    if (ebur128->i##time.cache_pos >=                       \
         ebur128->i##time.cache_size) {                      \
         ebur128->i##time.filled    = 1;                     \
-        ebur128->i##time.cache_pos = 0;                     \
+        ebur128->i##time.cache_pos -= ebur128->i##time.cache_size; \
     }                                                       \
 } while (0)
 
-        MOVE_TO_NEXT_CACHED_ENTRY(400);
-        MOVE_TO_NEXT_CACHED_ENTRY(3000);
-
-        for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
-
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
-                ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(samples[idx_insample * nb_channels + ch]));
-
-            ebur128->x[ch * 3] = samples[idx_insample * nb_channels + ch]; // set X[i]
-
-            if (!ebur128->ch_weighting[ch])
-                continue;
-
-            /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, NUM, DEN) do {                                             \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*NUM[0] + src[1]*NUM[1] + src[2]*NUM[2]              \
-                                   - dst[1]*DEN[1] - dst[2]*DEN[2];             \
-} while (0)
-
-            // TODO: merge both filters in one?
-            FILTER(y, x, ebur128->pre_b, ebur128->pre_a);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, ebur128->rlb_b, ebur128->rlb_a);  // apply RLB-filter
+        /* the runs of samples stop at the end of the caches */
+        for (i = 0; i < nb_period;) {
+            ThreadData td = {
+                .samples    = samples + (idx_insample + i) * nb_channels,
+                .nb_samples = FFMIN3(nb_period - i,
+                                     ebur128->i400.cache_size  - ebur128->i400.cache_pos,
+                                     ebur128->i3000.cache_size - ebur128->i3000.cache_pos),
+            };
 
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
+            for (ch = 0; ch < nb_channels; ch++) {
+                ebur128->i400.cache_cur [ch] = ebur128->i400.cache [ch] + ebur128->i400.cache_pos;
+                ebur128->i3000.cache_cur[ch] = ebur128->i3000.cache[ch] + ebur128->i3000.cache_pos;
+            }
 
-            /* add the new value, and limit the sum to the cache size (400ms or 3s)
-             * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
+            ff_filter_execute(ctx, filter_channels, &td, NULL,
+                              FFMIN((nb_channels + 1) / 2, ff_filter_get_nb_threads(ctx)));
 
-            /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
+            MOVE_TO_NEXT_CACHED_ENTRY(400,  td.nb_samples);
+            MOVE_TO_NEXT_CACHED_ENTRY(3000, td.nb_samples);
+            i += td.nb_samples;
         }
+        idx_insample += nb_period - 1;
 
 #define FIND_PEAK(global, sp, ptype) do {                        \
     int ch;                                                      \
@@ -728,7 +720,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
-        if (++ebur128->sample_count == inlink->sample_rate / 10) {
+        ebur128->sample_count += nb_period;
+        if (ebur128->sample_count == period) {
             double loudness_400, loudness_3000;
             double power_400 = 1e-12, power_3000 = 1e-12;
             AVFilterLink *outlink = ctx->outputs[0];
@@ -742,7 +735,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     if (ebur128->i##time.filled) {                                                  \
         /* weighting sum of the last <time> ms */                                   \
         for (ch = 0; ch < nb_channels; ch++)                                        \
-            power_##time += ebur128->ch_weighting[ch] * ebur128->i##time.sum[ch];   \
+            power_##time += ebur128->ch_weighting[ch] *                             \
+                            FF_EBUR128_STATE(ebur128->state, ch, FF_EBUR128_SUM_##time); \
         power_##time /= I##time##_BINS(inlink->sample_rate);                        \
     }                                                                               \
     loudness_##time = LOUDNESS(power_##time);                                       \
@@ -1048,6 +1042,17 @@ static av_cold void uninit(AVFilterContext *ctx)
         ebur128->lra_high -= ebur128->pan_law;
     }
 
+    /* add the last samples kept by the true peak detector */
+    if (ebur128->tp.buf && ebur128->true_peaks) {
+        for (int ch = 0; ch < ebur128->nb_channels; ch++) {
+            const double peak = ff_ebur128_true_peak_channel(&ebur128->tp, ch, NULL, 0,
+                                                             FF_EBUR128_TP_TAPS + 3);
+
+            ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], peak);
+        }
+        FIND_PEAK(ebur128->true_peak, ebur128->true_peaks, TRUE);
+    }
+
     if (ebur128->nb_channels > 0) {
     av_log(ctx, AV_LOG_INFO, "Summary:\n\n"
            "  Integrated loudness:\n"
@@ -1075,15 +1080,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
 
     av_freep(&ebur128->y_line_ref);
-    av_freep(&ebur128->x);
-    av_freep(&ebur128->y);
-    av_freep(&ebur128->z);
+    av_freep(&ebur128->state);
     av_freep(&ebur128->ch_weighting);
     av_freep(&ebur128->true_peaks);
     av_freep(&ebur128->sample_peaks);
     av_freep(&ebur128->true_peaks_per_frame);
-    av_freep(&ebur128->i400.sum);
-    av_freep(&ebur128->i3000.sum);
     av_freep(&ebur128->i400.histogram);
     av_freep(&ebur128->i3000.histogram);
     for (int i = 0; i < ebur128->nb_channels; i++) {
@@ -1094,11 +1095,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
     av_freep(&ebur128->i400.cache);
     av_freep(&ebur128->i3000.cache);
+    av_freep(&ebur128->i400.cache_cur);
+    av_freep(&ebur128->i3000.cache_cur);
     av_frame_free(&ebur128->outpicref);
-#if CONFIG_SWRESAMPLE
-    av_freep(&ebur128->swr_buf);
-    swr_free(&ebur128->swr_ctx);
-#endif
+    ff_ebur128_true_peak_uninit(&ebur128->tp);
 }
 
 static const AVFilterPad ebur128_inputs[] = {
@@ -1120,5 +1120,6 @@ const AVFilter ff_af_ebur128 = {
     .outputs       = NULL,
     FILTER_QUERY_FUNC2(query_formats),
     .priv_class    = &ebur128_class,
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
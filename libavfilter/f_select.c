@@ -28,16 +28,14 @@
 #include "libavutil/avstring.h"
 #include "libavutil/eval.h"
 #include "libavutil/fifo.h"
-#include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
-#include "libavutil/pixdesc.h"
 #include "avfilter.h"
 #include "audio.h"
 #include "filters.h"
 #include "formats.h"
 #include "video.h"
-#include "scene_sad.h"
+#include "scene.h"
 
 static const char *const var_names[] = {
     "TB",                ///< timebase
@@ -162,14 +160,9 @@ typedef struct SelectContext {
     char *expr_str;
     AVExpr *expr;
     double var_values[VAR_VARS_NB];
-    int bitdepth;
-    int nb_planes;
-    ptrdiff_t width[4];
-    ptrdiff_t height[4];
     int do_scene_detect;            ///< 1 if the expression requires scene detection variables, 0 otherwise
-    ff_scene_sad_fn sad;            ///< Sum of the absolute difference function (scene detect only)
+    FFSceneContext scene;           ///< scene change analysis                   (scene detect only)
     double prev_mafd;               ///< previous MAFD                           (scene detect only)
-    AVFrame *prev_picref;           ///< previous frame                          (scene detect only)
     double select;
     int select_out;                 ///< mark the selected output pad index
     int nb_outputs;
@@ -222,21 +215,6 @@ static av_cold int init(AVFilterContext *ctx)
 static int config_input(AVFilterLink *inlink)
 {
     SelectContext *select = inlink->dst->priv;
-    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB) &&
-                 (desc->flags & AV_PIX_FMT_FLAG_PLANAR) &&
-                 desc->nb_components >= 3;
-
-    select->bitdepth = desc->comp[0].depth;
-    select->nb_planes = is_yuv ? 1 : av_pix_fmt_count_planes(inlink->format);
-
-    for (int plane = 0; plane < select->nb_planes; plane++) {
-        ptrdiff_t line_size = av_image_get_linesize(inlink->format, inlink->w, plane);
-        int vsub = desc->log2_chroma_h;
-
-        select->width[plane] = line_size >> (select->bitdepth > 8);
-        select->height[plane] = plane == 1 || plane == 2 ?  AV_CEIL_RSHIFT(inlink->h, vsub) : inlink->h;
-    }
 
     select->var_values[VAR_N]          = 0.0;
     select->var_values[VAR_SELECTED_N] = 0.0;
@@ -280,44 +258,25 @@ static int config_input(AVFilterLink *inlink)
     select->var_values[VAR_SAMPLE_RATE] =
         inlink->type == AVMEDIA_TYPE_AUDIO ? inlink->sample_rate : NAN;
 
-    if (CONFIG_SELECT_FILTER && select->do_scene_detect) {
-        select->sad = ff_scene_sad_get_fn(select->bitdepth == 8 ? 8 : 16);
-        if (!select->sad)
-            return AVERROR(EINVAL);
-    }
+    if (CONFIG_SELECT_FILTER && select->do_scene_detect)
+        return ff_scene_init(&select->scene, inlink->format, inlink->w, inlink->h, 1);
     return 0;
 }
 
 static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
 {
-    double ret = 0;
     SelectContext *select = ctx->priv;
-    AVFrame *prev_picref = select->prev_picref;
-
-    if (prev_picref &&
-        frame->height == prev_picref->height &&
-        frame->width  == prev_picref->width) {
-        uint64_t sad = 0;
-        double mafd, diff;
-        uint64_t count = 0;
-
-        for (int plane = 0; plane < select->nb_planes; plane++) {
-            uint64_t plane_sad;
-            select->sad(prev_picref->data[plane], prev_picref->linesize[plane],
-                    frame->data[plane], frame->linesize[plane],
-                    select->width[plane], select->height[plane], &plane_sad);
-            sad += plane_sad;
-            count += select->width[plane] * select->height[plane];
-        }
+    double mafd, diff;
 
-        mafd = (double)sad / count / (1ULL << (select->bitdepth - 8));
-        diff = fabs(mafd - select->prev_mafd);
-        ret  = av_clipf(FFMIN(mafd, diff) / 100., 0, 1);
-        select->prev_mafd = mafd;
-        av_frame_free(&prev_picref);
-    }
-    select->prev_picref = av_frame_clone(frame);
-    return ret;
+    if (ff_scene_get_mafd(ctx, &select->scene, frame, &mafd) <= 0)
+        return 0;
+
+    /* the score is based on the difference in 8-bit sample units */
+    mafd *= 256 / 100.;
+    diff = fabs(mafd - select->prev_mafd);
+    select->prev_mafd = mafd;
+
+    return av_clipf(FFMIN(mafd, diff) / 100., 0, 1);
 }
 
 static double get_concatdec_select(AVFrame *frame, int64_t pts)
@@ -466,9 +425,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_expr_free(select->expr);
     select->expr = NULL;
 
-    if (select->do_scene_detect) {
-        av_frame_free(&select->prev_picref);
-    }
+    if (select->do_scene_detect)
+        ff_scene_uninit(&select->scene);
 }
 
 #if CONFIG_ASELECT_FILTER
@@ -566,6 +524,7 @@ const AVFilter ff_vf_select = {
     .priv_class    = &select_class,
     FILTER_INPUTS(avfilter_vf_select_inputs),
     FILTER_QUERY_FUNC2(query_formats),
-    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_METADATA_ONLY |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif /* CONFIG_SELECT_FILTER */
@@ -18,6 +18,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+#include "libavutil/attributes.h"
 #include "libavutil/common.h"
 #include "motion_estimation.h"
 
@@ -43,6 +45,38 @@ do {\
 if (x >= x_min && x <= x_max && y >= y_min && y <= y_max)\
     COST_MV(x, y);
 
+#define DEF_SAD(w)                                                          \
+static int sad##w##_c(const uint8_t *src1, ptrdiff_t stride1,               \
+                      const uint8_t *src2, ptrdiff_t stride2, int h)        \
+{                                                                           \
+    int sad = 0;                                                            \
+                                                                            \
+    for (int j = 0; j < h; j++) {                                           \
+        for (int i = 0; i < w; i++)                                         \
+            sad += FFABS(src1[i] - src2[i]);                                \
+        src1 += stride1;                                                    \
+        src2 += stride2;                                                    \
+    }                                                                       \
+    return sad;                                                             \
+}
+
+DEF_SAD(4)
+DEF_SAD(8)
+DEF_SAD(16)
+DEF_SAD(32)
+
+av_cold void ff_me_init_sad(ff_me_sad_fn sad[4])
+{
+    sad[0] = sad4_c;
+    sad[1] = sad8_c;
+    sad[2] = sad16_c;
+    sad[3] = sad32_c;
+
+#if ARCH_X86
+    ff_me_init_sad_x86(sad);
+#endif
+}
+
 void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_param,
                         int width, int height, int x_min, int x_max, int y_min, int y_max)
 {
@@ -55,26 +89,38 @@ void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_para
     me_ctx->x_max = x_max;
     me_ctx->y_min = y_min;
     me_ctx->y_max = y_max;
+
+    ff_me_init_sad(me_ctx->sad);
 }
 
-uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv)
+uint64_t ff_me_block_sad(const AVMotionEstContext *me_ctx, int log2_size,
+                         const uint8_t *src1, int x1, int y1,
+                         const uint8_t *src2, int x2, int y2)
 {
-    const int linesize = me_ctx->linesize;
-    uint8_t *data_ref = me_ctx->data_ref;
-    uint8_t *data_cur = me_ctx->data_cur;
+    const ptrdiff_t linesize = me_ctx->linesize;
+    const int size = 1 << log2_size;
     uint64_t sad = 0;
-    int i, j;
 
-    data_ref += y_mv * linesize;
-    data_cur += y_mb * linesize;
+    src1 += x1 + y1 * linesize;
+    src2 += x2 + y2 * linesize;
 
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sad += FFABS(data_ref[x_mv + i + j * linesize] - data_cur[x_mb + i + j * linesize]);
+    if (log2_size >= 2 && log2_size <= 5)
+        return me_ctx->sad[log2_size - 2](src1, linesize, src2, linesize, size);
+
+    for (int j = 0; j < size; j++)
+        for (int i = 0; i < size; i++)
+            sad += FFABS(src1[i + j * linesize] - src2[i + j * linesize]);
 
     return sad;
 }
 
+uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv)
+{
+    return ff_me_block_sad(me_ctx, av_log2(me_ctx->mb_size),
+                           me_ctx->data_ref, x_mv, y_mv,
+                           me_ctx->data_cur, x_mb, y_mb);
+}
+
 uint64_t ff_me_search_esa(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv)
 {
     int x, y;
@@ -21,6 +21,7 @@
 #ifndef AVFILTER_MOTION_ESTIMATION_H
 #define AVFILTER_MOTION_ESTIMATION_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define AV_ME_METHOD_ESA        1
@@ -33,6 +34,13 @@
 #define AV_ME_METHOD_EPZS       8
 #define AV_ME_METHOD_UMH        9
 
+/**
+ * Sum of absolute differences of two blocks of 8-bit samples, the width of
+ * the block is given by the index in AVMotionEstContext.sad.
+ */
+typedef int (*ff_me_sad_fn)(const uint8_t *src1, ptrdiff_t stride1,
+                            const uint8_t *src2, ptrdiff_t stride2, int h);
+
 typedef struct AVMotionEstPredictor {
     int mvs[10][2];
     int nb;
@@ -59,11 +67,24 @@ typedef struct AVMotionEstContext {
 
     uint64_t (*get_cost)(struct AVMotionEstContext *me_ctx, int x_mb, int y_mb,
                          int mv_x, int mv_y);
+
+    ff_me_sad_fn sad[4];    ///< block SAD for the widths 4, 8, 16 and 32
 } AVMotionEstContext;
 
 void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_param,
                         int width, int height, int x_min, int x_max, int y_min, int y_max);
 
+void ff_me_init_sad(ff_me_sad_fn sad[4]);
+void ff_me_init_sad_x86(ff_me_sad_fn sad[4]);
+
+/**
+ * Sum of absolute differences of the blocks of size 1 << log2_size at (x1, y1)
+ * in src1 and (x2, y2) in src2.
+ */
+uint64_t ff_me_block_sad(const AVMotionEstContext *me_ctx, int log2_size,
+                         const uint8_t *src1, int x1, int y1,
+                         const uint8_t *src2, int x2, int y2);
+
 uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv);
 
 uint64_t ff_me_search_esa(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv);
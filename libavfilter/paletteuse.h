@@ -0,0 +1,39 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_H
+#define AVFILTER_PALETTEUSE_H
+
+#include <stdint.h>
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Find the nearest color to (L, a, b) by exhaustive search.
+     *
+     * @param lab the L, a and b components of the colors, in 3 planes of
+     *            AVPALETTE_COUNT entries aligned on 32 bytes
+     * @param nb  number of colors to search, a multiple of 8
+     * @return the lowest index of the colors at the smallest squared distance,
+     *         the distances being clipped to INT32_MAX - 1 as in the k-d tree
+     */
+    int (*nearest_color)(const int32_t *lab, int nb, int L, int a, int b);
+} PaletteUseDSPContext;
+
+void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSE_H */
@@ -0,0 +1,157 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Scene change analysis shared by the scene detecting filters
+ */
+
+#include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "filters.h"
+#include "scene.h"
+
+typedef struct ThreadData {
+    FFSceneContext *s;
+    const AVFrame *prev, *frame;
+} ThreadData;
+
+int ff_scene_init(FFSceneContext *s, enum AVPixelFormat pix_fmt,
+                  int w, int h, int step)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB) &&
+        (desc->flags & AV_PIX_FMT_FLAG_PLANAR) &&
+        desc->nb_components >= 3;
+
+    s->bitdepth = desc->comp[0].depth;
+    s->nb_planes = is_yuv ? 1 : av_pix_fmt_count_planes(pix_fmt);
+    s->step = FFMAX(step, 1);
+
+    for (int plane = 0; plane < 4; plane++) {
+        ptrdiff_t line_size = av_image_get_linesize(pix_fmt, w, plane);
+        s->width[plane] = line_size >> (s->bitdepth > 8);
+        s->height[plane] = plane == 1 || plane == 2 ? AV_CEIL_RSHIFT(h, desc->log2_chroma_h) : h;
+    }
+
+    s->sad = ff_scene_sad_get_fn(s->bitdepth == 8 ? 8 : 16);
+    if (!s->sad)
+        return AVERROR(EINVAL);
+
+    return 0;
+}
+
+void ff_scene_uninit(FFSceneContext *s)
+{
+    av_frame_free(&s->prev);
+    av_freep(&s->job_sad);
+    s->nb_jobs = 0;
+}
+
+static int sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    FFSceneContext *s = td->s;
+    const AVFrame *prev = td->prev, *frame = td->frame;
+    const int step = s->step;
+    uint64_t sad = 0;
+
+    for (int plane = 0; plane < s->nb_planes; plane++) {
+        const int lines = (s->height[plane] + step - 1) / step;
+        const int start = (lines * jobnr) / nb_jobs;
+        const int end = (lines * (jobnr+1)) / nb_jobs;
+        const ptrdiff_t prev_linesize = prev->linesize[plane];
+        const ptrdiff_t linesize = frame->linesize[plane];
+        uint64_t plane_sad;
+
+        if (start >= end)
+            continue;
+
+        s->sad(prev->data[plane] + start * step * prev_linesize, prev_linesize * step,
+               frame->data[plane] + start * step * linesize, linesize * step,
+               s->width[plane], end - start, &plane_sad);
+        sad += plane_sad;
+    }
+
+    s->job_sad[jobnr] = sad;
+
+    return 0;
+}
+
+static int compute_mafd(AVFilterContext *ctx, FFSceneContext *s,
+                        const AVFrame *prev, const AVFrame *frame, double *mafd)
+{
+    const int nb_jobs = FFMAX(1, FFMIN((s->height[0] + s->step - 1) / s->step,
+                                       ff_filter_get_nb_threads(ctx)));
+    ThreadData td = { .s = s, .prev = prev, .frame = frame };
+    uint64_t sad = 0, count = 0;
+
+    if (s->nb_jobs < nb_jobs) {
+        uint64_t *job_sad = av_realloc_array(s->job_sad, nb_jobs, sizeof(*s->job_sad));
+        if (!job_sad)
+            return AVERROR(ENOMEM);
+        s->job_sad = job_sad;
+        s->nb_jobs = nb_jobs;
+    }
+
+    ff_filter_execute(ctx, sad_slice, &td, NULL, nb_jobs);
+
+    for (int i = 0; i < nb_jobs; i++)
+        sad += s->job_sad[i];
+    for (int plane = 0; plane < s->nb_planes; plane++)
+        count += s->width[plane] * ((s->height[plane] + s->step - 1) / s->step);
+
+    *mafd = (double)sad * 100. / count / (1ULL << s->bitdepth);
+
+    return 0;
+}
+
+int ff_scene_frame_mafd(AVFilterContext *ctx, FFSceneContext *s,
+                        const AVFrame *prev, const AVFrame *frame, double *mafd)
+{
+    int ret;
+
+    if (!prev || frame->width  != prev->width ||
+                 frame->height != prev->height)
+        return 0;
+
+    ret = compute_mafd(ctx, s, prev, frame, mafd);
+    if (ret < 0)
+        return ret;
+
+    return 1;
+}
+
+int ff_scene_get_mafd(AVFilterContext *ctx, FFSceneContext *s,
+                      const AVFrame *frame, double *mafd)
+{
+    AVFrame *prev = s->prev;
+    int ret = ff_scene_frame_mafd(ctx, s, prev, frame, mafd);
+
+    if (ret < 0)
+        return ret;
+
+    s->prev = av_frame_clone(frame);
+    av_frame_free(&prev);
+    if (!s->prev)
+        return AVERROR(ENOMEM);
+
+    return ret;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Scene change analysis shared by the scene detecting filters
+ */
+
+#ifndef AVFILTER_SCENE_H
+#define AVFILTER_SCENE_H
+
+#include <stdint.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/pixfmt.h"
+
+#include "avfilter.h"
+#include "scene_sad.h"
+
+typedef struct FFSceneContext {
+    ptrdiff_t width[4];
+    ptrdiff_t height[4];
+    int nb_planes;
+    int bitdepth;
+    int step;                       ///< analyse one line out of step
+    ff_scene_sad_fn sad;
+
+    AVFrame *prev;                  ///< previous frame given to ff_scene_get_mafd()
+    uint64_t *job_sad;
+    int nb_jobs;
+} FFSceneContext;
+
+/**
+ * Initialize the analysis of frames of the given format and size. For YUV
+ * formats only the luma plane is analysed, all the planes for the others.
+ *
+ * @param step analyse one line out of step, 1 to analyse the full frame
+ */
+int ff_scene_init(FFSceneContext *s, enum AVPixelFormat pix_fmt,
+                  int w, int h, int step);
+
+void ff_scene_uninit(FFSceneContext *s);
+
+/**
+ * Compute the mean absolute frame difference between prev and frame, in
+ * percent of the sample range, with slice threads.
+ *
+ * @return 1 if mafd was set, 0 if the frames cannot be compared, a negative
+ *         error code on failure
+ */
+int ff_scene_frame_mafd(AVFilterContext *ctx, FFSceneContext *s,
+                        const AVFrame *prev, const AVFrame *frame, double *mafd);
+
+/**
+ * Same as ff_scene_frame_mafd() against the frame given to the previous call.
+ * A reference to frame is kept for the next call.
+ */
+int ff_scene_get_mafd(AVFilterContext *ctx, FFSceneContext *s,
+                      const AVFrame *frame, double *mafd);
+
+#endif /* AVFILTER_SCENE_H */
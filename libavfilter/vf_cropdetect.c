@@ -35,6 +35,8 @@
 #include "video.h"
 #include "edge_common.h"
 
+#define LINE_BLOCK 32
+
 typedef struct CropDetectContext {
     const AVClass *class;
     int x1, y1, x2, y2;
@@ -57,8 +59,19 @@ typedef struct CropDetectContext {
     uint16_t *gradients;
     char     *directions;
     int      *bboxes[4];
+
+    int nb_threads;
+    int batch;              ///< number of lines computed at once
+    int *totals[2];         ///< average value of the rows and columns of the current frame
+    int lo[2], hi[2];       ///< the lines before lo and from hi on are computed
 } CropDetectContext;
 
+typedef struct ThreadData {
+    const AVFrame *frame;
+    int dir;
+    int start, end;
+} ThreadData;
+
 static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUVJ420P,
     AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUVJ422P,
@@ -172,6 +185,59 @@ static int checkline_edge(void *ctx, const unsigned char *src, int stride, int l
     return 1;
 }
 
+static int lines_total(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    CropDetectContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const AVFrame *frame = td->frame;
+    const int bpp = s->max_pixsteps[0];
+    const int start = td->start + ((td->end - td->start) * jobnr) / nb_jobs;
+    const int end = td->start + ((td->end - td->start) * (jobnr+1)) / nb_jobs;
+    int *total = s->totals[td->dir];
+
+    for (int i = start; i < end; i++) {
+        if (!td->dir)
+            total[i] = checkline(ctx, frame->data[0] + frame->linesize[0] * i,
+                                 bpp, frame->width, bpp);
+        else
+            total[i] = checkline(ctx, frame->data[0] + bpp * i,
+                                 frame->linesize[0], frame->height, bpp);
+    }
+
+    return 0;
+}
+
+/**
+ * Return the average value of a row (dir 0) or a column (dir 1) of frame.
+ * The borders are scanned from the edges to the center up to the line
+ * scan_end, so the lines are computed on demand with the slice threads,
+ * in batches going from each edge and stopping there.
+ */
+static int line_total(AVFilterContext *ctx, const AVFrame *frame,
+                      int dir, int pos, int scan_end)
+{
+    CropDetectContext *s = ctx->priv;
+
+    if (pos >= s->lo[dir] && pos < s->hi[dir]) {
+        ThreadData td = { .frame = frame, .dir = dir };
+
+        if (scan_end > pos) {
+            td.start = s->lo[dir];
+            td.end = FFMIN3(FFMAX(pos + 1, s->lo[dir] + s->batch), s->hi[dir], scan_end);
+            s->lo[dir] = td.end;
+        } else {
+            td.start = FFMAX3(FFMIN(pos, s->hi[dir] - s->batch), s->lo[dir], scan_end + 1);
+            td.end = s->hi[dir];
+            s->hi[dir] = td.start;
+        }
+
+        ff_filter_execute(ctx, lines_total, &td, NULL,
+                          FFMIN(td.end - td.start, s->nb_threads));
+    }
+
+    return s->totals[dir][pos];
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     CropDetectContext *s = ctx->priv;
@@ -198,6 +264,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->bboxes[1]);
     av_freep(&s->bboxes[2]);
     av_freep(&s->bboxes[3]);
+    av_freep(&s->totals[0]);
+    av_freep(&s->totals[1]);
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -230,11 +298,18 @@ static int config_input(AVFilterLink *inlink)
     s->bboxes[1]   = av_malloc(s->window_size * sizeof(*s->bboxes[1]));
     s->bboxes[2]   = av_malloc(s->window_size * sizeof(*s->bboxes[2]));
     s->bboxes[3]   = av_malloc(s->window_size * sizeof(*s->bboxes[3]));
+    s->totals[0]   = av_malloc(inlink->h * sizeof(*s->totals[0]));
+    s->totals[1]   = av_malloc(inlink->w * sizeof(*s->totals[1]));
 
     if (!s->tmpbuf    || !s->filterbuf || !s->gradients || !s->directions ||
-        !s->bboxes[0] || !s->bboxes[1] || !s->bboxes[2] || !s->bboxes[3])
+        !s->bboxes[0] || !s->bboxes[1] || !s->bboxes[2] || !s->bboxes[3] ||
+        !s->totals[0] || !s->totals[1])
         return AVERROR(ENOMEM);
 
+    // without threads, compute only the lines which are actually scanned
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->batch      = s->nb_threads > 1 ? s->nb_threads * LINE_BLOCK : 1;
+
     return 0;
 }
 
@@ -282,10 +357,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
             s->frame_nb = 1;
         }
 
-#define FIND(DST, FROM, NOEND, INC, STEP0, STEP1, LEN) \
+#define FIND(DST, FROM, NOEND, INC, DIR, END) \
         outliers = 0;\
         for (last_y = y = FROM; NOEND; y = y INC) {\
-            if (checkline(ctx, frame->data[0] + STEP0 * y, STEP1, LEN, bpp) > limit_upscaled) {\
+            if (line_total(ctx, frame, DIR, y, END) > limit_upscaled) {\
                 if (++outliers > s->max_outliers) { \
                     DST = last_y;\
                     break;\
@@ -295,10 +370,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         }
 
         if (s->mode == MODE_BLACK) {
-            FIND(s->y1,                 0,               y < s->y1, +1, frame->linesize[0], bpp, frame->width);
-            FIND(s->y2, frame->height - 1, y > FFMAX(s->y2, s->y1), -1, frame->linesize[0], bpp, frame->width);
-            FIND(s->x1,                 0,               y < s->x1, +1, bpp, frame->linesize[0], frame->height);
-            FIND(s->x2,  frame->width - 1, y > FFMAX(s->x2, s->x1), -1, bpp, frame->linesize[0], frame->height);
+            s->lo[0] = s->lo[1] = 0;
+            s->hi[0] = frame->height;
+            s->hi[1] = frame->width;
+
+            FIND(s->y1,                 0,               y < s->y1, +1, 0, s->y1);
+            FIND(s->y2, frame->height - 1, y > FFMAX(s->y2, s->y1), -1, 0, FFMAX(s->y2, s->y1));
+            FIND(s->x1,                 0,               y < s->x1, +1, 1, s->x1);
+            FIND(s->x2,  frame->width - 1, y > FFMAX(s->x2, s->x1), -1, 1, FFMAX(s->x2, s->x1));
         } else { // MODE_MV_EDGES
             sd = av_frame_get_side_data(frame, AV_FRAME_DATA_MOTION_VECTORS);
             s->x1 = 0;
@@ -505,6 +584,7 @@ const AVFilter ff_vf_cropdetect = {
     FILTER_INPUTS(avfilter_vf_cropdetect_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_METADATA_ONLY |
+                     AVFILTER_FLAG_SLICE_THREADS,
     .process_command = process_command,
 };
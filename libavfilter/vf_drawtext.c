@@ -187,9 +187,12 @@ typedef struct HarfbuzzData {
     hb_glyph_position_t* glyph_pos;
 } HarfbuzzData;
 
+struct Glyph;
+
 /** Information about a single glyph in a text line */
 typedef struct GlyphInfo {
     uint32_t code;                  ///< the glyph code point
+    struct Glyph *glyph;            ///< the cached glyph
     int x;                          ///< the x position of the glyph
     int y;                          ///< the y position of the glyph
     int shift_x64;                  ///< the horizontal shift of the glyph in 26.6 units
@@ -327,8 +330,24 @@ typedef struct DrawTextContext {
     int tab_count;                  ///< the number of tab characters
     int blank_advance64;            ///< the size of the space character
     int tab_warning_printed;        ///< ensure the tab warning to be printed only once
+
+    char *layout_text;              ///< the text the lines were computed for
+    unsigned int layout_fontsize;   ///< the font size the lines were computed for
+    TextMetrics layout_metrics;     ///< the metrics of the computed lines
+    int layout_x64, layout_y64;     ///< the origin the glyphs were positioned at
+    int layout_positioned;          ///< 1 if the glyph positions are valid
 } DrawTextContext;
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    TextMetrics *metrics;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+    int y0, y1;                     ///< the rows covered by the text and its box
+} ThreadData;
+
 #define OFFSET(x) offsetof(DrawTextContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 #define TFLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
@@ -1120,6 +1139,56 @@ static int glyph_enu_free(void *opaque, void *elem)
     return 0;
 }
 
+// Shapes a line of text using libharfbuzz
+static int shape_text_hb(DrawTextContext *s, HarfbuzzData* hb, const char* text, int textLen)
+{
+    hb->buf = hb_buffer_create();
+    if(!hb_buffer_allocation_successful(hb->buf)) {
+        return AVERROR(ENOMEM);
+    }
+    hb_buffer_set_direction(hb->buf, HB_DIRECTION_LTR);
+    hb_buffer_set_script(hb->buf, HB_SCRIPT_LATIN);
+    hb_buffer_set_language(hb->buf, hb_language_from_string("en", -1));
+    hb_buffer_guess_segment_properties(hb->buf);
+    hb->font = hb_ft_font_create(s->face, NULL);
+    if(hb->font == NULL) {
+        return AVERROR(ENOMEM);
+    }
+    hb_ft_font_set_funcs(hb->font);
+    hb_buffer_add_utf8(hb->buf, text, textLen, 0, -1);
+    hb_shape(hb->font, hb->buf, NULL, 0);
+    hb->glyph_info = hb_buffer_get_glyph_infos(hb->buf, &hb->glyph_count);
+    hb->glyph_pos = hb_buffer_get_glyph_positions(hb->buf, &hb->glyph_count);
+
+    return 0;
+}
+
+static void hb_destroy(HarfbuzzData *hb)
+{
+    hb_buffer_destroy(hb->buf);
+    hb_font_destroy(hb->font);
+    hb->buf = NULL;
+    hb->font = NULL;
+    hb->glyph_info = NULL;
+    hb->glyph_pos = NULL;
+}
+
+static void free_layout(DrawTextContext *s)
+{
+    if (s->lines) {
+        for (int l = 0; l < s->line_count; ++l) {
+            TextLine *line = &s->lines[l];
+            av_freep(&line->glyphs);
+            hb_destroy(&line->hb_data);
+        }
+    }
+    av_freep(&s->lines);
+    av_freep(&s->tab_clusters);
+    av_freep(&s->layout_text);
+    s->line_count = 0;
+    s->layout_positioned = 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
@@ -1131,6 +1200,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     s->x_pexpr = s->y_pexpr = s->a_pexpr = s->fontsize_pexpr = NULL;
 
+    free_layout(s);
+
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
     av_tree_destroy(s->glyphs);
     s->glyphs = NULL;
@@ -1239,6 +1310,8 @@ static int command(AVFilterContext *ctx, const char *cmd, const char *arg, char
             old->fontsize_pexpr = NULL;
             old->blank_advance64 = 0;
         }
+        /* any option may affect the layout of the text */
+        free_layout(old);
         return config_input(ctx->inputs[0]);
     }
 
@@ -1270,17 +1343,27 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       FFDrawColor *color,
-                       TextMetrics *metrics,
-                       int x, int y, int borderw)
+/* Set data to the rows of frame starting at y, y must be a multiple of the
+ * vertical chroma subsampling */
+static void get_slice_data(DrawTextContext *s, AVFrame *frame, int y,
+                           uint8_t *data[MAX_PLANES])
+{
+    for (int p = 0; p < s->dc.nb_planes; p++)
+        data[p] = frame->data[p] + (y >> s->dc.vsub[p]) * frame->linesize[p];
+}
+
+static void draw_glyphs(DrawTextContext *s, AVFrame *frame,
+                        FFDrawColor *color,
+                        TextMetrics *metrics,
+                        int x, int y, int borderw,
+                        int slice_start, int slice_end)
 {
     int g, l, x1, y1, w1, h1, idx;
     int dx = 0, dy = 0, pdx = 0;
     GlyphInfo *info;
-    Glyph dummy = { 0 }, *glyph;
     FT_Bitmap bitmap;
     FT_BitmapGlyph b_glyph;
+    uint8_t *data[MAX_PLANES] = { NULL };
     uint8_t j_left = 0, j_right = 0, j_top = 0, j_bottom = 0;
     int line_w, offset_y = 0;
     int clip_x = 0, clip_y = 0;
@@ -1296,28 +1379,18 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
         offset_y = s->box_height - metrics->height;
     }
 
-    if ((!j_left || j_right) && !s->tab_warning_printed && s->tab_count > 0) {
-        s->tab_warning_printed = 1;
-        av_log(s, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
-    }
-
     clip_x = FFMIN(metrics->rect_x + s->box_width + s->bb_right, frame->width);
     clip_y = FFMIN(metrics->rect_y + s->box_height + s->bb_bottom, frame->height);
+    clip_y = FFMIN(clip_y, slice_end);
+    get_slice_data(s, frame, slice_start, data);
 
     for (l = 0; l < s->line_count; ++l) {
         TextLine *line = &s->lines[l];
         line_w = POS_CEIL(line->width64, 64);
         for (g = 0; g < line->hb_data.glyph_count; ++g) {
             info = &line->glyphs[g];
-            dummy.fontsize = s->fontsize;
-            dummy.code = info->code;
-            glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
-            if (!glyph) {
-                return AVERROR(EINVAL);
-            }
-
             idx = get_subpixel_idx(info->shift_x64, info->shift_y64);
-            b_glyph = borderw ? glyph->border_bglyph[idx] : glyph->bglyph[idx];
+            b_glyph = borderw ? info->glyph->border_bglyph[idx] : info->glyph->bglyph[idx];
             bitmap = b_glyph->bitmap;
             x1 = x + info->x + b_glyph->left;
             y1 = y + info->y - b_glyph->top + offset_y;
@@ -1342,7 +1415,8 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
             }
 
             // check if the glyph is empty or out of the clipping region
-            if (dx >= w1 || dy >= h1 || x1 >= clip_x || y1 >= clip_y) {
+            if (dx >= w1 || dy >= h1 || x1 >= clip_x || y1 >= clip_y ||
+                y1 + h1 - dy <= slice_start) {
                 continue;
             }
 
@@ -1350,48 +1424,54 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
             w1 = FFMIN(clip_x - x1, w1 - dx);
             h1 = FFMIN(clip_y - y1, h1 - dy);
 
-            ff_blend_mask(&s->dc, color, frame->data, frame->linesize, clip_x, clip_y,
-                bitmap.buffer + pdx, bitmap.pitch, w1, h1, 3, 0, x1, y1);
+            ff_blend_mask(&s->dc, color, data, frame->linesize,
+                clip_x, clip_y - slice_start,
+                bitmap.buffer + pdx, bitmap.pitch, w1, h1, 3, 0,
+                x1, y1 - slice_start);
         }
     }
-
-    return 0;
 }
 
-// Shapes a line of text using libharfbuzz
-static int shape_text_hb(DrawTextContext *s, HarfbuzzData* hb, const char* text, int textLen)
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    hb->buf = hb_buffer_create();
-    if(!hb_buffer_allocation_successful(hb->buf)) {
-        return AVERROR(ENOMEM);
-    }
-    hb_buffer_set_direction(hb->buf, HB_DIRECTION_LTR);
-    hb_buffer_set_script(hb->buf, HB_SCRIPT_LATIN);
-    hb_buffer_set_language(hb->buf, hb_language_from_string("en", -1));
-    hb_buffer_guess_segment_properties(hb->buf);
-    hb->font = hb_ft_font_create(s->face, NULL);
-    if(hb->font == NULL) {
-        return AVERROR(ENOMEM);
-    }
-    hb_ft_font_set_funcs(hb->font);
-    hb_buffer_add_utf8(hb->buf, text, textLen, 0, -1);
-    hb_shape(hb->font, hb->buf, NULL, 0);
-    hb->glyph_info = hb_buffer_get_glyph_infos(hb->buf, &hb->glyph_count);
-    hb->glyph_pos = hb_buffer_get_glyph_positions(hb->buf, &hb->glyph_count);
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    TextMetrics *metrics = td->metrics;
+    const int sub = s->dc.vsub_max;
+    const int rows = AV_CEIL_RSHIFT(td->y1 - td->y0, sub);
+    const int slice_start = td->y0 + (((rows *  jobnr     ) / nb_jobs) << sub);
+    const int slice_end   = FFMIN(td->y0 + (((rows * (jobnr + 1)) / nb_jobs) << sub), td->y1);
+
+    /* the slices are aligned on the chroma rows, so that blending them
+     * separately gives the same result as blending the whole frame */
+    if (s->draw_box) {
+        uint8_t *data[MAX_PLANES] = { NULL };
+        int rec_x = metrics->rect_x - s->bb_left;
+        int rec_y = metrics->rect_y - s->bb_top;
+        int rec_width = s->box_width + s->bb_right + s->bb_left;
+        int rec_height = s->box_height + s->bb_bottom + s->bb_top;
+
+        get_slice_data(s, frame, slice_start, data);
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+            data, frame->linesize, frame->width, slice_end - slice_start,
+            rec_x, rec_y - slice_start, rec_width, rec_height);
+    }
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(s, frame, &td->shadowcolor, metrics,
+                    s->shadowx, s->shadowy, s->borderw, slice_start, slice_end);
+
+    if (s->borderw)
+        draw_glyphs(s, frame, &td->bordercolor, metrics,
+                    0, 0, s->borderw, slice_start, slice_end);
+
+    draw_glyphs(s, frame, &td->fontcolor, metrics,
+                0, 0, 0, slice_start, slice_end);
 
     return 0;
 }
 
-static void hb_destroy(HarfbuzzData *hb)
-{
-    hb_buffer_destroy(hb->buf);
-    hb_font_destroy(hb->font);
-    hb->buf = NULL;
-    hb->font = NULL;
-    hb->glyph_info = NULL;
-    hb->glyph_pos = NULL;
-}
-
 static int measure_text(AVFilterContext *ctx, TextMetrics *metrics)
 {
     DrawTextContext *s = ctx->priv;
@@ -1437,8 +1517,12 @@ continue_on_failed:
     }
 
     s->line_count = line_count;
-    s->lines = av_mallocz(line_count * sizeof(TextLine));
-    s->tab_clusters = av_mallocz(s->tab_count * sizeof(uint32_t));
+    s->lines = av_calloc(line_count, sizeof(TextLine));
+    s->tab_clusters = av_calloc(s->tab_count, sizeof(uint32_t));
+    if (!s->lines || (s->tab_count && !s->tab_clusters)) {
+        ret = AVERROR(ENOMEM);
+        goto done;
+    }
     for (i = 0; i < s->tab_count; ++i) {
         s->tab_clusters[i] = -1;
     }
@@ -1464,6 +1548,11 @@ continue_on_failed2:
             if (ret != 0) {
                 goto done;
             }
+            cur_line->glyphs = av_calloc(hb->glyph_count, sizeof(GlyphInfo));
+            if (hb->glyph_count && !cur_line->glyphs) {
+                ret = AVERROR(ENOMEM);
+                goto done;
+            }
             w64 = 0;
             cur_min_y64 = 32000;
             for (int t = 0; t < hb->glyph_count; ++t) {
@@ -1566,14 +1655,10 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
     struct tm ltime;
     AVBPrint *bp = &s->expanded_text;
 
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
+    ThreadData td;
 
     int width = frame->width;
     int height = frame->height;
-    int rec_x = 0, rec_y = 0, rec_width = 0, rec_height = 0;
     int is_outside = 0;
     int last_tab_idx = 0;
 
@@ -1626,8 +1711,23 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
         return ret;
     }
 
-    if ((ret = measure_text(ctx, &metrics)) < 0) {
-        return ret;
+    /* the text is shaped and measured again only when it changes */
+    if (!s->lines || s->layout_fontsize != s->fontsize ||
+        strcmp(s->layout_text, bp->str)) {
+        free_layout(s);
+        if ((ret = measure_text(ctx, &metrics)) < 0) {
+            free_layout(s);
+            return ret;
+        }
+        s->layout_text = av_strdup(bp->str);
+        if (!s->layout_text) {
+            free_layout(s);
+            return AVERROR(ENOMEM);
+        }
+        s->layout_fontsize = s->fontsize;
+        s->layout_metrics = metrics;
+    } else {
+        metrics = s->layout_metrics;
     }
 
     s->max_glyph_h = POS_CEIL(metrics.max_y64 - metrics.min_y64, 64);
@@ -1658,10 +1758,10 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
     }
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
     if (s->draw_box && s->boxborderw) {
         int bbsize[4];
@@ -1719,45 +1819,51 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
         y64 = (int)(s->y * 64. + metrics.offset_top64);
     }
 
-    for (int l = 0; l < s->line_count; ++l) {
-        TextLine *line = &s->lines[l];
-        HarfbuzzData *hb = &line->hb_data;
-        line->glyphs = av_mallocz(hb->glyph_count * sizeof(GlyphInfo));
-
-        for (int t = 0; t < hb->glyph_count; ++t) {
-            GlyphInfo *g_info = &line->glyphs[t];
-            uint8_t is_tab = last_tab_idx < s->tab_count &&
-                hb->glyph_info[t].cluster == s->tab_clusters[last_tab_idx] - line->cluster_offset;
-            int true_x, true_y;
-            if (is_tab) {
-                ++last_tab_idx;
-            }
-            true_x = x + hb->glyph_pos[t].x_offset;
-            true_y = y + hb->glyph_pos[t].y_offset;
-            shift_x64 = (((x64 + true_x) >> 4) & 0b0011) << 4;
-            shift_y64 = ((4 - (((y64 + true_y) >> 4) & 0b0011)) & 0b0011) << 4;
+    /* the glyphs only need to be positioned again when the text moves */
+    if (!s->layout_positioned || x64 != s->layout_x64 || y64 != s->layout_y64) {
+        for (int l = 0; l < s->line_count; ++l) {
+            TextLine *line = &s->lines[l];
+            HarfbuzzData *hb = &line->hb_data;
 
-            ret = load_glyph(ctx, &glyph, hb->glyph_info[t].codepoint, shift_x64, shift_y64);
-            if (ret != 0) {
-                return ret;
-            }
-            g_info->code = hb->glyph_info[t].codepoint;
-            g_info->x = (x64 + true_x) >> 6;
-            g_info->y = ((y64 + true_y) >> 6) + (shift_y64 > 0 ? 1 : 0);
-            g_info->shift_x64 = shift_x64;
-            g_info->shift_y64 = shift_y64;
-
-            if (!is_tab) {
-                x += hb->glyph_pos[t].x_advance;
-            } else {
-                int size = s->blank_advance64 * s->tabsize;
-                x = (x / size + 1) * size;
+            for (int t = 0; t < hb->glyph_count; ++t) {
+                GlyphInfo *g_info = &line->glyphs[t];
+                uint8_t is_tab = last_tab_idx < s->tab_count &&
+                    hb->glyph_info[t].cluster == s->tab_clusters[last_tab_idx] - line->cluster_offset;
+                int true_x, true_y;
+                if (is_tab) {
+                    ++last_tab_idx;
+                }
+                true_x = x + hb->glyph_pos[t].x_offset;
+                true_y = y + hb->glyph_pos[t].y_offset;
+                shift_x64 = (((x64 + true_x) >> 4) & 0b0011) << 4;
+                shift_y64 = ((4 - (((y64 + true_y) >> 4) & 0b0011)) & 0b0011) << 4;
+
+                ret = load_glyph(ctx, &glyph, hb->glyph_info[t].codepoint, shift_x64, shift_y64);
+                if (ret != 0) {
+                    return ret;
+                }
+                g_info->code = hb->glyph_info[t].codepoint;
+                g_info->glyph = glyph;
+                g_info->x = (x64 + true_x) >> 6;
+                g_info->y = ((y64 + true_y) >> 6) + (shift_y64 > 0 ? 1 : 0);
+                g_info->shift_x64 = shift_x64;
+                g_info->shift_y64 = shift_y64;
+
+                if (!is_tab) {
+                    x += hb->glyph_pos[t].x_advance;
+                } else {
+                    int size = s->blank_advance64 * s->tabsize;
+                    x = (x / size + 1) * size;
+                }
+                y += hb->glyph_pos[t].y_advance;
             }
-            y += hb->glyph_pos[t].y_advance;
-        }
 
-        y += metrics.line_height64 + s->line_spacing * 64;
-        x = 0;
+            y += metrics.line_height64 + s->line_spacing * 64;
+            x = 0;
+        }
+        s->layout_x64 = x64;
+        s->layout_y64 = y64;
+        s->layout_positioned = 1;
     }
 
     metrics.rect_x = s->x;
@@ -1787,45 +1893,23 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
                     metrics.rect_y + s->box_height + s->bb_bottom <= 0;
 
     if (!is_outside) {
-        /* draw box */
-        if (s->draw_box) {
-            rec_x = metrics.rect_x - s->bb_left;
-            rec_y = metrics.rect_y - s->bb_top;
-            rec_width = s->box_width + s->bb_right + s->bb_left;
-            rec_height = s->box_height + s->bb_bottom + s->bb_top;
-            ff_blend_rectangle(&s->dc, &boxcolor,
-                frame->data, frame->linesize, width, height,
-                rec_x, rec_y, rec_width, rec_height);
-        }
+        int j_left  = !!(s->text_align & TA_LEFT);
+        int j_right = !!(s->text_align & TA_RIGHT);
 
-        if (s->shadowx || s->shadowy) {
-            if ((ret = draw_glyphs(s, frame, &shadowcolor, &metrics,
-                    s->shadowx, s->shadowy, s->borderw)) < 0) {
-                return ret;
-            }
+        if ((!j_left || j_right) && !s->tab_warning_printed && s->tab_count > 0) {
+            s->tab_warning_printed = 1;
+            av_log(s, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
         }
 
-        if (s->borderw) {
-            if ((ret = draw_glyphs(s, frame, &bordercolor, &metrics,
-                    0, 0, s->borderw)) < 0) {
-                return ret;
-            }
-        }
-
-        if ((ret = draw_glyphs(s, frame, &fontcolor, &metrics, 0,
-                0, 0)) < 0) {
-            return ret;
-        }
-    }
-
-    // FREE data structures
-    for (int l = 0; l < s->line_count; ++l) {
-        TextLine *line = &s->lines[l];
-        av_freep(&line->glyphs);
-        hb_destroy(&line->hb_data);
+        td.frame   = frame;
+        td.metrics = &metrics;
+        td.y0 = FFMAX(metrics.rect_y - s->bb_top, 0) & ~((1 << s->dc.vsub_max) - 1);
+        td.y1 = FFMIN(metrics.rect_y + s->box_height + s->bb_bottom, height);
+        if (td.y1 > td.y0)
+            ff_filter_execute(ctx, draw_text_slice, &td, NULL,
+                              FFMIN(AV_CEIL_RSHIFT(td.y1 - td.y0, s->dc.vsub_max),
+                                    ff_filter_get_nb_threads(ctx)));
     }
-    av_freep(&s->lines);
-    av_freep(&s->tab_clusters);
 
     return 0;
 }
@@ -1920,5 +2004,6 @@ const AVFilter ff_vf_drawtext = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC2(query_formats),
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -38,7 +38,7 @@
 #include "video.h"
 #include "filters.h"
 #include "framerate.h"
-#include "scene_sad.h"
+#include "scene.h"
 
 #define OFFSET(x) offsetof(FrameRateContext, x)
 #define V AV_OPT_FLAG_VIDEO_PARAM
@@ -70,12 +70,11 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *crnt, AVFrame *next
 
     if (crnt->height == next->height &&
         crnt->width  == next->width) {
-        uint64_t sad;
         double mafd, diff;
 
         ff_dlog(ctx, "get_scene_score() process\n");
-        s->sad(crnt->data[0], crnt->linesize[0], next->data[0], next->linesize[0], crnt->width, crnt->height, &sad);
-        mafd = (double)sad * 100.0 / (crnt->width * crnt->height) / (1 << s->bitdepth);
+        if (ff_scene_frame_mafd(ctx, &s->scene, crnt, next, &mafd) <= 0)
+            return 0;
         diff = fabs(mafd - s->prev_mafd);
         ret  = av_clipf(FFMIN(mafd, diff), 0, 100.0);
         s->prev_mafd = mafd;
@@ -213,6 +212,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     FrameRateContext *s = ctx->priv;
     av_frame_free(&s->f0);
     av_frame_free(&s->f1);
+    ff_scene_uninit(&s->scene);
 }
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -272,7 +272,7 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     FrameRateContext *s = ctx->priv;
     const AVPixFmtDescriptor *pix_desc = av_pix_fmt_desc_get(inlink->format);
-    int plane;
+    int plane, ret;
 
     s->vsub = pix_desc->log2_chroma_h;
     for (plane = 0; plane < 4; plane++) {
@@ -282,9 +282,9 @@ static int config_input(AVFilterLink *inlink)
 
     s->bitdepth = pix_desc->comp[0].depth;
 
-    s->sad = ff_scene_sad_get_fn(s->bitdepth == 8 ? 8 : 16);
-    if (!s->sad)
-        return AVERROR(EINVAL);
+    ret = ff_scene_init(&s->scene, inlink->format, inlink->w, inlink->h, 1);
+    if (ret < 0)
+        return ret;
 
     s->srce_time_base = inlink->time_base;
 
@@ -22,6 +22,7 @@
  */
 
 #include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/timestamp.h"
@@ -38,6 +39,8 @@ typedef struct FreezeDetectContext {
     ptrdiff_t height[4];
     ff_scene_sad_fn sad;
     int bitdepth;
+    int nb_threads;
+    uint64_t *job_sad;
     AVFrame *reference_frame;
     int64_t n;
     int64_t reference_n;
@@ -45,8 +48,13 @@ typedef struct FreezeDetectContext {
 
     double noise;
     int64_t duration;            ///< minimum duration of frozen frame until notification
+    int step;                    ///< analyse one line out of step
 } FreezeDetectContext;
 
+typedef struct ThreadData {
+    const AVFrame *reference, *frame;
+} ThreadData;
+
 #define OFFSET(x) offsetof(FreezeDetectContext, x)
 #define V AV_OPT_FLAG_VIDEO_PARAM
 #define F AV_OPT_FLAG_FILTERING_PARAM
@@ -56,6 +64,7 @@ static const AVOption freezedetect_options[] = {
     { "noise",               "set noise tolerance",                       OFFSET(noise),  AV_OPT_TYPE_DOUBLE,   {.dbl=0.001},     0,       1.0, V|F },
     { "d",                   "set minimum duration in seconds",        OFFSET(duration),  AV_OPT_TYPE_DURATION, {.i64=2000000},   0, INT64_MAX, V|F },
     { "duration",            "set minimum duration in seconds",        OFFSET(duration),  AV_OPT_TYPE_DURATION, {.i64=2000000},   0, INT64_MAX, V|F },
+    { "step",                "set the step between the analysed lines", OFFSET(step),     AV_OPT_TYPE_INT,      {.i64=1},         1,        16, V|F },
 
     {NULL}
 };
@@ -107,6 +116,11 @@ static int config_input(AVFilterLink *inlink)
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->job_sad = av_calloc(s->nb_threads, sizeof(*s->job_sad));
+    if (!s->job_sad)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -114,23 +128,54 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     FreezeDetectContext *s = ctx->priv;
     av_frame_free(&s->reference_frame);
+    av_freep(&s->job_sad);
 }
 
-static int is_frozen(FreezeDetectContext *s, AVFrame *reference, AVFrame *frame)
+static int sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    FreezeDetectContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const AVFrame *reference = td->reference, *frame = td->frame;
     uint64_t sad = 0;
-    uint64_t count = 0;
-    double mafd;
+
     for (int plane = 0; plane < 4; plane++) {
-        if (s->width[plane]) {
-            uint64_t plane_sad;
-            s->sad(frame->data[plane], frame->linesize[plane],
-                   reference->data[plane], reference->linesize[plane],
-                   s->width[plane], s->height[plane], &plane_sad);
-            sad += plane_sad;
-            count += s->width[plane] * s->height[plane];
-        }
+        const int lines = (s->height[plane] + s->step - 1) / s->step;
+        const int start = (lines * jobnr) / nb_jobs;
+        const int end = (lines * (jobnr+1)) / nb_jobs;
+        const ptrdiff_t linesize = frame->linesize[plane];
+        const ptrdiff_t ref_linesize = reference->linesize[plane];
+        uint64_t plane_sad;
+
+        if (!s->width[plane] || start >= end)
+            continue;
+
+        s->sad(frame->data[plane] + start * s->step * linesize, linesize * s->step,
+               reference->data[plane] + start * s->step * ref_linesize, ref_linesize * s->step,
+               s->width[plane], end - start, &plane_sad);
+        sad += plane_sad;
     }
+
+    s->job_sad[jobnr] = sad;
+
+    return 0;
+}
+
+static int is_frozen(AVFilterContext *ctx, AVFrame *reference, AVFrame *frame)
+{
+    FreezeDetectContext *s = ctx->priv;
+    const int nb_jobs = FFMAX(1, FFMIN((s->height[0] + s->step - 1) / s->step, s->nb_threads));
+    ThreadData td = { .reference = reference, .frame = frame };
+    uint64_t sad = 0;
+    uint64_t count = 0;
+    double mafd;
+
+    ff_filter_execute(ctx, sad_slice, &td, NULL, nb_jobs);
+
+    for (int i = 0; i < nb_jobs; i++)
+        sad += s->job_sad[i];
+    for (int plane = 0; plane < 4; plane++)
+        count += s->width[plane] * ((s->height[plane] + s->step - 1) / s->step);
+
     mafd = (double)sad / count / (1ULL << s->bitdepth);
     return (mafd <= s->noise);
 }
@@ -167,7 +212,7 @@ static int activate(AVFilterContext *ctx)
             else
                 duration = av_rescale_q(frame->pts - s->reference_frame->pts, inlink->time_base, AV_TIME_BASE_Q);
 
-            frozen = is_frozen(s, s->reference_frame, frame);
+            frozen = is_frozen(ctx, s->reference_frame, frame);
             if (duration >= s->duration) {
                 if (!s->frozen)
                     set_meta(s, frame, "lavfi.freezedetect.freeze_start", av_ts2timestr(s->reference_frame->pts, &inlink->time_base));
@@ -211,7 +256,7 @@ const AVFilter ff_vf_freezedetect = {
     .priv_size     = sizeof(FreezeDetectContext),
     .priv_class    = &freezedetect_class,
     .uninit        = uninit,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_METADATA_ONLY | AVFILTER_FLAG_SLICE_THREADS,
     FILTER_INPUTS(freezedetect_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
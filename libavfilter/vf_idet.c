@@ -21,6 +21,7 @@
 #include <float.h> /* FLT_MAX */
 
 #include "libavutil/common.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "filters.h"
 #include "vf_idet.h"
@@ -34,6 +35,7 @@ static const AVOption idet_options[] = {
     { "rep_thres",  "set repeat threshold",      OFFSET(repeat_threshold),      AV_OPT_TYPE_FLOAT, {.dbl = 3.0},  -1, FLT_MAX, FLAGS },
     { "half_life", "half life of cumulative statistics", OFFSET(half_life),     AV_OPT_TYPE_FLOAT, {.dbl = 0.0},  -1, INT_MAX, FLAGS },
     { "analyze_interlaced_flag", "set number of frames to use to determine if the interlace flag is accurate", OFFSET(analyze_interlaced_flag), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "step", "set the step between the analysed pairs of lines", OFFSET(step), AV_OPT_TYPE_INT, {.i64 = 1 }, 1, 16, FLAGS },
     { NULL }
 };
 
@@ -109,32 +111,37 @@ int ff_idet_filter_line_c_16bit(const uint16_t *a, const uint16_t *b, const uint
     return ret;
 }
 
-static void filter(AVFilterContext *ctx)
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     IDETContext *idet = ctx->priv;
-    int y, i;
+    IDETSums *sums = &idet->job_sums[jobnr];
     int64_t alpha[2]={0};
     int64_t delta=0;
     int64_t gamma[2]={0};
-    Type type, best_type;
-    RepeatedField repeat;
-    int match = 0;
-    AVDictionary **metadata = &idet->cur->metadata;
 
-    for (i = 0; i < idet->csp->nb_components; i++) {
+    for (int i = 0; i < idet->csp->nb_components; i++) {
         int w = idet->cur->width;
         int h = idet->cur->height;
         int refs = idet->cur->linesize[i];
+        int start, end;
 
         if (i && i<3) {
             w = AV_CEIL_RSHIFT(w, idet->csp->log2_chroma_w);
             h = AV_CEIL_RSHIFT(h, idet->csp->log2_chroma_h);
         }
 
-        for (y = 2; y < h - 2; y++) {
+        start = 2 + (FFMAX(h - 4, 0) *  jobnr   ) / nb_jobs;
+        end   = 2 + (FFMAX(h - 4, 0) * (jobnr+1)) / nb_jobs;
+
+        for (int y = start; y < end; y++) {
             uint8_t *prev = &idet->prev->data[i][y*refs];
             uint8_t *cur  = &idet->cur ->data[i][y*refs];
             uint8_t *next = &idet->next->data[i][y*refs];
+
+            // both lines of a pair are analysed, to compare the fields
+            if (((y >> 1) - 1) % idet->step)
+                continue;
+
             alpha[ y   &1] += idet->filter_line(cur-refs, prev, cur+refs, w);
             alpha[(y^1)&1] += idet->filter_line(cur-refs, next, cur+refs, w);
             delta          += idet->filter_line(cur-refs,  cur, cur+refs, w);
@@ -142,6 +149,38 @@ static void filter(AVFilterContext *ctx)
         }
     }
 
+    sums->alpha[0] = alpha[0];
+    sums->alpha[1] = alpha[1];
+    sums->delta    = delta;
+    sums->gamma[0] = gamma[0];
+    sums->gamma[1] = gamma[1];
+
+    return 0;
+}
+
+static void filter(AVFilterContext *ctx)
+{
+    IDETContext *idet = ctx->priv;
+    const int nb_jobs = FFMIN(FFMAX(idet->cur->height - 4, 1), idet->nb_threads);
+    int i;
+    int64_t alpha[2]={0};
+    int64_t delta=0;
+    int64_t gamma[2]={0};
+    Type type, best_type;
+    RepeatedField repeat;
+    int match = 0;
+    AVDictionary **metadata = &idet->cur->metadata;
+
+    ff_filter_execute(ctx, filter_slice, NULL, NULL, nb_jobs);
+
+    for (i = 0; i < nb_jobs; i++) {
+        alpha[0] += idet->job_sums[i].alpha[0];
+        alpha[1] += idet->job_sums[i].alpha[1];
+        delta    += idet->job_sums[i].delta;
+        gamma[0] += idet->job_sums[i].gamma[0];
+        gamma[1] += idet->job_sums[i].gamma[1];
+    }
+
     if      (alpha[0] > idet->interlace_threshold * alpha[1]){
         type = TFF;
     }else if(alpha[1] > idet->interlace_threshold * alpha[0]){
@@ -391,6 +430,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&idet->prev);
     av_frame_free(&idet->cur );
     av_frame_free(&idet->next);
+    av_freep(&idet->job_sums);
 }
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -449,10 +489,25 @@ static av_cold int init(AVFilterContext *ctx)
     return 0;
 }
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    IDETContext *idet = ctx->priv;
+
+    idet->nb_threads = ff_filter_get_nb_threads(ctx);
+    av_freep(&idet->job_sums);
+    idet->job_sums = av_calloc(idet->nb_threads, sizeof(*idet->job_sums));
+    if (!idet->job_sums)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
 static const AVFilterPad idet_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
 };
@@ -471,7 +526,7 @@ const AVFilter ff_vf_idet = {
     .priv_size     = sizeof(IDETContext),
     .init          = init,
     .uninit        = uninit,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_METADATA_ONLY | AVFILTER_FLAG_SLICE_THREADS,
     FILTER_INPUTS(idet_inputs),
     FILTER_OUTPUTS(idet_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
@@ -39,6 +39,12 @@ typedef enum {
     REPEAT_BOTTOM,
 } RepeatedField;
 
+typedef struct IDETSums {
+    int64_t alpha[2];
+    int64_t delta;
+    int64_t gamma[2];
+} IDETSums;
+
 typedef struct IDETContext {
     const AVClass *class;
     float interlace_threshold;
@@ -67,6 +73,10 @@ typedef struct IDETContext {
     int analyze_interlaced_flag;
     int analyze_interlaced_flag_done;
 
+    int step;
+    int nb_threads;
+    IDETSums *job_sums;
+
     const AVPixFmtDescriptor *csp;
     int eof;
 } IDETContext;
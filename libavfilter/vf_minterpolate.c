@@ -28,7 +28,7 @@
 #include "avfilter.h"
 #include "filters.h"
 #include "video.h"
-#include "scene_sad.h"
+#include "scene.h"
 
 #define ME_MODE_BIDIR 0
 #define ME_MODE_BILAT 1
@@ -159,11 +159,13 @@ typedef struct PixelRefs {
 typedef struct Frame {
     AVFrame *avf;
     Block *blocks;
+    uint8_t *lowres;    ///< luma at half resolution, for me_lowres
 } Frame;
 
 typedef struct MIContext {
     const AVClass *class;
     AVMotionEstContext me_ctx;
+    AVMotionEstContext me_ctx_lowres;
     AVRational frame_rate;
     enum MIMode mi_mode;
     int mc_mode;
@@ -172,6 +174,7 @@ typedef struct MIContext {
     int mb_size;
     int search_param;
     int vsbmc;
+    int me_lowres;
 
     Frame frames[NB_FRAMES];
     Cluster clusters[NB_CLUSTERS];
@@ -187,15 +190,26 @@ typedef struct MIContext {
 
     int scd_method;
     int scene_changed;
-    ff_scene_sad_fn sad;
+    FFSceneContext scene;
     double prev_mafd;
     double scd_threshold;
 
     int log2_chroma_w;
     int log2_chroma_h;
     int nb_planes;
+    int lowres_linesize;
 } MIContext;
 
+typedef struct ThreadData {
+    AVMotionEstContext *me_ctx;
+    Block *blocks;
+    int dir;
+    int line;           ///< anti-diagonal of blocks searched, -1 for the whole frame
+    int last_pred[2];   ///< predictor of the last block, left in the context
+    AVFrame *out;
+    int alpha;
+} ThreadData;
+
 #define OFFSET(x) offsetof(MIContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 #define CONST(name, help, val, u) { name, help, 0, AV_OPT_TYPE_CONST, {.i64=val}, 0, 0, FLAGS, .unit = u }
@@ -225,6 +239,7 @@ static const AVOption minterpolate_options[] = {
     { "mb_size", "macroblock size", OFFSET(mb_size), AV_OPT_TYPE_INT, {.i64 = 16}, 4, 16, FLAGS },
     { "search_param", "search parameter", OFFSET(search_param), AV_OPT_TYPE_INT, {.i64 = 32}, 4, INT_MAX, FLAGS },
     { "vsbmc", "variable-size block motion compensation", OFFSET(vsbmc), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1, FLAGS },
+    { "me_lowres", "estimate the motion at half resolution", OFFSET(me_lowres), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
     { "scd", "scene change detection method", OFFSET(scd_method), AV_OPT_TYPE_INT, {.i64 = SCD_METHOD_FDIFF}, SCD_METHOD_NONE, SCD_METHOD_FDIFF, FLAGS, .unit = "scene" },
         CONST("none",   "disable detection",                    SCD_METHOD_NONE,        "scene"),
         CONST("fdiff",  "frame difference",                     SCD_METHOD_FDIFF,       "scene"),
@@ -248,77 +263,73 @@ static const enum AVPixelFormat pix_fmts[] = {
 
 static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int y_mv)
 {
-    uint8_t *data_cur = me_ctx->data_cur;
-    uint8_t *data_next = me_ctx->data_ref;
-    int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - me_ctx->x_min, me_ctx->x_max - x), FFMIN(x - me_ctx->x_min, me_ctx->x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - me_ctx->y_min, me_ctx->y_max - y), FFMIN(y - me_ctx->y_min, me_ctx->y_max - y));
 
-    data_cur += (y + mv_y) * linesize;
-    data_next += (y - mv_y) * linesize;
-
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_block_sad(me_ctx, av_log2(me_ctx->mb_size),
+                           me_ctx->data_cur, x + mv_x, y + mv_y,
+                           me_ctx->data_ref, x - mv_x, y - mv_y);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
 
+/* the overlapped blocks are twice as large as the blocks, except for the
+ * single pixel blocks of variable-size block motion compensation */
+static int log2_ob_size(const AVMotionEstContext *me_ctx)
+{
+    return av_log2(me_ctx->mb_size) + (me_ctx->mb_size > 1);
+}
+
 static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int y_mv)
 {
-    uint8_t *data_cur = me_ctx->data_cur;
-    uint8_t *data_next = me_ctx->data_ref;
-    int linesize = me_ctx->linesize;
     int x_min = me_ctx->x_min + me_ctx->mb_size / 2;
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    x -= me_ctx->mb_size / 2;
+    y -= me_ctx->mb_size / 2;
+    sbad = ff_me_block_sad(me_ctx, log2_ob_size(me_ctx),
+                           me_ctx->data_cur, x + mv_x, y + mv_y,
+                           me_ctx->data_ref, x - mv_x, y - mv_y);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
 
 static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int y_mv)
 {
-    uint8_t *data_ref = me_ctx->data_ref;
-    uint8_t *data_cur = me_ctx->data_cur;
-    int linesize = me_ctx->linesize;
     int x_min = me_ctx->x_min + me_ctx->mb_size / 2;
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = ff_me_block_sad(me_ctx, log2_ob_size(me_ctx),
+                          me_ctx->data_ref, x_mv - me_ctx->mb_size / 2, y_mv - me_ctx->mb_size / 2,
+                          me_ctx->data_cur, x    - me_ctx->mb_size / 2, y    - me_ctx->mb_size / 2);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -367,6 +378,23 @@ static int config_input(AVFilterLink *inlink)
         else if (mi_ctx->me_mode == ME_MODE_BILAT)
             me_ctx->get_cost = &get_sbad_ob;
 
+        if (mi_ctx->me_lowres) {
+            AVMotionEstContext *me_lowres = &mi_ctx->me_ctx_lowres;
+
+            ff_me_init_context(me_lowres, mi_ctx->mb_size / 2, FFMAX(mi_ctx->search_param / 2, 1),
+                               width / 2, height / 2, 0, (mi_ctx->b_width - 1) << (mi_ctx->log2_mb_size - 1),
+                               0, (mi_ctx->b_height - 1) << (mi_ctx->log2_mb_size - 1));
+            me_lowres->get_cost = me_ctx->get_cost;
+
+            mi_ctx->lowres_linesize = FFALIGN(width / 2, 32);
+            for (i = 0; i < NB_FRAMES; i++) {
+                Frame *frame = &mi_ctx->frames[i];
+                frame->lowres = av_malloc(mi_ctx->lowres_linesize * (height / 2));
+                if (!frame->lowres)
+                    return AVERROR(ENOMEM);
+            }
+        }
+
         mi_ctx->pixel_mvs     = av_calloc(width * height, sizeof(*mi_ctx->pixel_mvs));
         mi_ctx->pixel_weights = av_calloc(width * height, sizeof(*mi_ctx->pixel_weights));
         mi_ctx->pixel_refs    = av_calloc(width * height, sizeof(*mi_ctx->pixel_refs));
@@ -386,11 +414,8 @@ static int config_input(AVFilterLink *inlink)
         }
     }
 
-    if (mi_ctx->scd_method == SCD_METHOD_FDIFF) {
-        mi_ctx->sad = ff_scene_sad_get_fn(mi_ctx->bitdepth == 8 ? 8 : 16);
-        if (!mi_ctx->sad)
-            return AVERROR(EINVAL);
-    }
+    if (mi_ctx->scd_method == SCD_METHOD_FDIFF)
+        return ff_scene_init(&mi_ctx->scene, inlink->format, width, height, 1);
 
     return 0;
 }
@@ -413,14 +438,13 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx, Block *blocks, int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
-    const int x_mb = mb_x << mi_ctx->log2_mb_size;
-    const int y_mb = mb_y << mi_ctx->log2_mb_size;
+    const int x_mb = mb_x * me_ctx->mb_size;
+    const int y_mb = mb_y * me_ctx->mb_size;
     const int mb_i = mb_x + mb_y * mi_ctx->b_width;
     int mv[2] = {x_mb, y_mb};
 
@@ -555,8 +579,154 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext me_ctx = *td->me_ctx;
+    const int b_width  = mi_ctx->b_width;
+    const int b_height = mi_ctx->b_height;
+    int mb_x, mb_y;
+
+    if (td->line < 0) {
+        const int slice_start = (b_height * jobnr) / nb_jobs;
+        const int slice_end   = (b_height * (jobnr + 1)) / nb_jobs;
+
+        for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+            for (mb_x = 0; mb_x < b_width; mb_x++)
+                search_mv(mi_ctx, &me_ctx, td->blocks, mb_x, mb_y, td->dir);
+    } else {
+        const int y_min = FFMAX(0, (td->line - b_width + 2) / 2);
+        const int y_max = FFMIN(b_height - 1, td->line / 2);
+        const int slice_start = y_min + ((y_max - y_min + 1) * jobnr) / nb_jobs;
+        const int slice_end   = y_min + ((y_max - y_min + 1) * (jobnr + 1)) / nb_jobs;
+
+        for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+            search_mv(mi_ctx, &me_ctx, td->blocks, td->line - 2 * mb_y, mb_y, td->dir);
+    }
+
+    /* the predictor of the last block is left in the context, as when
+     * the blocks are searched in raster order */
+    if (jobnr == nb_jobs - 1 && (td->line < 0 || td->line == b_width + 2 * b_height - 3)) {
+        td->last_pred[0] = me_ctx.pred_x;
+        td->last_pred[1] = me_ctx.pred_y;
+    }
+
+    return 0;
+}
+
+static void search_mvs(AVFilterContext *ctx, AVMotionEstContext *me_ctx, Block *blocks, int dir)
+{
+    MIContext *mi_ctx = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    ThreadData td = { .me_ctx = me_ctx, .blocks = blocks, .dir = dir, .line = -1 };
+
+    /* the predictive methods use the vectors of the left, top and top-right
+     * blocks: the anti-diagonals mb_x + 2 * mb_y are searched one after the
+     * other, so that the vectors do not depend on the number of threads */
+    if (nb_threads > 1 && (mi_ctx->me_method == AV_ME_METHOD_EPZS ||
+                           mi_ctx->me_method == AV_ME_METHOD_UMH)) {
+        const int nb_lines = mi_ctx->b_width + 2 * mi_ctx->b_height - 2;
+
+        for (td.line = 0; td.line < nb_lines; td.line++) {
+            const int nb_rows = FFMIN(mi_ctx->b_height - 1, td.line / 2) -
+                                FFMAX(0, (td.line - mi_ctx->b_width + 2) / 2) + 1;
+            ff_filter_execute(ctx, search_mv_slice, &td, NULL, FFMIN(nb_rows, nb_threads));
+        }
+    } else {
+        ff_filter_execute(ctx, search_mv_slice, &td, NULL, FFMIN(mi_ctx->b_height, nb_threads));
+    }
+
+    me_ctx->pred_x = td.last_pred[0];
+    me_ctx->pred_y = td.last_pred[1];
+}
+
+/* refine at full resolution the vectors found at half resolution */
+static int refine_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext me_ctx = *td->me_ctx;
+    const int slice_start = (mi_ctx->b_height * jobnr) / nb_jobs;
+    const int slice_end   = (mi_ctx->b_height * (jobnr + 1)) / nb_jobs;
+    int mb_x, mb_y;
+
+    me_ctx.preds[0].nb = 0;
+    me_ctx.preds[1].nb = 0;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+            Block *block = &td->blocks[mb_x + mb_y * mi_ctx->b_width];
+            const int x_mb = mb_x << mi_ctx->log2_mb_size;
+            const int y_mb = mb_y << mi_ctx->log2_mb_size;
+            int mv[2] = {x_mb, y_mb};
+
+            me_ctx.pred_x = block->mvs[td->dir][0] * 2;
+            me_ctx.pred_y = block->mvs[td->dir][1] * 2;
+            ff_me_search_epzs(&me_ctx, x_mb, y_mb, mv);
+
+            block->mvs[td->dir][0] = mv[0] - x_mb;
+            block->mvs[td->dir][1] = mv[1] - y_mb;
+        }
+
+    if (jobnr == nb_jobs - 1) {
+        td->last_pred[0] = me_ctx.pred_x;
+        td->last_pred[1] = me_ctx.pred_y;
+    }
+
+    return 0;
+}
+
+static void estimate_motion(AVFilterContext *ctx, Block *blocks, int dir)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td = { .me_ctx = &mi_ctx->me_ctx, .blocks = blocks, .dir = dir };
+
+    if (!mi_ctx->me_lowres) {
+        search_mvs(ctx, &mi_ctx->me_ctx, blocks, dir);
+        return;
+    }
+
+    search_mvs(ctx, &mi_ctx->me_ctx_lowres, blocks, dir);
+    ff_filter_execute(ctx, refine_mv_slice, &td, NULL,
+                      FFMIN(mi_ctx->b_height, ff_filter_get_nb_threads(ctx)));
+
+    mi_ctx->me_ctx.pred_x = td.last_pred[0];
+    mi_ctx->me_ctx.pred_y = td.last_pred[1];
+}
+
+static void set_me_frames(MIContext *mi_ctx, const Frame *cur, const Frame *ref)
+{
+    mi_ctx->me_ctx.linesize = cur->avf->linesize[0];
+    mi_ctx->me_ctx.data_cur = cur->avf->data[0];
+    mi_ctx->me_ctx.data_ref = ref->avf->data[0];
+
+    if (mi_ctx->me_lowres) {
+        mi_ctx->me_ctx_lowres.linesize = mi_ctx->lowres_linesize;
+        mi_ctx->me_ctx_lowres.data_cur = cur->lowres;
+        mi_ctx->me_ctx_lowres.data_ref = ref->lowres;
+    }
+}
+
+static void downscale_luma(MIContext *mi_ctx, Frame *frame)
+{
+    const AVFrame *avf = frame->avf;
+    const ptrdiff_t linesize = avf->linesize[0];
+    int x, y;
+
+    for (y = 0; y < avf->height / 2; y++) {
+        const uint8_t *src = avf->data[0] + 2 * y * linesize;
+        uint8_t *dst = frame->lowres + y * mi_ctx->lowres_linesize;
+
+        for (x = 0; x < avf->width / 2; x++)
+            dst[x] = (src[2 * x] + src[2 * x + 1] +
+                      src[2 * x + linesize] + src[2 * x + 1 + linesize] + 2) >> 2;
+    }
+}
+
+static void bilateral_me(AVFilterContext *ctx)
 {
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -571,9 +741,7 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    estimate_motion(ctx, mi_ctx->int_blocks, 0);
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -728,6 +896,25 @@ static int cluster_mvs(MIContext *mi_ctx)
     return 0;
 }
 
+static int sbad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    const int slice_start = (mi_ctx->b_height * jobnr) / nb_jobs;
+    const int slice_end   = (mi_ctx->b_height * (jobnr + 1)) / nb_jobs;
+    int mb_x, mb_y;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+            int x_mb = mb_x << mi_ctx->log2_mb_size;
+            int y_mb = mb_y << mi_ctx->log2_mb_size;
+            Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+            block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
+        }
+
+    return 0;
+}
+
 static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -743,6 +930,9 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
     if (mi_ctx->mi_mode == MI_MODE_MCI) {
 
+        if (mi_ctx->me_lowres)
+            downscale_luma(mi_ctx, &mi_ctx->frames[NB_FRAMES - 1]);
+
         if (mi_ctx->me_method == AV_ME_METHOD_EPZS) {
             mi_ctx->mv_table[2] = memcpy(mi_ctx->mv_table[2], mi_ctx->mv_table[1], sizeof(*mi_ctx->mv_table[1]) * mi_ctx->b_count);
             mi_ctx->mv_table[1] = memcpy(mi_ctx->mv_table[1], mi_ctx->mv_table[0], sizeof(*mi_ctx->mv_table[0]) * mi_ctx->b_count);
@@ -752,13 +942,8 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
             if (mi_ctx->frames[1].avf) {
                 for (dir = 0; dir < 2; dir++) {
-                    mi_ctx->me_ctx.linesize = mi_ctx->frames[2].avf->linesize[0];
-                    mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
-                    mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
-
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    set_me_frames(mi_ctx, &mi_ctx->frames[2], &mi_ctx->frames[dir ? 3 : 1]);
+                    estimate_motion(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -769,23 +954,12 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             if (!mi_ctx->frames[0].avf)
                 return 0;
 
-            mi_ctx->me_ctx.linesize = mi_ctx->frames[0].avf->linesize[0];
-            mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
-            mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
+            set_me_frames(mi_ctx, &mi_ctx->frames[1], &mi_ctx->frames[2]);
+            bilateral_me(ctx);
 
-            bilateral_me(mi_ctx);
-
-            if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        int x_mb = mb_x << mi_ctx->log2_mb_size;
-                        int y_mb = mb_y << mi_ctx->log2_mb_size;
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
-                    }
-            }
+            if (mi_ctx->mc_mode == MC_MODE_AOBMC)
+                ff_filter_execute(ctx, sbad_slice, NULL, NULL,
+                                  FFMIN(mi_ctx->b_height, ff_filter_get_nb_threads(ctx)));
 
             if (mi_ctx->vsbmc) {
 
@@ -817,17 +991,13 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 static int detect_scene_change(AVFilterContext *ctx)
 {
     MIContext *mi_ctx = ctx->priv;
-    AVFilterLink *input = ctx->inputs[0];
-    uint8_t *p1 = mi_ctx->frames[1].avf->data[0];
-    ptrdiff_t linesize1 = mi_ctx->frames[1].avf->linesize[0];
-    uint8_t *p2 = mi_ctx->frames[2].avf->data[0];
-    ptrdiff_t linesize2 = mi_ctx->frames[2].avf->linesize[0];
 
     if (mi_ctx->scd_method == SCD_METHOD_FDIFF) {
         double ret = 0, mafd, diff;
-        uint64_t sad;
-        mi_ctx->sad(p1, linesize1, p2, linesize2, input->w, input->h, &sad);
-        mafd = (double) sad * 100.0 / (input->h * input->w) / (1 << mi_ctx->bitdepth);
+
+        if (ff_scene_frame_mafd(ctx, &mi_ctx->scene, mi_ctx->frames[1].avf,
+                                mi_ctx->frames[2].avf, &mafd) <= 0)
+            return 0;
         diff = fabs(mafd - mi_ctx->prev_mafd);
         ret  = av_clipf(FFMIN(mafd, diff), 0, 100.0);
         mi_ctx->prev_mafd = mafd;
@@ -854,16 +1024,26 @@ static int detect_scene_change(AVFilterContext *ctx)
         pixel_refs->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void clear_pixel_refs(MIContext *mi_ctx, int y0, int y1)
+{
+    int width = mi_ctx->frames[0].avf->width;
+    int x, y;
+
+    for (y = y0; y < y1; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixel_refs[x + y * width].nb = 0;
+}
+
+/* the blocks are visited in the same order for every slice of rows
+ * [y0, y1), so that the pixels get their references in the same order */
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int y0, int y1)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixel_refs[x + y * width].nb = 0;
+    clear_pixel_refs(mi_ctx, y0, y1);
 
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
@@ -878,9 +1058,9 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2 + mv_y * a / ALPHA_MAX;
 
                 startc_x = av_clip(start_x, 0, width - 1);
-                startc_y = av_clip(start_y, 0, height - 1);
+                startc_y = av_clip(start_y, y0, y1);
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), y0, FFMIN(y1, height - 1));
 
                 if (dir) {
                     mv_x = -mv_x;
@@ -904,16 +1084,15 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out, int y0, int y1)
 {
     int x, y, plane;
 
     for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
         int width = avf_out->width;
-        int height = avf_out->height;
         int chroma = plane == 1 || plane == 2;
 
-        for (y = 0; y < height; y++)
+        for (y = y0; y < y1; y++)
             for (x = 0; x < width; x++) {
                 int x_mv, y_mv;
                 int weight_sum = 0;
@@ -962,7 +1141,7 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha, int y0, int y1)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -973,7 +1152,7 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha, y0, y1);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
@@ -982,7 +1161,9 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
                 int start_x = x_mb + (sb_x << (n - 1));
                 int start_y = y_mb + (sb_y << (n - 1));
                 int end_x = start_x + (1 << (n - 1));
-                int end_y = start_y + (1 << (n - 1));
+                int end_y = FFMIN(start_y + (1 << (n - 1)), y1);
+
+                start_y = FFMAX(start_y, y0);
 
                 for (y = start_y; y < end_y; y++)  {
                     int y_min = -y;
@@ -1001,7 +1182,7 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha, int y0, int y1)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1016,6 +1197,17 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     int start_x, start_y;
     int startc_x, startc_y, endc_x, endc_y;
 
+    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+
+    startc_x = av_clip(start_x, 0, width - 1);
+    startc_y = av_clip(start_y, y0, y1);
+    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
+    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), y0, FFMIN(y1, height - 1));
+
+    if (startc_y >= endc_y)
+        return;
+
     if (mi_ctx->mc_mode == MC_MODE_AOBMC)
         for (nb_y = FFMAX(0, mb_y - 1); nb_y < FFMIN(mb_y + 2, mi_ctx->b_height); nb_y++)
             for (nb_x = FFMAX(0, mb_x - 1); nb_x < FFMIN(mb_x + 2, mi_ctx->b_width); nb_x++) {
@@ -1026,14 +1218,6 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
                     sbads[nb_x - mb_x + 1 + (nb_y - mb_y + 1) * 3] = get_sbad(&mi_ctx->me_ctx, x_nb, y_nb, x_nb + block->mvs[0][0], y_nb + block->mvs[0][1]);
             }
 
-    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-
-    startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
-    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
-
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
         int y_max = height - y - 1;
@@ -1065,13 +1249,89 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *avf_out = td->out;
+    const AVFrame *prev = mi_ctx->frames[1].avf;
+    const AVFrame *next = mi_ctx->frames[2].avf;
+    const int alpha = td->alpha;
+    int x, y, plane;
+
+    for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
+        int width = avf_out->width;
+        int height = avf_out->height;
+        int slice_start, slice_end;
+
+        if (plane == 1 || plane == 2) {
+            width = AV_CEIL_RSHIFT(width, mi_ctx->log2_chroma_w);
+            height = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
+        }
+        slice_start = (height * jobnr) / nb_jobs;
+        slice_end   = (height * (jobnr + 1)) / nb_jobs;
+
+        for (y = slice_start; y < slice_end; y++) {
+            for (x = 0; x < width; x++) {
+                avf_out->data[plane][x + y * avf_out->linesize[plane]] =
+                    (alpha  * next->data[plane][x + y * next->linesize[plane]] +
+                     (ALPHA_MAX - alpha) * prev->data[plane][x + y * prev->linesize[plane]] + 512) >> 10;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* the slices start on a chroma row, set_frame_data() writes the chroma
+ * samples from the last luma row of their block */
+static int mc_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    const int height = td->out->height;
+    const int align = (1 << mi_ctx->log2_chroma_h) - 1;
+    const int slice_start = ((height * jobnr) / nb_jobs) & ~align;
+    const int slice_end   = jobnr == nb_jobs - 1 ? height : ((height * (jobnr + 1)) / nb_jobs) & ~align;
+    int mb_x, mb_y;
+
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, slice_start, slice_end);
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        clear_pixel_refs(mi_ctx, slice_start, slice_end);
+
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++) {
+            const int y_mb = mb_y << mi_ctx->log2_mb_size;
+
+            /* rows of blocks whose overlapped window misses the slice */
+            if (y_mb + mi_ctx->mb_size * 3 / 2 <= slice_start || y_mb - mi_ctx->mb_size / 2 >= slice_end)
+                continue;
+
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, y_mb, mi_ctx->log2_mb_size,
+                                 td->alpha, slice_start, slice_end);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, slice_start, slice_end);
+            }
+        }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, td->out, slice_start, slice_end);
+
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     MIContext *mi_ctx = ctx->priv;
-    int x, y;
-    int plane, alpha;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    ThreadData td;
+    int alpha;
     int64_t pts;
 
     pts = av_rescale(avf_out->pts, (int64_t) ALPHA_MAX * outlink->time_base.num * inlink->time_base.den,
@@ -1103,51 +1363,17 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 
             break;
         case MI_MODE_BLEND:
-            for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
-                int width = avf_out->width;
-                int height = avf_out->height;
-
-                if (plane == 1 || plane == 2) {
-                    width = AV_CEIL_RSHIFT(width, mi_ctx->log2_chroma_w);
-                    height = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
-                }
-
-                for (y = 0; y < height; y++) {
-                    for (x = 0; x < width; x++) {
-                        avf_out->data[plane][x + y * avf_out->linesize[plane]] =
-                            (alpha  * mi_ctx->frames[2].avf->data[plane][x + y * mi_ctx->frames[2].avf->linesize[plane]] +
-                             (ALPHA_MAX - alpha) * mi_ctx->frames[1].avf->data[plane][x + y * mi_ctx->frames[1].avf->linesize[plane]] + 512) >> 10;
-                    }
-                }
-            }
+            td.out   = avf_out;
+            td.alpha = alpha;
+            ff_filter_execute(ctx, blend_slice, &td, NULL,
+                              FFMIN(avf_out->height >> mi_ctx->log2_chroma_h, nb_threads));
 
             break;
         case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
-
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
-
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixel_refs[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+            td.out   = avf_out;
+            td.alpha = alpha;
+            ff_filter_execute(ctx, mc_slice, &td, NULL,
+                              FFMIN(avf_out->height >> mi_ctx->log2_chroma_h, nb_threads));
 
             break;
     }
@@ -1228,11 +1454,14 @@ static av_cold void uninit(AVFilterContext *ctx)
     for (i = 0; i < NB_FRAMES; i++) {
         Frame *frame = &mi_ctx->frames[i];
         av_freep(&frame->blocks);
+        av_freep(&frame->lowres);
         av_frame_free(&frame->avf);
     }
 
     for (i = 0; i < 3; i++)
         av_freep(&mi_ctx->mv_table[i]);
+
+    ff_scene_uninit(&mi_ctx->scene);
 }
 
 static const AVFilterPad minterpolate_inputs[] = {
@@ -1261,4 +1490,5 @@ const AVFilter ff_vf_minterpolate = {
     FILTER_INPUTS(minterpolate_inputs),
     FILTER_OUTPUTS(minterpolate_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
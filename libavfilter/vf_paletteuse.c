@@ -28,6 +28,7 @@
 #include "libavutil/file_open.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
 #include "avfilter.h"
@@ -36,6 +37,7 @@
 #include "framesync.h"
 #include "palette.h"
 #include "video.h"
+#include "vf_paletteuse_init.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -70,6 +72,10 @@ struct color_node {
 
 #define CACHE_SIZE (1<<15)
 
+/* up to this number of colors, the nearest color is searched exhaustively
+ * instead of in the k-d tree */
+#define EXHAUSTIVE_SEARCH_MAX_COLORS 64
+
 struct cached_color {
     uint32_t color;
     uint8_t pal_entry;
@@ -82,14 +88,22 @@ struct cache_node {
 
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
                               int x_start, int y_start, int width, int height);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*caches)[CACHE_SIZE]; /* lookup caches, one per slice job */
+    int nb_caches;
+    int *jobs_ret;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
+    DECLARE_ALIGNED(32, int32_t, lab)[3][AVPALETTE_COUNT]; /* colors of the tree, for the exhaustive search */
+    uint8_t lab_id[AVPALETTE_COUNT];
+    int nb_lab;
+    int exhaustive_search;
+    PaletteUseDSPContext dsp;
     uint32_t palette[AVPALETTE_COUNT];
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
@@ -235,15 +249,21 @@ struct stack_node {
     int dx2;
 };
 
+typedef struct ThreadData {
+    AVFrame *out, *in;
+    int x_start, y_start, w, h;
+} ThreadData;
+
 /**
  * Check if the requested color is in the cache already. If not, find it in the
  * color tree and cache it.
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color)
 {
     struct color_info clrinfo;
     const uint32_t hash = ff_lowbias32(color) & (CACHE_SIZE - 1);
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -263,16 +283,22 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
         return AVERROR(ENOMEM);
     e->color = color;
     clrinfo = get_color_from_srgb(color);
-    e->pal_entry = colormap_nearest(s->map, &clrinfo, s->trans_thresh);
+    if (!s->exhaustive_search)
+        e->pal_entry = colormap_nearest(s->map, &clrinfo, s->trans_thresh);
+    else if (color>>24 < s->trans_thresh) // all the colors are as far, as in the tree
+        e->pal_entry = s->lab_id[0];
+    else
+        e->pal_entry = s->lab_id[s->dsp.nearest_color(s->lab[0], s->nb_lab, clrinfo.lab[0],
+                                                      clrinfo.lab[1], clrinfo.lab[2])];
 
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb)
 {
     uint32_t dstc;
-    const int dstx = color_get(s, c);
+    const int dstx = color_get(s, cache, c);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -289,7 +315,8 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
                                       enum dithering_mode dither)
 {
@@ -315,7 +342,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
                 const uint32_t color_new = (unsigned)(a8) << 24 | r << 16 | g << 8 | b;
-                const int color = color_get(s, color_new);
+                const int color = color_get(s, cache, color_new);
 
                 if (color < 0)
                     return color;
@@ -323,7 +350,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -335,7 +362,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -349,7 +376,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -368,7 +395,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -381,7 +408,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA3) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2, down2 = y < h - 2, left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -407,7 +434,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_BURKES) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -427,7 +454,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_ATKINSON) {
                 const int right  = x < w - 1, down  = y < h - 1, left = x > x_start;
                 const int right2 = x < w - 2, down2 = y < h - 2;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -444,7 +471,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 }
 
             } else {
-                const int color = color_get(s, src[x]);
+                const int color = color_get(s, cache, src[x]);
 
                 if (color < 0)
                     return color;
@@ -674,6 +701,17 @@ static void load_colormap(PaletteUseContext *s)
 
     colormap_insert(s->map, color_used, &nb_used, s->palette, s->trans_thresh, &box);
 
+    /* the exhaustive search goes through the colors in the order of the tree
+     * nodes, the padding repeats the root which is never picked again */
+    s->exhaustive_search = nb_used <= EXHAUSTIVE_SEARCH_MAX_COLORS;
+    s->nb_lab = FFALIGN(FFMAX(nb_used, 1), 8);
+    for (int i = 0; i < s->nb_lab; i++) {
+        const struct color_node *node = &s->map[i < nb_used ? i : 0];
+        for (int c = 0; c < 3; c++)
+            s->lab[c][i] = node->c.lab[c];
+        s->lab_id[i] = node->palette_id;
+    }
+
     if (s->dot_filename)
         disp_tree(s->map, s->dot_filename);
 }
@@ -767,6 +805,18 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+/* the dithering modes without error diffusion map the rows independently */
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = td->y_start + (td->h * jobnr) / nb_jobs;
+    const int slice_end   = td->y_start + (td->h * (jobnr + 1)) / nb_jobs;
+
+    return s->set_frame(s, s->caches[jobnr], td->out, td->in,
+                        td->x_start, slice_start, td->w, slice_end - slice_start);
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
     int x, y, w, h, ret;
@@ -795,7 +845,17 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    if (s->nb_caches > 1) {
+        ThreadData td = { .out = out, .in = in, .x_start = x, .y_start = y, .w = w, .h = h };
+        const int nb_jobs = FFMAX(FFMIN(h, s->nb_caches), 1);
+
+        ff_filter_execute(ctx, set_frame_slice, &td, s->jobs_ret, nb_jobs);
+        ret = 0;
+        for (int i = 0; i < nb_jobs; i++)
+            ret = FFMIN(ret, s->jobs_ret[i]);
+    } else {
+        ret = s->set_frame(s, s->caches[0], out, in, x, y, w, h);
+    }
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -806,6 +866,15 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     return 0;
 }
 
+static void free_caches(PaletteUseContext *s)
+{
+    for (int j = 0; s->caches && j < s->nb_caches; j++)
+        for (int i = 0; i < CACHE_SIZE; i++)
+            av_freep(&s->caches[j][i].entries);
+    av_freep(&s->caches);
+    av_freep(&s->jobs_ret);
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     int ret;
@@ -822,6 +891,15 @@ static int config_output(AVFilterLink *outlink)
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
+    free_caches(s);
+    s->nb_caches = 1;
+    if (s->dither == DITHERING_NONE || s->dither == DITHERING_BAYER)
+        s->nb_caches = ff_filter_get_nb_threads(ctx);
+    s->caches   = av_calloc(s->nb_caches, sizeof(*s->caches));
+    s->jobs_ret = av_calloc(s->nb_caches, sizeof(*s->jobs_ret));
+    if (!s->caches || !s->jobs_ret)
+        return AVERROR(ENOMEM);
+
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
@@ -854,9 +932,11 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        for (int j = 0; j < s->nb_caches; j++) {
+            for (i = 0; i < CACHE_SIZE; i++)
+                av_freep(&s->caches[j][i].entries);
+            memset(s->caches[j], 0, sizeof(s->caches[j]));
+        }
     }
 
     i = 0;
@@ -904,10 +984,11 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(name, value)                                           \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            AVFrame *out, AVFrame *in,                          \
                             int x_start, int y_start, int w, int h)             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value);                \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h, value);         \
 }
 
 DEFINE_SET_FRAME(none,            DITHERING_NONE)
@@ -950,6 +1031,7 @@ static av_cold int init(AVFilterContext *ctx)
         return AVERROR(ENOMEM);
 
     s->set_frame = set_frame_lut[s->dither];
+    ff_paletteuse_init(&s->dsp);
 
     if (s->dither == DITHERING_BAYER) {
         const int delta = 1 << (5 - s->bayer_scale); // to avoid too much luma
@@ -972,8 +1054,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (int i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    free_caches(s);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1008,4 +1089,5 @@ const AVFilter ff_vf_paletteuse = {
     FILTER_OUTPUTS(paletteuse_outputs),
     FILTER_QUERY_FUNC2(query_formats),
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
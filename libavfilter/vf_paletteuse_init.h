@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_INIT_H
+#define AVFILTER_PALETTEUSE_INIT_H
+
+#include <stdint.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/pixfmt.h"
+#include "paletteuse.h"
+
+static int nearest_color_c(const int32_t *lab, int nb, int L, int a, int b)
+{
+    int64_t dist_min = INT64_MAX;
+    int pos = 0;
+
+    for (int i = 0; i < nb; i++) {
+        const int64_t dL = lab[i] - L;
+        const int64_t da = lab[i + AVPALETTE_COUNT] - a;
+        const int64_t db = lab[i + AVPALETTE_COUNT * 2] - b;
+        const int64_t dist = FFMIN(dL*dL + da*da + db*db, INT32_MAX - 1);
+
+        if (dist < dist_min) {
+            dist_min = dist;
+            pos = i;
+        }
+    }
+
+    return pos;
+}
+
+static av_unused void ff_paletteuse_init(PaletteUseDSPContext *dsp)
+{
+    dsp->nearest_color = nearest_color_c;
+
+#if ARCH_X86
+    ff_paletteuse_init_x86(dsp);
+#endif
+}
+
+#endif /* AVFILTER_PALETTEUSE_INIT_H */
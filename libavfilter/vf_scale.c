@@ -929,7 +929,8 @@ static int scale_frame(AVFilterLink *link, AVFrame **frame_in,
     AVFrame *out, *in = *frame_in;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     char buf[32];
-    int ret;
+    int ret, interlaced;
+    int64_t zero_copy = 0;
     int frame_changed;
 
     *frame_in = NULL;
@@ -1021,7 +1022,15 @@ scale:
     scale->hsub = desc->log2_chroma_w;
     scale->vsub = desc->log2_chroma_h;
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    interlaced = scale->interlaced > 0 ||
+                 (scale->interlaced < 0 && (in->flags & AV_FRAME_FLAG_INTERLACED));
+    av_opt_get_int(scale->sws, "zero_copy", 0, &zero_copy);
+
+    /* without buffers, the scaler can output references to the input planes */
+    if (zero_copy && !interlaced && !scale->output_is_pal)
+        out = av_frame_alloc();
+    else
+        out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
         ret = AVERROR(ENOMEM);
         goto err;
@@ -1043,13 +1052,14 @@ scale:
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
-    if (scale->interlaced>0 || (scale->interlaced<0 &&
-        (in->flags & AV_FRAME_FLAG_INTERLACED))) {
+    if (interlaced) {
         ret = scale_field(scale, out, in, 0);
         if (ret >= 0)
             ret = scale_field(scale, out, in, 1);
     } else {
         ret = sws_scale_frame(scale->sws, out, in);
+        /* the scaler sets its own, possibly remapped, format when allocating */
+        out->format = outlink->format;
     }
 
     if (ret < 0)
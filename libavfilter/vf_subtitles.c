@@ -64,8 +64,18 @@ typedef struct AssContext {
     int shaping;
     FFDrawContext draw;
     int wrap_unicode;
+
+    FFDrawColor *colors;       ///< colors of the images of the last render
+    unsigned int colors_size;
+    int colors_valid;          ///< 0 if the colors must be computed again
+    int y0, y1;                ///< rows covered by the images of the last render
 } AssContext;
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    const ASS_Image *image;
+} ThreadData;
+
 #define OFFSET(x) offsetof(AssContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 
@@ -136,6 +146,7 @@ static av_cold void uninit(AVFilterContext *ctx)
         ass_renderer_done(ass->renderer);
     if (ass->library)
         ass_library_done(ass->library);
+    av_freep(&ass->colors);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -149,6 +160,7 @@ static int config_input(AVFilterLink *inlink)
 
     ff_draw_init2(&ass->draw, inlink->format, inlink->colorspace, inlink->color_range,
                   ass->alpha ? FF_DRAW_PROCESS_ALPHA : 0);
+    ass->colors_valid = 0;
 
     ass_set_frame_size  (ass->renderer, inlink->w, inlink->h);
     if (ass->original_w && ass->original_h) {
@@ -170,19 +182,65 @@ static int config_input(AVFilterLink *inlink)
 #define AB(c)  (((c)>>8) &0xFF)
 #define AA(c)  ((0xFF-(c)) &0xFF)
 
-static void overlay_ass_image(AssContext *ass, AVFrame *picref,
-                              const ASS_Image *image)
+static int update_image_colors(AssContext *ass, const ASS_Image *image, int h)
+{
+    const ASS_Image *img;
+    int nb_images = 0;
+
+    for (img = image; img; img = img->next)
+        nb_images++;
+
+    av_fast_malloc(&ass->colors, &ass->colors_size,
+                   FFMAX(nb_images, 1) * sizeof(*ass->colors));
+    if (!ass->colors)
+        return AVERROR(ENOMEM);
+
+    ass->y0 = h;
+    ass->y1 = 0;
+    for (img = image, nb_images = 0; img; img = img->next, nb_images++) {
+        uint8_t rgba_color[] = {AR(img->color), AG(img->color), AB(img->color), AA(img->color)};
+        ff_draw_color(&ass->draw, &ass->colors[nb_images], rgba_color);
+        if (img->w <= 0 || img->h <= 0)
+            continue;
+        ass->y0 = FFMIN(ass->y0, img->dst_y);
+        ass->y1 = FFMAX(ass->y1, img->dst_y + img->h);
+    }
+    ass->y0 = FFMAX(ass->y0, 0) & ~((1 << ass->draw.vsub_max) - 1);
+    ass->y1 = FFMIN(ass->y1, h);
+    ass->colors_valid = 1;
+
+    return 0;
+}
+
+static int overlay_ass_image_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    for (; image; image = image->next) {
-        uint8_t rgba_color[] = {AR(image->color), AG(image->color), AB(image->color), AA(image->color)};
-        FFDrawColor color;
-        ff_draw_color(&ass->draw, &color, rgba_color);
-        ff_blend_mask(&ass->draw, &color,
-                      picref->data, picref->linesize,
-                      picref->width, picref->height,
+    AssContext *ass = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *picref = td->frame;
+    const int sub = ass->draw.vsub_max;
+    const int rows = AV_CEIL_RSHIFT(ass->y1 - ass->y0, sub);
+    const int slice_start = ass->y0 + (((rows *  jobnr     ) / nb_jobs) << sub);
+    const int slice_end   = FFMIN(ass->y0 + (((rows * (jobnr + 1)) / nb_jobs) << sub), ass->y1);
+    uint8_t *data[MAX_PLANES] = { NULL };
+    const ASS_Image *image;
+    int i;
+
+    /* the slices are aligned on the chroma rows, so that they can be
+     * blended separately with the same result */
+    for (i = 0; i < ass->draw.nb_planes; i++)
+        data[i] = picref->data[i] + (slice_start >> ass->draw.vsub[i]) * picref->linesize[i];
+
+    for (image = td->image, i = 0; image; image = image->next, i++) {
+        if (image->dst_y >= slice_end || image->dst_y + image->h <= slice_start)
+            continue;
+        ff_blend_mask(&ass->draw, &ass->colors[i],
+                      data, picref->linesize,
+                      picref->width, slice_end - slice_start,
                       image->bitmap, image->stride, image->w, image->h,
-                      3, 0, image->dst_x, image->dst_y);
+                      3, 0, image->dst_x, image->dst_y - slice_start);
     }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
@@ -194,11 +252,27 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
     double time_ms = picref->pts * av_q2d(inlink->time_base) * 1000;
     ASS_Image *image = ass_render_frame(ass->renderer, ass->track,
                                         time_ms, &detect_change);
+    ThreadData td;
+    int ret;
 
     if (detect_change)
         av_log(ctx, AV_LOG_DEBUG, "Change happened at time ms:%f\n", time_ms);
 
-    overlay_ass_image(ass, picref, image);
+    /* the images and their colors are unchanged while libass reports no change */
+    if (detect_change || !ass->colors_valid) {
+        if ((ret = update_image_colors(ass, image, picref->height)) < 0) {
+            av_frame_free(&picref);
+            return ret;
+        }
+    }
+
+    if (image && ass->y1 > ass->y0) {
+        td.frame = picref;
+        td.image = image;
+        ff_filter_execute(ctx, overlay_ass_image_slice, &td, NULL,
+                          FFMIN(AV_CEIL_RSHIFT(ass->y1 - ass->y0, ass->draw.vsub_max),
+                                ff_filter_get_nb_threads(ctx)));
+    }
 
     return ff_filter_frame(outlink, picref);
 }
@@ -257,6 +331,7 @@ const AVFilter ff_vf_ass = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &ass_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif
 
@@ -512,5 +587,6 @@ const AVFilter ff_vf_subtitles = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &subtitles_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif
@@ -0,0 +1,222 @@
+;*****************************************************************************
+;* x86-optimized functions for the EBU R128 filters
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+pd_abs: times 2 dq 0x7fffffffffffffff
+
+SECTION .text
+
+; offsets of the values of a pair of channels in the state, see ebur128dsp.h
+%define X1       0*16
+%define X2       1*16
+%define Y1       2*16
+%define Y2       3*16
+%define Z1       4*16
+%define Z2       5*16
+%define SUM_400  6*16
+%define SUM_3000 7*16
+%define STATE_SIZE 8*16
+
+%define TP_TAPS 12
+
+%if ARCH_X86_64
+
+; filter one (sd) or two (pd) channels, the coefficients are in m0-m6
+%macro FILTER_CHANNELS 2 ; suffix, load/store instruction
+    mov      srcpq, srcq
+    mov        a4q, [c400q]
+    mov        a3q, [c3000q]
+    add        a4q, lenq
+    add        a3q, lenq
+%ifidn %1, pd
+    mov        b4q, [c400q  + 8]
+    mov        b3q, [c3000q + 8]
+    add        b4q, lenq
+    add        b3q, lenq
+%endif
+    mov       idxq, lenq
+    neg       idxq
+
+    %2          m7, [stateq + X1]
+    %2          m8, [stateq + X2]
+    %2          m9, [stateq + Y1]
+    %2         m10, [stateq + Y2]
+    %2         m11, [stateq + Z1]
+    %2         m12, [stateq + Z2]
+
+%%loop:
+    %2         m13, [srcpq]            ; x0
+    mul%1      m14, m13, m0
+    mul%1      m15, m7, m1
+    add%1      m14, m15
+    mul%1      m15, m8, m2
+    add%1      m14, m15
+    mul%1      m15, m9, m3
+    sub%1      m14, m15
+    mul%1      m15, m10, m4
+    sub%1      m14, m15                ; y0
+    mova        m8, m7
+    mova        m7, m13
+    add%1      m15, m9, m9
+    sub%1      m13, m14, m15
+    add%1      m13, m10
+    mul%1      m15, m11, m5
+    sub%1      m13, m15
+    mul%1      m15, m12, m6
+    sub%1      m13, m15                ; z0
+    mova       m10, m9
+    mova        m9, m14
+    mova       m12, m11
+    mova       m11, m13
+    mul%1      m13, m13                ; bin
+
+    %2         m14, [stateq + SUM_400]
+    add%1      m14, m13
+    movsd      m15, [a4q + idxq]
+%ifidn %1, pd
+    movhpd     m15, [b4q + idxq]
+%endif
+    sub%1      m14, m15
+    %2  [stateq + SUM_400], m14
+    movsd [a4q + idxq], m13
+%ifidn %1, pd
+    movhpd [b4q + idxq], m13
+%endif
+
+    %2         m14, [stateq + SUM_3000]
+    add%1      m14, m13
+    movsd      m15, [a3q + idxq]
+%ifidn %1, pd
+    movhpd     m15, [b3q + idxq]
+%endif
+    sub%1      m14, m15
+    %2  [stateq + SUM_3000], m14
+    movsd [a3q + idxq], m13
+%ifidn %1, pd
+    movhpd [b3q + idxq], m13
+%endif
+
+    add      srcpq, strideq
+    add       idxq, 8
+    jl %%loop
+
+    %2  [stateq + X1], m7
+    %2  [stateq + X2], m8
+    %2  [stateq + Y1], m9
+    %2  [stateq + Y2], m10
+    %2  [stateq + Z1], m11
+    %2  [stateq + Z2], m12
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_ebur128_filter_channels_sse2(const double *coeffs, double *state,
+;                                      const double *samples, ptrdiff_t stride,
+;                                      double *const *cache_400,
+;                                      double *const *cache_3000,
+;                                      int nb_channels, int nb_samples);
+;-----------------------------------------------------------------------------
+
+INIT_XMM sse2
+cglobal ebur128_filter_channels, 8, 14, 16, coeffs, state, src, stride, c400, c3000, nbch, len, srcp, idx, a4, b4, a3, b3
+    movsxdifnidn lenq, lend
+    test      lenq, lenq
+    jle .end
+    shl       lenq, 3
+    shl    strideq, 3
+
+    movsd       m0, [coeffsq + 0*8]
+    movsd       m1, [coeffsq + 1*8]
+    movsd       m2, [coeffsq + 2*8]
+    movsd       m3, [coeffsq + 3*8]
+    movsd       m4, [coeffsq + 4*8]
+    movsd       m5, [coeffsq + 5*8]
+    movsd       m6, [coeffsq + 6*8]
+    unpcklpd    m0, m0
+    unpcklpd    m1, m1
+    unpcklpd    m2, m2
+    unpcklpd    m3, m3
+    unpcklpd    m4, m4
+    unpcklpd    m5, m5
+    unpcklpd    m6, m6
+
+    sub      nbchd, 2
+    jl .single
+.pair:
+    FILTER_CHANNELS pd, movupd
+    add       srcq, 16
+    add     stateq, STATE_SIZE
+    add      c400q, 16
+    add     c3000q, 16
+    sub      nbchd, 2
+    jge .pair
+.single:
+    cmp      nbchd, -1
+    jne .end
+    FILTER_CHANNELS sd, movsd
+.end:
+    RET
+
+;-----------------------------------------------------------------------------
+; double ff_ebur128_find_peak_sse3(const double *src, int nb_samples,
+;                                  const double *coeffs, int nb_phases);
+;-----------------------------------------------------------------------------
+
+INIT_XMM sse3
+cglobal ebur128_find_peak, 4, 6, 6, src, len, coeffs, phases, c, ph
+    xorpd       m0, m0
+    test      lend, lend
+    jle .end
+    mova        m5, [pd_abs]
+.loop:
+    mov         cq, coeffsq
+    mov        phd, phasesd
+.phase:
+    xorpd       m1, m1
+    xorpd       m2, m2
+%assign k 0
+%rep TP_TAPS
+    movddup     m3, [cq + k*8]
+    movupd      m4, [srcq + k*8]
+    mulpd       m4, m3
+    addpd       m1, m4
+    movupd      m4, [srcq + k*8 + 16]
+    mulpd       m4, m3
+    addpd       m2, m4
+%assign k k+1
+%endrep
+    andpd       m1, m5
+    andpd       m2, m5
+    maxpd       m0, m1
+    maxpd       m0, m2
+    add         cq, TP_TAPS*8
+    dec        phd
+    jg .phase
+    add       srcq, 32
+    sub       lend, 4
+    jg .loop
+.end:
+    movhlps     m1, m0
+    maxsd       m0, m1
+    RET
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/ebur128dsp.h"
+
+void ff_ebur128_filter_channels_sse2(const double *coeffs, double *state,
+                                     const double *samples, ptrdiff_t stride,
+                                     double *const *cache_400, double *const *cache_3000,
+                                     int nb_channels, int nb_samples);
+double ff_ebur128_find_peak_sse3(const double *src, int nb_samples,
+                                 const double *coeffs, int nb_phases);
+
+av_cold void ff_ebur128_dsp_init_x86(FFEBUR128DSPContext *dsp)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        dsp->filter_channels = ff_ebur128_filter_channels_sse2;
+    if (EXTERNAL_SSE3(cpu_flags))
+        dsp->find_peak = ff_ebur128_find_peak_sse3;
+#endif
+}
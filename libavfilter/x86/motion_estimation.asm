@@ -0,0 +1,81 @@
+;*****************************************************************************
+;* x86-optimized block SAD functions for motion estimation
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; int ff_me_sad<w>_<opt>(const uint8_t *src1, ptrdiff_t stride1,
+;                        const uint8_t *src2, ptrdiff_t stride2, int h);
+;-----------------------------------------------------------------------------
+
+%macro ME_SAD 1 ; width
+cglobal me_sad%1, 5, 5, 4, src1, stride1, src2, stride2, h
+    pxor                m2, m2
+.loop:
+%if %1 == 4
+    movd                m0, [src1q]
+    movd                m1, [src2q]
+    psadbw              m0, m1
+%elif %1 == 8
+    movq                m0, [src1q]
+    movq                m1, [src2q]
+    psadbw              m0, m1
+%elif %1 == mmsize
+    movu                m0, [src1q]
+    movu                m1, [src2q]
+    psadbw              m0, m1
+%else ; two registers per line
+    movu                m0, [src1q]
+    movu                m1, [src1q + mmsize]
+    movu                m3, [src2q]
+    psadbw              m0, m3
+    movu                m3, [src2q + mmsize]
+    psadbw              m1, m3
+    paddd               m0, m1
+%endif
+    paddd               m2, m0
+    add              src1q, stride1q
+    add              src2q, stride2q
+    dec                 hd
+    jg .loop
+%if mmsize == 32
+    vextracti128       xm0, m2, 1
+    paddd              xm2, xm0
+%endif
+%if %1 >= 16
+    movhlps            xm0, xm2
+    paddd              xm2, xm0
+%endif
+    movd               eax, xm2
+    RET
+%endmacro
+
+INIT_XMM sse2
+ME_SAD 4
+ME_SAD 8
+ME_SAD 16
+ME_SAD 32
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+ME_SAD 32
+%endif
@@ -0,0 +1,45 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/motion_estimation.h"
+
+#define SAD_PARAMS const uint8_t *src1, ptrdiff_t stride1, \
+                   const uint8_t *src2, ptrdiff_t stride2, int h
+
+int ff_me_sad4_sse2(SAD_PARAMS);
+int ff_me_sad8_sse2(SAD_PARAMS);
+int ff_me_sad16_sse2(SAD_PARAMS);
+int ff_me_sad32_sse2(SAD_PARAMS);
+int ff_me_sad32_avx2(SAD_PARAMS);
+
+av_cold void ff_me_init_sad_x86(ff_me_sad_fn sad[4])
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        sad[0] = ff_me_sad4_sse2;
+        sad[1] = ff_me_sad8_sse2;
+        sad[2] = ff_me_sad16_sse2;
+        sad[3] = ff_me_sad32_sse2;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        sad[3] = ff_me_sad32_avx2;
+}
@@ -0,0 +1,102 @@
+;*****************************************************************************
+;* x86-optimized functions for paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pq_0123:     dq 0, 1, 2, 3
+pq_4:        dq 4
+pq_dist_max: dq 0x7ffffffe
+
+SECTION .text
+
+; select in %1/%2 the (distance, index) pairs of %3/%4 which are nearer, or
+; as near with a lower index
+%macro MIN_DIST_INDEX 4 ; dist, index, dist2, index2
+    pcmpgtq              xm5, xm%1, xm%3
+    pcmpeqq              xm6, xm%1, xm%3
+    pcmpgtq              xm7, xm%2, xm%4
+    pand                 xm6, xm7
+    por                  xm5, xm6
+    pblendvb            xm%1, xm%1, xm%3, xm5
+    pblendvb            xm%2, xm%2, xm%4, xm5
+%endmacro
+
+;-----------------------------------------------------------------------------
+; int ff_paletteuse_nearest_color_avx2(const int32_t *lab, int nb,
+;                                      int L, int a, int b);
+;-----------------------------------------------------------------------------
+
+%if ARCH_X86_64
+INIT_YMM avx2
+cglobal paletteuse_nearest_color, 5, 5, 10, lab, nb, tL, ta, tb
+    movd                 xm0, tLd
+    movd                 xm1, tad
+    movd                 xm2, tbd
+    pmovsxdq             xm0, xm0
+    pmovsxdq             xm1, xm1
+    pmovsxdq             xm2, xm2
+    vpbroadcastq          m0, xm0
+    vpbroadcastq          m1, xm1
+    vpbroadcastq          m2, xm2
+
+    pcmpeqq               m3, m3
+    psrlq                 m3, 1             ; nearest distances
+    pxor                  m4, m4            ; nearest indexes
+    mova                  m5, [pq_0123]     ; current indexes
+    vpbroadcastq          m6, [pq_4]
+    vpbroadcastq          m7, [pq_dist_max]
+
+    movsxdifnidn         nbq, nbd
+    lea                 labq, [labq + nbq * 4]
+    neg                  nbq
+    shl                  nbq, 2
+.loop:
+    pmovsxdq              m8, [labq + nbq]
+    psubq                 m8, m0
+    pmuldq                m8, m8
+    pmovsxdq              m9, [labq + nbq + 256 * 4]
+    psubq                 m9, m1
+    pmuldq                m9, m9
+    paddq                 m8, m9
+    pmovsxdq              m9, [labq + nbq + 256 * 8]
+    psubq                 m9, m2
+    pmuldq                m9, m9
+    paddq                 m8, m9
+
+    pcmpgtq               m9, m8, m7
+    pblendvb              m8, m8, m7, m9
+    pcmpgtq               m9, m3, m8
+    pblendvb              m3, m3, m8, m9
+    pblendvb              m4, m4, m5, m9
+    paddq                 m5, m6
+    add                  nbq, 16
+    jl .loop
+
+    vextracti128         xm8, m3, 1
+    vextracti128         xm9, m4, 1
+    MIN_DIST_INDEX         3, 4, 8, 9
+    punpckhqdq           xm8, xm3, xm3
+    punpckhqdq           xm9, xm4, xm4
+    MIN_DIST_INDEX         3, 4, 8, 9
+    movd                 eax, xm4
+    RET
+%endif
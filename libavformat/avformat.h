@@ -2335,6 +2335,47 @@ int avformat_open_input(AVFormatContext **ps, const char *url,
  */
 int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options);
 
+/**
+ * Serialize the stream information of a media file, as found by
+ * avformat_find_stream_info(), into a buffer that can be passed to
+ * avformat_stream_info_load() when the same file is opened again, so that
+ * probing can be skipped.
+ *
+ * The buffer stores the codec parameters (including extradata and coded
+ * side data), start times, durations and frame rates of all streams, the
+ * start time, duration and bitrate of the file, and the time that was
+ * spent in avformat_find_stream_info().
+ *
+ * @param ic   media file handle, after avformat_find_stream_info()
+ * @param data set to a newly allocated buffer, which must be freed with
+ *             av_free()
+ * @param size set to the size of the buffer in bytes
+ * @return >= 0 on success, a negative AVERROR code on failure
+ */
+int avformat_stream_info_save(AVFormatContext *ic, uint8_t **data, size_t *size);
+
+/**
+ * Restore stream information saved with avformat_stream_info_save(),
+ * as a replacement for avformat_find_stream_info().
+ *
+ * The streams created by avformat_open_input() must match the saved
+ * streams in number, id, codec type and time base. Otherwise, or if the
+ * buffer is invalid, ic is not modified and avformat_find_stream_info()
+ * should be used instead.
+ *
+ * @param ic         media file handle, after avformat_open_input()
+ * @param data       buffer returned by avformat_stream_info_save()
+ * @param size       size of the buffer in bytes
+ * @param probe_time if non-NULL, set to the time in microseconds that
+ *                   avformat_find_stream_info() took when the buffer
+ *                   was created
+ * @return >= 0 on success, AVERROR(EINVAL) if the saved information does
+ *         not match the streams of ic, another negative AVERROR code on
+ *         failure
+ */
+int avformat_stream_info_load(AVFormatContext *ic, const uint8_t *data, size_t size,
+                              int64_t *probe_time);
+
 /**
  * Find the programs which belong to a given stream.
  *
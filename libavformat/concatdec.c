@@ -18,6 +18,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
 #include "libavutil/avstring.h"
 #include "libavutil/avassert.h"
 #include "libavutil/bprint.h"
@@ -25,6 +27,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/thread.h"
 #include "libavutil/timestamp.h"
 #include "libavcodec/codec_desc.h"
 #include "libavcodec/bsf.h"
@@ -44,6 +47,13 @@ typedef struct ConcatStream {
     int out_stream_index;
 } ConcatStream;
 
+enum PrefetchState {
+    PREFETCH_IDLE,
+    PREFETCH_REQUESTED,
+    PREFETCH_RUNNING,
+    PREFETCH_DONE,
+};
+
 typedef struct {
     char *url;
     int64_t start_time;
@@ -58,6 +68,9 @@ typedef struct {
     AVDictionary *metadata;
     AVDictionary *options;
     int nb_streams;
+    enum PrefetchState prefetch_state;
+    AVFormatContext *prefetch_avf;
+    int prefetch_ret;
 } ConcatFile;
 
 typedef struct {
@@ -72,6 +85,22 @@ typedef struct {
     ConcatMatchMode stream_match_mode;
     unsigned auto_convert;
     int segment_time_metadata;
+    int prefetch;
+    int reuse_stream_params;
+
+    /* stream parameters of the first file, for reuse_stream_params */
+    AVCodecParameters **ref_par;
+    AVRational *ref_frame_rate;
+    unsigned nb_ref_par;
+
+#if HAVE_THREADS
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+    int prefetch_thread_started;
+    int prefetch_quit;
+    unsigned prefetch_start; ///< first file of the prefetch window
+#endif
 } ConcatContext;
 
 static int concat_probe(const AVProbeData *probe)
@@ -332,42 +361,331 @@ static int64_t get_best_effort_duration(ConcatFile *file, AVFormatContext *avf)
     return AV_NOPTS_VALUE;
 }
 
-static int open_file(AVFormatContext *avf, unsigned fileno)
+/**
+ * Check the parameters known from the header of a file against the first
+ * file. Parameters that cannot be checked from the header are treated as
+ * a mismatch, as they could only be validated by decoding.
+ */
+static int stream_params_match(const AVCodecParameters *par,
+                               const AVCodecParameters *ref)
+{
+    if (par->codec_type != ref->codec_type ||
+        par->codec_id   != ref->codec_id)
+        return 0;
+    if (par->extradata_size != ref->extradata_size ||
+        (par->extradata_size &&
+         memcmp(par->extradata, ref->extradata, par->extradata_size)))
+        return 0;
+    if (par->format >= 0 && par->format != ref->format)
+        return 0;
+
+    switch (par->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        return par->width  == ref->width &&
+               par->height == ref->height;
+    case AVMEDIA_TYPE_AUDIO:
+        return par->sample_rate == ref->sample_rate &&
+               (!par->frame_size || par->frame_size == ref->frame_size) &&
+               par->ch_layout.nb_channels == ref->ch_layout.nb_channels &&
+               (par->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC ||
+                !av_channel_layout_compare(&par->ch_layout, &ref->ch_layout));
+    default:
+        return 1;
+    }
+}
+
+/**
+ * Fill in the codec parameters which are not known from the header of a
+ * file, and would otherwise need decoding in avformat_find_stream_info(),
+ * from the first file, if the header parameters of all streams match.
+ * Otherwise the file is fully probed.
+ */
+static void reuse_stream_params(AVFormatContext *avf, AVFormatContext *ic)
 {
     ConcatContext *cat = avf->priv_data;
-    ConcatFile *file = &cat->files[fileno];
-    AVDictionary *options = NULL;
-    int ret;
 
-    if (cat->avf)
-        avformat_close_input(&cat->avf);
+    if (ic->ctx_flags & AVFMTCTX_NOHEADER) {
+        av_log(avf, AV_LOG_VERBOSE, "'%s' has no header to match the stream "
+               "parameters with, probing them\n", ic->url);
+        return;
+    }
+    if (ic->nb_streams != cat->nb_ref_par)
+        goto mismatch;
+    for (unsigned i = 0; i < ic->nb_streams; i++)
+        if (!stream_params_match(ic->streams[i]->codecpar, cat->ref_par[i]))
+            goto mismatch;
+
+    for (unsigned i = 0; i < ic->nb_streams; i++) {
+        AVStream *st = ic->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        const AVCodecParameters *ref = cat->ref_par[i];
+
+        if (par->format < 0)
+            par->format = ref->format;
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            if (!st->r_frame_rate.num && !st->avg_frame_rate.num)
+                st->r_frame_rate = st->avg_frame_rate = cat->ref_frame_rate[i];
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+            if (!par->frame_size)
+                par->frame_size = ref->frame_size;
+            if (par->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC &&
+                av_channel_layout_copy(&par->ch_layout, &ref->ch_layout) < 0)
+                av_channel_layout_uninit(&par->ch_layout);
+        }
+    }
+    return;
 
-    cat->avf = avformat_alloc_context();
-    if (!cat->avf)
+mismatch:
+    av_log(avf, AV_LOG_VERBOSE, "Stream parameters of '%s' cannot be "
+           "matched with the first file, probing them\n", ic->url);
+}
+
+static int save_stream_params(ConcatContext *cat, AVFormatContext *ic)
+{
+    cat->ref_par = av_calloc(ic->nb_streams, sizeof(*cat->ref_par));
+    cat->ref_frame_rate = av_calloc(ic->nb_streams, sizeof(*cat->ref_frame_rate));
+    if (!cat->ref_par || !cat->ref_frame_rate)
         return AVERROR(ENOMEM);
 
-    cat->avf->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
-    cat->avf->interrupt_callback = avf->interrupt_callback;
+    for (; cat->nb_ref_par < ic->nb_streams; cat->nb_ref_par++) {
+        AVStream *st = ic->streams[cat->nb_ref_par];
+        AVCodecParameters *par = avcodec_parameters_alloc();
+        int ret;
 
-    if ((ret = ff_copy_whiteblacklists(cat->avf, avf)) < 0)
-        return ret;
+        if (!par)
+            return AVERROR(ENOMEM);
+        cat->ref_par[cat->nb_ref_par] = par;
+        if ((ret = avcodec_parameters_copy(par, st->codecpar)) < 0)
+            return ret;
+        cat->ref_frame_rate[cat->nb_ref_par] = st->r_frame_rate;
+    }
+    return 0;
+}
 
-    ret = av_dict_copy(&options, file->options, 0);
-    if (ret < 0)
-        return ret;
+/* Open and probe a file; may be called from the prefetch thread. */
+static int open_input(AVFormatContext *avf, ConcatFile *file, AVFormatContext **pic)
+{
+    ConcatContext *cat = avf->priv_data;
+    AVFormatContext *ic;
+    AVDictionary *options = NULL;
+    int ret;
 
-    if ((ret = avformat_open_input(&cat->avf, file->url, NULL, &options)) < 0 ||
-        (ret = avformat_find_stream_info(cat->avf, NULL)) < 0) {
-        av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
-        av_dict_free(&options);
-        avformat_close_input(&cat->avf);
+    ic = avformat_alloc_context();
+    if (!ic)
+        return AVERROR(ENOMEM);
+
+    ic->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
+    ic->interrupt_callback = avf->interrupt_callback;
+
+    if ((ret = ff_copy_whiteblacklists(ic, avf)) < 0 ||
+        (ret = av_dict_copy(&options, file->options, 0)) < 0) {
+        avformat_free_context(ic);
         return ret;
     }
+
+    if ((ret = avformat_open_input(&ic, file->url, NULL, &options)) < 0)
+        goto fail;
+    if (cat->nb_ref_par)
+        reuse_stream_params(avf, ic);
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0)
+        goto fail;
+
     if (options) {
         av_log(avf, AV_LOG_WARNING, "Unused options for '%s'.\n", file->url);
         /* TODO log unused options once we have a proper string API */
         av_dict_free(&options);
     }
+    *pic = ic;
+    return 0;
+
+fail:
+    av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
+    av_dict_free(&options);
+    avformat_close_input(&ic);
+    return ret;
+}
+
+#if HAVE_THREADS
+static void *prefetch_thread(void *arg)
+{
+    AVFormatContext *avf = arg;
+    ConcatContext *cat = avf->priv_data;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    while (!cat->prefetch_quit) {
+        unsigned end = FFMIN(cat->prefetch_start + cat->prefetch, cat->nb_files);
+        AVFormatContext *ic = NULL;
+        ConcatFile *file = NULL;
+        int ret;
+
+        for (unsigned i = cat->prefetch_start; i < end; i++) {
+            if (cat->files[i].prefetch_state == PREFETCH_REQUESTED) {
+                file = &cat->files[i];
+                break;
+            }
+        }
+        if (!file) {
+            pthread_cond_wait(&cat->prefetch_cond, &cat->prefetch_lock);
+            continue;
+        }
+
+        file->prefetch_state = PREFETCH_RUNNING;
+        pthread_mutex_unlock(&cat->prefetch_lock);
+        ret = open_input(avf, file, &ic);
+        pthread_mutex_lock(&cat->prefetch_lock);
+
+        if (file - cat->files >= cat->prefetch_start &&
+            file - cat->files < cat->prefetch_start + cat->prefetch) {
+            file->prefetch_avf   = ic;
+            file->prefetch_ret   = ret;
+            file->prefetch_state = PREFETCH_DONE;
+        } else {
+            /* the window moved on while the file was being opened */
+            avformat_close_input(&ic);
+            file->prefetch_state = PREFETCH_IDLE;
+        }
+        pthread_cond_broadcast(&cat->prefetch_cond);
+    }
+    pthread_mutex_unlock(&cat->prefetch_lock);
+
+    return NULL;
+}
+
+static int prefetch_init(AVFormatContext *avf)
+{
+    ConcatContext *cat = avf->priv_data;
+    int ret;
+
+    if ((ret = pthread_mutex_init(&cat->prefetch_lock, NULL))) {
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&cat->prefetch_cond, NULL))) {
+        pthread_mutex_destroy(&cat->prefetch_lock);
+        return AVERROR(ret);
+    }
+    cat->prefetch_start = cat->nb_files;
+    if ((ret = pthread_create(&cat->prefetch_thread, NULL, prefetch_thread, avf))) {
+        pthread_cond_destroy(&cat->prefetch_cond);
+        pthread_mutex_destroy(&cat->prefetch_lock);
+        return AVERROR(ret);
+    }
+    cat->prefetch_thread_started = 1;
+    return 0;
+}
+
+static void prefetch_uninit(AVFormatContext *avf)
+{
+    ConcatContext *cat = avf->priv_data;
+
+    if (!cat->prefetch_thread_started)
+        return;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    cat->prefetch_quit = 1;
+    pthread_cond_broadcast(&cat->prefetch_cond);
+    pthread_mutex_unlock(&cat->prefetch_lock);
+    pthread_join(cat->prefetch_thread, NULL);
+    pthread_cond_destroy(&cat->prefetch_cond);
+    pthread_mutex_destroy(&cat->prefetch_lock);
+    cat->prefetch_thread_started = 0;
+
+    for (unsigned i = 0; i < cat->nb_files; i++)
+        avformat_close_input(&cat->files[i].prefetch_avf);
+}
+
+/**
+ * Take the context of a file opened by the prefetch thread.
+ *
+ * @return 1 if the file was prefetched, with *ret set to the result of
+ *         opening it, 0 if it must be opened by the caller
+ */
+static int prefetch_get(AVFormatContext *avf, ConcatFile *file,
+                        AVFormatContext **pic, int *ret)
+{
+    ConcatContext *cat = avf->priv_data;
+    int found = 0;
+
+    if (!cat->prefetch_thread_started)
+        return 0;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    while (file->prefetch_state == PREFETCH_RUNNING)
+        pthread_cond_wait(&cat->prefetch_cond, &cat->prefetch_lock);
+    if (file->prefetch_state == PREFETCH_DONE) {
+        *pic = file->prefetch_avf;
+        *ret = file->prefetch_ret;
+        file->prefetch_avf = NULL;
+        found = 1;
+    }
+    file->prefetch_state = PREFETCH_IDLE;
+    pthread_mutex_unlock(&cat->prefetch_lock);
+
+    return found;
+}
+
+/* Move the prefetch window to the files following fileno. */
+static void prefetch_schedule(AVFormatContext *avf, unsigned fileno)
+{
+    ConcatContext *cat = avf->priv_data;
+    unsigned start = fileno + 1, end = FFMIN(start + cat->prefetch, cat->nb_files);
+
+    if (!cat->prefetch_thread_started)
+        return;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    for (unsigned i = 0; i < cat->nb_files; i++) {
+        ConcatFile *file = &cat->files[i];
+        if (i >= start && i < end) {
+            if (file->prefetch_state == PREFETCH_IDLE)
+                file->prefetch_state = PREFETCH_REQUESTED;
+        } else if (file->prefetch_state == PREFETCH_DONE) {
+            avformat_close_input(&file->prefetch_avf);
+            file->prefetch_state = PREFETCH_IDLE;
+        } else if (file->prefetch_state == PREFETCH_REQUESTED) {
+            file->prefetch_state = PREFETCH_IDLE;
+        }
+    }
+    cat->prefetch_start = start;
+    pthread_cond_signal(&cat->prefetch_cond);
+    pthread_mutex_unlock(&cat->prefetch_lock);
+}
+#else
+static int prefetch_init(AVFormatContext *avf)
+{
+    av_log(avf, AV_LOG_WARNING, "Prefetching requires threading support, ignoring\n");
+    return 0;
+}
+
+static void prefetch_uninit(AVFormatContext *avf)
+{
+}
+
+static int prefetch_get(AVFormatContext *avf, ConcatFile *file,
+                        AVFormatContext **pic, int *ret)
+{
+    return 0;
+}
+
+static void prefetch_schedule(AVFormatContext *avf, unsigned fileno)
+{
+}
+#endif
+
+static int open_file(AVFormatContext *avf, unsigned fileno)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = &cat->files[fileno];
+    int ret;
+
+    if (cat->avf)
+        avformat_close_input(&cat->avf);
+
+    if (!prefetch_get(avf, file, &cat->avf, &ret))
+        ret = open_input(avf, file, &cat->avf);
+    prefetch_schedule(avf, fileno);
+    if (ret < 0)
+        return ret;
+
     cat->cur_file = file;
     file->start_time = !fileno ? 0 :
                        cat->files[fileno - 1].start_time +
@@ -396,6 +714,7 @@ static int concat_read_close(AVFormatContext *avf)
     ConcatContext *cat = avf->priv_data;
     unsigned i, j;
 
+    prefetch_uninit(avf);
     for (i = 0; i < cat->nb_files; i++) {
         av_freep(&cat->files[i].url);
         for (j = 0; j < cat->files[i].nb_streams; j++) {
@@ -409,6 +728,10 @@ static int concat_read_close(AVFormatContext *avf)
     if (cat->avf)
         avformat_close_input(&cat->avf);
     av_freep(&cat->files);
+    for (i = 0; i < cat->nb_ref_par; i++)
+        avcodec_parameters_free(&cat->ref_par[i]);
+    av_freep(&cat->ref_par);
+    av_freep(&cat->ref_frame_rate);
     return 0;
 }
 
@@ -699,6 +1022,15 @@ static int concat_read_header(AVFormatContext *avf)
     if ((ret = open_file(avf, 0)) < 0)
         return ret;
 
+    if (cat->reuse_stream_params &&
+        (ret = save_stream_params(cat, cat->avf)) < 0)
+        return ret;
+    if (cat->prefetch && cat->nb_files > 1) {
+        if ((ret = prefetch_init(avf)) < 0)
+            return ret;
+        prefetch_schedule(avf, 0);
+    }
+
     return 0;
 }
 
@@ -939,6 +1271,10 @@ static const AVOption options[] = {
       OFFSET(auto_convert), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, DEC },
     { "segment_time_metadata", "output file segment start time and duration as packet metadata",
       OFFSET(segment_time_metadata), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, DEC },
+    { "prefetch", "number of following files to open ahead on a background thread",
+      OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, DEC },
+    { "reuse_stream_params", "reuse the stream parameters of the first file when probing the following files",
+      OFFSET(reuse_stream_params), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, DEC },
     { NULL }
 };
 
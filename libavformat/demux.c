@@ -25,6 +25,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
 #include "libavutil/dict.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
@@ -2537,6 +2538,7 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     int64_t max_subtitle_analyze_duration;
     int64_t probesize = ic->probesize;
     int eof_reached = 0;
+    int64_t start_time = av_gettime_relative();
 
     flush_codecs = probesize > 0;
 
@@ -3118,6 +3120,7 @@ find_stream_info_err:
 
         av_bsf_free(&sti->extract_extradata.bsf);
     }
+    si->stream_info_time = av_gettime_relative() - start_time;
     if (ic->pb) {
         FFIOContext *const ctx = ffiocontext(ic->pb);
         av_log(ic, AV_LOG_DEBUG, "After avformat_find_stream_info() pos: %"PRId64" bytes read:%"PRId64" seeks:%d frames:%d\n",
@@ -3129,3 +3132,327 @@ unref_then_goto_end:
     av_packet_unref(pkt1);
     goto find_stream_info_err;
 }
+
+#define STREAM_INFO_TAG     MKBETAG('F', 'S', 'I', 'N')
+#define STREAM_INFO_VERSION 1
+
+typedef struct StreamInfoEntry {
+    AVCodecParameters *par;
+    int id;
+    AVRational time_base;
+    int64_t start_time;
+    int64_t duration;
+    int64_t nb_frames;
+    int disposition;
+    AVRational sample_aspect_ratio;
+    AVRational avg_frame_rate;
+    AVRational r_frame_rate;
+} StreamInfoEntry;
+
+static void stream_info_write_q(AVIOContext *pb, AVRational q)
+{
+    avio_wb32(pb, q.num);
+    avio_wb32(pb, q.den);
+}
+
+static AVRational stream_info_read_q(AVIOContext *pb)
+{
+    AVRational q;
+    q.num = (int)avio_rb32(pb);
+    q.den = (int)avio_rb32(pb);
+    return q;
+}
+
+static int stream_info_write_par(AVIOContext *pb, const AVCodecParameters *par)
+{
+    AVBPrint layout;
+    int ret;
+
+    av_bprint_init(&layout, 0, AV_BPRINT_SIZE_UNLIMITED);
+    if (par->ch_layout.nb_channels) {
+        ret = av_channel_layout_describe_bprint(&par->ch_layout, &layout);
+        if (ret >= 0 && !av_bprint_is_complete(&layout))
+            ret = AVERROR(ENOMEM);
+        if (ret < 0) {
+            av_bprint_finalize(&layout, NULL);
+            return ret;
+        }
+    }
+
+    avio_wb32(pb, par->codec_type);
+    avio_wb32(pb, par->codec_id);
+    avio_wb32(pb, par->codec_tag);
+    avio_wb32(pb, par->format);
+    avio_wb64(pb, par->bit_rate);
+    avio_wb32(pb, par->bits_per_coded_sample);
+    avio_wb32(pb, par->bits_per_raw_sample);
+    avio_wb32(pb, par->profile);
+    avio_wb32(pb, par->level);
+    avio_wb32(pb, par->width);
+    avio_wb32(pb, par->height);
+    stream_info_write_q(pb, par->sample_aspect_ratio);
+    stream_info_write_q(pb, par->framerate);
+    avio_wb32(pb, par->field_order);
+    avio_wb32(pb, par->color_range);
+    avio_wb32(pb, par->color_primaries);
+    avio_wb32(pb, par->color_trc);
+    avio_wb32(pb, par->color_space);
+    avio_wb32(pb, par->chroma_location);
+    avio_wb32(pb, par->video_delay);
+    avio_put_str(pb, layout.str);
+    av_bprint_finalize(&layout, NULL);
+    avio_wb32(pb, par->sample_rate);
+    avio_wb32(pb, par->block_align);
+    avio_wb32(pb, par->frame_size);
+    avio_wb32(pb, par->initial_padding);
+    avio_wb32(pb, par->trailing_padding);
+    avio_wb32(pb, par->seek_preroll);
+
+    avio_wb32(pb, par->extradata_size);
+    avio_write(pb, par->extradata, par->extradata_size);
+
+    avio_wb32(pb, par->nb_coded_side_data);
+    for (int i = 0; i < par->nb_coded_side_data; i++) {
+        const AVPacketSideData *sd = &par->coded_side_data[i];
+        if (sd->size > INT_MAX)
+            return AVERROR(ERANGE);
+        avio_wb32(pb, sd->type);
+        avio_wb32(pb, sd->size);
+        avio_write(pb, sd->data, sd->size);
+    }
+
+    return 0;
+}
+
+static int stream_info_read_par(AVIOContext *pb, AVCodecParameters *par, size_t max_size)
+{
+    AVBPrint layout;
+    unsigned extradata_size, nb_side_data;
+    int ret;
+
+    par->codec_type            = (int)avio_rb32(pb);
+    par->codec_id              = avio_rb32(pb);
+    par->codec_tag             = avio_rb32(pb);
+    par->format                = (int)avio_rb32(pb);
+    par->bit_rate              = avio_rb64(pb);
+    par->bits_per_coded_sample = avio_rb32(pb);
+    par->bits_per_raw_sample   = avio_rb32(pb);
+    par->profile               = (int)avio_rb32(pb);
+    par->level                 = (int)avio_rb32(pb);
+    par->width                 = avio_rb32(pb);
+    par->height                = avio_rb32(pb);
+    par->sample_aspect_ratio   = stream_info_read_q(pb);
+    par->framerate             = stream_info_read_q(pb);
+    par->field_order           = avio_rb32(pb);
+    par->color_range           = avio_rb32(pb);
+    par->color_primaries       = avio_rb32(pb);
+    par->color_trc             = avio_rb32(pb);
+    par->color_space           = avio_rb32(pb);
+    par->chroma_location       = avio_rb32(pb);
+    par->video_delay           = avio_rb32(pb);
+    av_bprint_init(&layout, 0, AV_BPRINT_SIZE_UNLIMITED);
+    ret = ff_read_string_to_bprint_overwrite(pb, &layout, max_size);
+    if (ret < 0) {
+        av_bprint_finalize(&layout, NULL);
+        return ret;
+    }
+    par->sample_rate           = avio_rb32(pb);
+    par->block_align           = avio_rb32(pb);
+    par->frame_size            = avio_rb32(pb);
+    par->initial_padding       = avio_rb32(pb);
+    par->trailing_padding      = avio_rb32(pb);
+    par->seek_preroll          = avio_rb32(pb);
+
+    if (layout.len)
+        ret = av_channel_layout_from_string(&par->ch_layout, layout.str);
+    av_bprint_finalize(&layout, NULL);
+    if (ret < 0)
+        return ret;
+
+    extradata_size = avio_rb32(pb);
+    if (extradata_size > max_size)
+        return AVERROR_INVALIDDATA;
+    if (extradata_size) {
+        ret = ff_get_extradata(NULL, par, pb, extradata_size);
+        if (ret < 0)
+            return ret;
+    }
+
+    nb_side_data = avio_rb32(pb);
+    for (unsigned i = 0; i < nb_side_data && !avio_feof(pb); i++) {
+        enum AVPacketSideDataType type = avio_rb32(pb);
+        unsigned size = avio_rb32(pb);
+        AVPacketSideData *sd;
+
+        if (size > max_size)
+            return AVERROR_INVALIDDATA;
+        sd = av_packet_side_data_new(&par->coded_side_data, &par->nb_coded_side_data,
+                                     type, size, 0);
+        if (!sd)
+            return AVERROR(ENOMEM);
+        if (avio_read(pb, sd->data, size) != size)
+            return AVERROR_INVALIDDATA;
+    }
+
+    return 0;
+}
+
+int avformat_stream_info_save(AVFormatContext *ic, uint8_t **data, size_t *size)
+{
+    FFFormatContext *const si = ffformatcontext(ic);
+    AVIOContext *pb;
+    int ret;
+
+    *data = NULL;
+    *size = 0;
+
+    ret = avio_open_dyn_buf(&pb);
+    if (ret < 0)
+        return ret;
+
+    avio_wb32(pb, STREAM_INFO_TAG);
+    avio_w8(pb, STREAM_INFO_VERSION);
+    avio_wb64(pb, si->stream_info_time);
+    avio_wb64(pb, ic->start_time);
+    avio_wb64(pb, ic->duration);
+    avio_wb64(pb, ic->bit_rate);
+    avio_wb32(pb, ic->duration_estimation_method);
+    avio_wb32(pb, ic->nb_streams);
+
+    for (unsigned i = 0; i < ic->nb_streams; i++) {
+        const AVStream *st = ic->streams[i];
+
+        avio_wb32(pb, st->id);
+        stream_info_write_q(pb, st->time_base);
+        avio_wb64(pb, st->start_time);
+        avio_wb64(pb, st->duration);
+        avio_wb64(pb, st->nb_frames);
+        avio_wb32(pb, st->disposition);
+        stream_info_write_q(pb, st->sample_aspect_ratio);
+        stream_info_write_q(pb, st->avg_frame_rate);
+        stream_info_write_q(pb, st->r_frame_rate);
+
+        ret = stream_info_write_par(pb, st->codecpar);
+        if (ret < 0) {
+            ffio_free_dyn_buf(&pb);
+            return ret;
+        }
+    }
+
+    ret = avio_close_dyn_buf(pb, data);
+    if (ret < 0)
+        return ret;
+    *size = ret;
+
+    return 0;
+}
+
+int avformat_stream_info_load(AVFormatContext *ic, const uint8_t *data, size_t size,
+                              int64_t *probe_time)
+{
+    FFIOContext ctx;
+    AVIOContext *const pb = &ctx.pub;
+    StreamInfoEntry *entries = NULL;
+    int64_t stream_info_time, start_time, duration, bit_rate;
+    int duration_estimation_method;
+    unsigned nb_streams;
+    int ret = 0;
+
+    if (size > INT_MAX)
+        return AVERROR(EINVAL);
+
+    ffio_init_read_context(&ctx, data, size);
+
+    if (avio_rb32(pb) != STREAM_INFO_TAG || avio_r8(pb) != STREAM_INFO_VERSION)
+        return AVERROR_INVALIDDATA;
+
+    stream_info_time           = avio_rb64(pb);
+    start_time                 = avio_rb64(pb);
+    duration                   = avio_rb64(pb);
+    bit_rate                   = avio_rb64(pb);
+    duration_estimation_method = avio_rb32(pb);
+    nb_streams                 = avio_rb32(pb);
+
+    if (nb_streams != ic->nb_streams) {
+        av_log(ic, AV_LOG_VERBOSE, "Saved stream info has %u streams, "
+               "file has %u\n", nb_streams, ic->nb_streams);
+        return AVERROR(EINVAL);
+    }
+
+    entries = av_calloc(nb_streams, sizeof(*entries));
+    if (nb_streams && !entries)
+        return AVERROR(ENOMEM);
+
+    /* parse everything first, so that ic is left untouched on failure */
+    for (unsigned i = 0; i < nb_streams; i++) {
+        StreamInfoEntry *const e = &entries[i];
+        const AVStream *st = ic->streams[i];
+
+        e->par = avcodec_parameters_alloc();
+        if (!e->par) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+
+        e->id                  = avio_rb32(pb);
+        e->time_base           = stream_info_read_q(pb);
+        e->start_time          = avio_rb64(pb);
+        e->duration            = avio_rb64(pb);
+        e->nb_frames           = avio_rb64(pb);
+        e->disposition         = avio_rb32(pb);
+        e->sample_aspect_ratio = stream_info_read_q(pb);
+        e->avg_frame_rate      = stream_info_read_q(pb);
+        e->r_frame_rate        = stream_info_read_q(pb);
+
+        ret = stream_info_read_par(pb, e->par, size);
+        if (ret < 0)
+            goto fail;
+        if (avio_feof(pb) || pb->error) {
+            ret = AVERROR_INVALIDDATA;
+            goto fail;
+        }
+
+        if (e->id != st->id || e->par->codec_type != st->codecpar->codec_type ||
+            av_cmp_q(e->time_base, st->time_base)) {
+            av_log(ic, AV_LOG_VERBOSE, "Saved stream info does not match "
+                   "stream %u\n", i);
+            ret = AVERROR(EINVAL);
+            goto fail;
+        }
+    }
+
+    for (unsigned i = 0; i < nb_streams; i++) {
+        StreamInfoEntry *const e = &entries[i];
+        AVStream *const st  = ic->streams[i];
+        FFStream *const sti = ffstream(st);
+
+        avcodec_parameters_free(&st->codecpar);
+        st->codecpar = e->par;
+        e->par       = NULL;
+
+        st->start_time          = e->start_time;
+        st->duration            = e->duration;
+        st->nb_frames           = e->nb_frames;
+        st->disposition         = e->disposition;
+        st->sample_aspect_ratio = e->sample_aspect_ratio;
+        st->avg_frame_rate      = e->avg_frame_rate;
+        st->r_frame_rate        = e->r_frame_rate;
+
+        sti->codec_desc = avcodec_descriptor_get(st->codecpar->codec_id);
+        sti->need_context_update = 1;
+    }
+
+    ic->start_time                 = start_time;
+    ic->duration                   = duration;
+    ic->bit_rate                   = bit_rate;
+    ic->duration_estimation_method = duration_estimation_method;
+
+    if (probe_time)
+        *probe_time = stream_info_time;
+
+fail:
+    for (unsigned i = 0; i < nb_streams; i++)
+        avcodec_parameters_free(&entries[i].par);
+    av_free(entries);
+    return ret;
+}
@@ -122,6 +122,11 @@ typedef struct FFFormatContext {
     AVDictionary *id3v2_meta;
 
     int missing_streams;
+
+    /**
+     * Time in microseconds spent in avformat_find_stream_info()
+     */
+    int64_t stream_info_time;
 } FFFormatContext;
 
 static av_always_inline FFFormatContext *ffformatcontext(AVFormatContext *s)
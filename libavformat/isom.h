@@ -164,6 +164,27 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * Position in the sample tables up to which the index has been built,
+ * used to resume building it when the index is created on demand.
+ */
+typedef struct MOVIndexCursor {
+    unsigned int chunk;           ///< current chunk
+    unsigned int chunk_sample;    ///< sample within the current chunk
+    unsigned int current_sample;
+    unsigned int stsc_index;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    unsigned int stss_index;
+    unsigned int stps_index;
+    unsigned int rap_group_index;
+    unsigned int rap_group_sample;
+    unsigned int distance;
+    int64_t current_offset;
+    int64_t current_dts;
+    uint64_t stream_size;         ///< sum of the sizes of the indexed samples
+} MOVIndexCursor;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int refcount;
@@ -204,6 +225,8 @@ typedef struct MOVStreamContext {
     int64_t current_index;
     MOVIndexRange* index_ranges;
     MOVIndexRange* current_index_range;
+    int lazy_index;       ///< index entries are still being built from the sample tables
+    MOVIndexCursor index_cursor;
     unsigned int bytes_per_frame;
     unsigned int samples_per_frame;
     int dv_audio_container;
@@ -367,6 +390,7 @@ typedef struct MOVContext {
     int thmb_item_id;
     int64_t idat_offset;
     int interleaved_read;
+    int lazy_index;
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
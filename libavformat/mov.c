@@ -4579,20 +4579,262 @@ static int build_open_gop_key_points(AVStream *st)
     return 0;
 }
 
+#define MOV_LAZY_INDEX_BATCH 4096
+
+/**
+ * Expand the ctts entries such that we have a 1-1 mapping with samples.
+ * The read position in the table is carried over to the expanded table.
+ */
+static int mov_expand_ctts(MOVStreamContext *sc)
+{
+    MOVCtts *ctts_data_old = sc->ctts_data;
+    unsigned int ctts_count_old = sc->ctts_count;
+    int64_t ctts_pos = sc->ctts_sample;
+
+    if (!ctts_data_old)
+        return 0;
+    if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
+        return AVERROR_INVALIDDATA;
+
+    for (unsigned int i = 0; i < sc->ctts_index && i < ctts_count_old; i++)
+        ctts_pos += ctts_data_old[i].count;
+
+    sc->ctts_count = 0;
+    sc->ctts_allocated_size = 0;
+    sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
+                            sc->sample_count * sizeof(*sc->ctts_data));
+    if (!sc->ctts_data) {
+        av_free(ctts_data_old);
+        return AVERROR(ENOMEM);
+    }
+
+    memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
+
+    for (unsigned int i = 0; i < ctts_count_old &&
+                             sc->ctts_count < sc->sample_count; i++)
+        for (unsigned int j = 0; j < ctts_data_old[i].count &&
+                                 sc->ctts_count < sc->sample_count; j++)
+            add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
+                           &sc->ctts_allocated_size, 1,
+                           ctts_data_old[i].duration);
+    av_free(ctts_data_old);
+
+    sc->ctts_index  = FFMIN(ctts_pos, sc->ctts_count);
+    sc->ctts_sample = 0;
+    return 0;
+}
+
+/**
+ * Append index entries for the samples described by the sample tables,
+ * resuming at the position saved in sc->index_cursor, until the index holds
+ * nb_entries entries or the sample tables are exhausted.
+ *
+ * @return 1 if all samples have been indexed, 0 if samples remain,
+ *         a negative AVERROR code on failure
+ */
+static int mov_build_index_entries(MOVContext *mov, AVStream *st, unsigned int nb_entries)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    MOVIndexCursor *const c = &sc->index_cursor;
+    unsigned int sample_size;
+    int rap_group_present = sc->rap_group_count && sc->rap_group;
+    int key_off = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+
+    if (nb_entries > sti->index_entries_allocated_size / sizeof(*sti->index_entries)) {
+        unsigned int size = nb_entries;
+
+        /* grow geometrically, entries are appended in small batches */
+        if (sc->lazy_index)
+            size = FFMIN(FFMAX(size, sti->nb_index_entries + (sti->nb_index_entries >> 1)),
+                         sc->sample_count);
+        if (av_reallocp_array(&sti->index_entries, size, sizeof(*sti->index_entries)) < 0) {
+            sti->nb_index_entries = 0;
+            sti->index_entries_allocated_size = 0;
+            return AVERROR(ENOMEM);
+        }
+        sti->index_entries_allocated_size = size * sizeof(*sti->index_entries);
+    }
+
+    for (; c->chunk < sc->chunk_count; c->chunk++, c->chunk_sample = 0) {
+        if (!c->chunk_sample) {
+            int64_t next_offset = c->chunk + 1 < sc->chunk_count ? sc->chunk_offsets[c->chunk + 1] : INT64_MAX;
+
+            if (sti->nb_index_entries >= nb_entries)
+                return 0;
+
+            c->current_offset = sc->chunk_offsets[c->chunk];
+            while (mov_stsc_index_valid(c->stsc_index, sc->stsc_count) &&
+                c->chunk + 1 == sc->stsc_data[c->stsc_index + 1].first)
+                c->stsc_index++;
+
+            if (next_offset > c->current_offset && sc->sample_size>0 && sc->sample_size < sc->stsz_sample_size &&
+                sc->stsc_data[c->stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - c->current_offset) {
+                av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too large), ignoring\n", sc->stsz_sample_size);
+                sc->stsz_sample_size = sc->sample_size;
+            }
+            if (sc->stsz_sample_size>0 && sc->stsz_sample_size < sc->sample_size) {
+                av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too small), ignoring\n", sc->stsz_sample_size);
+                sc->stsz_sample_size = sc->sample_size;
+            }
+        }
+
+        for (; c->chunk_sample < sc->stsc_data[c->stsc_index].count; c->chunk_sample++) {
+            int keyframe = 0;
+            if (sti->nb_index_entries >= nb_entries)
+                return 0;
+            if (c->current_sample >= sc->sample_count) {
+                av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
+                return AVERROR_INVALIDDATA;
+            }
+
+            if (!sc->keyframe_absent && (!sc->keyframe_count || c->current_sample+key_off == sc->keyframes[c->stss_index])) {
+                keyframe = 1;
+                if (c->stss_index + 1 < sc->keyframe_count)
+                    c->stss_index++;
+            } else if (sc->stps_count && c->current_sample+key_off == sc->stps_data[c->stps_index]) {
+                keyframe = 1;
+                if (c->stps_index + 1 < sc->stps_count)
+                    c->stps_index++;
+            }
+            if (rap_group_present && c->rap_group_index < sc->rap_group_count) {
+                if (sc->rap_group[c->rap_group_index].index > 0)
+                    keyframe = 1;
+                if (++c->rap_group_sample == sc->rap_group[c->rap_group_index].count) {
+                    c->rap_group_sample = 0;
+                    c->rap_group_index++;
+                }
+            }
+            if (sc->keyframe_absent
+                && !sc->stps_count
+                && !rap_group_present
+                && (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || (c->chunk == 0 && c->chunk_sample == 0)))
+                 keyframe = 1;
+            if (keyframe)
+                c->distance = 0;
+            sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[c->current_sample];
+            if (c->current_offset > INT64_MAX - sample_size) {
+                av_log(mov->fc, AV_LOG_ERROR, "Current offset %"PRId64" or sample size %u is too large\n",
+                       c->current_offset,
+                       sample_size);
+                return AVERROR_INVALIDDATA;
+            }
+
+            if (sc->pseudo_stream_id == -1 ||
+               sc->stsc_data[c->stsc_index].id - 1 == sc->pseudo_stream_id) {
+                AVIndexEntry *e;
+                if (sample_size > 0x3FFFFFFF) {
+                    av_log(mov->fc, AV_LOG_ERROR, "Sample size %u is too large\n", sample_size);
+                    return AVERROR_INVALIDDATA;
+                }
+                e = &sti->index_entries[sti->nb_index_entries++];
+                e->pos = c->current_offset;
+                e->timestamp = c->current_dts;
+                e->size = sample_size;
+                e->min_distance = c->distance;
+                e->flags = keyframe ? AVINDEX_KEYFRAME : 0;
+                av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, sample %u, offset %"PRIx64", dts %"PRId64", "
+                        "size %u, distance %u, keyframe %d\n", st->index, c->current_sample,
+                        c->current_offset, c->current_dts, sample_size, c->distance, keyframe);
+                if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sti->nb_index_entries < 100)
+                    ff_rfps_add_frame(mov->fc, st, c->current_dts);
+            }
+
+            c->current_offset += sample_size;
+            c->stream_size += sample_size;
+            c->current_dts += sc->stts_data[c->stts_index].duration;
+
+            c->distance++;
+            c->stts_sample++;
+            c->current_sample++;
+            if (c->stts_index + 1 < sc->stts_count && c->stts_sample == sc->stts_data[c->stts_index].count) {
+                c->stts_sample = 0;
+                c->stts_index++;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Build further index entries of a lazily indexed stream so that the index
+ * holds at least nb_entries entries. The sample tables are released once
+ * the whole stream has been indexed, or when indexing fails; the entries
+ * built so far are kept in that case.
+ *
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+static int mov_lazy_index_extend(MOVContext *mov, AVStream *st, unsigned int nb_entries)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    int ret;
+
+    if (!sc->lazy_index || nb_entries <= sti->nb_index_entries)
+        return 0;
+
+    nb_entries = FFMAX(nb_entries, sti->nb_index_entries + MOV_LAZY_INDEX_BATCH);
+    ret = mov_build_index_entries(mov, st, FFMIN(nb_entries, sc->sample_count));
+    if (!ret)
+        return 0;
+
+    /* Fragments append to the ctts table one entry per sample. */
+    sc->lazy_index = 0;
+    if (ret > 0)
+        ret = mov_expand_ctts(sc);
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    av_freep(&sc->stps_data);
+    av_freep(&sc->rap_group);
+    if (ret < 0) {
+        av_log(mov->fc, AV_LOG_ERROR, "Error building the index of stream %d\n", st->index);
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Build the index of a lazily indexed stream up to the first keyframe
+ * following timestamp, so that a seek to timestamp can be resolved.
+ */
+static int mov_lazy_index_seek(MOVContext *mov, AVStream *st, int64_t timestamp)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    int ret;
+
+    while (sc->lazy_index) {
+        for (int i = sti->nb_index_entries - 1;
+             i >= 0 && sti->index_entries[i].timestamp > timestamp; i--)
+            if (sti->index_entries[i].flags & AVINDEX_KEYFRAME)
+                return 0;
+        ret = mov_lazy_index_extend(mov, st, sti->nb_index_entries + MOV_LAZY_INDEX_BATCH);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
     FFStream *const sti = ffstream(st);
     int64_t current_offset;
     int64_t current_dts = 0;
-    unsigned int stts_index = 0;
     unsigned int stsc_index = 0;
-    unsigned int stss_index = 0;
-    unsigned int stps_index = 0;
-    unsigned int i, j;
-    uint64_t stream_size = 0;
-    MOVCtts *ctts_data_old = sc->ctts_data;
-    unsigned int ctts_count_old = sc->ctts_count;
+    unsigned int i;
+    /* A lazily built index cannot be rewritten according to the edit list,
+     * so it is only used for streams with at most one edit, which are then
+     * handled as if advanced_editlist was disabled. */
+    int lazy_index = mov->lazy_index &&
+                     !(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+                       sc->stts_count == 1 && sc->stts_data[0].duration == 1);
+    int advanced_editlist = mov->advanced_editlist && !lazy_index;
 
     int ret = build_open_gop_key_points(st);
     if (ret < 0)
@@ -4617,6 +4859,11 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
             }
         }
 
+        if (multiple_edits) {
+            lazy_index = 0;
+            advanced_editlist = mov->advanced_editlist;
+        }
+
         if (multiple_edits && !mov->advanced_editlist) {
             if (mov->advanced_editlist_autodisabled)
                 av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
@@ -4637,11 +4884,11 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
 
             sc->time_offset = start_time -  (uint64_t)empty_duration;
             sc->min_corrected_pts = start_time;
-            if (!mov->advanced_editlist)
+            if (!advanced_editlist)
                 current_dts = -sc->time_offset;
         }
 
-        if (!multiple_edits && !mov->advanced_editlist &&
+        if (!multiple_edits && !advanced_editlist &&
             st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
             sc->start_pad = start_time;
     }
@@ -4649,14 +4896,7 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     /* only use old uncompressed audio chunk demuxing when stts specifies it */
     if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
           sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
-        unsigned int current_sample = 0;
-        unsigned int stts_sample = 0;
-        unsigned int sample_size;
-        unsigned int distance = 0;
-        unsigned int rap_group_index = 0;
-        unsigned int rap_group_sample = 0;
-        int rap_group_present = sc->rap_group_count && sc->rap_group;
-        int key_off = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+        uint64_t stream_size = 0;
 
         current_dts -= sc->dts_shift;
 
@@ -4664,128 +4904,30 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
             return;
         if (sc->sample_count >= UINT_MAX / sizeof(*sti->index_entries) - sti->nb_index_entries)
             return;
-        if (av_reallocp_array(&sti->index_entries,
-                              sti->nb_index_entries + sc->sample_count,
-                              sizeof(*sti->index_entries)) < 0) {
-            sti->nb_index_entries = 0;
-            return;
-        }
-        sti->index_entries_allocated_size = (sti->nb_index_entries + sc->sample_count) * sizeof(*sti->index_entries);
-
-        if (ctts_data_old) {
-            // Expand ctts entries such that we have a 1-1 mapping with samples
-            if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
-                return;
-            sc->ctts_count = 0;
-            sc->ctts_allocated_size = 0;
-            sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
-                                    sc->sample_count * sizeof(*sc->ctts_data));
-            if (!sc->ctts_data) {
-                av_free(ctts_data_old);
-                return;
-            }
 
-            memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
-
-            for (i = 0; i < ctts_count_old &&
-                        sc->ctts_count < sc->sample_count; i++)
-                for (j = 0; j < ctts_data_old[i].count &&
-                            sc->ctts_count < sc->sample_count; j++)
-                    add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
-                                   &sc->ctts_allocated_size, 1,
-                                   ctts_data_old[i].duration);
-            av_free(ctts_data_old);
-        }
-
-        for (i = 0; i < sc->chunk_count; i++) {
-            int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
-            current_offset = sc->chunk_offsets[i];
-            while (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
-                i + 1 == sc->stsc_data[stsc_index + 1].first)
-                stsc_index++;
+        if (!lazy_index && mov_expand_ctts(sc) < 0)
+            return;
 
-            if (next_offset > current_offset && sc->sample_size>0 && sc->sample_size < sc->stsz_sample_size &&
-                sc->stsc_data[stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - current_offset) {
-                av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too large), ignoring\n", sc->stsz_sample_size);
-                sc->stsz_sample_size = sc->sample_size;
-            }
-            if (sc->stsz_sample_size>0 && sc->stsz_sample_size < sc->sample_size) {
-                av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too small), ignoring\n", sc->stsz_sample_size);
-                sc->stsz_sample_size = sc->sample_size;
-            }
+        memset(&sc->index_cursor, 0, sizeof(sc->index_cursor));
+        sc->index_cursor.current_dts = current_dts;
+        sc->lazy_index = lazy_index;
 
-            for (j = 0; j < sc->stsc_data[stsc_index].count; j++) {
-                int keyframe = 0;
-                if (current_sample >= sc->sample_count) {
-                    av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
-                    return;
-                }
+        if (lazy_index) {
+            /* the sizes were summed up while reading the stsz atom */
+            stream_size = sc->stsz_sample_size > 0 ?
+                          (uint64_t)sc->stsz_sample_size * sc->sample_count : sc->data_size;
 
-                if (!sc->keyframe_absent && (!sc->keyframe_count || current_sample+key_off == sc->keyframes[stss_index])) {
-                    keyframe = 1;
-                    if (stss_index + 1 < sc->keyframe_count)
-                        stss_index++;
-                } else if (sc->stps_count && current_sample+key_off == sc->stps_data[stps_index]) {
-                    keyframe = 1;
-                    if (stps_index + 1 < sc->stps_count)
-                        stps_index++;
-                }
-                if (rap_group_present && rap_group_index < sc->rap_group_count) {
-                    if (sc->rap_group[rap_group_index].index > 0)
-                        keyframe = 1;
-                    if (++rap_group_sample == sc->rap_group[rap_group_index].count) {
-                        rap_group_sample = 0;
-                        rap_group_index++;
-                    }
-                }
-                if (sc->keyframe_absent
-                    && !sc->stps_count
-                    && !rap_group_present
-                    && (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || (i==0 && j==0)))
-                     keyframe = 1;
-                if (keyframe)
-                    distance = 0;
-                sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[current_sample];
-                if (current_offset > INT64_MAX - sample_size) {
-                    av_log(mov->fc, AV_LOG_ERROR, "Current offset %"PRId64" or sample size %u is too large\n",
-                           current_offset,
-                           sample_size);
+            ret = mov_build_index_entries(mov, st, FFMIN(sc->sample_count, MOV_LAZY_INDEX_BATCH));
+            if (ret) {
+                sc->lazy_index = 0;
+                if (ret < 0 || mov_expand_ctts(sc) < 0)
                     return;
-                }
-
-                if (sc->pseudo_stream_id == -1 ||
-                   sc->stsc_data[stsc_index].id - 1 == sc->pseudo_stream_id) {
-                    AVIndexEntry *e;
-                    if (sample_size > 0x3FFFFFFF) {
-                        av_log(mov->fc, AV_LOG_ERROR, "Sample size %u is too large\n", sample_size);
-                        return;
-                    }
-                    e = &sti->index_entries[sti->nb_index_entries++];
-                    e->pos = current_offset;
-                    e->timestamp = current_dts;
-                    e->size = sample_size;
-                    e->min_distance = distance;
-                    e->flags = keyframe ? AVINDEX_KEYFRAME : 0;
-                    av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, sample %u, offset %"PRIx64", dts %"PRId64", "
-                            "size %u, distance %u, keyframe %d\n", st->index, current_sample,
-                            current_offset, current_dts, sample_size, distance, keyframe);
-                    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sti->nb_index_entries < 100)
-                        ff_rfps_add_frame(mov->fc, st, current_dts);
-                }
-
-                current_offset += sample_size;
-                stream_size += sample_size;
-
-                current_dts += sc->stts_data[stts_index].duration;
-
-                distance++;
-                stts_sample++;
-                current_sample++;
-                if (stts_index + 1 < sc->stts_count && stts_sample == sc->stts_data[stts_index].count) {
-                    stts_sample = 0;
-                    stts_index++;
-                }
             }
+        } else {
+            ret = mov_build_index_entries(mov, st, sc->sample_count);
+            if (ret < 0)
+                return;
+            stream_size = sc->index_cursor.stream_size;
         }
         if (st->duration > 0)
             st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
@@ -4891,7 +5033,7 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
     }
 
-    if (!mov->ignore_editlist && mov->advanced_editlist) {
+    if (!mov->ignore_editlist && advanced_editlist) {
         // Fix index according to edit lists.
         mov_fix_index(mov, st);
     }
@@ -5209,14 +5351,16 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             ffstream(st)->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
-    av_freep(&sc->stps_data);
+    /* Do not need those anymore, unless the index is built on demand. */
+    if (!sc->lazy_index) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stts_data);
+        av_freep(&sc->stps_data);
+        av_freep(&sc->rap_group);
+    }
     av_freep(&sc->elst_data);
-    av_freep(&sc->rap_group);
     av_freep(&sc->sync_group);
     av_freep(&sc->sgpd_sync);
 
@@ -5691,7 +5835,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     int64_t dts, pts = AV_NOPTS_VALUE;
     int data_offset = 0;
     unsigned entries, first_sample_flags = frag->flags;
-    int flags, distance, i;
+    int flags, distance, i, ret;
     int64_t prev_dts = AV_NOPTS_VALUE;
     int next_frag_index = -1, index_entry_pos;
     size_t requested_size;
@@ -5720,6 +5864,11 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
 
+    // Samples from the moov atom must precede the fragment samples.
+    ret = mov_lazy_index_extend(c, st, UINT_MAX);
+    if (ret < 0)
+        return ret;
+
     // Find the next frag_index index that has a valid index_entry for
     // the current track_id.
     //
@@ -9509,6 +9658,8 @@ static void mov_read_chapters(AVFormatContext *s)
         sti = ffstream(st);
 
         sc = st->priv_data;
+        if (mov_lazy_index_extend(mov, st, UINT_MAX) < 0)
+            continue;
         cur_pos = avio_tell(sc->pb);
 
         if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
@@ -10568,6 +10719,24 @@ static int mov_read_header(AVFormatContext *s)
     return 0;
 }
 
+/**
+ * Make sure the index of every lazily indexed stream holds the current
+ * sample and the one following it, which is needed for its duration.
+ */
+static int mov_lazy_index_update(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *msc = s->streams[i]->priv_data;
+        int ret = mov_lazy_index_extend(mov, s->streams[i], msc->current_sample + 2);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
 {
     AVIndexEntry *sample = NULL;
@@ -10754,6 +10923,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     int ret;
     mov->fc = s;
  retry:
+    if ((ret = mov_lazy_index_update(s)) < 0)
+        return ret;
     sample = mov_find_next_sample(s, &st);
     if (!sample || (mov->next_root_atom && sample->pos > mov->next_root_atom)) {
         if (!mov->next_root_atom)
@@ -10948,6 +11119,10 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
+    ret = mov_lazy_index_seek(s->priv_data, st, timestamp);
+    if (ret < 0)
+        return ret;
+
     for (;;) {
         sample = av_index_search_timestamp(st, timestamp, flags);
         av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
@@ -11066,7 +11241,11 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
         }
         while (1) {
             MOVStreamContext *sc;
-            AVIndexEntry *entry = mov_find_next_sample(s, &st);
+            AVIndexEntry *entry;
+            int ret = mov_lazy_index_update(s);
+            if (ret < 0)
+                return ret;
+            entry = mov_find_next_sample(s, &st);
             if (!entry)
                 return AVERROR_INVALIDDATA;
             sc = st->priv_data;
@@ -11129,6 +11308,7 @@ static const AVOption mov_options[] = {
         {.i64 = 0}, 0, 1, FLAGS },
     { "max_stts_delta", "treat offsets above this value as invalid", OFFSET(max_stts_delta), AV_OPT_TYPE_INT, {.i64 = UINT_MAX-48000*10 }, 0, UINT_MAX, .flags = AV_OPT_FLAG_DECODING_PARAM },
     { "interleaved_read", "Interleave packets from multiple tracks at demuxer level", OFFSET(interleaved_read), AV_OPT_TYPE_BOOL, {.i64 = 1 }, 0, 1, .flags = AV_OPT_FLAG_DECODING_PARAM },
+    { "lazy_index", "Build the sample index on demand while reading and seeking", OFFSET(lazy_index), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, .flags = AV_OPT_FLAG_DECODING_PARAM },
 
     { NULL },
 };
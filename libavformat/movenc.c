@@ -104,6 +104,7 @@ static const AVOption options[] = {
       { "negative_cts_offsets", "Use negative CTS offsets (reducing the need for edit lists)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "omit_tfhd_offset", "Omit the base data offset in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_OMIT_TFHD_OFFSET}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "prefer_icc", "If writing colr atom prioritise usage of ICC profile if it exists in stream packet side data", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_PREFER_ICC}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
+      { "reserve_moov", "Reserve space for the moov atom at the beginning of the file, sized from the stream durations", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RESERVE_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "rtphint", "Add RTP hint tracks", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RTP_HINT}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "separate_moof", "Write separate moof/mdat atoms for each track", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_SEPARATE_MOOF}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
       { "skip_sidx", "Skip writing of sidx atom", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_SKIP_SIDX}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, .unit = "movflags" },
@@ -7594,6 +7595,50 @@ static int mov_init_iamf_track(AVFormatContext *s)
 }
 #endif
 
+/*
+ * Estimate an upper bound of the moov atom size from the duration and frame
+ * count hints of the streams, or return 0 if some stream has none.
+ */
+static int estimate_moov_size(AVFormatContext *s)
+{
+    int64_t size = 4096;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        const AVStream *st = s->streams[i];
+        const AVCodecParameters *par = st->codecpar;
+        int64_t nb_samples = st->nb_frames;
+        int sample_size;
+
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            /* stsz, stts, stss, chunk offsets, and ctts if reordered */
+            sample_size = 4 + 8 + 4 + 8 + (par->video_delay ? 8 : 0);
+            if (nb_samples <= 0 && st->duration > 0 && st->avg_frame_rate.num > 0)
+                nb_samples = av_rescale_q(st->duration, st->time_base,
+                                          av_inv_q(st->avg_frame_rate));
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+            /* stsz and chunk offsets, the sample duration rarely changes */
+            sample_size = 4 + 8;
+            if (nb_samples <= 0 && st->duration > 0 && par->sample_rate > 0)
+                nb_samples = av_rescale_q(st->duration, st->time_base,
+                                          (AVRational){ FFMAX(par->frame_size, 1024),
+                                                        par->sample_rate });
+        } else {
+            sample_size = 4 + 8 + 8;
+            if (nb_samples <= 0 && st->duration > 0)
+                nb_samples = 1;
+        }
+        if (nb_samples <= 0)
+            return 0;
+
+        size += 4096 + par->extradata_size + (nb_samples + 1) * sample_size;
+        if (size > INT_MAX / 2)
+            return 0;
+    }
+
+    /* leave some margin for the variable parts */
+    return size + size / 8;
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -7656,6 +7701,25 @@ static int mov_init(AVFormatContext *s)
         mov->flags &= ~FF_MOV_FLAG_SKIP_SIDX;
     }
 
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+        if (mov->flags & FF_MOV_FLAG_FRAGMENT || mov->mode == MODE_AVIF) {
+            av_log(s, AV_LOG_WARNING, "reserve_moov is not supported with fragmented output\n");
+            mov->flags &= ~FF_MOV_FLAG_RESERVE_MOOV;
+        } else {
+            if (!mov->reserved_moov_size)
+                mov->reserved_moov_size = estimate_moov_size(s);
+            /* without duration hints, fall back to moving the moov atom
+             * at the end */
+            if (mov->reserved_moov_size > 0) {
+                av_log(s, AV_LOG_VERBOSE, "Reserving %d bytes for the moov atom\n",
+                       mov->reserved_moov_size);
+                mov->flags &= ~FF_MOV_FLAG_FASTSTART;
+            } else {
+                mov->flags |= FF_MOV_FLAG_FASTSTART;
+            }
+        }
+    }
+
     if (mov->flags & FF_MOV_FLAG_FASTSTART) {
         mov->reserved_moov_size = -1;
     }
@@ -8319,6 +8383,50 @@ static int shift_data(AVFormatContext *s)
     return ff_format_shift_data(s, mov->reserved_header_pos, moov_size);
 }
 
+/*
+ * Make room for the moov atom in the space reserved at the beginning of the
+ * file, shifting the data after it if it is too small. Returns the size of the
+ * shift.
+ */
+static int64_t shift_reserved_moov(AVFormatContext *s, int64_t moov_pos)
+{
+    MOVMuxContext *mov = s->priv_data;
+    int moov_size, moov_size2, shift;
+    int ret;
+
+    moov_size = get_moov_size(s);
+    if (moov_size < 0)
+        return moov_size;
+    /* keep room for a free atom */
+    if (moov_size + 8 <= mov->reserved_moov_size)
+        return 0;
+
+    shift = moov_size + 8 - mov->reserved_moov_size;
+    for (int i = 0; i < mov->nb_tracks; i++)
+        mov->tracks[i].data_offset += shift;
+
+    /* the chunk offset tables may have switched from stco to co64 */
+    moov_size2 = get_moov_size(s);
+    if (moov_size2 < 0)
+        return moov_size2;
+    if (moov_size2 != moov_size) {
+        for (int i = 0; i < mov->nb_tracks; i++)
+            mov->tracks[i].data_offset += moov_size2 - moov_size;
+        shift += moov_size2 - moov_size;
+    }
+
+    av_log(s, AV_LOG_INFO, "Reserved moov size %d is too small, shifting the data by %d bytes\n",
+           mov->reserved_moov_size, shift);
+    avio_seek(s->pb, moov_pos, SEEK_SET);
+    ret = ff_format_shift_data(s, mov->reserved_header_pos + mov->reserved_moov_size, shift);
+    if (ret < 0)
+        return ret;
+    mov->reserved_moov_size += shift;
+    avio_seek(s->pb, mov->reserved_header_pos, SEEK_SET);
+
+    return shift;
+}
+
 static int mov_write_trailer(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -8421,6 +8529,12 @@ static int mov_write_trailer(AVFormatContext *s)
                 return res;
         } else if (mov->reserved_moov_size > 0) {
             int64_t size;
+            if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+                int64_t shift = shift_reserved_moov(s, moov_pos);
+                if (shift < 0)
+                    return shift;
+                moov_pos += shift;
+            }
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
                 return res;
             size = mov->reserved_moov_size - (avio_tell(pb) - mov->reserved_header_pos);
@@ -69,6 +69,10 @@ int avformat_query_codec(const AVOutputFormat *ofmt, enum AVCodecID codec_id,
     return AVERROR_PATCHWELCOME;
 }
 
+/* Minimum size of the blocks data is shifted by, so that small shifts are not
+ * done with small reads and writes. */
+#define SHIFT_BLOCK_SIZE (1 << 20)
+
 int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
 {
     int ret;
@@ -76,13 +80,17 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     uint8_t *buf, *read_buf[2];
     int read_buf_id = 0;
     int read_size[2];
+    /* A block must not be overwritten before being read, which holds as long
+     * as blocks are at least shift_size large, since one block is read ahead
+     * of the one being written. */
+    int block_size = FFMAX(shift_size, SHIFT_BLOCK_SIZE);
     AVIOContext *read_pb;
 
-    buf = av_malloc_array(shift_size, 2);
+    buf = av_malloc_array(block_size, 2);
     if (!buf)
         return AVERROR(ENOMEM);
     read_buf[0] = buf;
-    read_buf[1] = buf + shift_size;
+    read_buf[1] = buf + block_size;
 
     /* Shift the data: the AVIO context of the output can only be used for
      * writing, so we re-open the same output, but for reading. It also avoids
@@ -103,11 +111,11 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     pos = avio_tell(read_pb);
 
 #define READ_BLOCK do {                                                             \
-    read_size[read_buf_id] = avio_read(read_pb, read_buf[read_buf_id], shift_size);  \
+    read_size[read_buf_id] = avio_read(read_pb, read_buf[read_buf_id], block_size);  \
     read_buf_id ^= 1;                                                               \
 } while (0)
 
-    /* shift data by chunk of at most shift_size */
+    /* shift data by chunk of at most block_size */
     READ_BLOCK;
     do {
         int n;
@@ -0,0 +1,188 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that the stream information saved with avformat_stream_info_save()
+ * is restored identically by avformat_stream_info_load().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/avcodec.h"
+
+#include "libavformat/avformat.h"
+
+#define NB_CUSTOM_CHANNELS 64
+
+static int open_file(AVFormatContext **ic, const char *filename)
+{
+    int ret = avformat_open_input(ic, filename, NULL, NULL);
+    if (ret < 0)
+        fprintf(stderr, "Cannot open %s\n", filename);
+    return ret;
+}
+
+static int q_equal(AVRational a, AVRational b)
+{
+    return a.num == b.num && a.den == b.den;
+}
+
+static int params_equal(const AVCodecParameters *a, const AVCodecParameters *b)
+{
+    return a->codec_type  == b->codec_type  &&
+           a->codec_id    == b->codec_id    &&
+           a->codec_tag   == b->codec_tag   &&
+           a->format      == b->format      &&
+           a->bit_rate    == b->bit_rate    &&
+           a->profile     == b->profile     &&
+           a->level       == b->level       &&
+           a->width       == b->width       &&
+           a->height      == b->height      &&
+           a->sample_rate == b->sample_rate &&
+           a->frame_size  == b->frame_size  &&
+           a->video_delay == b->video_delay &&
+           q_equal(a->sample_aspect_ratio, b->sample_aspect_ratio) &&
+           q_equal(a->framerate, b->framerate) &&
+           !av_channel_layout_compare(&a->ch_layout, &b->ch_layout) &&
+           a->extradata_size == b->extradata_size &&
+           (!a->extradata_size ||
+            !memcmp(a->extradata, b->extradata, a->extradata_size));
+}
+
+static int contexts_equal(const AVFormatContext *a, const AVFormatContext *b)
+{
+    if (a->nb_streams != b->nb_streams || a->start_time != b->start_time ||
+        a->duration   != b->duration   || a->bit_rate   != b->bit_rate)
+        return 0;
+
+    for (unsigned i = 0; i < a->nb_streams; i++) {
+        const AVStream *sa = a->streams[i], *sb = b->streams[i];
+
+        if (sa->start_time != sb->start_time || sa->duration != sb->duration ||
+            sa->nb_frames  != sb->nb_frames  ||
+            !q_equal(sa->avg_frame_rate, sb->avg_frame_rate) ||
+            !q_equal(sa->r_frame_rate,   sb->r_frame_rate)   ||
+            !params_equal(sa->codecpar, sb->codecpar))
+            return 0;
+    }
+    return 1;
+}
+
+/* a layout whose description is longer than any fixed size buffer */
+static int set_custom_layout(AVFormatContext *ic)
+{
+    for (unsigned i = 0; i < ic->nb_streams; i++) {
+        AVCodecParameters *par = ic->streams[i]->codecpar;
+        int ret;
+
+        if (par->codec_type != AVMEDIA_TYPE_AUDIO)
+            continue;
+        av_channel_layout_uninit(&par->ch_layout);
+        ret = av_channel_layout_custom_init(&par->ch_layout, NB_CUSTOM_CHANNELS);
+        if (ret < 0)
+            return ret;
+        for (int c = 0; c < NB_CUSTOM_CHANNELS; c++) {
+            par->ch_layout.u.map[c].id = AV_CHAN_FRONT_LEFT + c % 2;
+            snprintf(par->ch_layout.u.map[c].name, sizeof(par->ch_layout.u.map[c].name),
+                     "input%d", c);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static int round_trip(const char *filename, int custom_layout)
+{
+    AVFormatContext *ref = NULL, *ic = NULL;
+    uint8_t *data = NULL;
+    size_t size;
+    int ret;
+
+    if ((ret = open_file(&ref, filename)) < 0 ||
+        (ret = avformat_find_stream_info(ref, NULL)) < 0)
+        goto end;
+
+    if (custom_layout) {
+        AVBPrint bp;
+
+        if ((ret = set_custom_layout(ref)) <= 0) {
+            ret = ret ? ret : AVERROR(EINVAL);
+            goto end;
+        }
+        av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+        for (unsigned i = 0; i < ref->nb_streams; i++)
+            if (ref->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+                av_channel_layout_describe_bprint(&ref->streams[i]->codecpar->ch_layout, &bp);
+        printf("custom layout of %d channels, %u characters\n",
+               NB_CUSTOM_CHANNELS, bp.len);
+        av_bprint_finalize(&bp, NULL);
+    }
+
+    if ((ret = avformat_stream_info_save(ref, &data, &size)) < 0) {
+        printf("save: error %d\n", ret);
+        goto end;
+    }
+
+    if ((ret = open_file(&ic, filename)) < 0)
+        goto end;
+
+    /* a truncated buffer must be rejected without changing the context */
+    ret = avformat_stream_info_load(ic, data, size - 1, NULL);
+    printf("load truncated: %s\n", ret == AVERROR_INVALIDDATA ? "invalid data" :
+                                   ret < 0 ? "error" : "loaded");
+
+    ret = avformat_stream_info_load(ic, data, size, NULL);
+    printf("load: %s\n", ret < 0 ? "error" : "loaded");
+    if (ret < 0)
+        goto end;
+
+    for (unsigned i = 0; i < ic->nb_streams; i++) {
+        const AVCodecParameters *par = ic->streams[i]->codecpar;
+        printf("stream %u: %s, format %d, %dx%d, %d Hz, %d channels, extradata %d\n",
+               i, avcodec_get_name(par->codec_id), par->format, par->width,
+               par->height, par->sample_rate, par->ch_layout.nb_channels,
+               par->extradata_size);
+    }
+    ret = contexts_equal(ref, ic);
+    printf("round trip: %s\n", ret ? "identical" : "differs");
+    ret = ret ? 0 : 1;
+
+end:
+    av_free(data);
+    avformat_close_input(&ic);
+    avformat_close_input(&ref);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <input file>\n", argv[0]);
+        return 1;
+    }
+
+    if (round_trip(argv[1], 0) || round_trip(argv[1], 1))
+        return 1;
+
+    return 0;
+}
@@ -447,6 +447,12 @@ av_cold static int auto_matrix(SwrContext *s)
     return ret;
 }
 
+static int native_sparse_size(SwrContext *s)
+{
+    return s->midbuf.fmt == AV_SAMPLE_FMT_S16P ? sizeof(int) :
+                                                 av_get_bytes_per_sample(s->midbuf.fmt);
+}
+
 av_cold int swri_rematrix_init(SwrContext *s){
     int i, j;
     int nb_in  = s->used_ch_layout.nb_channels;
@@ -487,6 +493,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
             s->mix_2_1_f = (mix_2_1_func_type*)sum2_clip_s16;
             s->mix_any_f = (mix_any_func_type*)get_mix_any_func_clip_s16(s);
         }
+        s->mix_n_1_f = (mix_n_1_func_type*)mix_n_1_clip_s16;
     }else if(s->midbuf.fmt == AV_SAMPLE_FMT_FLTP){
         s->native_matrix = av_calloc(nb_in * nb_out, sizeof(float));
         s->native_one    = av_mallocz(sizeof(float));
@@ -499,6 +506,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->mix_1_1_f = (mix_1_1_func_type*)copy_float;
         s->mix_2_1_f = (mix_2_1_func_type*)sum2_float;
         s->mix_any_f = (mix_any_func_type*)get_mix_any_func_float(s);
+        s->mix_n_1_f = (mix_n_1_func_type*)mix_n_1_float;
     }else if(s->midbuf.fmt == AV_SAMPLE_FMT_DBLP){
         s->native_matrix = av_calloc(nb_in * nb_out, sizeof(double));
         s->native_one    = av_mallocz(sizeof(double));
@@ -511,6 +519,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->mix_1_1_f = (mix_1_1_func_type*)copy_double;
         s->mix_2_1_f = (mix_2_1_func_type*)sum2_double;
         s->mix_any_f = (mix_any_func_type*)get_mix_any_func_double(s);
+        s->mix_n_1_f = (mix_n_1_func_type*)mix_n_1_double;
     }else if(s->midbuf.fmt == AV_SAMPLE_FMT_S32P){
         s->native_one    = av_mallocz(sizeof(int));
         if (!s->native_one)
@@ -533,6 +542,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->mix_1_1_f = (mix_1_1_func_type*)copy_s32;
         s->mix_2_1_f = (mix_2_1_func_type*)sum2_s32;
         s->mix_any_f = (mix_any_func_type*)get_mix_any_func_s32(s);
+        s->mix_n_1_f = (mix_n_1_func_type*)mix_n_1_s32;
     }else
         av_assert0(0);
     //FIXME quantize for integeres
@@ -546,6 +556,28 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->matrix_ch[i][0]= ch_in;
     }
 
+    /* the generic mixing only goes through the non zero coefficients */
+    s->native_sparse_matrix = av_calloc(nb_in * nb_out, native_sparse_size(s));
+    if (!s->native_sparse_matrix)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < nb_out; i++) {
+        for (j = 0; j < s->matrix_ch[i][0]; j++) {
+            int in_i = s->matrix_ch[i][1 + j];
+            switch (s->midbuf.fmt) {
+            case AV_SAMPLE_FMT_S16P:
+            case AV_SAMPLE_FMT_S32P:
+                ((int   *)s->native_sparse_matrix)[i * nb_in + j] = s->matrix32[i][in_i];
+                break;
+            case AV_SAMPLE_FMT_FLTP:
+                ((float *)s->native_sparse_matrix)[i * nb_in + j] = s->matrix_flt[i][in_i];
+                break;
+            case AV_SAMPLE_FMT_DBLP:
+                ((double*)s->native_sparse_matrix)[i * nb_in + j] = s->matrix[i][in_i];
+                break;
+            }
+        }
+    }
+
 #if ARCH_X86 && HAVE_X86ASM && HAVE_MMX
     return swri_rematrix_init_x86(s);
 #endif
@@ -558,10 +590,11 @@ av_cold void swri_rematrix_free(SwrContext *s){
     av_freep(&s->native_one);
     av_freep(&s->native_simd_matrix);
     av_freep(&s->native_simd_one);
+    av_freep(&s->native_sparse_matrix);
 }
 
 int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mustcopy){
-    int out_i, in_i, i, j;
+    int out_i, in_i, j;
     int len1 = 0;
     int off = 0;
 
@@ -607,35 +640,22 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
             if(len != len1)
                 s->mix_2_1_f   (out->ch[out_i]+off, in->ch[in_i1]+off, in->ch[in_i2]+off, s->native_matrix, in->ch_count*out_i + in_i1, in->ch_count*out_i + in_i2, len-len1);
             break;}
-        default:
-            if(s->int_sample_fmt == AV_SAMPLE_FMT_FLTP){
-                for(i=0; i<len; i++){
-                    float v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((float*)in->ch[in_i])[i] * s->matrix_flt[out_i][in_i];
-                    }
-                    ((float*)out->ch[out_i])[i]= v;
-                }
-            }else if(s->int_sample_fmt == AV_SAMPLE_FMT_DBLP){
-                for(i=0; i<len; i++){
-                    double v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((double*)in->ch[in_i])[i] * s->matrix[out_i][in_i];
-                    }
-                    ((double*)out->ch[out_i])[i]= v;
-                }
-            }else{
-                for(i=0; i<len; i++){
-                    int v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((int16_t*)in->ch[in_i])[i] * s->matrix32[out_i][in_i];
-                    }
-                    ((int16_t*)out->ch[out_i])[i]= (v + 16384)>>15;
-                }
+        default: {
+            const uint8_t *in_ch[SWR_CH_MAX];
+            const uint8_t *coeffp = s->native_sparse_matrix + out_i * in->ch_count * native_sparse_size(s);
+            int nb  = s->matrix_ch[out_i][0];
+            int len2 = s->mix_n_1_simd ? len & ~15 : 0;
+
+            for(j=0; j<nb; j++)
+                in_ch[j] = in->ch[s->matrix_ch[out_i][1+j]];
+            if(len2)
+                s->mix_n_1_simd(out->ch[out_i], (const void **)in_ch, coeffp, nb, len2);
+            if(len != len2) {
+                for(j=0; j<nb; j++)
+                    in_ch[j] += len2 * out->bps;
+                s->mix_n_1_f(out->ch[out_i] + len2 * out->bps, (const void **)in_ch, coeffp, nb, len - len2);
             }
+            break;}
         }
     }
     return 0;
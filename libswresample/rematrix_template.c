@@ -87,6 +87,29 @@ static void RENAME(mix8to2)(SAMPLE **out, const SAMPLE **in, COEFF *coeffp, inte
     }
 }
 
+#if !defined(TEMPLATE_REMATRIX_S16) || defined(TEMPLATE_CLIP)
+static void RENAME(mix_n_1)(SAMPLE *out, const SAMPLE * const *in, const COEFF *coeffp, integer nb_in, integer len){
+    INTER acc[256];
+    int i, j, k;
+
+    /* accumulate one input at a time over blocks that stay in cache */
+    for(k=0; k<len; k+=FF_ARRAY_ELEMS(acc)) {
+        int n = FFMIN(len - k, FF_ARRAY_ELEMS(acc));
+        INTER coeff = coeffp[0];
+
+        for(i=0; i<n; i++)
+            acc[i] = coeff*in[0][k + i];
+        for(j=1; j<nb_in; j++) {
+            coeff = coeffp[j];
+            for(i=0; i<n; i++)
+                acc[i] += coeff*in[j][k + i];
+        }
+        for(i=0; i<n; i++)
+            out[k + i] = R(acc[i]);
+    }
+}
+#endif
+
 static RENAME(mix_any_func_type) *RENAME(get_mix_any_func)(SwrContext *s){
     if (  !av_channel_layout_compare(&s->out_ch_layout, &(AVChannelLayout)AV_CHANNEL_LAYOUT_STEREO)
        && (   !av_channel_layout_compare(&s->in_ch_layout, &(AVChannelLayout)AV_CHANNEL_LAYOUT_5POINT1)
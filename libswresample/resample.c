@@ -28,8 +28,226 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/mem.h"
+#include "libavutil/tx.h"
 #include "resample.h"
 
+/* largest prototype filter turned into a minimum phase one, in taps */
+#define MIN_PHASE_MAX_LEN (1 << 14)
+
+/**
+ * Turn a filter into the minimum phase filter with the same magnitude
+ * response, through its folded real cepstrum.
+ * @param h   filter taps, replaced by the minimum phase ones
+ * @param len number of taps
+ * @return 0 on success, negative on error
+ */
+static int min_phase_filter(double *h, int len)
+{
+    AVTXContext *fft = NULL, *ifft = NULL;
+    av_tx_fn fft_fn, ifft_fn;
+    AVComplexDouble *a, *b;
+    double scale = 1.0, max = 0;
+    int i, n = 1 << av_ceil_log2(16 * len);
+    int ret;
+
+    a = av_malloc_array(n, sizeof(*a));
+    b = av_malloc_array(n, sizeof(*b));
+    if (!a || !b) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    if ((ret = av_tx_init(&fft,  &fft_fn,  AV_TX_DOUBLE_FFT, 0, n, &scale, 0)) < 0 ||
+        (ret = av_tx_init(&ifft, &ifft_fn, AV_TX_DOUBLE_FFT, 1, n, &scale, 0)) < 0)
+        goto fail;
+
+    for (i = 0; i < n; i++)
+        a[i] = (AVComplexDouble){ i < len ? h[i] : 0, 0 };
+    fft_fn(fft, b, a, sizeof(*a));
+
+    /* log magnitude, floored at -200 dB to keep the stopband zeros finite */
+    for (i = 0; i < n; i++) {
+        b[i].re = hypot(b[i].re, b[i].im);
+        max = FFMAX(max, b[i].re);
+    }
+    for (i = 0; i < n; i++)
+        b[i] = (AVComplexDouble){ log(FFMAX(b[i].re, max * 1e-10)), 0 };
+    ifft_fn(ifft, a, b, sizeof(*a));
+
+    /* fold the anticausal part of the cepstrum onto the causal one */
+    a[0].re /= n;
+    a[0].im  = 0;
+    for (i = 1; i < n / 2; i++)
+        a[i] = (AVComplexDouble){ 2 * a[i].re / n, 0 };
+    a[n / 2].re /= n;
+    a[n / 2].im  = 0;
+    for (i = n / 2 + 1; i < n; i++)
+        a[i] = (AVComplexDouble){ 0, 0 };
+    fft_fn(fft, b, a, sizeof(*a));
+
+    for (i = 0; i < n; i++) {
+        double m = exp(b[i].re);
+        b[i] = (AVComplexDouble){ m * cos(b[i].im), m * sin(b[i].im) };
+    }
+    ifft_fn(ifft, a, b, sizeof(*a));
+
+    for (i = 0; i < len; i++)
+        h[i] = a[i].re / n;
+    ret = 0;
+fail:
+    av_tx_uninit(&fft);
+    av_tx_uninit(&ifft);
+    av_free(a);
+    av_free(b);
+    return ret;
+}
+
+/* normalize so that an uniform color remains the same */
+static void write_phase(ResampleContext *c, void *filter, const double *tab, int ph,
+                        int tap_count, int alloc, int phase_count, int scale,
+                        double norm, int mirror)
+{
+    int i;
+
+    switch(c->format){
+    case AV_SAMPLE_FMT_S16P:
+        for(i=0;i<tap_count;i++)
+            ((int16_t*)filter)[ph * alloc + i] = av_clip_int16(lrintf(tab[i] * scale / norm));
+        if (!mirror) break;
+        for (i = 0; i < tap_count; i++)
+            ((int16_t*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((int16_t*)filter)[ph * alloc + i];
+        break;
+    case AV_SAMPLE_FMT_S32P:
+        for(i=0;i<tap_count;i++)
+            ((int32_t*)filter)[ph * alloc + i] = av_clipl_int32(llrint(tab[i] * scale / norm));
+        if (!mirror) break;
+        for (i = 0; i < tap_count; i++)
+            ((int32_t*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((int32_t*)filter)[ph * alloc + i];
+        break;
+    case AV_SAMPLE_FMT_FLTP:
+        for(i=0;i<tap_count;i++)
+            ((float*)filter)[ph * alloc + i] = tab[i] * scale / norm;
+        if (!mirror) break;
+        for (i = 0; i < tap_count; i++)
+            ((float*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((float*)filter)[ph * alloc + i];
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        for(i=0;i<tap_count;i++)
+            ((double*)filter)[ph * alloc + i] = tab[i] * scale / norm;
+        if (!mirror) break;
+        for (i = 0; i < tap_count; i++)
+            ((double*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((double*)filter)[ph * alloc + i];
+        break;
+    }
+}
+
+/**
+ * Apply the filter window to one tap of the sinc.
+ * @param y    sinc value at x
+ * @param x    M_PI * t * factor
+ * @param t    time offset of the tap, in input samples
+ */
+static double window_tap(double y, double x, double t, double factor, int tap_count,
+                         int filter_type, double kaiser_beta)
+{
+    double w;
+
+    switch(filter_type){
+    case SWR_FILTER_TYPE_CUBIC:{
+        const float d= -0.5; //first order derivative = -0.5
+        x = fabs(t * factor);
+        if(x<1.0) y= 1 - 3*x*x + 2*x*x*x + d*(            -x*x + x*x*x);
+        else      y=                       d*(-4 + 8*x - 5*x*x + x*x*x);
+        break;}
+    case SWR_FILTER_TYPE_BLACKMAN_NUTTALL:
+        w = 2.0*x / (factor*tap_count);
+        t = -cos(w);
+        y *= 0.3635819 - 0.4891775 * t + 0.1365995 * (2*t*t-1) - 0.0106411 * (4*t*t*t - 3*t);
+        break;
+    case SWR_FILTER_TYPE_KAISER:
+        w = 2.0*x / (factor*tap_count*M_PI);
+        y *= av_bessel_i0(kaiser_beta*sqrt(FFMAX(1-w*w, 0)));
+        break;
+    default:
+        av_assert0(0);
+    }
+    return y;
+}
+
+/**
+ * Build the minimum phase version of the filter bank.
+ *
+ * The prototype filter is sampled with at most MIN_PHASE_MAX_LEN taps, so
+ * that the cepstral FFT stays small for large phase counts, and the minimum
+ * phase response is linearly interpolated to the phases of the bank.
+ * @param tab scratch buffer of tap_count elements
+ * @return 0 on success, negative on error
+ */
+static int build_min_phase_filter(ResampleContext *c, void *filter, double *tab, double factor,
+                                  int tap_count, int alloc, int phase_count, int scale,
+                                  int filter_type, double kaiser_beta)
+{
+    const int center = (tap_count - 1) / 2;
+    int nb_phases = phase_count;
+    int len;
+    double *lin, norm = 0, delay = 0;
+    int ph, i, ret;
+
+    if ((int64_t)tap_count * phase_count > MIN_PHASE_MAX_LEN)
+        nb_phases = 1 << av_log2(FFMAX(MIN_PHASE_MAX_LEN / tap_count, 1));
+    len = tap_count * nb_phases;
+
+    lin = av_malloc_array(len, sizeof(*lin));
+    if (!lin)
+        return AVERROR(ENOMEM);
+
+    /* ordered by increasing time offset, ending at the newest input sample */
+    for (i = 0; i < len; i++) {
+        int64_t num = i - nb_phases + 1 - (int64_t)center * nb_phases;
+        double t = (double)num / nb_phases;
+        double x = M_PI * t * factor;
+        double y = num ? sin(x) / x : 1.0;
+
+        lin[i] = window_tap(y, x, t, factor, tap_count, filter_type, kaiser_beta);
+    }
+
+    ret = min_phase_filter(lin, len);
+    if (ret < 0)
+        goto fail;
+
+    /* the taps now start at the most recent input sample, align the
+     * output on the group delay of the filter at DC */
+    for (i = 0; i < len; i++) {
+        norm  += lin[i];
+        delay += lin[i] * i;
+    }
+    if (c->filter_center < 0)
+        c->filter_center = tap_count - 1 -
+                           av_clip(lrint(delay / norm / nb_phases), 0, tap_count - 1);
+
+    for (ph = 0; ph < phase_count; ph++) {
+        norm = 0;
+        for (i = 0; i < tap_count; i++) {
+            /* position of the tap on the prototype grid, in 1/phase_count units */
+            int64_t pos = ((int64_t)(tap_count - 1 - i) * phase_count + ph + 1) * nb_phases - phase_count;
+            int idx     = pos < 0 ? -1 : pos / phase_count;
+            double frac = (double)(pos - (int64_t)idx * phase_count) / phase_count;
+
+            tab[i] = 0;
+            if (idx >= 0)
+                tab[i] += lin[idx] * (1 - frac);
+            if (idx + 1 < len)
+                tab[i] += lin[idx + 1] * frac;
+            norm += tab[i];
+        }
+        /* each phase keeps the unity gain at DC */
+        write_phase(c, filter, tab, ph, tap_count, alloc, phase_count, scale, norm, 0);
+    }
+
+fail:
+    av_free(lin);
+    return ret;
+}
+
 /**
  * builds a polyphase filterbank.
  * @param factor resampling factor
@@ -42,7 +260,7 @@ static int build_filter(ResampleContext *c, void *filter, double factor, int tap
                         int filter_type, double kaiser_beta){
     int ph, i;
     int ph_nb = phase_count % 2 ? phase_count : phase_count / 2 + 1;
-    double x, y, w, t, s;
+    double x, y, s;
     double *tab = av_malloc_array(tap_count+1,  sizeof(*tab));
     double *sin_lut = av_malloc_array(ph_nb, sizeof(*sin_lut));
     const int center= (tap_count-1)/2;
@@ -58,6 +276,12 @@ static int build_filter(ResampleContext *c, void *filter, double factor, int tap
     if (factor > 1.0)
         factor = 1.0;
 
+    if (c->low_delay && tap_count > 1) {
+        ret = build_min_phase_filter(c, filter, tab, factor, tap_count, alloc, phase_count,
+                                     scale, filter_type, kaiser_beta);
+        goto fail;
+    }
+
     if (factor == 1.0) {
         for (ph = 0; ph < ph_nb; ph++)
             sin_lut[ph] = sin(M_PI * ph / phase_count) * (center & 1 ? 1 : -1);
@@ -71,25 +295,8 @@ static int build_filter(ResampleContext *c, void *filter, double factor, int tap
                 y = s / x;
             else
                 y = sin(x) / x;
-            switch(filter_type){
-            case SWR_FILTER_TYPE_CUBIC:{
-                const float d= -0.5; //first order derivative = -0.5
-                x = fabs(((double)(i - center) - (double)ph / phase_count) * factor);
-                if(x<1.0) y= 1 - 3*x*x + 2*x*x*x + d*(            -x*x + x*x*x);
-                else      y=                       d*(-4 + 8*x - 5*x*x + x*x*x);
-                break;}
-            case SWR_FILTER_TYPE_BLACKMAN_NUTTALL:
-                w = 2.0*x / (factor*tap_count);
-                t = -cos(w);
-                y *= 0.3635819 - 0.4891775 * t + 0.1365995 * (2*t*t-1) - 0.0106411 * (4*t*t*t - 3*t);
-                break;
-            case SWR_FILTER_TYPE_KAISER:
-                w = 2.0*x / (factor*tap_count*M_PI);
-                y *= av_bessel_i0(kaiser_beta*sqrt(FFMAX(1-w*w, 0)));
-                break;
-            default:
-                av_assert0(0);
-            }
+            y = window_tap(y, x, (double)(i - center) - (double)ph / phase_count,
+                           factor, tap_count, filter_type, kaiser_beta);
 
             tab[i] = y;
             s = -s;
@@ -97,37 +304,8 @@ static int build_filter(ResampleContext *c, void *filter, double factor, int tap
                 norm += y;
         }
 
-        /* normalize so that an uniform color remains the same */
-        switch(c->format){
-        case AV_SAMPLE_FMT_S16P:
-            for(i=0;i<tap_count;i++)
-                ((int16_t*)filter)[ph * alloc + i] = av_clip_int16(lrintf(tab[i] * scale / norm));
-            if (phase_count % 2) break;
-            for (i = 0; i < tap_count; i++)
-                ((int16_t*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((int16_t*)filter)[ph * alloc + i];
-            break;
-        case AV_SAMPLE_FMT_S32P:
-            for(i=0;i<tap_count;i++)
-                ((int32_t*)filter)[ph * alloc + i] = av_clipl_int32(llrint(tab[i] * scale / norm));
-            if (phase_count % 2) break;
-            for (i = 0; i < tap_count; i++)
-                ((int32_t*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((int32_t*)filter)[ph * alloc + i];
-            break;
-        case AV_SAMPLE_FMT_FLTP:
-            for(i=0;i<tap_count;i++)
-                ((float*)filter)[ph * alloc + i] = tab[i] * scale / norm;
-            if (phase_count % 2) break;
-            for (i = 0; i < tap_count; i++)
-                ((float*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((float*)filter)[ph * alloc + i];
-            break;
-        case AV_SAMPLE_FMT_DBLP:
-            for(i=0;i<tap_count;i++)
-                ((double*)filter)[ph * alloc + i] = tab[i] * scale / norm;
-            if (phase_count % 2) break;
-            for (i = 0; i < tap_count; i++)
-                ((double*)filter)[(phase_count-ph) * alloc + tap_count-1-i] = ((double*)filter)[ph * alloc + i];
-            break;
-        }
+        write_phase(c, filter, tab, ph, tap_count, alloc, phase_count, scale, norm,
+                    !(phase_count % 2));
     }
 #if 0
     {
@@ -183,7 +361,7 @@ static void resample_free(ResampleContext **cc){
 
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational, int low_delay)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -206,7 +384,8 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     if (!c || c->phase_count != phase_count || c->linear!=linear || c->factor != factor
            || c->filter_length != filter_length || c->format != format
-           || c->filter_type != filter_type || c->kaiser_beta != kaiser_beta) {
+           || c->filter_type != filter_type || c->kaiser_beta != kaiser_beta
+           || c->low_delay != low_delay) {
         resample_free(&c);
         c = av_mallocz(sizeof(*c));
         if (!c)
@@ -246,6 +425,8 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
         c->phase_count_compensation = phase_count_compensation;
+        c->low_delay     = low_delay;
+        c->filter_center = low_delay && filter_length > 1 ? -1 : (filter_length - 1) / 2;
         if (!c->filter_bank)
             goto error;
         if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
@@ -265,7 +446,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
     c->dst_incr_div   = c->dst_incr / c->src_incr;
     c->dst_incr_mod   = c->dst_incr % c->src_incr;
 
-    c->index= -phase_count*((c->filter_length-1)/2);
+    c->index= -phase_count*c->filter_center;
     c->frac= 0;
 
     swri_resample_dsp_init(c);
@@ -388,7 +569,13 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
+            i = 0;
+            if (resample_func == c->dsp.resample_common && c->dsp.resample_common_x4) {
+                for (; i + 4 <= dst->ch_count; i += 4)
+                    *consumed = c->dsp.resample_common_x4(c, dst->ch + i, src->ch + i, dst_size,
+                                                          i + 4 == dst->ch_count);
+            }
+            for (; i < dst->ch_count; i++)
                 *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
         }
     }
@@ -407,7 +594,7 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
 
 static int64_t get_delay(struct SwrContext *s, int64_t base){
     ResampleContext *c = s->resample;
-    int64_t num = s->in_buffer_count - (c->filter_length-1)/2;
+    int64_t num = s->in_buffer_count - c->filter_center;
     num *= c->phase_count;
     num -= c->index;
     num *= c->src_incr;
@@ -438,7 +625,8 @@ static int resample_flush(struct SwrContext *s) {
     ResampleContext *c = s->resample;
     AudioData *a= &s->in_buffer;
     int i, j, ret;
-    int reflection = (FFMIN(s->in_buffer_count, c->filter_length) + 1) / 2;
+    int reflection = c->low_delay ? FFMIN(s->in_buffer_count, c->filter_length - 1 - c->filter_center) :
+                                    (FFMIN(s->in_buffer_count, c->filter_length) + 1) / 2;
 
     if((ret = swri_realloc_audio(a, s->in_buffer_index + s->in_buffer_count + reflection)) < 0)
         return ret;
@@ -462,6 +650,21 @@ static int invert_initial_buffer(ResampleContext *c, AudioData *dst, const Audio
     if (c->index >= 0)
         return 0;
 
+    /* start from silence instead of waiting for enough input to mirror */
+    if (c->low_delay) {
+        if ((res = swri_realloc_audio(dst, c->filter_length)) < 0)
+            return res;
+        *out_idx = c->filter_length;
+        while (c->index < 0) {
+            --*out_idx;
+            c->index += c->phase_count;
+        }
+        *out_sz = c->filter_length - *out_idx;
+        for (ch = 0; ch < dst->ch_count; ch++)
+            memset(dst->ch[ch] + *out_idx * c->felem_size, 0, *out_sz * c->felem_size);
+        return 0;
+    }
+
     if ((res = swri_realloc_audio(dst, c->filter_length * 2 + 1)) < 0)
         return res;
 
@@ -49,6 +49,8 @@ typedef struct ResampleContext {
     int felem_size;
     int filter_shift;
     int phase_count_compensation;      /* desired phase_count when compensation is enabled */
+    int low_delay;                     /* minimum phase filter */
+    int filter_center;                 /* tap aligned with the output sample */
 
     struct {
         void (*resample_one)(void *dst, const void *src,
@@ -57,6 +59,10 @@ typedef struct ResampleContext {
                                const void *src, int n, int update_ctx);
         int (*resample_linear)(struct ResampleContext *c, void *dst,
                                const void *src, int n, int update_ctx);
+        /* same as resample_common, but for 4 planes at once, sharing the
+         * filter phase between them */
+        int (*resample_common_x4)(struct ResampleContext *c, uint8_t * const *dst,
+                                  uint8_t * const *src, int n, int update_ctx);
     } dsp;
 } ResampleContext;
 
@@ -45,29 +45,41 @@
 
 void swri_resample_dsp_init(ResampleContext *c)
 {
+    int (*resample_common_c)(ResampleContext *c, void *dst,
+                             const void *src, int n, int update_ctx);
+    int (*resample_common_x4_c)(ResampleContext *c, uint8_t * const *dst,
+                                uint8_t * const *src, int n, int update_ctx);
+
     switch(c->format){
     case AV_SAMPLE_FMT_S16P:
         c->dsp.resample_one = resample_one_int16;
         c->dsp.resample_common = resample_common_int16;
         c->dsp.resample_linear = resample_linear_int16;
+        c->dsp.resample_common_x4 = resample_common_x4_int16;
         break;
     case AV_SAMPLE_FMT_S32P:
         c->dsp.resample_one = resample_one_int32;
         c->dsp.resample_common = resample_common_int32;
         c->dsp.resample_linear = resample_linear_int32;
+        c->dsp.resample_common_x4 = resample_common_x4_int32;
         break;
     case AV_SAMPLE_FMT_FLTP:
         c->dsp.resample_one = resample_one_float;
         c->dsp.resample_common = resample_common_float;
         c->dsp.resample_linear = resample_linear_float;
+        c->dsp.resample_common_x4 = resample_common_x4_float;
         break;
     case AV_SAMPLE_FMT_DBLP:
         c->dsp.resample_one = resample_one_double;
         c->dsp.resample_common = resample_common_double;
         c->dsp.resample_linear = resample_linear_double;
+        c->dsp.resample_common_x4 = resample_common_x4_double;
         break;
     }
 
+    resample_common_c    = c->dsp.resample_common;
+    resample_common_x4_c = c->dsp.resample_common_x4;
+
 #if ARCH_X86
     swri_resample_dsp_x86_init(c);
 #elif ARCH_ARM
@@ -75,4 +87,10 @@ void swri_resample_dsp_init(ResampleContext *c)
 #elif ARCH_AARCH64
     swri_resample_dsp_aarch64_init(c);
 #endif
+
+    /* the C batched version is only worth it over the C single plane one,
+     * not over SIMD single plane versions */
+    if (c->dsp.resample_common    != resample_common_c &&
+        c->dsp.resample_common_x4 == resample_common_x4_c)
+        c->dsp.resample_common_x4 = NULL;
 }
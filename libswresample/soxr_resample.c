@@ -29,8 +29,12 @@
 
 #include <soxr.h>
 
+#ifndef SOXR_MINIMUM_PHASE /* older versions only have linear phase filters */
+#define SOXR_MINIMUM_PHASE 0
+#endif
+
 static struct ResampleContext *create(struct ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
-        double cutoff, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta, double precision, int cheby, int exact_rational){
+        double cutoff, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta, double precision, int cheby, int exact_rational, int low_delay){
     soxr_error_t error;
 
     soxr_datatype_t type =
@@ -45,7 +49,8 @@ static struct ResampleContext *create(struct ResampleContext *c, int out_rate, i
 
     soxr_io_spec_t io_spec = soxr_io_spec(type, type);
 
-    soxr_quality_spec_t q_spec = soxr_quality_spec((int)((precision-2)/4), (SOXR_HI_PREC_CLOCK|SOXR_ROLLOFF_NONE)*!!cheby);
+    soxr_quality_spec_t q_spec = soxr_quality_spec((int)((precision-2)/4) | SOXR_MINIMUM_PHASE*!!low_delay,
+                                                   (SOXR_HI_PREC_CLOCK|SOXR_ROLLOFF_NONE)*!!cheby);
     q_spec.precision = precision;
 #if !defined SOXR_VERSION /* Deprecated @ March 2013: */
     q_spec.bw_pc = cutoff? FFMAX(FFMIN(cutoff,.995),.8)*100 : q_spec.bw_pc;
@@ -24,6 +24,7 @@ SECTION_RODATA 32
 flt2pm31: times 8 dd 4.6566129e-10
 flt2p31 : times 8 dd 2147483648.0
 flt2p15 : times 8 dd 32768.0
+dbl2pm31: times 2 dq 0x3E00000000000000
 
 word_unpack_shuf : db  0, 1, 4, 5, 8, 9,12,13, 2, 3, 6, 7,10,11,14,15
 
@@ -605,6 +606,41 @@ pack_8ch_%2_to_%1_u_int %+ SUFFIX:
     packssdw  m1, m3
 %endmacro
 
+%macro INT32_TO_DOUBLE_INIT 6
+    mova      %5, [dbl2pm31]
+%endmacro
+%macro INT32_TO_DOUBLE_N 6
+    pshufd    m3, m1, q3232
+    cvtdq2pd  m2, m1
+    cvtdq2pd  m3, m3
+    pshufd    m1, m0, q3232
+    cvtdq2pd  m0, m0
+    cvtdq2pd  m1, m1
+    mulpd     m0, %5
+    mulpd     m1, %5
+    mulpd     m2, %5
+    mulpd     m3, %5
+%endmacro
+
+%macro FLOAT_TO_DOUBLE_N 6
+    movhlps   m3, m1
+    cvtps2pd  m2, m1
+    cvtps2pd  m3, m3
+    movhlps   m1, m0
+    cvtps2pd  m0, m0
+    cvtps2pd  m1, m1
+%endmacro
+
+%macro DOUBLE_TO_FLOAT_N 6
+    cvtpd2ps  m0, m0
+    cvtpd2ps  m1, m1
+    cvtpd2ps  m2, m2
+    cvtpd2ps  m3, m3
+    movlhps   m0, m1
+    movlhps   m2, m3
+    SWAP 1,2
+%endmacro
+
 %macro NOP_N 0-6
 %endmacro
 
@@ -647,6 +683,12 @@ CONV float, int16, u, 2, 1, INT16_TO_FLOAT_N, INT16_TO_FLOAT_INIT
 CONV float, int16, a, 2, 1, INT16_TO_FLOAT_N, INT16_TO_FLOAT_INIT
 CONV int16, float, u, 1, 2, FLOAT_TO_INT16_N, FLOAT_TO_INT16_INIT
 CONV int16, float, a, 1, 2, FLOAT_TO_INT16_N, FLOAT_TO_INT16_INIT
+CONV double, int32, u, 3, 2, INT32_TO_DOUBLE_N, INT32_TO_DOUBLE_INIT
+CONV double, int32, a, 3, 2, INT32_TO_DOUBLE_N, INT32_TO_DOUBLE_INIT
+CONV double, float, u, 3, 2, FLOAT_TO_DOUBLE_N, NOP_N
+CONV double, float, a, 3, 2, FLOAT_TO_DOUBLE_N, NOP_N
+CONV float, double, u, 2, 3, DOUBLE_TO_FLOAT_N, NOP_N
+CONV float, double, a, 2, 3, DOUBLE_TO_FLOAT_N, NOP_N
 
 PACK_2CH float, int32, u, 2, 2, INT32_TO_FLOAT_N, INT32_TO_FLOAT_INIT
 PACK_2CH float, int32, a, 2, 2, INT32_TO_FLOAT_N, INT32_TO_FLOAT_INIT
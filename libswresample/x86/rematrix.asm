@@ -24,6 +24,8 @@
 SECTION_RODATA 32
 dw1: times 8  dd 1
 w1 : times 16 dw 1
+pd_16384: times 8 dd 16384
+pq_16384: times 4 dq 16384
 
 SECTION .text
 
@@ -222,6 +224,143 @@ mix_2_1_int16_u_int %+ SUFFIX:
 %endif
 %endmacro
 
+%if ARCH_X86_64
+; void mix_n_1(void *out, const void * const *in, const void *coeffp,
+;              integer nb_in, integer len)
+; len is a multiple of 16, inputs are accumulated in the order of the
+; C version so that the output is bitexact
+%macro MIX_N_1_FLT 0
+cglobal mix_n_1_float, 5, 8, 6, out, in, coeffp, nb_in, len, off, j, ptr
+    shl              lenq, 2
+    xor              offq, offq
+.next:
+    mov              ptrq, [inq]
+    VBROADCASTSS       m4, [coeffpq]
+    mulps              m0, m4, [ptrq + offq]
+    mulps              m1, m4, [ptrq + offq + mmsize]
+    mov                jq, 1
+    cmp                jq, nb_inq
+    jge .store
+.in_loop:
+    mov              ptrq, [inq + jq*gprsize]
+    VBROADCASTSS       m4, [coeffpq + jq*4]
+    mulps              m2, m4, [ptrq + offq]
+    mulps              m3, m4, [ptrq + offq + mmsize]
+    addps              m0, m2
+    addps              m1, m3
+    inc                jq
+    cmp                jq, nb_inq
+    jl .in_loop
+.store:
+    movu  [outq + offq         ], m0
+    movu  [outq + offq + mmsize], m1
+    add              offq, mmsize*2
+    cmp              offq, lenq
+    jl .next
+    RET
+%endmacro
+
+%macro MIX_N_1_INT16 0
+cglobal mix_n_1_int16, 5, 8, 6, out, in, coeffp, nb_in, len, off, j, ptr
+    add              lenq, lenq
+    xor              offq, offq
+.next:
+    mov              ptrq, [inq]
+    vpbroadcastd       m4, [coeffpq]
+    pmovsxwd           m0, [ptrq + offq]
+    pmovsxwd           m1, [ptrq + offq + mmsize/2]
+    pmulld             m0, m4
+    pmulld             m1, m4
+    mov                jq, 1
+    cmp                jq, nb_inq
+    jge .store
+.in_loop:
+    mov              ptrq, [inq + jq*gprsize]
+    vpbroadcastd       m4, [coeffpq + jq*4]
+    pmovsxwd           m2, [ptrq + offq]
+    pmovsxwd           m3, [ptrq + offq + mmsize/2]
+    pmulld             m2, m4
+    pmulld             m3, m4
+    paddd              m0, m2
+    paddd              m1, m3
+    inc                jq
+    cmp                jq, nb_inq
+    jl .in_loop
+.store:
+    mova               m5, [pd_16384]
+    paddd              m0, m5
+    paddd              m1, m5
+    psrad              m0, 15
+    psrad              m1, 15
+    packssdw           m0, m1
+    vpermq             m0, m0, q3120
+    movu     [outq + offq], m0
+    add              offq, mmsize
+    cmp              offq, lenq
+    jl .next
+    RET
+%endmacro
+
+; the products are accumulated in 64 bits like the C version, only the low
+; 32 bits of the rounded result are stored
+%macro MIX_N_1_INT32 0
+cglobal mix_n_1_int32, 5, 8, 8, out, in, coeffp, nb_in, len, off, j, ptr
+    shl              lenq, 2
+    xor              offq, offq
+.next:
+    mov              ptrq, [inq]
+    vpbroadcastd       m4, [coeffpq]
+    pmovsxdq           m0, [ptrq + offq]
+    pmovsxdq           m1, [ptrq + offq + mmsize/2]
+    pmovsxdq           m2, [ptrq + offq + mmsize]
+    pmovsxdq           m3, [ptrq + offq + mmsize*3/2]
+    pmuldq             m0, m4
+    pmuldq             m1, m4
+    pmuldq             m2, m4
+    pmuldq             m3, m4
+    mov                jq, 1
+    cmp                jq, nb_inq
+    jge .store
+.in_loop:
+    mov              ptrq, [inq + jq*gprsize]
+    vpbroadcastd       m4, [coeffpq + jq*4]
+    pmovsxdq           m5, [ptrq + offq]
+    pmovsxdq           m6, [ptrq + offq + mmsize/2]
+    pmuldq             m5, m4
+    pmuldq             m6, m4
+    paddq              m0, m5
+    paddq              m1, m6
+    pmovsxdq           m5, [ptrq + offq + mmsize]
+    pmovsxdq           m6, [ptrq + offq + mmsize*3/2]
+    pmuldq             m5, m4
+    pmuldq             m6, m4
+    paddq              m2, m5
+    paddq              m3, m6
+    inc                jq
+    cmp                jq, nb_inq
+    jl .in_loop
+.store:
+    mova               m7, [pq_16384]
+    paddq              m0, m7
+    paddq              m1, m7
+    paddq              m2, m7
+    paddq              m3, m7
+    psrlq              m0, 15
+    psrlq              m1, 15
+    psrlq              m2, 15
+    psrlq              m3, 15
+    shufps             m0, m1, q2020
+    shufps             m2, m3, q2020
+    vpermq             m0, m0, q3120
+    vpermq             m2, m2, q3120
+    movu  [outq + offq         ], m0
+    movu  [outq + offq + mmsize], m2
+    add              offq, mmsize*2
+    cmp              offq, lenq
+    jl .next
+    RET
+%endmacro
+%endif
 
 INIT_XMM sse
 MIX2_FLT u
@@ -241,4 +380,13 @@ MIX2_FLT u
 MIX2_FLT a
 MIX1_FLT u
 MIX1_FLT a
+%if ARCH_X86_64
+MIX_N_1_FLT
+%endif
+%endif
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+MIX_N_1_INT16
+MIX_N_1_INT32
 %endif
@@ -612,3 +612,119 @@ RESAMPLE_FNS double, 8, 3, d, pdbl_1
 INIT_YMM fma3
 RESAMPLE_FNS double, 8, 3, d, pdbl_1
 %endif
+
+%if ARCH_X86_64
+; int resample_common_x4_float(ResampleContext *ctx, float * const *dst,
+;                              float * const *src, int size, int update_ctx)
+; Same as resample_common_float, for 4 planes at once; each filter chunk is
+; loaded once and applied to all of them.
+%macro RESAMPLE_COMMON_X4_FLOAT 0
+cglobal resample_common_x4_float, 4, 15, 5, ctx, dst, filter_bank, size, \
+                                            src0, src1, src2, src3, filter, \
+                                            min_filter_len_x4, min_filter_count_x4, \
+                                            index, frac, dst_idx, tmp
+
+%define src_stackq            [rsp-0x8]
+%if WIN64
+%define update_context_stackd r4m
+%else ; unix64
+%define update_context_stackd [rsp-0xc]
+    mov        update_context_stackd, r4d
+%endif
+
+    mov                        src0q, [filter_bankq+0*gprsize]
+    mov                        src1q, [filter_bankq+1*gprsize]
+    mov                        src2q, [filter_bankq+2*gprsize]
+    mov                        src3q, [filter_bankq+3*gprsize]
+    mov                 filter_bankq, [ctxq+ResampleContext.filter_bank]
+    mov           min_filter_len_x4d, [ctxq+ResampleContext.filter_length]
+    mov                       indexd, [ctxq+ResampleContext.index]
+    mov                        fracd, [ctxq+ResampleContext.frac]
+    shl                        sized, 2
+    shl           min_filter_len_x4d, 2
+    xor                     dst_idxd, dst_idxd
+    mov                   src_stackq, src0q
+
+    neg           min_filter_len_x4q
+    sub                 filter_bankq, min_filter_len_x4q
+    sub                        src0q, min_filter_len_x4q
+    sub                        src1q, min_filter_len_x4q
+    sub                        src2q, min_filter_len_x4q
+    sub                        src3q, min_filter_len_x4q
+
+.loop:
+    mov                      filterd, [ctxq+ResampleContext.filter_alloc]
+    imul                     filterd, indexd
+    mov         min_filter_count_x4q, min_filter_len_x4q
+    lea                      filterq, [filter_bankq+filterq*4]
+    xorps                         m0, m0, m0
+    xorps                         m1, m1, m1
+    xorps                         m2, m2, m2
+    xorps                         m3, m3, m3
+
+    align 16
+.inner_loop:
+    movu                          m4, [filterq+min_filter_count_x4q]
+    fmaddps                       m0, m4, [src0q+min_filter_count_x4q], m0
+    fmaddps                       m1, m4, [src1q+min_filter_count_x4q], m1
+    fmaddps                       m2, m4, [src2q+min_filter_count_x4q], m2
+    fmaddps                       m3, m4, [src3q+min_filter_count_x4q], m3
+    add         min_filter_count_x4q, mmsize
+    js .inner_loop
+
+    ; horizontal sums of the 4 accumulators, one plane per dword
+    haddps                        m0, m0, m1
+    haddps                        m2, m2, m3
+    haddps                        m0, m0, m2
+    vextractf128                 xm1, m0, 0x1
+    addps                        xm0, xm1
+
+    mov                         tmpq, [dstq+0*gprsize]
+    movss           [tmpq+dst_idxq], xm0
+    mov                         tmpq, [dstq+1*gprsize]
+    extractps       [tmpq+dst_idxq], xm0, 1
+    mov                         tmpq, [dstq+2*gprsize]
+    extractps       [tmpq+dst_idxq], xm0, 2
+    mov                         tmpq, [dstq+3*gprsize]
+    extractps       [tmpq+dst_idxq], xm0, 3
+
+    add                        fracd, [ctxq+ResampleContext.dst_incr_mod]
+    add                       indexd, [ctxq+ResampleContext.dst_incr_div]
+    cmp                        fracd, [ctxq+ResampleContext.src_incr]
+    jl .skip
+    sub                        fracd, [ctxq+ResampleContext.src_incr]
+    inc                       indexd
+.skip:
+    add                     dst_idxq, 4
+    cmp                       indexd, [ctxq+ResampleContext.phase_count]
+    jb .index_skip
+.index_while:
+    sub                       indexd, [ctxq+ResampleContext.phase_count]
+    add                        src0q, 4
+    add                        src1q, 4
+    add                        src2q, 4
+    add                        src3q, 4
+    cmp                       indexd, [ctxq+ResampleContext.phase_count]
+    jnb .index_while
+.index_skip:
+    cmp                     dst_idxq, sizeq
+    jne .loop
+
+    cmp  dword update_context_stackd, 0
+    jz .skip_store
+    mov [ctxq+ResampleContext.frac ], fracd
+    mov [ctxq+ResampleContext.index], indexd
+    add                        src0q, min_filter_len_x4q
+    mov                          rax, src0q
+    sub                          rax, src_stackq
+    shr                          rax, 2
+
+.skip_store:
+    RET
+%endmacro
+
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+RESAMPLE_COMMON_X4_FLOAT
+%endif
+%endif
@@ -45,6 +45,9 @@ RESAMPLE_FUNCS(double, sse2);
 RESAMPLE_FUNCS(double, avx);
 RESAMPLE_FUNCS(double, fma3);
 
+int ff_resample_common_x4_float_fma3(ResampleContext *c, uint8_t * const *dst,
+                                     uint8_t * const *src, int sz, int upd);
+
 av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
 {
     int av_unused mm_flags = av_get_cpu_flags();
@@ -73,6 +76,8 @@ av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
             c->dsp.resample_linear = ff_resample_linear_float_fma3;
             c->dsp.resample_common = ff_resample_common_float_fma3;
         }
+        if (ARCH_X86_64 && EXTERNAL_FMA3_FAST(mm_flags))
+            c->dsp.resample_common_x4 = ff_resample_common_x4_float_fma3;
         if (EXTERNAL_FMA4(mm_flags)) {
             c->dsp.resample_linear = ff_resample_linear_float_fma4;
             c->dsp.resample_common = ff_resample_common_float_fma4;
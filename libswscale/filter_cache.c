@@ -0,0 +1,144 @@
+/*
+ * Process wide cache of scaler filter coefficients
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "swscale.h"
+#include "swscale_internal.h"
+
+/* Limits of the cache, the least recently used filters are dropped first. */
+#define MAX_ENTRIES 256
+#define MAX_BYTES   (64 << 20)
+
+typedef struct FilterCacheEntry {
+    SwsFilterKey key;
+    AVBufferRef *buf;
+    int32_t     *pos;
+    int          size;
+    uint64_t     last_use;
+} FilterCacheEntry;
+
+static AVMutex cache_lock = AV_MUTEX_INITIALIZER;
+static FilterCacheEntry cache[MAX_ENTRIES];
+static int      nb_entries;
+static size_t   cache_bytes;
+static uint64_t use_count;
+
+static void free_filter(void *opaque, uint8_t *data)
+{
+    av_free(opaque);
+    av_free(data);
+}
+
+AVBufferRef *ff_sws_filter_buffer_wrap(int16_t *filter, int32_t *pos,
+                                       int filterSize, int dstW)
+{
+    return av_buffer_create((uint8_t *)filter,
+                            (dstW + 3) * filterSize * sizeof(*filter) +
+                            (dstW + 3) * sizeof(*pos),
+                            free_filter, pos, AV_BUFFER_FLAG_READONLY);
+}
+
+static int find_entry(const SwsFilterKey *key)
+{
+    for (int i = 0; i < nb_entries; i++)
+        if (!memcmp(&cache[i].key, key, sizeof(*key)))
+            return i;
+    return -1;
+}
+
+static void drop_entry(int i)
+{
+    cache_bytes -= cache[i].buf->size;
+    av_buffer_unref(&cache[i].buf);
+    cache[i] = cache[--nb_entries];
+}
+
+int ff_sws_filter_cache_get(const SwsFilterKey *key, AVBufferRef **buf,
+                            int32_t **pos, int *filterSize)
+{
+    int i, ret = 0;
+
+    ff_mutex_lock(&cache_lock);
+    i = find_entry(key);
+    if (i >= 0) {
+        *buf = av_buffer_ref(cache[i].buf);
+        if (*buf) {
+            *pos        = cache[i].pos;
+            *filterSize = cache[i].size;
+            cache[i].last_use = ++use_count;
+            ret = 1;
+        } else
+            ret = AVERROR(ENOMEM);
+    }
+    ff_mutex_unlock(&cache_lock);
+
+    return ret;
+}
+
+void ff_sws_filter_cache_add(const SwsFilterKey *key, const AVBufferRef *buf,
+                             int32_t *pos, int filterSize)
+{
+    FilterCacheEntry *e;
+
+    if (buf->size > MAX_BYTES)
+        return;
+
+    ff_mutex_lock(&cache_lock);
+    /* another context may have computed the same filter meanwhile */
+    if (find_entry(key) >= 0)
+        goto end;
+
+    while (nb_entries &&
+           (nb_entries == MAX_ENTRIES || cache_bytes + buf->size > MAX_BYTES)) {
+        int oldest = 0;
+        for (int i = 1; i < nb_entries; i++)
+            if (cache[i].last_use < cache[oldest].last_use)
+                oldest = i;
+        drop_entry(oldest);
+    }
+
+    e = &cache[nb_entries];
+    e->buf = av_buffer_ref(buf);
+    if (!e->buf)
+        goto end;
+    e->key      = *key;
+    e->pos      = pos;
+    e->size     = filterSize;
+    e->last_use = ++use_count;
+    cache_bytes += buf->size;
+    nb_entries++;
+
+end:
+    ff_mutex_unlock(&cache_lock);
+}
+
+void sws_filter_cache_clear(void)
+{
+    ff_mutex_lock(&cache_lock);
+    while (nb_entries)
+        drop_entry(nb_entries - 1);
+    ff_mutex_unlock(&cache_lock);
+}
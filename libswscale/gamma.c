@@ -18,56 +18,273 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/intfloat.h"
 #include "libavutil/mem.h"
+#include "swscale.h"
 #include "swscale_internal.h"
 
-typedef struct GammaContext
+/*
+ * The gamma tables are indexed by the bits of the absolute value of the
+ * sample: every power of two between 2^LUT_MIN_EXP and 2^LUT_MAX_EXP is split
+ * into 2^LUT_BITS segments which are linearly interpolated. This keeps the
+ * relative error below 1e-5 over the whole range, including the steep part
+ * of the curve near black, and handles values above 1.0.
+ */
+#define LUT_BITS    8
+#define LUT_MIN_EXP -64
+#define LUT_MAX_EXP 8
+#define LUT_SIZE    (((LUT_MAX_EXP - LUT_MIN_EXP) << LUT_BITS) + 1)
+#define LUT_SHIFT   (23 - LUT_BITS)
+#define LUT_START   ((uint32_t)(127 + LUT_MIN_EXP) << 23)
+#define LUT_END     ((uint32_t)(127 + LUT_MAX_EXP) << 23)
+
+/* width multiple processed by the scaling functions */
+#define ALIGN 16
+
+static av_cold float *alloc_gamma_lut(double e)
 {
-    uint16_t *table;
-} GammaContext;
+    float *lut = av_malloc_array(LUT_SIZE, sizeof(*lut));
+
+    if (!lut)
+        return NULL;
+
+    for (int i = 0; i < LUT_SIZE; i++)
+        lut[i] = pow(av_int2float(LUT_START + ((uint32_t)i << LUT_SHIFT)), e);
+
+    return lut;
+}
 
-// gamma_convert expects 16 bit rgb format
-// it writes directly in src slice thus it must be modifiable (done through cascade context)
-static int gamma_convert(SwsContext *c, SwsFilterDescriptor *desc, int sliceY, int sliceH)
+static void apply_gamma(float *dst, const float *src, int w,
+                        const float *lut, float e)
 {
-    GammaContext *instance = desc->instance;
-    uint16_t *table = instance->table;
-    int srcW = desc->src->width;
-
-    int i;
-    for (i = 0; i < sliceH; ++i) {
-        uint8_t ** src = desc->src->plane[0].line;
-        int src_pos = sliceY+i - desc->src->plane[0].sliceY;
-
-        uint16_t *src1 = (uint16_t*)*(src+src_pos);
-        int j;
-        for (j = 0; j < srcW; ++j) {
-            uint16_t r = AV_RL16(src1 + j*4 + 0);
-            uint16_t g = AV_RL16(src1 + j*4 + 1);
-            uint16_t b = AV_RL16(src1 + j*4 + 2);
-
-            AV_WL16(src1 + j*4 + 0, table[r]);
-            AV_WL16(src1 + j*4 + 1, table[g]);
-            AV_WL16(src1 + j*4 + 2, table[b]);
+    for (int i = 0; i < w; i++) {
+        uint32_t bits = av_float2int(src[i]);
+        uint32_t abs  = bits & 0x7FFFFFFF;
+        float v;
+
+        if (abs < LUT_START) {
+            v = 0.0f;
+        } else if (abs < LUT_END) {
+            uint32_t idx = (abs - LUT_START) >> LUT_SHIFT;
+            float frac   = (abs & ((1 << LUT_SHIFT) - 1)) * (1.0f / (1 << LUT_SHIFT));
+            v = lut[idx] + frac * (lut[idx + 1] - lut[idx]);
+        } else {
+            v = powf(av_int2float(abs), e);
         }
+        /* negative values from out of gamut colors are mirrored */
+        dst[i] = av_int2float(av_float2int(v) | (bits & 0x80000000));
+    }
+}
 
+static void hscale_float_c(float *dst, int dstW, const float *src,
+                           const float *filter, const int32_t *filterPos,
+                           int filterSize)
+{
+    for (int i = 0; i < dstW; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            float sum = 0.0f;
+            for (int j = 0; j < filterSize; j++)
+                sum += filter[j * 8 + k] * src[filterPos[i + k] + j];
+            dst[i + k] = sum;
+        }
+        filter += filterSize * 8;
     }
-    return sliceH;
 }
 
+static void vscale_float_c(float *dst, int dstW, const float *const *src,
+                           const float *filter, int filterSize)
+{
+    for (int i = 0; i < dstW; i++) {
+        float sum = 0.0f;
+        for (int j = 0; j < filterSize; j++)
+            sum += filter[j] * src[j][i];
+        dst[i] = sum;
+    }
+}
+
+av_cold void ff_sws_init_gamma_scaler_dsp(SwsGammaScaler *g)
+{
+    g->hscale = hscale_float_c;
+    g->vscale = vscale_float_c;
+
+#if ARCH_X86
+    ff_sws_init_gamma_scaler_dsp_x86(g);
+#endif
+}
 
-int ff_init_gamma_convert(SwsFilterDescriptor *desc, SwsSlice * src, uint16_t *table)
+av_cold int ff_sws_gamma_scaler_init(SwsContext *c, struct SwsFilter *srcFilter,
+                                     struct SwsFilter *dstFilter, int alpha)
 {
-    GammaContext *li = av_malloc(sizeof(GammaContext));
-    if (!li)
+    SwsGammaScaler *g;
+    float *hfilter = NULL;
+    int32_t *hfilter_pos = NULL;
+    int dstW_align, ret;
+
+    g = c->gamma_scaler = av_mallocz(sizeof(*g));
+    if (!g)
         return AVERROR(ENOMEM);
-    li->table = table;
 
-    desc->instance = li;
-    desc->src = src;
-    desc->dst = NULL;
-    desc->process = &gamma_convert;
+    g->srcW      = c->srcW;
+    g->srcH      = c->srcH;
+    g->dstW      = c->dstW;
+    g->dstH      = c->dstH;
+    g->nb_planes = alpha ? 4 : 3;
+    g->gamma     = c->gamma_value;
+    dstW_align   = FFALIGN(g->dstW, ALIGN);
+
+    g->lut[0] = alloc_gamma_lut(g->gamma);
+    g->lut[1] = alloc_gamma_lut(1.0 / g->gamma);
+    if (!g->lut[0] || !g->lut[1])
+        return AVERROR(ENOMEM);
 
-    return 0;
+    ret = ff_sws_init_float_filter(c, &hfilter, &hfilter_pos, &g->hfilter_size,
+                                   g->srcW, g->dstW,
+                                   srcFilter ? srcFilter->lumH : NULL,
+                                   dstFilter ? dstFilter->lumH : NULL);
+    if (ret < 0)
+        return ret;
+    ret = ff_sws_init_float_filter(c, &g->vfilter, &g->vfilter_pos, &g->vfilter_size,
+                                   g->srcH, g->dstH,
+                                   srcFilter ? srcFilter->lumV : NULL,
+                                   dstFilter ? dstFilter->lumV : NULL);
+    if (ret < 0)
+        goto end;
+
+    /* interleave the coefficients of groups of 8 output pixels, the padding
+     * pixels replicate the position of the last one with null coefficients */
+    g->hfilter     = av_calloc(dstW_align * g->hfilter_size, sizeof(*g->hfilter));
+    g->hfilter_pos = av_malloc_array(dstW_align, sizeof(*g->hfilter_pos));
+    if (!g->hfilter || !g->hfilter_pos) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    for (int i = 0; i < dstW_align; i++) {
+        g->hfilter_pos[i] = hfilter_pos[FFMIN(i, g->dstW - 1)];
+        if (i >= g->dstW)
+            continue;
+        for (int j = 0; j < g->hfilter_size; j++)
+            g->hfilter[(i & ~7) * g->hfilter_size + j * 8 + (i & 7)] =
+                hfilter[i * g->hfilter_size + j];
+    }
+
+    g->ring_stride = dstW_align;
+    g->line   = av_calloc(g->srcW + g->hfilter_size, sizeof(*g->line));
+    g->out    = av_malloc_array(dstW_align, sizeof(*g->out));
+    g->ring_y = av_malloc_array(g->vfilter_size, sizeof(*g->ring_y));
+    g->vsrc   = av_malloc_array(g->vfilter_size, sizeof(*g->vsrc));
+    if (!g->line || !g->out || !g->ring_y || !g->vsrc) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    for (int p = 0; p < g->nb_planes; p++) {
+        g->ring[p] = av_calloc(g->vfilter_size * g->ring_stride, sizeof(*g->ring[p]));
+        if (!g->ring[p]) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+
+    ff_sws_init_gamma_scaler_dsp(g);
+    ff_sws_gamma_scaler_reset(g);
+    ret = 0;
+
+end:
+    av_free(hfilter);
+    av_free(hfilter_pos);
+    return ret;
+}
+
+av_cold void ff_sws_gamma_scaler_free(SwsGammaScaler **pg)
+{
+    SwsGammaScaler *g = *pg;
+
+    if (!g)
+        return;
+
+    av_freep(&g->lut[0]);
+    av_freep(&g->lut[1]);
+    av_freep(&g->hfilter);
+    av_freep(&g->hfilter_pos);
+    av_freep(&g->vfilter);
+    av_freep(&g->vfilter_pos);
+    av_freep(&g->line);
+    av_freep(&g->out);
+    for (int p = 0; p < FF_ARRAY_ELEMS(g->ring); p++)
+        av_freep(&g->ring[p]);
+    av_freep(&g->ring_y);
+    av_freep(&g->vsrc);
+    av_freep(pg);
+}
+
+void ff_sws_gamma_scaler_reset(SwsGammaScaler *g)
+{
+    g->dstY = 0;
+    g->srcY = 0;
+    for (int i = 0; i < g->vfilter_size; i++)
+        g->ring_y[i] = -1;
+}
+
+int ff_sws_gamma_scaler_src_end(const SwsGammaScaler *g, int y)
+{
+    if (y <= 0)
+        return 0;
+    return FFMIN(g->vfilter_pos[y - 1] + g->vfilter_size, g->srcH);
+}
+
+/* scale the source line y horizontally into the ring */
+static void hscale_line(SwsGammaScaler *g, int slot, int y,
+                        const uint8_t *const src[], const int srcStride[])
+{
+    for (int p = 0; p < g->nb_planes; p++) {
+        const float *line = (const float *)(src[p] + y * (ptrdiff_t)srcStride[p]);
+
+        if (p < 3)
+            apply_gamma(g->line, line, g->srcW, g->lut[0], g->gamma);
+        else
+            memcpy(g->line, line, g->srcW * sizeof(*g->line));
+
+        g->hscale(g->ring[p] + slot * g->ring_stride, g->ring_stride, g->line,
+                  g->hfilter, g->hfilter_pos, g->hfilter_size);
+    }
+    g->ring_y[slot] = y;
 }
 
+void ff_sws_gamma_scaler_scale(SwsGammaScaler *g,
+                               uint8_t *const dst[], const int dstStride[],
+                               const uint8_t *const src[], const int srcStride[],
+                               int y0, int y1)
+{
+    const int size = g->vfilter_size;
+
+    for (int y = y0; y < y1; y++) {
+        const float *filter = g->vfilter + y * size;
+
+        /* consecutive lines never share a slot of the ring, the lines past
+         * the bottom have null coefficients */
+        for (int j = 0; j < size; j++) {
+            int sy = FFMIN(g->vfilter_pos[y] + j, g->srcH - 1);
+
+            if (g->ring_y[sy % size] != sy)
+                hscale_line(g, sy % size, sy, src, srcStride);
+        }
+
+        for (int p = 0; p < g->nb_planes; p++) {
+            float *out = (float *)(dst[p] + y * (ptrdiff_t)dstStride[p]);
+
+            for (int j = 0; j < size; j++) {
+                int sy = FFMIN(g->vfilter_pos[y] + j, g->srcH - 1);
+                g->vsrc[j] = g->ring[p] + (sy % size) * g->ring_stride;
+            }
+            g->vscale(g->out, g->ring_stride, g->vsrc, filter, size);
+
+            if (p < 3)
+                apply_gamma(out, g->out, g->dstW, g->lut[1], 1.0f / g->gamma);
+            else
+                memcpy(out, g->out, g->dstW * sizeof(*out));
+        }
+    }
+}
@@ -81,6 +81,9 @@ static const AVOption swscale_options[] = {
 
     { "threads",         "number of threads",             OFFSET(nb_threads),   AV_OPT_TYPE_INT, {.i64 = 1 }, 0, INT_MAX, VE, .unit = "threads" },
         { "auto",        NULL,                            0,                  AV_OPT_TYPE_CONST, {.i64 = 0 },    .flags = VE, .unit = "threads" },
+    { "filter_cache",    "share filter coefficients through a process wide cache", OFFSET(filter_cache), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, VE },
+    { "tile_width",      "scale in column tiles of this width", OFFSET(tile_width), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, INT_MAX, VE },
+    { "zero_copy",       "reference the source planes instead of copying them when possible", OFFSET(zero_copy), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, VE },
 
     { NULL }
 };
@@ -27,6 +27,7 @@
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/emms.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
@@ -844,38 +845,115 @@ static int scale_internal(SwsContext *c,
                           uint8_t *const dstSlice[], const int dstStride[],
                           int dstSliceY, int dstSliceH);
 
+/* Lines of the source of the same size context c used for the lines [y0, y1). */
+static void cascaded_src_lines(const SwsContext *c, int y0, int y1, int *start, int *end)
+{
+    int cy0 = y0 >> c->chrDstVSubSample, cy1 = (y1 - 1) >> c->chrDstVSubSample;
+
+    if (c->convert_unscaled) {
+        *start = y0;
+        *end   = y1;
+        return;
+    }
+    *start = FFMIN(c->vLumFilterPos[y0], c->vChrFilterPos[cy0] << c->chrSrcVSubSample);
+    *end   = FFMAX(c->vLumFilterPos[y1 - 1] + c->vLumFilterSize,
+                   (c->vChrFilterPos[cy1] + c->vChrFilterSize) << c->chrSrcVSubSample);
+    *start = FFMAX(*start, 0);
+    *end   = FFMIN(*end, c->srcH);
+}
+
+static void offset_planes(uint8_t *dst[4], uint8_t *const src[4],
+                          const int stride[4], int y)
+{
+    for (int i = 0; i < 4; i++)
+        dst[i] = src[i] ? src[i] + y * (ptrdiff_t)stride[i] : NULL;
+}
+
 static int scale_gamma(SwsContext *c,
                        const uint8_t * const srcSlice[], const int srcStride[],
                        int srcSliceY, int srcSliceH,
                        uint8_t * const dstSlice[], const int dstStride[],
                        int dstSliceY, int dstSliceH)
 {
-    int ret = scale_internal(c->cascaded_context[0],
-                             srcSlice, srcStride, srcSliceY, srcSliceH,
-                             c->cascaded_tmp[0], c->cascaded_tmpStride[0], 0, c->srcH);
+    SwsGammaScaler *g = c->gamma_scaler;
+    SwsContext *c0 = c->cascaded_context[0], *c2 = c->cascaded_context[2];
+    const int scale_dst = dstSliceY > 0 || dstSliceH < c->dstH;
+    const uint8_t *const *src = (const uint8_t *const *)c->cascaded_tmp[0];
+    const int *src_stride = c->cascaded_tmpStride[0];
+    uint8_t *tmp[4];
+    int y0, y1, ret;
 
-    if (ret < 0)
-        return ret;
+    if (!srcSliceY)
+        ff_sws_gamma_scaler_reset(g);
 
-    if (c->cascaded_context[2])
-        ret = scale_internal(c->cascaded_context[1], (const uint8_t * const *)c->cascaded_tmp[0],
-                             c->cascaded_tmpStride[0], srcSliceY, srcSliceH,
-                             c->cascaded_tmp[1], c->cascaded_tmpStride[1], 0, c->dstH);
-    else
-        ret = scale_internal(c->cascaded_context[1], (const uint8_t * const *)c->cascaded_tmp[0],
-                             c->cascaded_tmpStride[0], srcSliceY, srcSliceH,
-                             dstSlice, dstStride, dstSliceY, dstSliceH);
+    if (scale_dst) {
+        /* the whole source is available, only the lines needed for the
+         * output slice are computed */
+        int start, end;
+
+        y0 = dstSliceY;
+        y1 = dstSliceY + dstSliceH;
+        if (c2)
+            cascaded_src_lines(c2, y0, y1, &y0, &y1);
+
+        start = g->vfilter_pos[y0];
+        end   = ff_sws_gamma_scaler_src_end(g, y1);
+        if (c0) {
+            offset_planes(tmp, c->cascaded_tmp[0], src_stride, start);
+            ret = scale_internal(c0, srcSlice, srcStride, srcSliceY, srcSliceH,
+                                 tmp, src_stride, start, end - start);
+            if (ret < 0)
+                return ret;
+        } else {
+            src        = srcSlice;
+            src_stride = srcStride;
+        }
+    } else {
+        if (c0) {
+            ret = scale_internal(c0, srcSlice, srcStride, srcSliceY, srcSliceH,
+                                 c->cascaded_tmp[0], src_stride, 0, c->srcH);
+            if (ret < 0)
+                return ret;
+            g->srcY += ret;
+        } else if (srcSliceY || srcSliceH < c->srcH) {
+            /* keep the previous slices for the lines spanning two slices */
+            offset_planes(tmp, c->cascaded_tmp[0], src_stride, srcSliceY);
+            av_image_copy((uint8_t **)tmp, src_stride, (const uint8_t **)srcSlice,
+                          srcStride, c->srcFormat, c->srcW, srcSliceH);
+            g->srcY = srcSliceY + srcSliceH;
+        } else {
+            src        = srcSlice;
+            src_stride = srcStride;
+            g->srcY    = c->srcH;
+        }
 
-    if (ret < 0)
-        return ret;
+        y0 = y1 = g->dstY;
+        while (y1 < c->dstH && ff_sws_gamma_scaler_src_end(g, y1 + 1) <= g->srcY)
+            y1++;
+        g->dstY = y1;
+        if (y1 == y0)
+            return 0;
+    }
 
-    if (c->cascaded_context[2]) {
-        ret = scale_internal(c->cascaded_context[2], (const uint8_t * const *)c->cascaded_tmp[1],
-                             c->cascaded_tmpStride[1], c->cascaded_context[1]->dstY - ret,
-                             c->cascaded_context[1]->dstY,
-                             dstSlice, dstStride, dstSliceY, dstSliceH);
+    if (!c2) {
+        uint8_t *dst[4];
+
+        /* the scaler addresses the lines from the top of the frame */
+        offset_planes(dst, dstSlice, dstStride, -dstSliceY);
+        ff_sws_gamma_scaler_scale(g, dst, dstStride, src, src_stride, y0, y1);
+        return scale_dst ? dstSliceH : y1 - y0;
     }
-    return ret;
+
+    ff_sws_gamma_scaler_scale(g, c->cascaded_tmp[1], c->cascaded_tmpStride[1],
+                              src, src_stride, y0, y1);
+    if (scale_dst)
+        return scale_internal(c2, (const uint8_t * const *)c->cascaded_tmp[1],
+                              c->cascaded_tmpStride[1], 0, c->dstH,
+                              dstSlice, dstStride, dstSliceY, dstSliceH);
+
+    offset_planes(tmp, c->cascaded_tmp[1], c->cascaded_tmpStride[1], y0);
+    return scale_internal(c2, (const uint8_t * const *)tmp, c->cascaded_tmpStride[1],
+                          y0, y1 - y0, dstSlice, dstStride, 0, c->dstH);
 }
 
 static int scale_cascaded(SwsContext *c,
@@ -948,7 +1026,7 @@ static int scale_internal(SwsContext *c,
     if (srcSliceH == 0)
         return 0;
 
-    if (c->gamma_flag && c->cascaded_context[0])
+    if (c->gamma_scaler)
         return scale_gamma(c, srcSlice, srcStride, srcSliceY, srcSliceH,
                            dstSlice, dstStride, dstSliceY, dstSliceH);
 
@@ -1091,6 +1169,83 @@ static int scale_internal(SwsContext *c,
     return ret;
 }
 
+static void tile_offsets(ptrdiff_t offset[4], enum AVPixelFormat format, int x)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+
+    memset(offset, 0, 4 * sizeof(*offset));
+    for (int i = 0; i < desc->nb_components; i++) {
+        const AVComponentDescriptor *comp = &desc->comp[i];
+        const int shift = (i == 1 || i == 2) ? desc->log2_chroma_w : 0;
+
+        offset[comp->plane] = (x >> shift) * comp->step;
+    }
+}
+
+static int scale_tile(SwsContext *c, const SwsTileJob *job)
+{
+    ptrdiff_t src_offset[4], dst_offset[4];
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+
+    tile_offsets(src_offset, c->srcFormat, c->tile_src_x);
+    tile_offsets(dst_offset, c->dstFormat, c->tile_dst_x);
+
+    for (int i = 0; i < 4; i++) {
+        src[i] = FF_PTR_ADD(job->src[i], src_offset[i]);
+        dst[i] = FF_PTR_ADD(job->dst[i], dst_offset[i]);
+    }
+
+    return scale_internal(c, src, job->src_stride, job->src_slice_y, job->src_slice_h,
+                          dst, job->dst_stride, job->dst_slice_y, job->dst_slice_h);
+}
+
+static int scale_tiles(SwsContext *c,
+                       const uint8_t * const srcSlice[], const int srcStride[],
+                       int srcSliceY, int srcSliceH,
+                       uint8_t * const dstSlice[], const int dstStride[],
+                       int dstSliceY, int dstSliceH)
+{
+    const SwsTileJob job = {
+        .src         = srcSlice,
+        .src_stride  = srcStride,
+        .src_slice_y = srcSliceY,
+        .src_slice_h = srcSliceH,
+        .dst         = dstSlice,
+        .dst_stride  = dstStride,
+        .dst_slice_y = dstSliceY,
+        .dst_slice_h = dstSliceH,
+    };
+    int ret = 0;
+
+    // let the whole frame context report the invalid parameters
+    if (!srcStride || !dstStride || !dstSlice || !srcSlice)
+        return scale_internal(c, srcSlice, srcStride, srcSliceY, srcSliceH,
+                              dstSlice, dstStride, dstSliceY, dstSliceH);
+
+    if (!c->slicethread) {
+        for (int i = 0; i < c->nb_tile_ctx && ret >= 0; i++)
+            ret = scale_tile(c->tile_ctx[i], &job);
+        return ret;
+    }
+
+    c->tile_job = &job;
+    avpriv_slicethread_execute(c->slicethread, c->nb_tile_ctx, 0);
+    c->tile_job = NULL;
+
+    ret = c->slice_err[0];
+    for (int i = 0; i < c->nb_tile_ctx; i++) {
+        if (c->slice_err[i] < 0) {
+            ret = c->slice_err[i];
+            break;
+        }
+    }
+
+    memset(c->slice_err, 0, c->nb_tile_ctx * sizeof(*c->slice_err));
+
+    return ret;
+}
+
 void sws_frame_end(struct SwsContext *c)
 {
     av_frame_unref(c->frame_src);
@@ -1161,14 +1316,15 @@ int sws_receive_slice(struct SwsContext *c, unsigned int slice_start,
         return AVERROR(EAGAIN);
 
     if ((slice_start > 0 || slice_height < c->dstH) &&
-        (slice_start % align || slice_height % align)) {
+        (slice_start % align ||
+         (slice_height % align && slice_start + slice_height != c->dstH))) {
         av_log(c, AV_LOG_ERROR,
                "Incorrectly aligned output: %u/%u not multiples of %u\n",
                slice_start, slice_height, align);
         return AVERROR(EINVAL);
     }
 
-    if (c->slicethread) {
+    if (c->slicethread && !c->nb_tile_ctx) {
         int nb_jobs = c->slice_ctx[0]->dither == SWS_DITHER_ED ? 1 : c->nb_slice_ctx;
         int ret = 0;
 
@@ -1190,18 +1346,156 @@ int sws_receive_slice(struct SwsContext *c, unsigned int slice_start,
     }
 
     for (int i = 0; i < FF_ARRAY_ELEMS(dst); i++) {
-        ptrdiff_t offset = c->frame_dst->linesize[i] * (ptrdiff_t)(slice_start >> c->chrDstVSubSample);
+        const int vshift = (i == 1 || i == 2) ? c->chrDstVSubSample : 0;
+        ptrdiff_t offset = c->frame_dst->linesize[i] * (ptrdiff_t)(slice_start >> vshift);
         dst[i] = FF_PTR_ADD(c->frame_dst->data[i], offset);
     }
 
+    if (c->nb_tile_ctx)
+        return scale_tiles(c, (const uint8_t * const *)c->frame_src->data,
+                           c->frame_src->linesize, 0, c->srcH,
+                           dst, c->frame_dst->linesize, slice_start, slice_height);
+
     return scale_internal(c, (const uint8_t * const *)c->frame_src->data,
                           c->frame_src->linesize, 0, c->srcH,
                           dst, c->frame_dst->linesize, slice_start, slice_height);
 }
 
+/**
+ * Index in src of the component i of dst. Components with the same index
+ * have the same meaning, except the alpha of the gray formats.
+ */
+static int component_index(const AVPixFmtDescriptor *dst,
+                           const AVPixFmtDescriptor *src, int i)
+{
+    int dst_gray = dst->nb_components < 3, src_gray = src->nb_components < 3;
+
+    if (dst_gray && i == 1)
+        i = 3;
+    if (src_gray && i == 3)
+        i = 1;
+    else if (src_gray && i > 0)
+        return -1;
+
+    return i < src->nb_components ? i : -1;
+}
+
+/**
+ * Check whether every destination plane is found unchanged in a source plane,
+ * and if so, set map to the source plane of each destination plane.
+ */
+static int zero_copy_planes(const SwsContext *c, int map[4])
+{
+    const AVPixFmtDescriptor *src_desc, *dst_desc;
+    const uint64_t flags = AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM |
+                           AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BAYER |
+                           AV_PIX_FMT_FLAG_XYZ;
+
+    if (c->slice_ctx)
+        c = c->slice_ctx[0];
+
+    src_desc = av_pix_fmt_desc_get(c->srcFormat);
+    dst_desc = av_pix_fmt_desc_get(c->dstFormat);
+    if (!c->convert_unscaled || c->srcW != c->dstW || c->srcH != c->dstH ||
+        c->gamma_flag || c->srcRange != c->dstRange || c->cascaded_context[0] ||
+        c->src0Alpha && !c->dst0Alpha || c->srcXYZ || c->dstXYZ ||
+        (src_desc->flags | dst_desc->flags) & flags ||
+        (src_desc->flags ^ dst_desc->flags) & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_FLOAT |
+                                               AV_PIX_FMT_FLAG_BE))
+        return 0;
+    /* the regular copy of these does not fill the whole chroma plane or
+     * does not keep the float values as is */
+    if (isSemiPlanarYUV(c->dstFormat) || isFloat(c->dstFormat))
+        return 0;
+    if (dst_desc->nb_components > 2 &&
+        (src_desc->log2_chroma_w != dst_desc->log2_chroma_w ||
+         src_desc->log2_chroma_h != dst_desc->log2_chroma_h))
+        return 0;
+    /* the alpha plane is only dropped, never created or blended */
+    if (isALPHA(c->dstFormat) && !isALPHA(c->srcFormat) ||
+        isALPHA(c->srcFormat) && !isALPHA(c->dstFormat) &&
+        c->alphablend != SWS_ALPHA_BLEND_NONE)
+        return 0;
+
+    for (int p = 0; p < 4; p++)
+        map[p] = -1;
+
+    for (int i = 0; i < dst_desc->nb_components; i++) {
+        const AVComponentDescriptor *d = &dst_desc->comp[i];
+        const AVComponentDescriptor *s;
+        int j = component_index(dst_desc, src_desc, i);
+
+        if (j < 0)
+            return 0;
+        s = &src_desc->comp[j];
+        if (d->step != s->step || d->offset != s->offset ||
+            d->shift != s->shift || d->depth != s->depth)
+            return 0;
+        if (map[d->plane] >= 0 && map[d->plane] != s->plane)
+            return 0;
+        map[d->plane] = s->plane;
+    }
+
+    /* a packed plane must not hold other source components */
+    for (int p = 0; p < 4; p++) {
+        int nb_src = 0, nb_dst = 0;
+
+        if (map[p] < 0)
+            continue;
+        for (int i = 0; i < src_desc->nb_components; i++)
+            nb_src += src_desc->comp[i].plane == map[p];
+        for (int i = 0; i < dst_desc->nb_components; i++)
+            nb_dst += dst_desc->comp[i].plane == p;
+        if (nb_src != nb_dst)
+            return 0;
+    }
+
+    return 1;
+}
+
+static int scale_frame_zero_copy(SwsContext *c, AVFrame *dst, const AVFrame *src,
+                                 const int map[4])
+{
+    for (int i = 0; i < FF_ARRAY_ELEMS(src->buf) && src->buf[i]; i++) {
+        dst->buf[i] = av_buffer_ref(src->buf[i]);
+        if (!dst->buf[i])
+            goto fail;
+    }
+    if (src->nb_extended_buf) {
+        dst->extended_buf = av_calloc(src->nb_extended_buf, sizeof(*dst->extended_buf));
+        if (!dst->extended_buf)
+            goto fail;
+        for (int i = 0; i < src->nb_extended_buf; i++) {
+            dst->extended_buf[i] = av_buffer_ref(src->extended_buf[i]);
+            if (!dst->extended_buf[i])
+                goto fail;
+            dst->nb_extended_buf++;
+        }
+    }
+
+    dst->width  = c->dstW;
+    dst->height = c->dstH;
+    dst->format = c->dstFormat;
+    for (int p = 0; p < 4; p++) {
+        if (map[p] < 0)
+            continue;
+        dst->data[p]     = src->data[map[p]];
+        dst->linesize[p] = src->linesize[map[p]];
+    }
+    dst->extended_data = dst->data;
+
+    return 0;
+fail:
+    av_frame_unref(dst);
+    return AVERROR(ENOMEM);
+}
+
 int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src)
 {
-    int ret;
+    int ret, map[4];
+
+    if (c->zero_copy && !dst->buf[0] && src->buf[0] && zero_copy_planes(c, map))
+        return scale_frame_zero_copy(c, dst, src, map);
 
     ret = sws_frame_start(c, dst, src);
     if (ret < 0)
@@ -1229,6 +1523,10 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     if (c->nb_slice_ctx)
         c = c->slice_ctx[0];
 
+    if (c->nb_tile_ctx)
+        return scale_tiles(c, srcSlice, srcStride, srcSliceY, srcSliceH,
+                           dst, dstStride, 0, c->dstH);
+
     return scale_internal(c, srcSlice, srcStride, srcSliceY, srcSliceH,
                           dst, dstStride, 0, c->dstH);
 }
@@ -1264,3 +1562,11 @@ void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
 
     parent->slice_err[threadnr] = err;
 }
+
+void ff_sws_tile_worker(void *priv, int jobnr, int threadnr,
+                        int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+
+    parent->slice_err[jobnr] = scale_tile(parent->tile_ctx[jobnr], parent->tile_job);
+}
@@ -193,6 +193,27 @@ int sws_init_context(struct SwsContext *sws_context, SwsFilter *srcFilter, SwsFi
  */
 void sws_freeContext(struct SwsContext *swsContext);
 
+/**
+ * Compute the filter coefficients of the scaling configured in the given
+ * context and keep them in the process wide filter cache, so that contexts
+ * later initialized with the same parameters and the filter_cache option set
+ * share them instead of computing them again.
+ *
+ * The context is not modified and does not have to be initialized.
+ * This function is thread safe.
+ *
+ * @return zero or positive value on success, a negative value on
+ * error
+ */
+int sws_filter_cache_prewarm(const struct SwsContext *c);
+
+/**
+ * Drop all the filters held by the process wide filter cache. Contexts using
+ * them keep their own references, which are released when they are freed.
+ * This function is thread safe.
+ */
+void sws_filter_cache_clear(void);
+
 /**
  * Allocate and return an SwsContext. You need it to perform
  * scaling/conversion operations using sws_scale().
@@ -258,6 +279,13 @@ int sws_scale(struct SwsContext *c, const uint8_t *const srcSlice[],
  * - sws_receive_slice(0, dst->height)
  * - sws_frame_end()
  *
+ * If the zero_copy option is set, dst has no buffers, src is reference counted
+ * and the conversion does not change any pixel (the same dimensions, and a
+ * destination format whose planes are all found unchanged in the source, e.g.
+ * an identity conversion or dropping the alpha plane), dst is filled with new
+ * references to the buffers of src and its data pointers point to the source
+ * planes. No pixel is copied and dst is not writable.
+ *
  * @param c   The scaling context
  * @param dst The destination frame. See documentation for sws_frame_start() for
  *            more details.
@@ -319,6 +319,35 @@ typedef void (*planarX2_YV12_fn)(uint8_t *dst, uint8_t *dst2,
 
 struct SwsSlice;
 struct SwsFilterDescriptor;
+struct SwsGammaScaler;
+struct SwsFilter;
+struct SwsVector;
+
+/**
+ * Arguments of the scaling call being distributed over the column tiles.
+ */
+typedef struct SwsTileJob {
+    const uint8_t *const *src;
+    const int *src_stride;
+    int src_slice_y, src_slice_h;
+    uint8_t *const *dst;
+    const int *dst_stride;
+    int dst_slice_y, dst_slice_h;
+} SwsTileJob;
+
+/**
+ * Parameters fully determining a set of filter coefficients, used as the key
+ * of the process wide filter cache. Must be zeroed before being filled, so
+ * that it can be compared with memcmp().
+ */
+typedef struct SwsFilterKey {
+    int xInc, srcW, dstW;
+    int filterAlign, one;
+    int flags, cpu_flags;
+    int srcPos, dstPos;
+    int layout;                   ///< Coefficients shuffled for the AVX2 horizontal scalers.
+    double param[2];
+} SwsFilterKey;
 
 /* This struct should be aligned on at least a 32-byte boundary. */
 struct SwsContext {
@@ -382,9 +411,7 @@ struct SwsContext {
 
     double gamma_value;
     int gamma_flag;
-    int is_internal_gamma;
-    uint16_t *gamma;
-    uint16_t *inv_gamma;
+    struct SwsGammaScaler *gamma_scaler; ///< linear light float scaler used with gamma_flag
 
     int numDesc;
     int descIndex[2];
@@ -695,6 +722,19 @@ struct SwsContext {
     atomic_int   data_unaligned_warned;
 
     Half2FloatTables *h2f_tables;
+
+    // column tiles scaled by their own contexts, see context_init_tiled()
+    int tile_width;               ///< Width of the column tiles in destination pixels, 0 to scale whole lines.
+    struct SwsContext **tile_ctx;
+    int              nb_tile_ctx;
+    const struct SwsTileJob *tile_job;
+    int tile_src_x;               ///< First source column read by this tile.
+    int tile_dst_x;               ///< First destination column written by this tile.
+
+    int filter_cache;             ///< Share the filters through the process wide cache.
+    AVBufferRef *filter_buf[4];   ///< Owners of the hLum, hChr, vLum and vChr filters when shared.
+
+    int zero_copy;                ///< Let sws_scale_frame() reference the source planes when no pixel changes.
 };
 //FIXME check init (where 0)
 
@@ -1138,9 +1178,6 @@ int ff_free_filters(SwsContext *c);
 */
 int ff_rotate_slice(SwsSlice *s, int lum, int chr);
 
-/// initializes gamma conversion descriptor
-int ff_init_gamma_convert(SwsFilterDescriptor *desc, SwsSlice * src, uint16_t *table);
-
 /// initializes lum pixel format conversion descriptor
 int ff_init_desc_fmt_convert(SwsFilterDescriptor *desc, SwsSlice * src, SwsSlice *dst, uint32_t *pal);
 
@@ -1158,6 +1195,74 @@ int ff_init_desc_no_chr(SwsFilterDescriptor *desc, SwsSlice * src, SwsSlice *dst
 /// initializes vertical scaling descriptors
 int ff_init_vscale(SwsContext *c, SwsFilterDescriptor *desc, SwsSlice *src, SwsSlice *dst);
 
+/**
+ * Scaler of planar float RGB(A) in linear light, used for gamma correct
+ * scaling. The color planes are converted to linear light before being
+ * scaled and back after, the alpha plane is scaled as is.
+ */
+typedef struct SwsGammaScaler {
+    int srcW, srcH, dstW, dstH;
+    int nb_planes;
+    float gamma;
+    float *lut[2];          ///< tables to and from linear light, see gamma.c
+
+    /* horizontal filter, the coefficients of 8 consecutive output pixels
+     * are interleaved, filterPos and the output are padded to 16 pixels */
+    float   *hfilter;
+    int32_t *hfilter_pos;
+    int      hfilter_size;
+    float   *vfilter;
+    int32_t *vfilter_pos;
+    int      vfilter_size;
+
+    float  *line;           ///< source line in linear light, zero padded
+    float  *out;            ///< output line in linear light
+    float  *ring[4];        ///< horizontally scaled lines, vfilter_size per plane
+    int     ring_stride;
+    int    *ring_y;         ///< source line held by each line of the ring
+    const float **vsrc;
+    int     dstY;           ///< next output line when the input comes in slices
+    int     srcY;           ///< source lines available when the input comes in slices
+
+    void (*hscale)(float *dst, int dstW, const float *src, const float *filter,
+                   const int32_t *filterPos, int filterSize);
+    void (*vscale)(float *dst, int dstW, const float *const *src,
+                   const float *filter, int filterSize);
+} SwsGammaScaler;
+
+int ff_sws_gamma_scaler_init(SwsContext *c, struct SwsFilter *srcFilter,
+                             struct SwsFilter *dstFilter, int alpha);
+void ff_sws_gamma_scaler_free(SwsGammaScaler **g);
+void ff_sws_init_gamma_scaler_dsp(SwsGammaScaler *g);
+void ff_sws_init_gamma_scaler_dsp_x86(SwsGammaScaler *g);
+
+/**
+ * Reset the state kept between the slices of a frame.
+ */
+void ff_sws_gamma_scaler_reset(SwsGammaScaler *g);
+
+/**
+ * Number of source lines needed to output the lines before y.
+ */
+int ff_sws_gamma_scaler_src_end(const SwsGammaScaler *g, int y);
+
+/**
+ * Output the lines [y0, y1). The planes of src and dst point to the first
+ * line of the frames, the source lines used must be available.
+ */
+void ff_sws_gamma_scaler_scale(SwsGammaScaler *g,
+                               uint8_t *const dst[], const int dstStride[],
+                               const uint8_t *const src[], const int srcStride[],
+                               int y0, int y1);
+
+/**
+ * Compute a filter in floating point for the linear light scaler, with the
+ * coefficients normalized to 1 but not quantized.
+ */
+int ff_sws_init_float_filter(SwsContext *c, float **filter, int32_t **filterPos,
+                             int *filterSize, int srcW, int dstW,
+                             struct SwsVector *srcFilter, struct SwsVector *dstFilter);
+
 /// setup vertical scaler functions
 void ff_init_vscale_pfn(SwsContext *c, yuv2planar1_fn yuv2plane1, yuv2planarX_fn yuv2planeX,
     yuv2interleavedX_fn yuv2nv12cX, yuv2packed1_fn yuv2packed1, yuv2packed2_fn yuv2packed2,
@@ -1166,6 +1271,32 @@ void ff_init_vscale_pfn(SwsContext *c, yuv2planar1_fn yuv2plane1, yuv2planarX_fn
 void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
                          int nb_jobs, int nb_threads);
 
+void ff_sws_tile_worker(void *priv, int jobnr, int threadnr,
+                        int nb_jobs, int nb_threads);
+
+/**
+ * Wrap a filter and its positions allocated by initFilter() in a buffer
+ * owning both of them.
+ */
+AVBufferRef *ff_sws_filter_buffer_wrap(int16_t *filter, int32_t *pos,
+                                       int filterSize, int dstW);
+
+/**
+ * Look up a filter in the process wide filter cache.
+ *
+ * @return 1 and a new reference to the filter if found, 0 if not found,
+ *         a negative AVERROR code on failure
+ */
+int ff_sws_filter_cache_get(const SwsFilterKey *key, AVBufferRef **buf,
+                            int32_t **pos, int *filterSize);
+
+/**
+ * Add a filter to the process wide filter cache, dropping the least recently
+ * used ones if needed. The cache takes its own reference to buf.
+ */
+void ff_sws_filter_cache_add(const SwsFilterKey *key, const AVBufferRef *buf,
+                             int32_t *pos, int filterSize);
+
 int ff_swscale(SwsContext *c, const uint8_t *const src[], const int srcStride[],
                int srcSliceY, int srcSliceH, uint8_t *const dst[],
                const int dstStride[], int dstSliceY, int dstSliceH);
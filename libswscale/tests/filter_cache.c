@@ -0,0 +1,163 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+static const struct {
+    int src_w, src_h;
+    enum AVPixelFormat src_fmt;
+    int dst_w, dst_h;
+    enum AVPixelFormat dst_fmt;
+    int flags;
+} tests[] = {
+    { 352, 288, AV_PIX_FMT_YUV420P, 176, 144, AV_PIX_FMT_YUV420P,     SWS_BICUBIC  },
+    { 352, 288, AV_PIX_FMT_YUV420P, 176, 144, AV_PIX_FMT_RGB24,       SWS_BICUBIC  },
+    { 640, 360, AV_PIX_FMT_RGB24,   100, 100, AV_PIX_FMT_YUV444P,     SWS_LANCZOS  },
+    { 160, 120, AV_PIX_FMT_NV12,    704, 576, AV_PIX_FMT_YUV422P10LE, SWS_SPLINE   },
+    { 160, 120, AV_PIX_FMT_GBRP,    321, 241, AV_PIX_FMT_YUVA420P,    SWS_BILINEAR },
+};
+
+static SwsContext *alloc_context(int i, int filter_cache)
+{
+    SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+
+    av_opt_set_int(c, "srcw",         tests[i].src_w,   0);
+    av_opt_set_int(c, "srch",         tests[i].src_h,   0);
+    av_opt_set_int(c, "src_format",   tests[i].src_fmt, 0);
+    av_opt_set_int(c, "dstw",         tests[i].dst_w,   0);
+    av_opt_set_int(c, "dsth",         tests[i].dst_h,   0);
+    av_opt_set_int(c, "dst_format",   tests[i].dst_fmt, 0);
+    av_opt_set_int(c, "sws_flags",    tests[i].flags | SWS_ACCURATE_RND | SWS_BITEXACT, 0);
+    av_opt_set_int(c, "filter_cache", filter_cache,     0);
+
+    return c;
+}
+
+static AVFrame *scale(SwsContext *c, const AVFrame *src, int i)
+{
+    AVFrame *dst = av_frame_alloc();
+
+    if (!dst)
+        return NULL;
+
+    dst->width  = tests[i].dst_w;
+    dst->height = tests[i].dst_h;
+    dst->format = tests[i].dst_fmt;
+    if (sws_scale_frame(c, dst, src) < 0)
+        av_frame_free(&dst);
+
+    return dst;
+}
+
+static int frames_equal(const AVFrame *a, const AVFrame *b)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->format);
+    int linesize[4];
+
+    if (av_image_fill_linesizes(linesize, a->format, a->width) < 0)
+        return 0;
+
+    for (int p = 0; p < 4 && a->data[p]; p++) {
+        int h = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h) : a->height;
+        for (int y = 0; y < h; y++)
+            if (memcmp(a->data[p] + y * a->linesize[p], b->data[p] + y * b->linesize[p],
+                       linesize[p]))
+                return 0;
+    }
+    return 1;
+}
+
+int main(void)
+{
+    AVLFG rand;
+    int ret = 0;
+
+    av_lfg_init(&rand, 1);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        SwsContext *ref_ctx = alloc_context(i, 0);
+        SwsContext *c1      = alloc_context(i, 1);
+        SwsContext *c2      = alloc_context(i, 1);
+        AVFrame *src = av_frame_alloc(), *ref = NULL, *out1 = NULL, *out2 = NULL;
+        int shared = 0, equal = 0;
+
+        if (!ref_ctx || !c1 || !c2 || !src)
+            return 1;
+
+        src->width  = tests[i].src_w;
+        src->height = tests[i].src_h;
+        src->format = tests[i].src_fmt;
+        if (av_frame_get_buffer(src, 0) < 0)
+            return 1;
+        for (int p = 0; p < 4 && src->buf[p]; p++)
+            for (size_t j = 0; j < src->buf[p]->size; j++)
+                src->buf[p]->data[j] = av_lfg_get(&rand);
+
+        /* the first test gets the filters from the prewarmed cache, the
+         * others compute them in the first context */
+        if (!i && sws_filter_cache_prewarm(c1) < 0)
+            return 1;
+        if (sws_init_context(ref_ctx, NULL, NULL) < 0 ||
+            sws_init_context(c1,      NULL, NULL) < 0 ||
+            sws_init_context(c2,      NULL, NULL) < 0)
+            return 1;
+
+        /* the contexts keep their filters when the cache is cleared */
+        sws_filter_cache_clear();
+
+        ref  = scale(ref_ctx, src, i);
+        out1 = scale(c1,      src, i);
+        out2 = scale(c2,      src, i);
+        if (ref && out1 && out2) {
+            shared = c1->hLumFilter == c2->hLumFilter &&
+                     c1->vLumFilter == c2->vLumFilter &&
+                     c1->hLumFilter != ref_ctx->hLumFilter;
+            equal  = frames_equal(ref, out1) && frames_equal(ref, out2);
+        }
+
+        printf("%s %dx%d -> %s %dx%d: filters %s, output %s\n",
+               av_get_pix_fmt_name(tests[i].src_fmt), tests[i].src_w, tests[i].src_h,
+               av_get_pix_fmt_name(tests[i].dst_fmt), tests[i].dst_w, tests[i].dst_h,
+               shared ? "shared" : "not shared", equal ? "identical" : "differs");
+        if (!equal || !shared)
+            ret = 1;
+
+        av_frame_free(&src);
+        av_frame_free(&ref);
+        av_frame_free(&out1);
+        av_frame_free(&out2);
+        sws_freeContext(ref_ctx);
+        sws_freeContext(c1);
+        sws_freeContext(c2);
+    }
+
+    return ret;
+}
@@ -0,0 +1,167 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that the conversions done by sws_scale_frame() without copying give
+ * the same pixels as the regular conversion, for all the format pairs.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+#define W 66
+#define H 42
+
+static struct SwsContext *alloc_context(enum AVPixelFormat src_fmt,
+                                 enum AVPixelFormat dst_fmt, int zero_copy)
+{
+    struct SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+
+    av_opt_set_int(c, "srcw",       W,         0);
+    av_opt_set_int(c, "srch",       H,         0);
+    av_opt_set_int(c, "src_format", src_fmt,   0);
+    av_opt_set_int(c, "dstw",       W,         0);
+    av_opt_set_int(c, "dsth",       H,         0);
+    av_opt_set_int(c, "dst_format", dst_fmt,   0);
+    av_opt_set_int(c, "sws_flags",  SWS_BILINEAR | SWS_ACCURATE_RND | SWS_BITEXACT, 0);
+    av_opt_set_int(c, "zero_copy",  zero_copy, 0);
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+
+    return c;
+}
+
+static int frames_equal(const AVFrame *a, const AVFrame *b)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->format);
+    int linesize[4];
+
+    if (av_image_fill_linesizes(linesize, a->format, a->width) < 0)
+        return 0;
+
+    for (int p = 0; p < 4 && linesize[p]; p++) {
+        int h = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h) : a->height;
+        for (int y = 0; y < h; y++)
+            if (memcmp(a->data[p] + y * a->linesize[p], b->data[p] + y * b->linesize[p],
+                       linesize[p]))
+                return 0;
+    }
+    return 1;
+}
+
+int main(void)
+{
+    const AVPixFmtDescriptor *src_desc = NULL, *dst_desc;
+    AVFrame *rnd = av_frame_alloc();
+    AVLFG lfg;
+    int nb_zero_copy = 0, ret = 0;
+
+    if (!rnd)
+        return 1;
+    av_lfg_init(&lfg, 1);
+
+    /* random content, brought into each source format by swscale so that
+     * the bits unused by the format are as it would set them */
+    rnd->width  = W;
+    rnd->height = H;
+    rnd->format = AV_PIX_FMT_YUVA444P16;
+    if (av_frame_get_buffer(rnd, 0) < 0)
+        return 1;
+    for (int p = 0; p < 4 && rnd->buf[p]; p++)
+        for (size_t j = 0; j < rnd->buf[p]->size; j++)
+            rnd->buf[p]->data[j] = av_lfg_get(&lfg);
+
+    while ((src_desc = av_pix_fmt_desc_next(src_desc))) {
+        enum AVPixelFormat src_fmt = av_pix_fmt_desc_get_id(src_desc);
+        AVFrame *src = av_frame_alloc();
+        struct SwsContext *c;
+
+        if (!src)
+            return 1;
+        if (!sws_isSupportedInput(src_fmt) || !sws_isSupportedOutput(src_fmt) ||
+            !(c = alloc_context(rnd->format, src_fmt, 0))) {
+            av_frame_free(&src);
+            continue;
+        }
+        src->width  = W;
+        src->height = H;
+        src->format = src_fmt;
+        if (av_frame_get_buffer(src, 0) < 0 || sws_scale_frame(c, src, rnd) < 0)
+            return 1;
+        sws_freeContext(c);
+
+        dst_desc = NULL;
+        while ((dst_desc = av_pix_fmt_desc_next(dst_desc))) {
+            enum AVPixelFormat dst_fmt = av_pix_fmt_desc_get_id(dst_desc);
+            struct SwsContext *ref_ctx, *zc_ctx;
+            AVFrame *ref, *out;
+
+            if (!sws_isSupportedOutput(dst_fmt))
+                continue;
+            ref_ctx = alloc_context(src_fmt, dst_fmt, 0);
+            zc_ctx  = alloc_context(src_fmt, dst_fmt, 1);
+            ref     = av_frame_alloc();
+            out     = av_frame_alloc();
+            if (!ref || !out)
+                return 1;
+
+            if (ref_ctx && zc_ctx &&
+                sws_scale_frame(ref_ctx, ref, src) >= 0 &&
+                sws_scale_frame(zc_ctx,  out, src) >= 0) {
+                int shared = 0;
+
+                for (int p = 0; p < 4 && out->data[p]; p++)
+                    for (int q = 0; q < 4; q++)
+                        shared |= out->data[p] == src->data[q];
+                if (shared) {
+                    int equal = frames_equal(ref, out);
+
+                    printf("%s -> %s: %s\n", av_get_pix_fmt_name(src_fmt),
+                           av_get_pix_fmt_name(dst_fmt), equal ? "no copy" : "differs");
+                    nb_zero_copy++;
+                    if (!equal)
+                        ret = 1;
+                }
+            }
+
+            av_frame_free(&ref);
+            av_frame_free(&out);
+            sws_freeContext(ref_ctx);
+            sws_freeContext(zc_ctx);
+        }
+        av_frame_free(&src);
+    }
+
+    printf("%d conversions without copy\n", nb_zero_copy);
+    av_frame_free(&rnd);
+
+    return ret;
+}
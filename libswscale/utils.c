@@ -423,9 +423,9 @@ static const ScaleAlgorithm scale_algorithms[] = {
     { SWS_X,             "experimental",                    8 },
 };
 
-static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
-                              int *outFilterSize, int xInc, int srcW,
-                              int dstW, int filterAlign, int one,
+static av_cold int initFilter(int16_t **outFilter, float **outFilterFloat,
+                              int32_t **filterPos, int *outFilterSize,
+                              int xInc, int srcW, int dstW, int filterAlign, int one,
                               int flags, int cpu_flags,
                               SwsVector *srcFilter, SwsVector *dstFilter,
                               double param[2], int srcPos, int dstPos)
@@ -783,7 +783,10 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
 
     // Note the +1 is for the MMX scaler which reads over the end
     /* align at 16 for AltiVec (needed by hScale_altivec_real) */
-    if (!FF_ALLOCZ_TYPED_ARRAY(*outFilter, *outFilterSize * (dstW + 3)))
+    if (outFilterFloat) {
+        if (!FF_ALLOCZ_TYPED_ARRAY(*outFilterFloat, *outFilterSize * (dstW + 3)))
+            goto nomem;
+    } else if (!FF_ALLOCZ_TYPED_ARRAY(*outFilter, *outFilterSize * (dstW + 3)))
         goto nomem;
 
     /* normalize & store in outFilter */
@@ -795,11 +798,19 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
         for (j = 0; j < filterSize; j++) {
             sum += filter[i * filterSize + j];
         }
-        sum = (sum + one / 2) / one;
+        if (!outFilterFloat)
+            sum = (sum + one / 2) / one;
         if (!sum) {
             av_log(NULL, AV_LOG_WARNING, "SwScaler: zero vector in scaling\n");
             sum = 1;
         }
+        if (outFilterFloat) {
+            /* the float scalers keep the full precision of the coefficients */
+            for (j = 0; j < *outFilterSize; j++)
+                (*outFilterFloat)[i * (*outFilterSize) + j] =
+                    (double)filter[i * filterSize + j] / sum;
+            continue;
+        }
         for (j = 0; j < *outFilterSize; j++) {
             int64_t v = filter[i * filterSize + j] + error;
             int intV  = ROUNDED_DIV(v, sum);
@@ -814,6 +825,12 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
                                                       * read over the end */
     for (i = 0; i < *outFilterSize; i++) {
         int k = (dstW - 1) * (*outFilterSize) + i;
+        if (outFilterFloat) {
+            (*outFilterFloat)[k + 1 * (*outFilterSize)] =
+            (*outFilterFloat)[k + 2 * (*outFilterSize)] =
+            (*outFilterFloat)[k + 3 * (*outFilterSize)] = (*outFilterFloat)[k];
+            continue;
+        }
         (*outFilter)[k + 1 * (*outFilterSize)] =
         (*outFilter)[k + 2 * (*outFilterSize)] =
         (*outFilter)[k + 3 * (*outFilterSize)] = (*outFilter)[k];
@@ -1030,6 +1047,17 @@ static void handle_formats(SwsContext *c)
         fill_xyztables(c);
 }
 
+static void free_tiles(SwsContext *c)
+{
+    avpriv_slicethread_free(&c->slicethread);
+    av_freep(&c->slice_err);
+
+    for (int i = 0; i < c->nb_tile_ctx; i++)
+        sws_freeContext(c->tile_ctx[i]);
+    av_freep(&c->tile_ctx);
+    c->nb_tile_ctx = 0;
+}
+
 static int range_override_needed(enum AVPixelFormat format)
 {
     return !isYUV(format) && !isGray(format);
@@ -1056,6 +1084,24 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
         return parent_ret;
     }
 
+    if (c->nb_tile_ctx) {
+        int cascaded = 0;
+
+        for (int i = 0; i < c->nb_tile_ctx; i++) {
+            int ret = sws_setColorspaceDetails(c->tile_ctx[i], inv_table,
+                                               srcRange, table, dstRange,
+                                               brightness, contrast, saturation);
+            if (ret < 0)
+                return ret;
+            cascaded |= !!c->tile_ctx[i]->cascaded_context[0];
+        }
+
+        /* the tiles would each go through an intermediate format of their
+         * own size, let the whole frame context do the conversion instead */
+        if (cascaded)
+            free_tiles(c);
+    }
+
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
     desc_src = av_pix_fmt_desc_get(c->srcFormat);
@@ -1238,20 +1284,6 @@ SwsContext *sws_alloc_context(void)
     return c;
 }
 
-static uint16_t * alloc_gamma_tbl(double e)
-{
-    int i = 0;
-    uint16_t * tbl;
-    tbl = (uint16_t*)av_malloc(sizeof(uint16_t) * 1 << 16);
-    if (!tbl)
-        return NULL;
-
-    for (i = 0; i < 65536; ++i) {
-        tbl[i] = pow(i / 65535.0, e) * 65535.0;
-    }
-    return tbl;
-}
-
 static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
 {
     switch(fmt) {
@@ -1316,6 +1348,135 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
 static int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
                                    SwsFilter *dstFilter);
 
+/**
+ * Compute a filter with initFilter() and set it up for the scalers, or
+ * share it with other contexts through the filter cache if enabled.
+ * index selects the hLum, hChr, vLum or vChr filter.
+ */
+static av_cold int init_filter(SwsContext *c, int index,
+                               int16_t **outFilter, int32_t **filterPos,
+                               int *outFilterSize, int xInc, int srcW,
+                               int dstW, int filterAlign, int one,
+                               int flags, int cpu_flags,
+                               SwsVector *srcFilter, SwsVector *dstFilter,
+                               int srcPos, int dstPos)
+{
+    const int horizontal = index < 2;
+    // filters built from user supplied vectors are not shared
+    const int cache = c->filter_cache && !srcFilter && !dstFilter;
+    SwsFilterKey key;
+    int ret;
+
+    if (cache) {
+        memset(&key, 0, sizeof(key));
+        key.xInc        = xInc;
+        key.srcW        = srcW;
+        key.dstW        = dstW;
+        key.filterAlign = filterAlign;
+        key.one         = one;
+        key.flags       = flags;
+        key.cpu_flags   = cpu_flags;
+        key.srcPos      = srcPos;
+        key.dstPos      = dstPos;
+        key.layout      = horizontal && c->srcBpc == 8 && c->dstBpc <= 14;
+        key.param[0]    = c->param[0];
+        key.param[1]    = c->param[1];
+
+        ret = ff_sws_filter_cache_get(&key, &c->filter_buf[index],
+                                      filterPos, outFilterSize);
+        if (ret < 0)
+            return ret;
+        if (ret > 0) {
+            *outFilter = (int16_t *)c->filter_buf[index]->data;
+            return 0;
+        }
+    }
+
+    ret = initFilter(outFilter, NULL, filterPos, outFilterSize, xInc, srcW, dstW,
+                     filterAlign, one, flags, cpu_flags, srcFilter, dstFilter,
+                     c->param, srcPos, dstPos);
+    if (ret < 0)
+        return ret;
+
+    if (horizontal &&
+        ff_shuffle_filter_coefficients(c, *filterPos, *outFilterSize, *outFilter, dstW) < 0)
+        return AVERROR(ENOMEM);
+
+    if (cache) {
+        c->filter_buf[index] = ff_sws_filter_buffer_wrap(*outFilter, *filterPos,
+                                                         *outFilterSize, dstW);
+        if (!c->filter_buf[index])
+            return AVERROR(ENOMEM);
+        ff_sws_filter_cache_add(&key, c->filter_buf[index], *filterPos, *outFilterSize);
+    }
+
+    return 0;
+}
+
+av_cold int ff_sws_init_float_filter(SwsContext *c, float **filter, int32_t **filterPos,
+                                     int *filterSize, int srcW, int dstW,
+                                     SwsVector *srcFilter, SwsVector *dstFilter)
+{
+    const int flags = (c->flags & SWS_BICUBLIN) ? (c->flags | SWS_BICUBIC) : c->flags;
+    const int xInc  = (((int64_t)srcW << 16) + (dstW >> 1)) / dstW;
+
+    /* no alignment needed, the float scalers handle any filter size, and
+     * the coefficients are not quantized */
+    return initFilter(NULL, filter, filterPos, filterSize, xInc, srcW, dstW,
+                      1, 1, flags, 0, srcFilter, dstFilter, c->param,
+                      get_local_pos(c, 0, 0, 0), get_local_pos(c, 0, 0, 0));
+}
+
+static int copy_tile_filter(int16_t **filter, int **filterPos, int filterSize,
+                            const int16_t *srcFilter, const int *srcFilterPos,
+                            int x, int w, int srcX)
+{
+    int i;
+
+    if (!FF_ALLOC_TYPED_ARRAY(*filter,    filterSize * (w + 3)) ||
+        !FF_ALLOC_TYPED_ARRAY(*filterPos, w + 3))
+        return AVERROR(ENOMEM);
+
+    memcpy(*filter, srcFilter + x * filterSize, filterSize * w * sizeof(**filter));
+    for (i = 0; i < w; i++)
+        (*filterPos)[i] = srcFilterPos[x + i] - srcX;
+
+    /* replicate the last pixel like initFilter() does, the SIMD scalers
+     * read over the end */
+    for (; i < w + 3; i++) {
+        (*filterPos)[i] = (*filterPos)[w - 1];
+        memcpy(*filter + i * filterSize, *filter + (w - 1) * filterSize,
+               filterSize * sizeof(**filter));
+    }
+
+    return 0;
+}
+
+/**
+ * Use the part of the horizontal filters of the whole frame covering the
+ * tile, so that the tiles produce exactly the same output.
+ * The tiles start at a multiple of 16 pixels, so the coefficients keep the
+ * layout set up by ff_shuffle_filter_coefficients().
+ */
+static int init_tile_filters(SwsContext *c, const SwsContext *parent)
+{
+    int ret;
+
+    c->hLumFilterSize = parent->hLumFilterSize;
+    c->hChrFilterSize = parent->hChrFilterSize;
+
+    ret = copy_tile_filter(&c->hLumFilter, &c->hLumFilterPos, c->hLumFilterSize,
+                           parent->hLumFilter, parent->hLumFilterPos,
+                           c->tile_dst_x, c->dstW, c->tile_src_x);
+    if (ret < 0)
+        return ret;
+
+    return copy_tile_filter(&c->hChrFilter, &c->hChrFilterPos, c->hChrFilterSize,
+                            parent->hChrFilter, parent->hChrFilterPos,
+                            c->tile_dst_x >> c->chrDstHSubSample, c->chrDstW,
+                            c->tile_src_x >> c->chrSrcHSubSample);
+}
+
 static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
                                            SwsFilter *dstFilter)
 {
@@ -1335,12 +1496,14 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
     int ret = 0;
     enum AVPixelFormat tmpFmt;
     static const float float_mult = 1.0f / 255.0f;
+    const SwsContext *tile_parent = c->parent && c->parent->tile_ctx ? c->parent : NULL;
 
     cpu_flags = av_get_cpu_flags();
     flags     = c->flags;
     emms_c();
 
-    unscaled = (srcW == dstW && srcH == dstH);
+    /* a column tile is never unscaled, even if its own sizes happen to match */
+    unscaled = (srcW == dstW && srcH == dstH) && !tile_parent;
 
     if (!c->contrast && !c->saturation && !c->dstFormatBpp)
         sws_setColorspaceDetails(c, ff_yuv2rgb_coeffs[SWS_CS_DEFAULT], c->srcRange,
@@ -1554,6 +1717,12 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
          (flags & SWS_FAST_BILINEAR)))
         c->chrSrcHSubSample = 1;
 
+    /* column tiles keep the chroma layout chosen for the whole frame */
+    if (tile_parent) {
+        c->chrSrcHSubSample = tile_parent->chrSrcHSubSample;
+        c->chrDstHSubSample = tile_parent->chrDstHSubSample;
+    }
+
     // Note the AV_CEIL_RSHIFT is so that we always round toward +inf.
     c->chrSrcW = AV_CEIL_RSHIFT(srcW, c->chrSrcHSubSample);
     c->chrSrcH = AV_CEIL_RSHIFT(srcH, c->chrSrcVSubSample);
@@ -1614,48 +1783,31 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
 
     // hardcoded for now
     c->gamma_value = 2.2;
-    tmpFmt = AV_PIX_FMT_RGBA64LE;
-
 
-    if (!unscaled && c->gamma_flag && (srcFormat != tmpFmt || dstFormat != tmpFmt)) {
-        SwsContext *c2;
-        c->cascaded_context[0] = NULL;
+    /* gamma correct scaling converts to planar float, scales in linear
+     * light and converts to the destination format */
+    if (!unscaled && c->gamma_flag) {
+        tmpFmt = isALPHA(srcFormat) && isALPHA(dstFormat) ? AV_PIX_FMT_GBRAPF32
+                                                          : AV_PIX_FMT_GBRPF32;
 
         ret = av_image_alloc(c->cascaded_tmp[0], c->cascaded_tmpStride[0],
                             srcW, srcH, tmpFmt, 64);
         if (ret < 0)
             return ret;
 
-        c->cascaded_context[0] = sws_getContext(srcW, srcH, srcFormat,
-                                                srcW, srcH, tmpFmt,
-                                                flags, NULL, NULL, c->param);
-        if (!c->cascaded_context[0]) {
-            return AVERROR(ENOMEM);
+        c->cascaded_context[0] = NULL;
+        if (srcFormat != tmpFmt) {
+            c->cascaded_context[0] = sws_getContext(srcW, srcH, srcFormat,
+                                                    srcW, srcH, tmpFmt,
+                                                    flags, NULL, NULL, c->param);
+            if (!c->cascaded_context[0])
+                return AVERROR(ENOMEM);
         }
 
-        c->cascaded_context[1] = sws_getContext(srcW, srcH, tmpFmt,
-                                                dstW, dstH, tmpFmt,
-                                                flags, srcFilter, dstFilter, c->param);
-
-        if (!c->cascaded_context[1])
-            return AVERROR(ENOMEM);
-
-        c2 = c->cascaded_context[1];
-        c2->is_internal_gamma = 1;
-        c2->gamma     = alloc_gamma_tbl(    c->gamma_value);
-        c2->inv_gamma = alloc_gamma_tbl(1.f/c->gamma_value);
-        if (!c2->gamma || !c2->inv_gamma)
-            return AVERROR(ENOMEM);
-
-        // is_internal_flag is set after creating the context
-        // to properly create the gamma convert FilterDescriptor
-        // we have to re-initialize it
-        ff_free_filters(c2);
-        if ((ret = ff_init_filters(c2)) < 0) {
-            sws_freeContext(c2);
-            c->cascaded_context[1] = NULL;
+        ret = ff_sws_gamma_scaler_init(c, srcFilter, dstFilter,
+                                       tmpFmt == AV_PIX_FMT_GBRAPF32);
+        if (ret < 0)
             return ret;
-        }
 
         c->cascaded_context[2] = NULL;
         if (dstFormat != tmpFmt) {
@@ -1856,35 +2008,32 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
 #endif
         } else
 #endif /* HAVE_MMXEXT_INLINE */
-        {
+        if (tile_parent) {
+            if ((ret = init_tile_filters(c, tile_parent)) < 0)
+                goto fail;
+        } else {
             const int filterAlign = X86_MMX(cpu_flags)     ? 4 :
                                     PPC_ALTIVEC(cpu_flags) ? 8 :
                                     have_neon(cpu_flags)   ? 4 :
                                     have_lsx(cpu_flags)    ? 8 :
                                     have_lasx(cpu_flags)   ? 8 : 1;
 
-            if ((ret = initFilter(&c->hLumFilter, &c->hLumFilterPos,
+            if ((ret = init_filter(c, 0, &c->hLumFilter, &c->hLumFilterPos,
                            &c->hLumFilterSize, c->lumXInc,
                            srcW, dstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                            cpu_flags, srcFilter->lumH, dstFilter->lumH,
-                           c->param,
                            get_local_pos(c, 0, 0, 0),
                            get_local_pos(c, 0, 0, 0))) < 0)
                 goto fail;
-            if (ff_shuffle_filter_coefficients(c, c->hLumFilterPos, c->hLumFilterSize, c->hLumFilter, dstW) < 0)
-                goto nomem;
-            if ((ret = initFilter(&c->hChrFilter, &c->hChrFilterPos,
+            if ((ret = init_filter(c, 1, &c->hChrFilter, &c->hChrFilterPos,
                            &c->hChrFilterSize, c->chrXInc,
                            c->chrSrcW, c->chrDstW, filterAlign, 1 << 14,
                            (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
                            cpu_flags, srcFilter->chrH, dstFilter->chrH,
-                           c->param,
                            get_local_pos(c, c->chrSrcHSubSample, c->src_h_chr_pos, 0),
                            get_local_pos(c, c->chrDstHSubSample, c->dst_h_chr_pos, 0))) < 0)
                 goto fail;
-            if (ff_shuffle_filter_coefficients(c, c->hChrFilterPos, c->hChrFilterSize, c->hChrFilter, c->chrDstW) < 0)
-                goto nomem;
         }
     } // initialize horizontal stuff
 
@@ -1894,20 +2043,18 @@ static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
                                 PPC_ALTIVEC(cpu_flags) ? 8 :
                                 have_neon(cpu_flags)   ? 2 : 1;
 
-        if ((ret = initFilter(&c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
+        if ((ret = init_filter(c, 2, &c->vLumFilter, &c->vLumFilterPos, &c->vLumFilterSize,
                        c->lumYInc, srcH, dstH, filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BICUBIC) : flags,
                        cpu_flags, srcFilter->lumV, dstFilter->lumV,
-                       c->param,
                        get_local_pos(c, 0, 0, 1),
                        get_local_pos(c, 0, 0, 1))) < 0)
             goto fail;
-        if ((ret = initFilter(&c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
+        if ((ret = init_filter(c, 3, &c->vChrFilter, &c->vChrFilterPos, &c->vChrFilterSize,
                        c->chrYInc, c->chrSrcH, c->chrDstH,
                        filterAlign, (1 << 12),
                        (flags & SWS_BICUBLIN) ? (flags | SWS_BILINEAR) : flags,
                        cpu_flags, srcFilter->chrV, dstFilter->chrV,
-                       c->param,
                        get_local_pos(c, c->chrSrcVSubSample, c->src_v_chr_pos, 1),
                        get_local_pos(c, c->chrDstVSubSample, c->dst_v_chr_pos, 1))) < 0)
 
@@ -2073,6 +2220,123 @@ static int context_init_threaded(SwsContext *c,
     return 0;
 }
 
+static int tiling_supported(const SwsContext *c)
+{
+    const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
+
+    /* only the generic scaler writing planar output is split in columns,
+     * the other paths either carry state along the lines or do not use
+     * per pixel horizontal filters; the inline MMX vertical filter used
+     * without accurate_rnd or bitexact is not known to be tile safe */
+    return !c->convert_unscaled && !c->cascaded_context[0] &&
+           !c->use_mmx_vfilter &&
+           !(c->srcW == c->dstW && c->srcH == c->dstH) &&
+           !(c->flags & SWS_FAST_BILINEAR) && c->dither != SWS_DITHER_ED &&
+           !(desc_src->flags & AV_PIX_FMT_FLAG_BITSTREAM) &&
+           !isPacked(c->dstFormat);
+}
+
+/**
+ * Find the source columns read by the horizontal filters of the
+ * destination columns [dst_x0, dst_x1).
+ */
+static void tile_src_range(const SwsContext *c, int dst_x0, int dst_x1,
+                           int *src_x0, int *src_x1)
+{
+    const int chr_x0 = dst_x0 >> c->chrDstHSubSample;
+    const int chr_x1 = AV_CEIL_RSHIFT(dst_x1, c->chrDstHSubSample);
+    int min = INT_MAX, max = 0;
+
+    for (int i = dst_x0; i < dst_x1; i++) {
+        min = FFMIN(min, c->hLumFilterPos[i]);
+        max = FFMAX(max, c->hLumFilterPos[i] + c->hLumFilterSize);
+    }
+    for (int i = chr_x0; i < chr_x1; i++) {
+        min = FFMIN(min, c->hChrFilterPos[i] << c->chrSrcHSubSample);
+        max = FFMAX(max, (c->hChrFilterPos[i] + c->hChrFilterSize) << c->chrSrcHSubSample);
+    }
+
+    // keep the source pointers aligned and chroma sited like in the frame
+    *src_x0 = FFMAX(min, 0) & ~15;
+    *src_x1 = FFMIN(max, c->srcW);
+}
+
+static int context_init_tiled(SwsContext *c,
+                              SwsFilter *src_filter, SwsFilter *dst_filter)
+{
+    /* a multiple of 64 keeps the luma and chroma tile starts aligned for the
+     * SIMD horizontal scalers and the ordered dither */
+    const int tile_w   = FFALIGN(c->tile_width, 64);
+    const int nb_tiles = c->dstW / tile_w;
+    int ret;
+
+    ret = sws_init_single_context(c, src_filter, dst_filter);
+    if (ret < 0)
+        return ret;
+
+    if (nb_tiles < 2 || !tiling_supported(c)) {
+        av_log(c, AV_LOG_VERBOSE, "Column tiles are not used for this conversion\n");
+        return 0;
+    }
+
+    c->tile_ctx = av_calloc(nb_tiles, sizeof(*c->tile_ctx));
+    if (!c->tile_ctx)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < nb_tiles; i++) {
+        const int dst_x0 = i * tile_w;
+        const int dst_x1 = i == nb_tiles - 1 ? c->dstW : dst_x0 + tile_w;
+        int src_x0, src_x1;
+        SwsContext *t;
+
+        tile_src_range(c, dst_x0, dst_x1, &src_x0, &src_x1);
+
+        t = c->tile_ctx[i] = sws_alloc_context();
+        if (!t)
+            return AVERROR(ENOMEM);
+
+        c->nb_tile_ctx++;
+        t->parent = c;
+
+        ret = av_opt_copy((void*)t, (void*)c);
+        if (ret < 0)
+            return ret;
+
+        t->srcW       = src_x1 - src_x0;
+        t->dstW       = dst_x1 - dst_x0;
+        t->tile_src_x = src_x0;
+        t->tile_dst_x = dst_x0;
+        t->tile_width = 0;
+        t->nb_threads = 1;
+
+        ret = sws_init_single_context(t, src_filter, dst_filter);
+        if (ret < 0)
+            return ret;
+    }
+
+    av_log(c, AV_LOG_VERBOSE, "Scaling in %d column tiles of %d pixels\n",
+           nb_tiles, tile_w);
+
+    if (c->nb_threads == 1)
+        return 0;
+
+    ret = avpriv_slicethread_create(&c->slicethread, (void*)c,
+                                    ff_sws_tile_worker, NULL, c->nb_threads);
+    if (ret == AVERROR(ENOSYS)) {
+        c->nb_threads = 1;
+        return 0;
+    } else if (ret < 0)
+        return ret;
+
+    c->nb_threads = ret;
+
+    c->slice_err = av_calloc(nb_tiles, sizeof(*c->slice_err));
+    if (!c->slice_err)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -2096,6 +2360,14 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     if (src_format != c->srcFormat || dst_format != c->dstFormat)
         av_log(c, AV_LOG_WARNING, "deprecated pixel format used, make sure you did set range correctly\n");
 
+    if (c->tile_width) {
+        ret = context_init_tiled(c, srcFilter, dstFilter);
+        if (ret < 0 || c->nb_tile_ctx || c->nb_threads == 1)
+            return ret;
+        // tiles cannot be used, fall back to threading over rows
+        return context_init_threaded(c, srcFilter, dstFilter);
+    }
+
     if (c->nb_threads != 1) {
         ret = context_init_threaded(c, srcFilter, dstFilter);
         if (ret < 0 || c->nb_threads > 1)
@@ -2106,6 +2378,26 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     return sws_init_single_context(c, srcFilter, dstFilter);
 }
 
+int sws_filter_cache_prewarm(const struct SwsContext *c)
+{
+    SwsContext *tmp = sws_alloc_context();
+    int ret;
+
+    if (!tmp)
+        return AVERROR(ENOMEM);
+
+    ret = av_opt_copy((void*)tmp, (const void*)c);
+    if (ret >= 0) {
+        tmp->filter_cache = 1;
+        tmp->nb_threads   = 1;
+        tmp->tile_width   = 0;
+        ret = sws_init_context(tmp, NULL, NULL);
+    }
+
+    sws_freeContext(tmp);
+    return ret;
+}
+
 SwsContext *sws_getContext(int srcW, int srcH, enum AVPixelFormat srcFormat,
                            int dstW, int dstH, enum AVPixelFormat dstFormat,
                            int flags, SwsFilter *srcFilter,
@@ -2443,6 +2735,8 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    free_tiles(c);
+
     for (i = 0; i < c->nb_slice_ctx; i++)
         sws_freeContext(c->slice_ctx[i]);
     av_freep(&c->slice_ctx);
@@ -2458,6 +2752,18 @@ void sws_freeContext(SwsContext *c)
 
     av_freep(&c->src_ranges.ranges);
 
+    // shared filters are freed with their buffers
+    if (c->filter_buf[0])
+        c->hLumFilter = NULL, c->hLumFilterPos = NULL;
+    if (c->filter_buf[1])
+        c->hChrFilter = NULL, c->hChrFilterPos = NULL;
+    if (c->filter_buf[2])
+        c->vLumFilter = NULL, c->vLumFilterPos = NULL;
+    if (c->filter_buf[3])
+        c->vChrFilter = NULL, c->vChrFilterPos = NULL;
+    for (i = 0; i < FF_ARRAY_ELEMS(c->filter_buf); i++)
+        av_buffer_unref(&c->filter_buf[i]);
+
     av_freep(&c->vLumFilter);
     av_freep(&c->vChrFilter);
     av_freep(&c->hLumFilter);
@@ -2501,8 +2807,7 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->cascaded_tmp[0][0]);
     av_freep(&c->cascaded_tmp[1][0]);
 
-    av_freep(&c->gamma);
-    av_freep(&c->inv_gamma);
+    ff_sws_gamma_scaler_free(&c->gamma_scaler);
 
     av_freep(&c->rgb0_scratch);
     av_freep(&c->xyz_scratch);
@@ -0,0 +1,102 @@
+;******************************************************************************
+;* x86-optimized float scaling functions for gamma correct scaling
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+
+;-----------------------------------------------------------------------------
+; void ff_hscale_float_avx2(float *dst, int dstW, const float *src,
+;                           const float *filter, const int32_t *filterPos,
+;                           int filterSize);
+;
+; dstW is a multiple of 16. The coefficients of each group of 8 output pixels
+; are interleaved, so that every tap is a gather of the source pixels at the
+; 8 positions multiplied by one vector of coefficients.
+;-----------------------------------------------------------------------------
+
+INIT_YMM avx2
+cglobal hscale_float, 6, 9, 8, dst, w, src, filter, pos, fsize, x, j, filter2
+    movsxdifnidn        wq, wd
+    movsxdifnidn    fsizeq, fsized
+    shl             fsizeq, 5               ; bytes of coefficients per group
+    pcmpeqd             m7, m7
+    psrld               m7, 31              ; 1 in each dword
+    xor                 xq, xq
+.loop:
+    movu                m2, [posq + xq*4]
+    movu                m3, [posq + xq*4 + mmsize]
+    lea           filter2q, [filterq + fsizeq]
+    xorps               m0, m0
+    xorps               m1, m1
+    xor                 jq, jq
+.tap:
+    pcmpeqd             m6, m6
+    vgatherdps          m4, [srcq + m2*4], m6
+    pcmpeqd             m6, m6
+    vgatherdps          m5, [srcq + m3*4], m6
+    fmaddps             m0, m4, [filterq  + jq], m0
+    fmaddps             m1, m5, [filter2q + jq], m1
+    paddd               m2, m7
+    paddd               m3, m7
+    add                 jq, mmsize
+    cmp                 jq, fsizeq
+    jl .tap
+    movu [dstq + xq*4], m0
+    movu [dstq + xq*4 + mmsize], m1
+    lea            filterq, [filterq + fsizeq*2]
+    add                 xq, 16
+    cmp                 xq, wq
+    jl .loop
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_vscale_float_avx2(float *dst, int dstW, const float *const *src,
+;                           const float *filter, int filterSize);
+;
+; dstW is a multiple of 16.
+;-----------------------------------------------------------------------------
+
+cglobal vscale_float, 5, 8, 3, dst, w, src, filter, fsize, x, j, ptr
+    movsxdifnidn        wq, wd
+    movsxdifnidn    fsizeq, fsized
+    xor                 xq, xq
+.loop:
+    xorps               m0, m0
+    xorps               m1, m1
+    xor                 jq, jq
+.tap:
+    mov               ptrq, [srcq + jq*8]
+    vbroadcastss        m2, [filterq + jq*4]
+    fmaddps             m0, m2, [ptrq + xq*4], m0
+    fmaddps             m1, m2, [ptrq + xq*4 + mmsize], m1
+    inc                 jq
+    cmp                 jq, fsizeq
+    jl .tap
+    movu [dstq + xq*4], m0
+    movu [dstq + xq*4 + mmsize], m1
+    add                 xq, 16
+    cmp                 xq, wq
+    jl .loop
+    RET
+
+%endif
@@ -27,12 +27,18 @@ SECTION_RODATA 32
 
 minshort:      times 8 dw 0x8000
 yuv2yuvX_16_start:  times 4 dd 0x4000 - 0x40000000
+yuv2yuvX_14_start:  times 4 dd 0x1000
+yuv2yuvX_12_start:  times 4 dd 0x4000
 yuv2yuvX_10_start:  times 4 dd 0x10000
 yuv2yuvX_9_start:   times 4 dd 0x20000
+yuv2yuvX_14_upper:  times 8 dw 0x3fff
+yuv2yuvX_12_upper:  times 8 dw 0xfff
 yuv2yuvX_10_upper:  times 8 dw 0x3ff
 yuv2yuvX_9_upper:   times 8 dw 0x1ff
 pd_4:          times 4 dd 4
 pd_4min0x40000:times 4 dd 4 - (0x40000)
+pw_1:          times 8 dw 1
+pw_4:          times 8 dw 4
 pw_16:         times 8 dw 16
 pw_32:         times 8 dw 32
 pd_255:        times 8 dd 255
@@ -106,7 +112,7 @@ SECTION .text
 ;                                     const uint8_t *dither, int offset)
 ;
 ; Scale one or $filterSize lines of source data to generate one line of output
-; data. The input is 15 bits in int16_t if $output_size is [8,10] and 19 bits in
+; data. The input is 15 bits in int16_t if $output_size is [8,14] and 19 bits in
 ; int32_t if $output_size is 16. $filter is 12 bits. $filterSize is a multiple
 ; of 2. $offset is either 0 or 3. $dither holds 8 values.
 ;-----------------------------------------------------------------------------
@@ -133,7 +139,7 @@ SECTION .text
     mova            m2,  m8
     mova            m1,  m_dith
 %endif ; x86-32/64
-%else ; %1 == 9/10/16
+%else ; %1 == 9/10/12/14/16
     mova            m1, [yuv2yuvX_%1_start]
     mova            m2,  m1
 %endif ; %1 == 8/9/10/16
@@ -199,19 +205,20 @@ SECTION .text
     packssdw        m2,  m1
     packuswb        m2,  m2
     movh   [dstq+r5*1],  m2
-%else ; %1 == 9/10/16
+%else ; %1 == 9/10/12/14/16
 %if %1 == 16
     packssdw        m2,  m1
     paddw           m2, [minshort]
-%else ; %1 == 9/10
+%else ; %1 == 9/10/12/14
 %if cpuflag(sse4)
     packusdw        m2,  m1
+    pminuw          m2, [yuv2yuvX_%1_upper]
 %else ; mmxext/sse2
     packssdw        m2,  m1
     pmaxsw          m2,  m6
-%endif ; mmxext/sse2/sse4/avx
     pminsw          m2, [yuv2yuvX_%1_upper]
-%endif ; %1 == 9/10/16
+%endif ; mmxext/sse2/sse4/avx
+%endif ; %1 == 9/10/12/14/16
     mov%2   [dstq+r5*2],  m2
 %endif ; %1 == 8/9/10/16
 
@@ -234,9 +241,9 @@ SECTION .text
 %endif
 
 cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
-%if %1 == 8 || %1 == 9 || %1 == 10
+%if %1 != 16
     pxor            m6,  m6
-%endif ; %1 == 8/9/10
+%endif ; %1 != 16
 
 %if %1 == 8
 %if ARCH_X86_32
@@ -323,11 +330,15 @@ INIT_XMM sse2
 yuv2planeX_fn  8, 10, 7
 yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 12,  7, 5
+yuv2planeX_fn 14,  7, 5
 
 INIT_XMM sse4
 yuv2planeX_fn  8, 10, 7
 yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 12,  7, 5
+yuv2planeX_fn 14,  7, 5
 yuv2planeX_fn 16,  8, 5
 
 %if HAVE_AVX_EXTERNAL
@@ -335,6 +346,8 @@ INIT_XMM avx
 yuv2planeX_fn  8, 10, 7
 yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 12,  7, 5
+yuv2planeX_fn 14,  7, 5
 %endif
 
 ; %1=outout-bpc, %2=alignment (u/a)
@@ -367,7 +380,7 @@ yuv2planeX_fn 10,  7, 5
 %endif ; mmx/sse2/sse4/avx
     mov%2    [dstq+wq*2+mmsize*0], m0
     mov%2    [dstq+wq*2+mmsize*1], m2
-%else ; %1 == 9/10
+%else ; %1 == 9/10/12/14
     paddsw          m0, m2, [srcq+wq*2+mmsize*0]
     paddsw          m1, m2, [srcq+wq*2+mmsize*1]
     psraw           m0, 15 - %1
@@ -420,6 +433,14 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     pxor            m4, m4
     mova            m3, [pw_1024]
     mova            m2, [pw_16]
+%elif %1 == 12
+    pxor            m4, m4
+    mova            m3, [yuv2yuvX_12_upper]
+    mova            m2, [pw_4]
+%elif %1 == 14
+    pxor            m4, m4
+    mova            m3, [yuv2yuvX_14_upper]
+    mova            m2, [pw_1]
 %else ; %1 == 16
 %if cpuflag(sse4) ; sse4/avx
     mova            m4, [pd_4]
@@ -443,6 +464,8 @@ INIT_XMM sse2
 yuv2plane1_fn  8, 5, 5
 yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 12, 5, 3
+yuv2plane1_fn 14, 5, 3
 yuv2plane1_fn 16, 6, 3
 
 INIT_XMM sse4
@@ -453,6 +476,8 @@ INIT_XMM avx
 yuv2plane1_fn  8, 5, 5
 yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 12, 5, 3
+yuv2plane1_fn 14, 5, 3
 yuv2plane1_fn 16, 5, 3
 %endif
 
@@ -570,6 +595,305 @@ yuv2nv12cX_fn yuv2nv21
 %endif
 %endif ; ARCH_X86_64
 
+;-----------------------------------------------------------------------------
+; AVX2 high bit depth vertical scaling
+;
+; void ff_yuv2planeX_<output_size>_avx2(const int16_t *filter, int filterSize,
+;                                       const int16_t **src, uint8_t *dst,
+;                                       int dstW, const uint8_t *dither,
+;                                       int offset)
+; void ff_yuv2plane1_<output_size>_avx2(const int16_t *src, uint8_t *dst,
+;                                       int dstW, const uint8_t *dither,
+;                                       int offset)
+;
+; The ff_yuv2p0<output_size>lX/l1_avx2 variants have the same prototype and
+; store the result in the most significant bits of each word (P010/P012).
+;
+; 16 pixels are handled per iteration, the remainder is done 8 pixels at a
+; time in xmm registers, so that at most 7 pixels past dstW are written, as
+; with the SSE versions.
+;-----------------------------------------------------------------------------
+
+%if ARCH_X86_64
+; %1=output-bpc, %2=msb, %3=register prefix (m/xm)
+%macro yuv2planeX_hbd_block 3
+    mova      %3 %+ 0, %3 %+ 6
+    mova      %3 %+ 1, %3 %+ 6
+    xor           cntq, cntq
+%%filterloop:
+    mov           tmpq, [srcq+cntq*gprsize]
+    movu      %3 %+ 2, [tmpq+xq*2]
+    mov           tmpq, [srcq+cntq*gprsize+gprsize]
+    movu      %3 %+ 3, [tmpq+xq*2]
+    vpbroadcastd %3 %+ 4, [filterq+cntq*2]  ; coeff[j], coeff[j+1]
+    punpcklwd %3 %+ 5, %3 %+ 2, %3 %+ 3
+    punpckhwd %3 %+ 2, %3 %+ 3
+    pmaddwd   %3 %+ 5, %3 %+ 4
+    pmaddwd   %3 %+ 2, %3 %+ 4
+    paddd     %3 %+ 0, %3 %+ 5
+    paddd     %3 %+ 1, %3 %+ 2
+    add           cntq, 2
+    cmp           cntq, fltsizeq
+    jl %%filterloop
+
+    psrad     %3 %+ 0, 27 - %1
+    psrad     %3 %+ 1, 27 - %1
+    ; the unpack above and the pack here are both in-lane,
+    ; so the pixels come out in order
+    packusdw  %3 %+ 0, %3 %+ 1
+    pminuw    %3 %+ 0, %3 %+ 7
+%if %2
+    psllw     %3 %+ 0, 16 - %1
+%endif
+    movu  [dstq+xq*2], %3 %+ 0
+%endmacro
+
+; %1=output-bpc, %2=msb
+%macro yuv2planeX_hbd_fn 2
+%if %2
+cglobal yuv2p0%1lX, 5, 8, 8, filter, fltsize, src, dst, w, x, cnt, tmp
+%else
+cglobal yuv2planeX_%1, 5, 8, 8, filter, fltsize, src, dst, w, x, cnt, tmp
+%endif
+    movsxdifnidn      wq, wd
+    movsxdifnidn fltsizeq, fltsized
+    vpbroadcastd      m6, [yuv2yuvX_%1_start]
+    vpbroadcastw      m7, [yuv2yuvX_%1_upper]
+    xor               xq, xq
+.loop:
+    lea             tmpq, [xq+mmsize/2]
+    cmp             tmpq, wq
+    jg .tail
+    yuv2planeX_hbd_block %1, %2, m
+    add               xq, mmsize/2
+    jmp .loop
+.tail:
+    cmp               xq, wq
+    jge .end
+    yuv2planeX_hbd_block %1, %2, xm
+    add               xq, mmsize/4
+    jmp .tail
+.end:
+    RET
+%endmacro
+
+; %1=output-bpc, %2=msb, %3=register prefix (m/xm)
+%macro yuv2plane1_hbd_block 3
+    paddsw    %3 %+ 0, %3 %+ 2, [srcq+xq*2]
+    psraw     %3 %+ 0, 15 - %1
+    pmaxsw    %3 %+ 0, %3 %+ 4
+    pminsw    %3 %+ 0, %3 %+ 3
+%if %2
+    psllw     %3 %+ 0, 16 - %1
+%endif
+    movu  [dstq+xq*2], %3 %+ 0
+%endmacro
+
+; %1=output-bpc, %2=msb
+%macro yuv2plane1_hbd_fn 2
+%if %2
+cglobal yuv2p0%1l1, 3, 5, 5, src, dst, w, x, tmp
+%else
+cglobal yuv2plane1_%1, 3, 5, 5, src, dst, w, x, tmp
+%endif
+    movsxdifnidn      wq, wd
+    mov             tmpd, 1 << (14 - %1)
+    movd             xm2, tmpd
+    vpbroadcastw      m2, xm2              ; rounding
+    vpbroadcastw      m3, [yuv2yuvX_%1_upper]
+    pxor              m4, m4
+    xor               xq, xq
+.loop:
+    lea             tmpq, [xq+mmsize/2]
+    cmp             tmpq, wq
+    jg .tail
+    yuv2plane1_hbd_block %1, %2, m
+    add               xq, mmsize/2
+    jmp .loop
+.tail:
+    cmp               xq, wq
+    jge .end
+    yuv2plane1_hbd_block %1, %2, xm
+    add               xq, mmsize/4
+    jmp .tail
+.end:
+    RET
+%endmacro
+
+; %1=register prefix (m/xm), %2=register size
+%macro yuv2planeX_16_block 2
+    mova      %1 %+ 0, %1 %+ 6
+    mova      %1 %+ 1, %1 %+ 6
+    xor           cntq, cntq
+%%filterloop:
+    vpbroadcastw %1 %+ 4, [filterq+cntq*2]
+    pmovsxwd  %1 %+ 4, xm4                  ; coeff[j] as dwords
+    mov           tmpq, [srcq+cntq*gprsize]
+    pmulld    %1 %+ 2, %1 %+ 4, [tmpq+xq*4]
+    pmulld    %1 %+ 3, %1 %+ 4, [tmpq+xq*4+%2]
+    paddd     %1 %+ 0, %1 %+ 2
+    paddd     %1 %+ 1, %1 %+ 3
+    inc           cntq
+    cmp           cntq, fltsizeq
+    jl %%filterloop
+
+    psrad     %1 %+ 0, 15
+    psrad     %1 %+ 1, 15
+    packssdw  %1 %+ 0, %1 %+ 1
+%ifidn %1, m
+    vpermq         m0, m0, q3120
+%endif
+    paddw     %1 %+ 0, %1 %+ 7
+    movu  [dstq+xq*2], %1 %+ 0
+%endmacro
+
+%macro yuv2planeX_16_fn 0
+cglobal yuv2planeX_16, 5, 8, 8, filter, fltsize, src, dst, w, x, cnt, tmp
+    movsxdifnidn      wq, wd
+    movsxdifnidn fltsizeq, fltsized
+    vpbroadcastd      m6, [yuv2yuvX_16_start]
+    vpbroadcastw      m7, [minshort]
+    xor               xq, xq
+.loop:
+    lea             tmpq, [xq+mmsize/2]
+    cmp             tmpq, wq
+    jg .tail
+    yuv2planeX_16_block m, mmsize
+    add               xq, mmsize/2
+    jmp .loop
+.tail:
+    cmp               xq, wq
+    jge .end
+    yuv2planeX_16_block xm, mmsize/2
+    add               xq, mmsize/4
+    jmp .tail
+.end:
+    RET
+%endmacro
+
+; %1=register prefix (m/xm), %2=register size
+%macro yuv2plane1_16_block 2
+    paddd     %1 %+ 0, %1 %+ 4, [srcq+xq*4]
+    paddd     %1 %+ 1, %1 %+ 4, [srcq+xq*4+%2]
+    psrad     %1 %+ 0, 3
+    psrad     %1 %+ 1, 3
+    packusdw  %1 %+ 0, %1 %+ 1
+%ifidn %1, m
+    vpermq         m0, m0, q3120
+%endif
+    movu  [dstq+xq*2], %1 %+ 0
+%endmacro
+
+%macro yuv2plane1_16_fn 0
+cglobal yuv2plane1_16, 3, 5, 5, src, dst, w, x, tmp
+    movsxdifnidn      wq, wd
+    vpbroadcastd      m4, [pd_4]
+    xor               xq, xq
+.loop:
+    lea             tmpq, [xq+mmsize/2]
+    cmp             tmpq, wq
+    jg .tail
+    yuv2plane1_16_block m, mmsize
+    add               xq, mmsize/2
+    jmp .loop
+.tail:
+    cmp               xq, wq
+    jge .end
+    yuv2plane1_16_block xm, mmsize/2
+    add               xq, mmsize/4
+    jmp .tail
+.end:
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_yuv2p0<output_size>cX_avx2(enum AVPixelFormat format,
+;                                    const uint8_t *dither,
+;                                    const int16_t *filter, int filterSize,
+;                                    const int16_t **u, const int16_t **v,
+;                                    uint8_t *dst, int dstWidth)
+;
+; U goes in the low lane and V in the high lane of each register, 8 pixels
+; are handled per iteration. $filterSize may be odd here.
+;-----------------------------------------------------------------------------
+
+%macro yuv2p01xcX_fn 1
+cglobal yuv2p0%1cX, 8, 11, 8, format, dither, filter, fltsize, u, v, dst, w, x, cnt, tmp
+    movsxdifnidn      wq, wd
+    movsxdifnidn fltsizeq, fltsized
+    vpbroadcastd      m6, [yuv2yuvX_%1_start]
+    vpbroadcastw      m7, [yuv2yuvX_%1_upper]
+    xor               xq, xq
+.loop:
+    mova              m0, m6
+    mova              m1, m6
+    xor             cntq, cntq
+.filterloop:
+    mov             tmpq, [uq+cntq*gprsize]
+    movu             xm2, [tmpq+xq*2]
+    mov             tmpq, [vq+cntq*gprsize]
+    vinserti128       m2, m2, [tmpq+xq*2], 1
+    lea             tmpq, [cntq+1]
+    cmp             tmpq, fltsizeq
+    jge .lasttap
+    mov             tmpq, [uq+cntq*gprsize+gprsize]
+    movu             xm3, [tmpq+xq*2]
+    mov             tmpq, [vq+cntq*gprsize+gprsize]
+    vinserti128       m3, m3, [tmpq+xq*2], 1
+    vpbroadcastd      m4, [filterq+cntq*2] ; coeff[j], coeff[j+1]
+    jmp .accumulate
+.lasttap:
+    pxor              m3, m3
+    vpbroadcastw      m4, [filterq+cntq*2] ; coeff[j]
+.accumulate:
+    punpcklwd         m5, m2, m3
+    punpckhwd         m2, m3
+    pmaddwd           m5, m4
+    pmaddwd           m2, m4
+    paddd             m0, m5
+    paddd             m1, m2
+    add             cntq, 2
+    cmp             cntq, fltsizeq
+    jl .filterloop
+
+    psrad             m0, 27 - %1
+    psrad             m1, 27 - %1
+    packusdw          m0, m1               ; u0..u7 | v0..v7
+    pminuw            m0, m7
+    psllw             m0, 16 - %1
+    vextracti128     xm1, m0, 1
+    punpckhwd        xm2, xm0, xm1
+    punpcklwd        xm0, xm1
+    movu   [dstq+xq*4   ], xm0
+    movu   [dstq+xq*4+16], xm2
+
+    add               xq, 8
+    cmp               xq, wq
+    jl .loop
+    RET
+%endmacro
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2planeX_hbd_fn  9, 0
+yuv2planeX_hbd_fn 10, 0
+yuv2planeX_hbd_fn 12, 0
+yuv2planeX_hbd_fn 14, 0
+yuv2planeX_hbd_fn 10, 1
+yuv2planeX_hbd_fn 12, 1
+yuv2planeX_16_fn
+yuv2plane1_hbd_fn  9, 0
+yuv2plane1_hbd_fn 10, 0
+yuv2plane1_hbd_fn 12, 0
+yuv2plane1_hbd_fn 14, 0
+yuv2plane1_hbd_fn 10, 1
+yuv2plane1_hbd_fn 12, 1
+yuv2plane1_16_fn
+yuv2p01xcX_fn 10
+yuv2p01xcX_fn 12
+%endif
+%endif ; ARCH_X86_64
+
 ;-----------------------------------------------------------------------------
 ; planar grb yuv2anyX functions
 ; void ff_yuv2<gbr_format>_full_X_<opt>(SwsContext *c, const int16_t *lumFilter,
@@ -582,7 +906,7 @@ yuv2nv12cX_fn yuv2nv21
 
 %if ARCH_X86_64
 struc SwsContext
-    .padding:           resb 40292 ; offsetof(SwsContext, yuv2rgb_y_offset)
+    .padding:           resb 40276 ; offsetof(SwsContext, yuv2rgb_y_offset)
     .yuv2rgb_y_offset:  resd 1
     .yuv2rgb_y_coeff:   resd 1
     .yuv2rgb_v2r_coeff: resd 1
@@ -270,7 +270,9 @@ void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
 #define VSCALEX_FUNCS(opt) \
     VSCALEX_FUNC(8,  opt); \
     VSCALEX_FUNC(9,  opt); \
-    VSCALEX_FUNC(10, opt)
+    VSCALEX_FUNC(10, opt); \
+    VSCALEX_FUNC(12, opt); \
+    VSCALEX_FUNC(14, opt)
 
 VSCALEX_FUNC(8, mmxext);
 VSCALEX_FUNCS(sse2);
@@ -285,6 +287,8 @@ void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int ds
     VSCALE_FUNC(8,  opt1); \
     VSCALE_FUNC(9,  opt2); \
     VSCALE_FUNC(10, opt2); \
+    VSCALE_FUNC(12, opt2); \
+    VSCALE_FUNC(14, opt2); \
     VSCALE_FUNC(16, opt1)
 
 VSCALE_FUNCS(sse2, sse2);
@@ -335,6 +339,29 @@ void ff_yuv2 ## fmt ## cX_ ## opt(enum AVPixelFormat format, const uint8_t *dith
 
 YUV2NV_DECL(nv12, avx2);
 YUV2NV_DECL(nv21, avx2);
+YUV2NV_DECL(p010, avx2);
+YUV2NV_DECL(p012, avx2);
+
+VSCALEX_FUNC(9,  avx2);
+VSCALEX_FUNC(10, avx2);
+VSCALEX_FUNC(12, avx2);
+VSCALEX_FUNC(14, avx2);
+VSCALEX_FUNC(16, avx2);
+VSCALE_FUNC(9,  avx2);
+VSCALE_FUNC(10, avx2);
+VSCALE_FUNC(12, avx2);
+VSCALE_FUNC(14, avx2);
+VSCALE_FUNC(16, avx2);
+
+#define YUV2P01X_DECL(bits, opt) \
+void ff_yuv2p0 ## bits ## lX_ ## opt(const int16_t *filter, int filterSize, \
+                                     const int16_t **src, uint8_t *dest, int dstW, \
+                                     const uint8_t *dither, int offset); \
+void ff_yuv2p0 ## bits ## l1_ ## opt(const int16_t *src, uint8_t *dst, int dstW, \
+                                     const uint8_t *dither, int offset)
+
+YUV2P01X_DECL(10, avx2);
+YUV2P01X_DECL(12, avx2);
 
 #define YUV2GBRP_FN_DECL(fmt, opt)                                                      \
 void ff_yuv2##fmt##_full_X_ ##opt(SwsContext *c, const int16_t *lumFilter,           \
@@ -484,6 +511,24 @@ av_cold void ff_sws_init_range_convert_x86(SwsContext *c)
     }
 }
 
+void ff_hscale_float_avx2(float *dst, int dstW, const float *src,
+                          const float *filter, const int32_t *filterPos,
+                          int filterSize);
+void ff_vscale_float_avx2(float *dst, int dstW, const float *const *src,
+                          const float *filter, int filterSize);
+
+av_cold void ff_sws_init_gamma_scaler_dsp_x86(SwsGammaScaler *g)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        g->hscale = ff_hscale_float_avx2;
+        g->vscale = ff_vscale_float_avx2;
+    }
+#endif
+}
+
 av_cold void ff_sws_init_swscale_x86(SwsContext *c)
 {
     int cpu_flags = av_get_cpu_flags();
@@ -540,6 +585,8 @@ av_cold void ff_sws_init_swscale_x86(SwsContext *c)
 #define ASSIGN_VSCALEX_FUNC(vscalefn, opt, do_16_case, condition_8bit) \
 switch(c->dstBpc){ \
     case 16:                          do_16_case;                          break; \
+    case 14: if (!isBE(c->dstFormat)) vscalefn = ff_yuv2planeX_14_ ## opt; break; \
+    case 12: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2planeX_12_ ## opt; break; \
     case 10: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2planeX_10_ ## opt; break; \
     case 9:  if (!isBE(c->dstFormat)) vscalefn = ff_yuv2planeX_9_  ## opt; break; \
     case 8: if ((condition_8bit) && !c->use_mmx_vfilter) vscalefn = ff_yuv2planeX_8_  ## opt; break; \
@@ -547,6 +594,8 @@ switch(c->dstBpc){ \
 #define ASSIGN_VSCALE_FUNC(vscalefn, opt) \
     switch(c->dstBpc){ \
     case 16: if (!isBE(c->dstFormat)) vscalefn = ff_yuv2plane1_16_ ## opt; break; \
+    case 14: if (!isBE(c->dstFormat)) vscalefn = ff_yuv2plane1_14_ ## opt; break; \
+    case 12: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2plane1_12_ ## opt; break; \
     case 10: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) vscalefn = ff_yuv2plane1_10_ ## opt; break; \
     case 9:  if (!isBE(c->dstFormat)) vscalefn = ff_yuv2plane1_9_  ## opt;  break; \
     case 8:                           vscalefn = ff_yuv2plane1_8_  ## opt;  break; \
@@ -692,6 +741,43 @@ switch(c->dstBpc){ \
         default:
             break;
         }
+
+        if (isSemiPlanarYUV(c->dstFormat) && isDataInHighBits(c->dstFormat)) {
+            if (!isBE(c->dstFormat)) {
+                switch (c->dstBpc) {
+                case 10:
+                    c->yuv2planeX = ff_yuv2p010lX_avx2;
+                    c->yuv2nv12cX = ff_yuv2p010cX_avx2;
+                    if (!(c->flags & SWS_ACCURATE_RND))
+                        c->yuv2plane1 = ff_yuv2p010l1_avx2;
+                    break;
+                case 12:
+                    c->yuv2planeX = ff_yuv2p012lX_avx2;
+                    c->yuv2nv12cX = ff_yuv2p012cX_avx2;
+                    if (!(c->flags & SWS_ACCURATE_RND))
+                        c->yuv2plane1 = ff_yuv2p012l1_avx2;
+                    break;
+                }
+            }
+        } else if (!isBE(c->dstFormat) &&
+                   (c->dstBpc == 16 || !isSemiPlanarYUV(c->dstFormat))) {
+            switch (c->dstBpc) {
+            case 16: c->yuv2planeX = ff_yuv2planeX_16_avx2; break;
+            case 14: c->yuv2planeX = ff_yuv2planeX_14_avx2; break;
+            case 12: c->yuv2planeX = ff_yuv2planeX_12_avx2; break;
+            case 10: c->yuv2planeX = ff_yuv2planeX_10_avx2; break;
+            case 9:  c->yuv2planeX = ff_yuv2planeX_9_avx2;  break;
+            }
+            if (!(c->flags & SWS_ACCURATE_RND)) {
+                switch (c->dstBpc) {
+                case 16: c->yuv2plane1 = ff_yuv2plane1_16_avx2; break;
+                case 14: c->yuv2plane1 = ff_yuv2plane1_14_avx2; break;
+                case 12: c->yuv2plane1 = ff_yuv2plane1_12_avx2; break;
+                case 10: c->yuv2plane1 = ff_yuv2plane1_10_avx2; break;
+                case 9:  c->yuv2plane1 = ff_yuv2plane1_9_avx2;  break;
+                }
+            }
+        }
     }
 
 
@@ -794,7 +880,7 @@ switch(c->dstBpc){ \
 
         /* yuv2gbrp uses the SwsContext for yuv coefficients
            if struct offsets change the asm needs to be updated too */
-        av_assert0(offsetof(SwsContext, yuv2rgb_y_offset) == 40292);
+        av_assert0(offsetof(SwsContext, yuv2rgb_y_offset) == 40276);
 
 #define YUV2ANYX_FUNC_CASE(fmt, name, opt)              \
         case fmt:                                       \
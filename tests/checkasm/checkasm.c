@@ -262,6 +262,9 @@ static const struct {
     #if CONFIG_COLORSPACE_FILTER
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
+    #if CONFIG_EBUR128_FILTER || CONFIG_LOUDNORM_FILTER
+        { "ebur128dsp", checkasm_check_ebur128dsp },
+    #endif
     #if CONFIG_EQ_FILTER
         { "vf_eq", checkasm_check_vf_eq },
     #endif
@@ -271,9 +274,15 @@ static const struct {
     #if CONFIG_HFLIP_FILTER
         { "vf_hflip", checkasm_check_vf_hflip },
     #endif
+    #if CONFIG_MINTERPOLATE_FILTER
+        { "vf_minterpolate", checkasm_check_vf_minterpolate },
+    #endif
     #if CONFIG_NLMEANS_FILTER
         { "vf_nlmeans", checkasm_check_nlmeans },
     #endif
+    #if CONFIG_PALETTEUSE_FILTER
+        { "vf_paletteuse", checkasm_check_vf_paletteuse },
+    #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
@@ -281,6 +290,10 @@ static const struct {
         { "vf_sobel", checkasm_check_vf_sobel },
     #endif
 #endif
+#if CONFIG_SWRESAMPLE
+    { "swr_rematrix", checkasm_check_swr_rematrix },
+    { "swr_resample", checkasm_check_swr_resample },
+#endif
 #if CONFIG_SWSCALE
     { "sw_gbrp", checkasm_check_sw_gbrp },
     { "sw_range_convert", checkasm_check_sw_range_convert },
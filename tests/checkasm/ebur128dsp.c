@@ -0,0 +1,140 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/ebur128dsp.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_CHANNELS 8
+#define NB_SAMPLES 256
+#define EPS 1e-9
+
+/* K-weighting filter at 48kHz */
+static const double coeffs_48k[FF_EBUR128_NB_COEFFS] = {
+    1.53512485958697, -2.69169618940638, 1.19839281085285,
+    -1.69065929318241, 0.73248077421585,
+    -1.99004745483398, 0.99007225036621,
+};
+
+static void randomize_buffer(double *buf, int len, double scale)
+{
+    for (int i = 0; i < len; i++)
+        buf[i] = ((double)rnd() / UINT32_MAX * 2.0 - 1.0) * scale;
+}
+
+static void check_filter_channels(void)
+{
+#define STATE_SIZE (MAX_CHANNELS * FF_EBUR128_NB_STATES)
+#define CACHE_SIZE (MAX_CHANNELS * NB_SAMPLES)
+    LOCAL_ALIGNED_16(double, src,       [MAX_CHANNELS * NB_SAMPLES]);
+    LOCAL_ALIGNED_16(double, state_ref, [STATE_SIZE]);
+    LOCAL_ALIGNED_16(double, state_new, [STATE_SIZE]);
+    LOCAL_ALIGNED_16(double, cache_ref, [2 * CACHE_SIZE]);
+    LOCAL_ALIGNED_16(double, cache_new, [2 * CACHE_SIZE]);
+    double *c400_ref[MAX_CHANNELS], *c3000_ref[MAX_CHANNELS];
+    double *c400_new[MAX_CHANNELS], *c3000_new[MAX_CHANNELS];
+    static const int nb_channels[] = { 1, 2, 3, 5, 8 };
+    FFEBUR128DSPContext dsp;
+
+    declare_func(void, const double *coeffs, double *state,
+                 const double *samples, ptrdiff_t stride,
+                 double *const *cache_400, double *const *cache_3000,
+                 int nb_channels, int nb_samples);
+
+    ff_ebur128_dsp_init(&dsp);
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        c400_ref [ch] = cache_ref + ch * NB_SAMPLES;
+        c3000_ref[ch] = cache_ref + ch * NB_SAMPLES + CACHE_SIZE;
+        c400_new [ch] = cache_new + ch * NB_SAMPLES;
+        c3000_new[ch] = cache_new + ch * NB_SAMPLES + CACHE_SIZE;
+    }
+
+    for (int n = 0; n < FF_ARRAY_ELEMS(nb_channels); n++) {
+        const int nb = nb_channels[n];
+
+        if (check_func(dsp.filter_channels, "filter_channels_%dch", nb)) {
+            const int len = 1 + rnd() % NB_SAMPLES;
+
+            randomize_buffer(src, MAX_CHANNELS * NB_SAMPLES, 1.0);
+            randomize_buffer(state_ref, STATE_SIZE, 1.0);
+            randomize_buffer(cache_ref, 2 * CACHE_SIZE, 1.0);
+            /* the window sums are sums of squares */
+            for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+                FF_EBUR128_STATE(state_ref, ch, FF_EBUR128_SUM_400)  = rnd() % 1000;
+                FF_EBUR128_STATE(state_ref, ch, FF_EBUR128_SUM_3000) = rnd() % 10000;
+            }
+            memcpy(state_new, state_ref, sizeof(*state_ref) * STATE_SIZE);
+            memcpy(cache_new, cache_ref, sizeof(*cache_ref) * 2 * CACHE_SIZE);
+
+            call_ref(coeffs_48k, state_ref, src, nb, c400_ref, c3000_ref, nb, len);
+            call_new(coeffs_48k, state_new, src, nb, c400_new, c3000_new, nb, len);
+            if (!double_near_abs_eps_array(state_ref, state_new, EPS, STATE_SIZE) ||
+                !double_near_abs_eps_array(cache_ref, cache_new, EPS, 2 * CACHE_SIZE))
+                fail();
+
+            bench_new(coeffs_48k, state_new, src, nb, c400_new, c3000_new, nb, NB_SAMPLES);
+        }
+    }
+
+    report("filter_channels");
+}
+
+static void check_find_peak(void)
+{
+    LOCAL_ALIGNED_16(double, src, [NB_SAMPLES + FF_EBUR128_TP_TAPS - 1]);
+    static const int sample_rates[] = { 48000, 96000, 192000 };
+    FFEBUR128TruePeak tp;
+
+    declare_func(double, const double *src, int nb_samples,
+                 const double *coeffs, int nb_phases);
+
+    for (int n = 0; n < FF_ARRAY_ELEMS(sample_rates); n++) {
+        if (ff_ebur128_true_peak_init(&tp, 1, sample_rates[n]) < 0) {
+            ff_ebur128_true_peak_uninit(&tp);
+            fail();
+            continue;
+        }
+
+        if (check_func(tp.dsp.find_peak, "find_peak_%dx", tp.nb_phases)) {
+            const int len = 4 * (1 + rnd() % (NB_SAMPLES / 4));
+            double ref, new;
+
+            randomize_buffer(src, NB_SAMPLES + FF_EBUR128_TP_TAPS - 1, 1.0);
+
+            ref = call_ref(src, len, tp.coeffs, tp.nb_phases);
+            new = call_new(src, len, tp.coeffs, tp.nb_phases);
+            if (!double_near_abs_eps(ref, new, EPS))
+                fail();
+
+            bench_new(src, NB_SAMPLES, tp.coeffs, tp.nb_phases);
+        }
+
+        ff_ebur128_true_peak_uninit(&tp);
+    }
+
+    report("find_peak");
+}
+
+void checkasm_check_ebur128dsp(void)
+{
+    check_filter_channels();
+    check_find_peak();
+}
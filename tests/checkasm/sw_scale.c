@@ -23,6 +23,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
 
 #include "libswscale/swscale.h"
 #include "libswscale/swscale_internal.h"
@@ -254,6 +255,216 @@ static void check_yuv2yuvX(int accurate)
 #undef FILTER_SIZES
 }
 
+static const enum AVPixelFormat hbd_formats[] = {
+    AV_PIX_FMT_YUV420P9LE,  AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_YUV420P12LE,
+    AV_PIX_FMT_YUV420P14LE, AV_PIX_FMT_YUV420P16LE, AV_PIX_FMT_P010LE,
+    AV_PIX_FMT_P012LE,
+};
+
+static const int hbd_input_sizes[] = {8, 24, 30, 144, 512};
+
+// Fill a line with data as produced by the horizontal scaler: 15 bits in
+// int16_t for output depths up to 14 bits, 19 bits in int32_t for 16 bits.
+static void randomize_hbd_line(int32_t *line, int len, int dstBpc)
+{
+    randomize_buffers((uint8_t *)line, len * sizeof(*line));
+    if (dstBpc == 16) {
+        for (int i = 0; i < len; i++)
+            line[i] &= (1 << 19) - 1;
+    }
+}
+
+static struct SwsContext *alloc_hbd_context(enum AVPixelFormat format)
+{
+    struct SwsContext *ctx = sws_alloc_context();
+    if (!ctx)
+        return NULL;
+    ctx->dstFormat = format;
+    if (sws_init_context(ctx, NULL, NULL) < 0) {
+        sws_freeContext(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+static void check_yuv2plane1_hbd(void)
+{
+#define LARGEST_HBD_INPUT_SIZE 512
+    struct SwsContext *ctx;
+    int fmti, isi;
+
+    declare_func(void, const int16_t *src, uint8_t *dest,
+                 int dstW, const uint8_t *dither, int offset);
+
+    LOCAL_ALIGNED_32(int32_t, src_pixels, [LARGEST_HBD_INPUT_SIZE]);
+    // room for writing up to 7 pixels past dstW
+    LOCAL_ALIGNED_32(uint16_t, dst0, [LARGEST_HBD_INPUT_SIZE + 8]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [LARGEST_HBD_INPUT_SIZE + 8]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    randomize_buffers(dither, 8);
+
+    for (fmti = 0; fmti < FF_ARRAY_ELEMS(hbd_formats); fmti++) {
+        const char *name = av_get_pix_fmt_name(hbd_formats[fmti]);
+        if (!(ctx = alloc_hbd_context(hbd_formats[fmti]))) {
+            fail();
+            continue;
+        }
+        randomize_hbd_line(src_pixels, LARGEST_HBD_INPUT_SIZE, ctx->dstBpc);
+
+        for (isi = 0; isi < FF_ARRAY_ELEMS(hbd_input_sizes); isi++) {
+            int dstW = hbd_input_sizes[isi];
+            if (check_func(ctx->yuv2plane1, "yuv2plane1_%s_%d", name, dstW)) {
+                memset(dst0, 0, (LARGEST_HBD_INPUT_SIZE + 8) * sizeof(dst0[0]));
+                memset(dst1, 0, (LARGEST_HBD_INPUT_SIZE + 8) * sizeof(dst1[0]));
+
+                call_ref((const int16_t *)src_pixels, (uint8_t *)dst0, dstW, dither, 0);
+                call_new((const int16_t *)src_pixels, (uint8_t *)dst1, dstW, dither, 0);
+                if (memcmp(dst0, dst1, dstW * sizeof(dst0[0]))) {
+                    fail();
+                    printf("failed: yuv2plane1_%s_%d\n", name, dstW);
+                    show_differences((uint8_t *)dst0, (uint8_t *)dst1, dstW * sizeof(dst0[0]));
+                }
+                if (dstW == LARGEST_HBD_INPUT_SIZE)
+                    bench_new((const int16_t *)src_pixels, (uint8_t *)dst1, dstW, dither, 0);
+            }
+        }
+        sws_freeContext(ctx);
+    }
+}
+
+// Produce filter coefficients summing up to 1 << 12, with negative values,
+// as done in check_yuv2yuvX(). Odd sizes are only valid for yuv2nv12cX.
+static void init_hbd_filter(int16_t *filter, int filter_size)
+{
+    if (filter_size == 1) {
+        filter[0] = 1 << 12;
+        return;
+    }
+    for (int i = 0; i < filter_size; i++)
+        filter[i] = -((1 << 12) / (filter_size - 1));
+    filter[rnd() % filter_size] = (1 << 13) - 1;
+}
+
+static void check_yuv2planeX_hbd(void)
+{
+#define LARGEST_HBD_FILTER 16
+    static const int filter_sizes[] = {2, 4, 8, 16};
+    struct SwsContext *ctx;
+    int fmti, fsi, isi, i;
+
+    declare_func(void, const int16_t *filter, int filterSize,
+                 const int16_t **src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    const int16_t *src[LARGEST_HBD_FILTER];
+    LOCAL_ALIGNED_32(int32_t, src_pixels, [LARGEST_HBD_FILTER * LARGEST_HBD_INPUT_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, filter, [LARGEST_HBD_FILTER]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [LARGEST_HBD_INPUT_SIZE + 8]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [LARGEST_HBD_INPUT_SIZE + 8]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    randomize_buffers(dither, 8);
+    for (i = 0; i < LARGEST_HBD_FILTER; i++)
+        src[i] = (const int16_t *)&src_pixels[i * LARGEST_HBD_INPUT_SIZE];
+
+    for (fmti = 0; fmti < FF_ARRAY_ELEMS(hbd_formats); fmti++) {
+        const char *name = av_get_pix_fmt_name(hbd_formats[fmti]);
+        if (!(ctx = alloc_hbd_context(hbd_formats[fmti]))) {
+            fail();
+            continue;
+        }
+        randomize_hbd_line(src_pixels, LARGEST_HBD_FILTER * LARGEST_HBD_INPUT_SIZE,
+                           ctx->dstBpc);
+
+        for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+            init_hbd_filter(filter, filter_sizes[fsi]);
+            for (isi = 0; isi < FF_ARRAY_ELEMS(hbd_input_sizes); isi++) {
+                int dstW = hbd_input_sizes[isi];
+                if (check_func(ctx->yuv2planeX, "yuv2planeX_%s_%d_%d",
+                               name, filter_sizes[fsi], dstW)) {
+                    memset(dst0, 0, (LARGEST_HBD_INPUT_SIZE + 8) * sizeof(dst0[0]));
+                    memset(dst1, 0, (LARGEST_HBD_INPUT_SIZE + 8) * sizeof(dst1[0]));
+
+                    call_ref(filter, filter_sizes[fsi], src, (uint8_t *)dst0, dstW, dither, 0);
+                    call_new(filter, filter_sizes[fsi], src, (uint8_t *)dst1, dstW, dither, 0);
+                    if (memcmp(dst0, dst1, dstW * sizeof(dst0[0]))) {
+                        fail();
+                        printf("failed: yuv2planeX_%s_%d_%d\n", name, filter_sizes[fsi], dstW);
+                        show_differences((uint8_t *)dst0, (uint8_t *)dst1, dstW * sizeof(dst0[0]));
+                    }
+                    if (dstW == LARGEST_HBD_INPUT_SIZE)
+                        bench_new(filter, filter_sizes[fsi], src, (uint8_t *)dst1, dstW, dither, 0);
+                }
+            }
+        }
+        sws_freeContext(ctx);
+    }
+}
+
+static void check_yuv2nv12cX_hbd(void)
+{
+    static const enum AVPixelFormat formats[] = { AV_PIX_FMT_P010LE, AV_PIX_FMT_P012LE };
+    static const int filter_sizes[] = {1, 2, 3, 4, 8, 16};
+    struct SwsContext *ctx;
+    int fmti, fsi, isi, i;
+
+    declare_func(void, enum AVPixelFormat format, const uint8_t *dither,
+                 const int16_t *filter, int filterSize,
+                 const int16_t **u, const int16_t **v,
+                 uint8_t *dst, int dstWidth);
+
+    const int16_t *u[LARGEST_HBD_FILTER], *v[LARGEST_HBD_FILTER];
+    LOCAL_ALIGNED_32(int16_t, u_pixels, [LARGEST_HBD_FILTER * LARGEST_HBD_INPUT_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, v_pixels, [LARGEST_HBD_FILTER * LARGEST_HBD_INPUT_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, filter, [LARGEST_HBD_FILTER]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [2 * (LARGEST_HBD_INPUT_SIZE + 8)]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [2 * (LARGEST_HBD_INPUT_SIZE + 8)]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    randomize_buffers(dither, 8);
+    randomize_buffers((uint8_t *)u_pixels, sizeof(u_pixels[0]) * LARGEST_HBD_FILTER * LARGEST_HBD_INPUT_SIZE);
+    randomize_buffers((uint8_t *)v_pixels, sizeof(v_pixels[0]) * LARGEST_HBD_FILTER * LARGEST_HBD_INPUT_SIZE);
+    for (i = 0; i < LARGEST_HBD_FILTER; i++) {
+        u[i] = &u_pixels[i * LARGEST_HBD_INPUT_SIZE];
+        v[i] = &v_pixels[i * LARGEST_HBD_INPUT_SIZE];
+    }
+
+    for (fmti = 0; fmti < FF_ARRAY_ELEMS(formats); fmti++) {
+        const char *name = av_get_pix_fmt_name(formats[fmti]);
+        if (!(ctx = alloc_hbd_context(formats[fmti]))) {
+            fail();
+            continue;
+        }
+
+        for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+            init_hbd_filter(filter, filter_sizes[fsi]);
+            for (isi = 0; isi < FF_ARRAY_ELEMS(hbd_input_sizes); isi++) {
+                int dstW = hbd_input_sizes[isi];
+                if (check_func(ctx->yuv2nv12cX, "yuv2nv12cX_%s_%d_%d",
+                               name, filter_sizes[fsi], dstW)) {
+                    memset(dst0, 0, 2 * (LARGEST_HBD_INPUT_SIZE + 8) * sizeof(dst0[0]));
+                    memset(dst1, 0, 2 * (LARGEST_HBD_INPUT_SIZE + 8) * sizeof(dst1[0]));
+
+                    call_ref(formats[fmti], dither, filter, filter_sizes[fsi],
+                             u, v, (uint8_t *)dst0, dstW);
+                    call_new(formats[fmti], dither, filter, filter_sizes[fsi],
+                             u, v, (uint8_t *)dst1, dstW);
+                    if (memcmp(dst0, dst1, 2 * dstW * sizeof(dst0[0]))) {
+                        fail();
+                        printf("failed: yuv2nv12cX_%s_%d_%d\n", name, filter_sizes[fsi], dstW);
+                        show_differences((uint8_t *)dst0, (uint8_t *)dst1, 2 * dstW * sizeof(dst0[0]));
+                    }
+                    if (dstW == LARGEST_HBD_INPUT_SIZE)
+                        bench_new(formats[fmti], dither, filter, filter_sizes[fsi],
+                                  u, v, (uint8_t *)dst1, dstW);
+                }
+            }
+        }
+        sws_freeContext(ctx);
+    }
+}
+
 #undef SRC_PIXELS
 #define SRC_PIXELS 512
 
@@ -359,6 +570,73 @@ static void check_hscale(void)
     sws_freeContext(ctx);
 }
 
+static void check_gamma_scale(void)
+{
+#define GAMMA_MAX_FILTER 24
+    static const int filter_sizes[] = { 1, 2, 3, 4, 7, 8, 13, 24 };
+    static const int widths[] = { 16, 128, 352, 512 };
+    SwsGammaScaler g = { 0 };
+
+    LOCAL_ALIGNED_32(float, src, [SRC_PIXELS + GAMMA_MAX_FILTER]);
+    LOCAL_ALIGNED_32(float, lines, [GAMMA_MAX_FILTER * SRC_PIXELS]);
+    LOCAL_ALIGNED_32(float, filter, [SRC_PIXELS * GAMMA_MAX_FILTER]);
+    LOCAL_ALIGNED_32(int32_t, filterPos, [SRC_PIXELS]);
+    LOCAL_ALIGNED_32(float, dst0, [SRC_PIXELS]);
+    LOCAL_ALIGNED_32(float, dst1, [SRC_PIXELS]);
+    const float *vsrc[GAMMA_MAX_FILTER];
+
+    ff_sws_init_gamma_scaler_dsp(&g);
+
+    for (int i = 0; i < SRC_PIXELS + GAMMA_MAX_FILTER; i++)
+        src[i] = (float)rnd() / UINT_MAX;
+    for (int i = 0; i < GAMMA_MAX_FILTER * SRC_PIXELS; i++)
+        lines[i] = (float)rnd() / UINT_MAX;
+    for (int i = 0; i < GAMMA_MAX_FILTER; i++)
+        vsrc[i] = lines + i * SRC_PIXELS;
+
+    for (int fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+        const int size = filter_sizes[fsi];
+
+        /* coefficients of random sign summing to about 1.0 */
+        for (int i = 0; i < SRC_PIXELS * size; i++)
+            filter[i] = ((float)rnd() / UINT_MAX - 0.25f) * 2.0f / size;
+
+        for (int wi = 0; wi < FF_ARRAY_ELEMS(widths); wi++) {
+            const int w = widths[wi];
+
+            for (int i = 0; i < w; i++)
+                filterPos[i] = rnd() % (SRC_PIXELS - size + 1);
+
+            if (check_func(g.hscale, "hscale_float_fs_%d_dstW_%d", size, w)) {
+                declare_func(void, float *dst, int dstW, const float *src,
+                             const float *filter, const int32_t *filterPos,
+                             int filterSize);
+
+                memset(dst0, 0, w * sizeof(*dst0));
+                memset(dst1, 0, w * sizeof(*dst1));
+                call_ref(dst0, w, src, filter, filterPos, size);
+                call_new(dst1, w, src, filter, filterPos, size);
+                if (!float_near_abs_eps_array(dst0, dst1, 1e-5, w))
+                    fail();
+                bench_new(dst1, w, src, filter, filterPos, size);
+            }
+
+            if (check_func(g.vscale, "vscale_float_fs_%d_dstW_%d", size, w)) {
+                declare_func(void, float *dst, int dstW, const float *const *src,
+                             const float *filter, int filterSize);
+
+                memset(dst0, 0, w * sizeof(*dst0));
+                memset(dst1, 0, w * sizeof(*dst1));
+                call_ref(dst0, w, vsrc, filter, size);
+                call_new(dst1, w, vsrc, filter, size);
+                if (!float_near_abs_eps_array(dst0, dst1, 1e-5, w))
+                    fail();
+                bench_new(dst1, w, vsrc, filter, size);
+            }
+        }
+    }
+}
+
 void checkasm_check_sw_scale(void)
 {
     check_hscale();
@@ -369,4 +647,12 @@ void checkasm_check_sw_scale(void)
     check_yuv2yuvX(0);
     check_yuv2yuvX(1);
     report("yuv2yuvX");
+    check_yuv2plane1_hbd();
+    report("yuv2plane1_hbd");
+    check_yuv2planeX_hbd();
+    report("yuv2planeX_hbd");
+    check_yuv2nv12cX_hbd();
+    report("yuv2nv12cX_hbd");
+    check_gamma_scale();
+    report("gamma_scale");
 }
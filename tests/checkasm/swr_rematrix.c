@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
+
+#include "libswresample/swresample.h"
+#include "libswresample/swresample_internal.h"
+
+#include "checkasm.h"
+
+#define LEN    512
+#define MAX_IN 24
+
+static const enum AVSampleFormat formats[] = {
+    AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP,
+};
+
+static void randomize(uint8_t *buf, int n, enum AVSampleFormat fmt)
+{
+    for (int i = 0; i < n; i++) {
+        switch (fmt) {
+        case AV_SAMPLE_FMT_S16P: ((int16_t *)buf)[i] = rnd();                            break;
+        case AV_SAMPLE_FMT_S32P: ((int32_t *)buf)[i] = rnd();                            break;
+        case AV_SAMPLE_FMT_FLTP: ((float   *)buf)[i] = (float)rnd() / UINT_MAX - 0.5f;  break;
+        case AV_SAMPLE_FMT_DBLP: ((double  *)buf)[i] = (double)rnd() / UINT_MAX - 0.5;  break;
+        }
+    }
+}
+
+static void check_mix_n_1(mix_n_1_func_type *func, enum AVSampleFormat fmt)
+{
+    LOCAL_ALIGNED_32(uint8_t, src_buf, [MAX_IN * LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst0,    [LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst1,    [LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, coeff,   [MAX_IN * 8]);
+    const uint8_t *src[MAX_IN];
+    int bps = av_get_bytes_per_sample(fmt);
+    static const int nb_in[] = { 3, 7, MAX_IN };
+
+    declare_func(void, void *out, const void * const *in, const void *coeffp,
+                 integer nb_in, integer len);
+
+    randomize(src_buf, MAX_IN * LEN, fmt);
+    for (int i = 0; i < MAX_IN; i++) {
+        src[i] = src_buf + i * LEN * bps;
+        switch (fmt) {
+        case AV_SAMPLE_FMT_S16P:
+        case AV_SAMPLE_FMT_S32P:
+            /* 17.15 fixed point coefficients as used by swri_rematrix() */
+            ((int *)coeff)[i] = (int)(rnd() % 65536) - 32768;
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            ((float *)coeff)[i] = (float)rnd() / UINT_MAX - 0.5f;
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            ((double *)coeff)[i] = (double)rnd() / UINT_MAX - 0.5;
+            break;
+        }
+    }
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(nb_in); i++) {
+        if (check_func(func, "mix_n_1_%d_%s", nb_in[i], av_get_sample_fmt_name(fmt))) {
+            memset(dst0, 0, LEN * bps);
+            memset(dst1, 0, LEN * bps);
+            call_ref(dst0, (const void **)src, coeff, nb_in[i], LEN);
+            call_new(dst1, (const void **)src, coeff, nb_in[i], LEN);
+            /* the SIMD versions accumulate in the same order as the C one */
+            if (memcmp(dst0, dst1, LEN * bps))
+                fail();
+            bench_new(dst1, (const void **)src, coeff, nb_in[i], LEN);
+        }
+    }
+}
+
+void checkasm_check_swr_rematrix(void)
+{
+    for (int i = 0; i < FF_ARRAY_ELEMS(formats); i++) {
+        AVChannelLayout in  = AV_CHANNEL_LAYOUT_7POINT1;
+        AVChannelLayout out = AV_CHANNEL_LAYOUT_SURROUND;
+        SwrContext *s = NULL;
+
+        if (swr_alloc_set_opts2(&s, &out, formats[i], 48000,
+                                    &in,  formats[i], 48000, 0, NULL) < 0)
+            return;
+        av_opt_set_sample_fmt(s, "internal_sample_fmt", formats[i], 0);
+        if (swr_init(s) < 0) {
+            swr_free(&s);
+            return;
+        }
+        check_mix_n_1(s->mix_n_1_simd ? s->mix_n_1_simd : s->mix_n_1_f, formats[i]);
+        swr_free(&s);
+    }
+    report("mix_n_1");
+}
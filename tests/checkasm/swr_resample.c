@@ -0,0 +1,180 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/samplefmt.h"
+
+#include "libswresample/resample.h"
+#include "libswresample/swresample_internal.h"
+
+#include "checkasm.h"
+
+#define SRC_LEN   2048
+#define SRC_PAD   64
+#define DST_LEN   256
+#define NB_PLANES 4
+
+static const struct {
+    int in_rate, out_rate, filter_size, phase_shift;
+} configs[] = {
+    { 44100, 48000, 32, 10 },
+    { 48000, 44100, 16, 10 },
+    {  8000, 48000, 16,  8 },
+    { 48000,  8000, 16, 10 },
+    { 48000, 44100, 64, 12 },
+};
+
+static const enum AVSampleFormat formats[] = {
+    AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP,
+};
+
+static void randomize_planes(uint8_t *planes[NB_PLANES], enum AVSampleFormat fmt)
+{
+    for (int p = 0; p < NB_PLANES; p++) {
+        for (int i = 0; i < SRC_LEN + SRC_PAD; i++) {
+            switch (fmt) {
+            case AV_SAMPLE_FMT_S16P:
+                /* leave some headroom, the SIMD versions accumulate in 32 bits */
+                ((int16_t *)planes[p])[i] = (int16_t)rnd() >> 1;
+                break;
+            case AV_SAMPLE_FMT_S32P:
+                ((int32_t *)planes[p])[i] = (int32_t)rnd() >> 1;
+                break;
+            case AV_SAMPLE_FMT_FLTP:
+                ((float *)planes[p])[i]   = (float)rnd() / UINT_MAX - 0.5f;
+                break;
+            case AV_SAMPLE_FMT_DBLP:
+                ((double *)planes[p])[i]  = (double)rnd() / UINT_MAX - 0.5;
+                break;
+            }
+        }
+    }
+}
+
+static int samples_near(const uint8_t *a, const uint8_t *b, int n,
+                        enum AVSampleFormat fmt)
+{
+    for (int i = 0; i < n; i++) {
+        switch (fmt) {
+        case AV_SAMPLE_FMT_S16P:
+            if (FFABS(((const int16_t *)a)[i] - ((const int16_t *)b)[i]) > 1)
+                return 0;
+            break;
+        case AV_SAMPLE_FMT_S32P:
+            if (FFABS((int64_t)((const int32_t *)a)[i] - ((const int32_t *)b)[i]) > 1)
+                return 0;
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            if (!float_near_abs_eps(((const float *)a)[i], ((const float *)b)[i], 1e-5))
+                return 0;
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            if (!double_near_abs_eps(((const double *)a)[i], ((const double *)b)[i], 1e-12))
+                return 0;
+            break;
+        }
+    }
+    return 1;
+}
+
+/* start every call from the same, randomly picked, filter position */
+static void set_position(ResampleContext *c, int index, int frac)
+{
+    c->index = index;
+    c->frac  = frac;
+}
+
+static void check_resample(ResampleContext *c, enum AVSampleFormat fmt, int linear)
+{
+    LOCAL_ALIGNED_32(uint8_t, src_buf,  [NB_PLANES * (SRC_LEN + SRC_PAD) * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_buf, [NB_PLANES * DST_LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_buf, [NB_PLANES * DST_LEN * 8]);
+    uint8_t *src[NB_PLANES], *dst0[NB_PLANES], *dst1[NB_PLANES];
+    const char *name = av_get_sample_fmt_name(fmt);
+    int bps = av_get_bytes_per_sample(fmt);
+    int index = rnd() % c->phase_count;
+    int frac  = rnd() % c->src_incr;
+    int ret0, ret1;
+
+    for (int p = 0; p < NB_PLANES; p++) {
+        src[p]  = src_buf  + p * (SRC_LEN + SRC_PAD) * bps;
+        dst0[p] = dst0_buf + p * DST_LEN * bps;
+        dst1[p] = dst1_buf + p * DST_LEN * bps;
+    }
+    randomize_planes(src, fmt);
+
+    if (check_func(linear ? c->dsp.resample_linear : c->dsp.resample_common,
+                   "%s_%s", linear ? "resample_linear" : "resample_common", name)) {
+        declare_func(int, ResampleContext *c, void *dst,
+                     const void *src, int n, int update_ctx);
+
+        memset(dst0_buf, 0, DST_LEN * bps);
+        memset(dst1_buf, 0, DST_LEN * bps);
+        set_position(c, index, frac);
+        ret0 = call_ref(c, dst0[0], src[0], DST_LEN, 1);
+        set_position(c, index, frac);
+        ret1 = call_new(c, dst1[0], src[0], DST_LEN, 1);
+        if (ret0 != ret1 || !samples_near(dst0[0], dst1[0], DST_LEN, fmt))
+            fail();
+        set_position(c, index, frac);
+        bench_new(c, dst1[0], src[0], DST_LEN, 0);
+    }
+
+    if (!linear && c->dsp.resample_common_x4 &&
+        check_func(c->dsp.resample_common_x4, "resample_common_x4_%s", name)) {
+        declare_func(int, ResampleContext *c, uint8_t * const *dst,
+                     uint8_t * const *src, int n, int update_ctx);
+
+        memset(dst0_buf, 0, NB_PLANES * DST_LEN * bps);
+        memset(dst1_buf, 0, NB_PLANES * DST_LEN * bps);
+        set_position(c, index, frac);
+        ret0 = call_ref(c, dst0, src, DST_LEN, 1);
+        set_position(c, index, frac);
+        ret1 = call_new(c, dst1, src, DST_LEN, 1);
+        if (ret0 != ret1 || !samples_near(dst0_buf, dst1_buf, NB_PLANES * DST_LEN, fmt))
+            fail();
+        set_position(c, index, frac);
+        bench_new(c, dst1, src, DST_LEN, 0);
+    }
+}
+
+void checkasm_check_swr_resample(void)
+{
+    for (int i = 0; i < FF_ARRAY_ELEMS(formats); i++) {
+        for (int j = 0; j < FF_ARRAY_ELEMS(configs); j++) {
+            for (int linear = 0; linear < 2; linear++) {
+                ResampleContext *c = swri_resampler.init(NULL, configs[j].out_rate,
+                                                         configs[j].in_rate,
+                                                         configs[j].filter_size,
+                                                         configs[j].phase_shift,
+                                                         linear, 0, formats[i],
+                                                         SWR_FILTER_TYPE_KAISER, 9,
+                                                         20, 0, 0, 0);
+                if (!c)
+                    return;
+                check_resample(c, formats[i], linear);
+                swri_resampler.free(&c);
+            }
+        }
+        report("%s", av_get_sample_fmt_name(formats[i]));
+    }
+}
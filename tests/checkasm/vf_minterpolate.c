@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/motion_estimation.h"
+#include "libavutil/mem_internal.h"
+
+#define STRIDE 96
+#define HEIGHT 32
+
+static void check_sad(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [STRIDE * HEIGHT]);
+    ff_me_sad_fn sad[4];
+
+    declare_func(int, const uint8_t *src1, ptrdiff_t stride1,
+                 const uint8_t *src2, ptrdiff_t stride2, int h);
+
+    ff_me_init_sad(sad);
+
+    for (int i = 0; i < STRIDE * HEIGHT; i++) {
+        src1[i] = rnd();
+        src2[i] = rnd();
+    }
+
+    for (int n = 0; n < 4; n++) {
+        const int w = 4 << n;
+
+        if (check_func(sad[n], "me_sad%d", w)) {
+            /* the blocks are rarely aligned in motion searches */
+            const int off1 = rnd() % (STRIDE - w + 1);
+            const int off2 = rnd() % (STRIDE - w + 1);
+
+            int ref, new;
+
+            for (int h = 1; h <= HEIGHT; h += h < 4 ? 1 : 7) {
+                ref = call_ref(src1 + off1, STRIDE, src2 + off2, STRIDE, h);
+                new = call_new(src1 + off1, STRIDE, src2 + off2, STRIDE, h);
+                if (ref != new)
+                    fail();
+            }
+            /* the strongest differences */
+            memset(src1, 0xff, STRIDE * HEIGHT);
+            memset(src2, 0x00, STRIDE * HEIGHT);
+            ref = call_ref(src1, STRIDE, src2, STRIDE, w);
+            new = call_new(src1, STRIDE, src2, STRIDE, w);
+            if (ref != new)
+                fail();
+            for (int i = 0; i < STRIDE * HEIGHT; i++) {
+                src1[i] = rnd();
+                src2[i] = rnd();
+            }
+            bench_new(src1 + off1, STRIDE, src2 + off2, STRIDE, w);
+        }
+    }
+    report("sad");
+}
+
+void checkasm_check_vf_minterpolate(void)
+{
+    check_sad();
+}
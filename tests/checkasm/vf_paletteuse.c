@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/palette.h"
+#include "libavfilter/vf_paletteuse_init.h"
+#include "libavutil/mem_internal.h"
+
+static void check_nearest_color(void)
+{
+    LOCAL_ALIGNED_32(int32_t, lab, [3 * AVPALETTE_COUNT]);
+    PaletteUseDSPContext dsp;
+
+    declare_func(int, const int32_t *lab, int nb, int L, int a, int b);
+
+    ff_paletteuse_init(&dsp);
+
+    if (check_func(dsp.nearest_color, "nearest_color")) {
+        static const int nbs[] = { 8, 16, 64, 256 };
+        struct Lab target;
+        int ref, new;
+
+        for (int i = 0; i < AVPALETTE_COUNT; i++) {
+            const struct Lab c = ff_srgb_u8_to_oklab_int(rnd());
+            lab[i]                       = c.L;
+            lab[i + AVPALETTE_COUNT]     = c.a;
+            lab[i + AVPALETTE_COUNT * 2] = c.b;
+        }
+        /* duplicates, the lowest index must win */
+        for (int i = 0; i < 8; i++) {
+            const int src = rnd() % AVPALETTE_COUNT, dst = rnd() % AVPALETTE_COUNT;
+            for (int c = 0; c < 3; c++)
+                lab[dst + c * AVPALETTE_COUNT] = lab[src + c * AVPALETTE_COUNT];
+        }
+
+        for (int n = 0; n < FF_ARRAY_ELEMS(nbs); n++) {
+            for (int i = 0; i < 32; i++) {
+                /* the palette colors themselves or random colors */
+                if (i & 1) {
+                    const int pos = rnd() % nbs[n];
+                    target.L = lab[pos];
+                    target.a = lab[pos + AVPALETTE_COUNT];
+                    target.b = lab[pos + AVPALETTE_COUNT * 2];
+                } else {
+                    target = ff_srgb_u8_to_oklab_int(rnd());
+                }
+                ref = call_ref(lab, nbs[n], target.L, target.a, target.b);
+                new = call_new(lab, nbs[n], target.L, target.a, target.b);
+                if (ref != new)
+                    fail();
+            }
+        }
+
+        /* the distances to a far color are clipped, the first one wins */
+        for (int i = 0; i < 16; i++) {
+            lab[i]                       = 0;
+            lab[i + AVPALETTE_COUNT]     = 0;
+            lab[i + AVPALETTE_COUNT * 2] = 0;
+        }
+        ref = call_ref(lab, 16, 65535, 0, 0);
+        new = call_new(lab, 16, 65535, 0, 0);
+        if (ref != new)
+            fail();
+
+        bench_new(lab, AVPALETTE_COUNT, target.L, target.a, target.b);
+    }
+    report("nearest_color");
+}
+
+void checkasm_check_vf_paletteuse(void)
+{
+    check_nearest_color();
+}
@@ -23,5 +23,33 @@ $(foreach D,$(FATE_CONCAT_DEMUXER_EXTENDED_LAVF),$(eval fate-concat-demuxer-exte
 $(foreach D,$(FATE_CONCAT_DEMUXER_EXTENDED_LAVF),$(eval fate-concat-demuxer-extended-lavf-$(D): CMD = concat $(SRC_PATH)/tests/extended.ffconcat ../lavf/lavf.$(D) md5))
 FATE_CONCAT_DEMUXER += $(FATE_CONCAT_DEMUXER_EXTENDED_LAVF:%=fate-concat-demuxer-extended-lavf-%)
 
+tests/data/concat-reuse-%.ts: TAG = GEN
+tests/data/concat-reuse-%.ts: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "testsrc2=s=64x48:r=$*:d=0.4" -flags +bitexact -fflags +bitexact -codec:v mpeg4 \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# Files whose parameters differ from the first file must still be fully probed.
+FATE_CONCAT_DEMUXER_FFMPEG-$(call ENCDEC, MPEG4, MPEGTS, LAVFI_INDEV TESTSRC2_FILTER) += fate-concat-demuxer-reuse-params-mismatch
+fate-concat-demuxer-reuse-params-mismatch: tests/data/concat-reuse-25.ts tests/data/concat-reuse-50.ts
+fate-concat-demuxer-reuse-params-mismatch: CMD = concat $(SRC_PATH)/tests/reuse-params.ffconcat ../concat-reuse "" "-reuse_stream_params 1"
+tests/data/concat-reuse-%.mp4: TAG = GEN
+tests/data/concat-reuse-%.mp4: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "testsrc2=s=64x48:r=$*:d=0.4" -flags +bitexact -fflags +bitexact -codec:v mpeg4 \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# The output must be the same as when every file is fully probed.
+FATE_CONCAT_DEMUXER_FFMPEG-$(call ENCDEC, MPEG4, MOV, LAVFI_INDEV TESTSRC2_FILTER) += fate-concat-demuxer-reuse-params
+fate-concat-demuxer-reuse-params: tests/data/concat-reuse-25.mp4
+fate-concat-demuxer-reuse-params: CMD = concat $(SRC_PATH)/tests/reuse-params-match.ffconcat ../concat-reuse-25.mp4 "" "-reuse_stream_params 1 -prefetch 2"
+FATE_CONCAT_DEMUXER += $(FATE_CONCAT_DEMUXER_FFMPEG-yes)
+
+# The files opened ahead of time must give the same output.
+fate-concat-demuxer-prefetch-lavf-mxf: fate-lavf-mxf
+fate-concat-demuxer-prefetch-lavf-mxf: CMD = concat $(SRC_PATH)/tests/simple1.ffconcat ../lavf/lavf.mxf "" "-prefetch 2"
+fate-concat-demuxer-prefetch-lavf-mxf: REF = $(SRC_PATH)/tests/ref/fate/concat-demuxer-simple1-lavf-mxf
+FATE_CONCAT_DEMUXER += $(if $(filter mxf,$(FATE_CONCAT_DEMUXER_SIMPLE1_LAVF)),fate-concat-demuxer-prefetch-lavf-mxf)
+
 FATE_CONCAT_DEMUXER := $(if $(CONFIG_CONCAT_DEMUXER), $(FATE_CONCAT_DEMUXER))
 FATE_FFPROBE += $(FATE_CONCAT_DEMUXER)
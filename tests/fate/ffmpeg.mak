@@ -264,6 +264,30 @@ fate-ffmpeg-loopback-decoding: CMD = transcode \
     "-map 0:v:0 -c:v mpeg2video -f null - -flags +bitexact -idct simple -threads $$threads -dec 0:0 -filter_complex '[0:v][dec:0]hstack[stack]' -map '[stack]' -c:v ffv1" ""
 FATE_FFMPEG-$(call ENCDEC2, MPEG2VIDEO, FFV1, NUT, HSTACK_FILTER PIPE_PROTOCOL FRAMECRC_MUXER) += fate-ffmpeg-loopback-decoding
 
+# Test that the -analyze_af pass rewinds the input exactly, so the real pass
+# sees the same packets as without it.
+FATE_FFMPEG_ANALYZE_AF = fate-ffmpeg-analyze-af fate-ffmpeg-analyze-af-ss
+$(FATE_FFMPEG_ANALYZE_AF): tests/data/vsynth1.yuv
+fate-ffmpeg-analyze-af: CMD = transcode \
+    "rawvideo -s 352x288 -pix_fmt yuv420p" $(TARGET_PATH)/tests/data/vsynth1.yuv mpegts \
+    "-c:v mpeg2video -g 12 -c:a mp2fixed -shortest" "-c copy" "" "-f lavfi -i sine=f=1000:d=2" \
+    "-analyze_af loudnorm=measure=1"
+fate-ffmpeg-analyze-af-ss: CMD = transcode \
+    "rawvideo -s 352x288 -pix_fmt yuv420p" $(TARGET_PATH)/tests/data/vsynth1.yuv mpegts \
+    "-c:v mpeg2video -g 12 -c:a mp2fixed -shortest" "-c copy" "" "-f lavfi -i sine=f=1000:d=2" \
+    "-ss 1 -analyze_af loudnorm=measure=1"
+FATE_FFMPEG-$(call TRANSCODE, MPEG2VIDEO MP2FIXED MP2, MPEGTS, MPEGVIDEO_PARSER MPEGAUDIO_PARSER \
+                   LAVFI_INDEV SINE_FILTER LOUDNORM_FILTER) += $(FATE_FFMPEG_ANALYZE_AF)
+
+# Same with B-frames in Matroska, where the first video dts is negative.
+fate-ffmpeg-analyze-af-mkv: tests/data/vsynth1.yuv
+fate-ffmpeg-analyze-af-mkv: CMD = transcode \
+    "rawvideo -s 352x288 -pix_fmt yuv420p" $(TARGET_PATH)/tests/data/vsynth1.yuv matroska \
+    "-c:v mpeg4 -bf 2 -g 12 -c:a mp2fixed -shortest" "-c copy" "" "-f lavfi -i sine=f=1000:d=2" \
+    "-analyze_af anull"
+FATE_FFMPEG-$(call TRANSCODE, MPEG4 MP2FIXED MP2, MATROSKA, MPEG4VIDEO_PARSER MPEGAUDIO_PARSER \
+                   LAVFI_INDEV SINE_FILTER ANULL_FILTER) += fate-ffmpeg-analyze-af-mkv
+
 # test matching by stream disposition
 fate-ffmpeg-spec-disposition: CMD = framecrc -i $(TARGET_SAMPLES)/mpegts/pmtchange.ts -map '0:disp:visual_impaired+descriptions:1' -c copy
 FATE_FFMPEG-$(call FRAMECRC, MPEGTS,,) += fate-ffmpeg-spec-disposition
@@ -52,6 +52,21 @@ fate-filter-afade-log: CMD = framecrc -i $(SRC) -af afade=t=in:ss=1:d=2.5:curve=
 
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, AFADE, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_FILTER_AFADE)
 
+tests/data/afftdn-double.wav: TAG = GEN
+tests/data/afftdn-double.wav: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/asynth-44100-2.wav | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af afftdn=nr=20:tn=1:gs=3:precision=double \
+        -flags +bitexact -fflags +bitexact -c:a pcm_s16le -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# single precision processing must stay within one LSB of the double precision output
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, AFFTDN ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-afftdn-float
+fate-filter-afftdn-float: tests/data/asynth-44100-2.wav tests/data/afftdn-double.wav
+fate-filter-afftdn-float: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-afftdn-float: REF = tests/data/afftdn-double.wav
+fate-filter-afftdn-float: CMD = ffmpeg -auto_conversion_filters -i $(SRC) -af afftdn=nr=20:tn=1:gs=3:precision=float -f wav -c:a pcm_s16le -
+fate-filter-afftdn-float: CMP = oneoff
+fate-filter-afftdn-float: CMP_UNIT = s16
+
 FATE_AFILTER_SAMPLES-$(call FILTERDEMDECENCMUX, ACROSSFADE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-acrossfade
 fate-filter-acrossfade: tests/data/asynth-44100-2.wav
 fate-filter-acrossfade: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
@@ -422,6 +437,11 @@ fate-filter-crazychannels: tests/data/filtergraphs/crazychannels
 fate-filter-crazychannels: CMD = framecrc -auto_conversion_filters -/filter_complex $(TARGET_PATH)/tests/data/filtergraphs/crazychannels
 FATE_AFILTER-$(call FILTERFRAMECRC, ARESAMPLE SINE JOIN ATRIM CHANNELMAP CHANNELSPLIT) += fate-filter-crazychannels
 
+# the formats of aformat are negotiated over the whole graph to dbl, instead
+# of its first entry s16 which would be picked link by link
+FATE_AFILTER-$(call ALLYES, AEVALSRC_FILTER AFORMAT_FILTER AFFTDN_FILTER ARESAMPLE_FILTER PCM_F32LE_ENCODER NULL_MUXER) += fate-filter-aformat-negotiation
+fate-filter-aformat-negotiation: CMD = ffmpeg -auto_conversion_filters -v verbose -filter_complex "aevalsrc=sin(1000*t*2*PI):d=0.1,aformat=s16|s32|flt|dbl,afftdn" -c:a pcm_f32le -f null - 2>&1 | grep "inserted between" | sed "s/ @ 0x[0-9a-f]*//"
+
 FATE_AFILTER-yes += fate-filter-formats
 fate-filter-formats: libavfilter/tests/formats$(EXESUF)
 fate-filter-formats: CMD = run libavfilter/tests/formats$(EXESUF)
@@ -85,6 +85,10 @@ fate-filter-lavd-testsrc: CMD = framecrc -f lavfi -i testsrc=r=7:n=2:d=10
 FATE_FILTER-$(call FILTERFRAMECRC, TESTSRC2) += $(addprefix fate-filter-testsrc2-, yuv420p yuv444p rgb24 rgba)
 fate-filter-testsrc2-%: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt $(word 4, $(subst -, ,$(@)))
 
+# the unchanged subtitles must be blended identically on every frame
+FATE_FILTER-$(call FILTERFRAMECRC, COLOR FORMAT SUBTITLES SPLIT TRIM LOOP BLEND) += $(addprefix fate-filter-subtitles-unchanged-, yuv420p rgb0)
+fate-filter-subtitles-unchanged-%: CMD = framecrc -lavfi "color=c=gray:s=64x48:r=5:d=1,format=$(word 5, $(subst -, ,$(@))),subtitles=$(SRC_PATH)/tests/drawing.ass,split[a][b];[b]trim=end_frame=1,loop=loop=4:size=1[c];[a][c]blend=all_mode=difference"
+
 FATE_FILTER-$(call FILTERFRAMECRC, ALLRGB) += fate-filter-allrgb
 fate-filter-allrgb: CMD = framecrc -lavfi allrgb=rate=5:duration=1 -pix_fmt rgb24
 
@@ -447,6 +451,11 @@ FATE_FILTER_VSYNTH-$(call FILTERDEMDEC, SCALE, RAWVIDEO, RAWVIDEO) += fate-filte
 fate-filter-scalechroma: tests/data/vsynth1.yuv
 fate-filter-scalechroma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv444p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -pix_fmt yuv420p -sws_flags +bitexact -vf scale=out_chroma_loc=bottomleft
 
+FATE_FILTER_VSYNTH-$(call FILTERDEMDEC, SCALE, RAWVIDEO, RAWVIDEO) += fate-filter-scale-gamma
+fate-filter-scale-gamma: tests/data/vsynth1.yuv
+fate-filter-scale-gamma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -pix_fmt rgb24 -sws_flags +bitexact+accurate_rnd -vf scale=176:120:gamma=1
+fate-filter-scale-gamma: CPUFLAGS = 0
+
 FATE_FILTER_VSYNTH_VIDEO_FILTER-$(CONFIG_VFLIP_FILTER) += fate-filter-vflip
 fate-filter-vflip: CMD = video_filter "vflip"
 
@@ -26,6 +26,10 @@ FATE_LIBAVFORMAT-$(CONFIG_IMF_DEMUXER) += fate-imf
 fate-imf: libavformat/tests/imf$(EXESUF)
 fate-imf: CMD = run libavformat/tests/imf$(EXESUF)
 
+FATE_LIBAVFORMAT-$(call ENCDEC2, MPEG4, MP2, MATROSKA) += fate-stream_info
+fate-stream_info: fate-lavf-mkv libavformat/tests/stream_info$(EXESUF)
+fate-stream_info: CMD = run libavformat/tests/stream_info$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mkv
+
 FATE_LIBAVFORMAT += fate-seek_utils
 fate-seek_utils: libavformat/tests/seek_utils$(EXESUF)
 fate-seek_utils: CMD = run libavformat/tests/seek_utils$(EXESUF)
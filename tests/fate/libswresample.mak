@@ -1097,5 +1097,22 @@ fate-swr-audioconvert: CMP = stddev
 fate-swr-audioconvert: FUZZ = 0
 
 FATE_SWR += $(FATE_SWR_AUDIOCONVERT-yes)
+
+FATE_SWR_LOW_DELAY-$(call FILTERDEMDECENCMUX, ARESAMPLE ATRIM, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-swr-low-delay
+fate-swr-low-delay: tests/data/asynth-44100-1.wav
+fate-swr-low-delay: REF = tests/data/asynth-44100-1.wav
+fate-swr-low-delay: CMD = ffmpeg -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -af atrim=end_sample=10240,aresample=48000:low_delay=1,aresample=44100:low_delay=1 -f wav -c:a pcm_s16le -
+fate-swr-low-delay: CMP = stddev
+fate-swr-low-delay: CMP_UNIT = s16
+fate-swr-low-delay: CMP_TARGET = 726.53
+fate-swr-low-delay: SIZE_TOLERANCE = 529200 - 20482
+fate-swr-low-delay: FUZZ = 0.1
+
+# the delay reported by swr_get_delay() and the lag of the output, the timing is cut
+FATE_SWR_LOW_DELAY-$(CONFIG_SWRESAMPLE) += fate-swr-low-delay-latency
+fate-swr-low-delay-latency: tools/swr_latency$(EXESUF)
+fate-swr-low-delay-latency: CMD = run tools/swr_latency$(EXESUF) 48000 44100 64 low_delay=1 filter_size=16:low_delay=1 | cut -d, -f1
+
+FATE_SWR += $(FATE_SWR_LOW_DELAY-yes)
 FATE_FFMPEG += $(FATE_SWR)
 fate-swr: $(FATE_SWR)
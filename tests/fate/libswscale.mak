@@ -2,10 +2,18 @@ FATE_LIBSWSCALE += fate-sws-pixdesc-query
 fate-sws-pixdesc-query: libswscale/tests/pixdesc_query$(EXESUF)
 fate-sws-pixdesc-query: CMD = run libswscale/tests/pixdesc_query$(EXESUF)
 
+FATE_LIBSWSCALE += fate-sws-filter-cache
+fate-sws-filter-cache: libswscale/tests/filter_cache$(EXESUF)
+fate-sws-filter-cache: CMD = run libswscale/tests/filter_cache$(EXESUF)
+
 FATE_LIBSWSCALE += fate-sws-floatimg-cmp
 fate-sws-floatimg-cmp: libswscale/tests/floatimg_cmp$(EXESUF)
 fate-sws-floatimg-cmp: CMD = run libswscale/tests/floatimg_cmp$(EXESUF)
 
+FATE_LIBSWSCALE += fate-sws-zero-copy
+fate-sws-zero-copy: libswscale/tests/zero_copy$(EXESUF)
+fate-sws-zero-copy: CMD = run libswscale/tests/zero_copy$(EXESUF)
+
 SWS_SLICE_TEST-$(call DEMDEC, MATROSKA, VP9) += fate-sws-slice-yuv422-12bit-rgb48
 fate-sws-slice-yuv422-12bit-rgb48: CMD = run tools/scale_slice_test$(EXESUF) $(TARGET_SAMPLES)/vp9-test-vectors/vp93-2-20-12bit-yuv422.webm 150 100 rgb48
 
@@ -18,7 +26,9 @@ $(SWS_SLICE_TEST-yes): REF = /dev/null
 FATE_LIBSWSCALE_SAMPLES += $(SWS_SLICE_TEST-yes)
 
 FATE_LIBSWSCALE_FFMPEG-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, SCALE_FILTER) += fate-sws-yuv-colorspace \
-                                                                             fate-sws-yuv-range
+                                                                             fate-sws-yuv-range \
+                                                                             fate-sws-yuv-tiles
+FATE_LIBSWSCALE_FFMPEG-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, SCALE_FILTER SPLIT_FILTER BLEND_FILTER) += fate-sws-yuv-tiles-default
 fate-sws-yuv-colorspace: tests/data/vsynth1.yuv
 fate-sws-yuv-colorspace: CMD = framecrc \
   -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
@@ -31,6 +41,23 @@ fate-sws-yuv-range: CMD = framecrc \
   -frames 1 \
   -vf scale=in_color_matrix=bt601:in_range=limited:out_color_matrix=bt601:out_range=full:flags=+accurate_rnd+bitexact
 
+# the reference is the output of the same scaling without tiles
+fate-sws-yuv-tiles: tests/data/vsynth1.yuv
+fate-sws-yuv-tiles: CMD = framecrc \
+  -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+  -frames 1 \
+  -vf scale=1000:600:tile_width=128:threads=3:flags=+accurate_rnd+bitexact,format=nv12
+
+# the default flags are not bitexact, so the difference to the scaling
+# without tiles is checked to be zero instead
+fate-sws-yuv-tiles-default: tests/data/vsynth1.yuv
+fate-sws-yuv-tiles-default: CMD = framecrc \
+  -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+  -frames 1 \
+  -filter_complex "split[a][b];[a]scale=1000:600:tile_width=64:threads=3[a];[b]scale=1000:600[b];[a][b]blend=all_mode=difference"
+# the inline MMX vertical filter is not deterministic with slice threads
+fate-sws-yuv-tiles-default: CPUFLAGS = 0
+
 FATE_LIBSWSCALE += $(FATE_LIBSWSCALE-yes)
 FATE_LIBSWSCALE_SAMPLES += $(FATE_LIBSWSCALE_SAMPLES-yes)
 FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
@@ -229,6 +229,18 @@ fate-mov-vfr: CMD = md5 -filter_complex testsrc=size=2x2:duration=1,setpts=N*N -
 fate-mov-vfr: CMP = oneline
 fate-mov-vfr: REF = 1558b4a9398d8635783c93f84eb5a60d
 
+# Test the lazily built index on fragmented files, without and with samples in the moov atom.
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MOV, TESTSRC_FILTER SCALE_FILTER LAVFI_INDEV) \
+                          += fate-mov-lazy-index-frag fate-mov-lazy-index-moov-frag
+fate-mov-lazy-index-frag: CMD = transcode "lavfi -graph testsrc=r=25:s=160x120:d=2" "foo" mp4 "-vf scale -c:v mpeg4 -bf 2 -g 12 -movflags frag_keyframe+empty_moov" "-c copy" "" "" "-lazy_index 1"
+fate-mov-lazy-index-moov-frag: CMD = transcode "lavfi -graph testsrc=r=25:s=160x120:d=2" "foo" mp4 "-vf scale -c:v mpeg4 -bf 2 -g 12 -movflags frag_keyframe" "-c copy" "" "" "-lazy_index 1"
+
+# Test the lazily built index on a file that is not fragmented, with more samples than
+# are indexed at once and B-frames for a compressed ctts, by seeking past the first batch.
+FATE_MOV_FFMPEG_FFPROBE-$(call TRANSCODE, MPEG4, MOV, TESTSRC_FILTER SCALE_FILTER LAVFI_INDEV) \
+                          += fate-mov-lazy-index-seek
+fate-mov-lazy-index-seek: CMD = transcode "lavfi -graph testsrc=r=100:s=32x32:d=50" "foo" mp4 "-vf scale -c:v mpeg4 -bf 2 -g 50" "-c copy -frames:v 30" "-lazy_index 1 -show_entries stream=bit_rate,nb_frames" "" "-lazy_index 1 -ss 45"
+
 FATE_MOV_FFMPEG_FFPROBE-$(call TRANSCODE, FLAC, MOV, WAV_DEMUXER PCM_S16LE_DECODER) += fate-mov-mp4-iamf-stereo
 fate-mov-mp4-iamf-stereo: tests/data/asynth-44100-2.wav tests/data/streamgroups/audio_element-stereo tests/data/streamgroups/mix_presentation-stereo
 fate-mov-mp4-iamf-stereo: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
@@ -284,6 +296,36 @@ fate-mov-mp4-iamf-ambisonic_1: CMD = transcode wav $(SRC) mp4 "-auto_conversion_
   -streamid 0:0 -streamid 1:1 -streamid 2:2 -streamid 3:3 -map [MONO0] -map [MONO1] -map [MONO2] -map [MONO3] -c:a flac -t 1" "-c:a copy -map 0" \
   "-show_entries stream_group=index,id,nb_streams,type:stream_group_components:stream_group_disposition:stream_group_tags:stream_group_stream=index,id:stream_group_stream_disposition"
 
+tests/data/frag-remux.mp4: TAG = GEN
+tests/data/frag-remux.mp4: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "testsrc2=s=64x48:r=25:d=4" -f lavfi -i "sine=r=44100:d=4" \
+        -flags +bitexact -fflags +bitexact -c:v mpeg4 -g 10 -c:a mp2fixed \
+        -movflags frag_keyframe+empty_moov -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# The output of frag_remux must be the same as the one of a sequential remux.
+FATE_MOV_FFMPEG-$(call REMUX, MP4 MOV, MPEG4_ENCODER MP2FIXED_ENCODER LAVFI_INDEV TESTSRC2_FILTER SINE_FILTER) \
+                          += fate-mov-frag-remux-sequential fate-mov-frag-remux
+fate-mov-frag-remux-sequential fate-mov-frag-remux: tests/data/frag-remux.mp4
+fate-mov-frag-remux-sequential: CMD = ffmpeg -i $(TARGET_PATH)/tests/data/frag-remux.mp4 -map 0 -c copy -y $(TARGET_PATH)/tests/data/fate/mov-frag-remux-sequential.mp4 ; \
+  framecrc -i $(TARGET_PATH)/tests/data/fate/mov-frag-remux-sequential.mp4 -map 0 -c copy
+fate-mov-frag-remux: tools/frag_remux$(EXESUF)
+fate-mov-frag-remux: CMD = run tools/frag_remux$(EXESUF) -j 3 -s 5 $(TARGET_PATH)/tests/data/frag-remux.mp4 $(TARGET_PATH)/tests/data/fate/mov-frag-remux.mp4 ; \
+  framecrc -i $(TARGET_PATH)/tests/data/fate/mov-frag-remux.mp4 -map 0 -c copy
+fate-mov-frag-remux: REF = $(SRC_PATH)/tests/ref/fate/mov-frag-remux-sequential
+
+# The moov atom must be written at the beginning of the file, both when it
+# fits in the reserved space and when the data has to be shifted after it.
+FATE_MOV_FFMPEG_FFPROBE-$(call REMUX, MP4 MOV, MPEG4_ENCODER MP2FIXED_ENCODER LAVFI_INDEV TESTSRC2_FILTER SINE_FILTER) \
+                          += fate-mov-reserve-moov fate-mov-reserve-moov-overflow
+fate-mov-reserve-moov fate-mov-reserve-moov-overflow: tests/data/frag-remux.mp4
+fate-mov-reserve-moov fate-mov-reserve-moov-overflow: CMD = \
+  ffmpeg -i $(TARGET_PATH)/tests/data/frag-remux.mp4 -map 0 -c copy -movflags +reserve_moov $(MOOV_SIZE) \
+    -y $(TARGET_PATH)/tests/data/fate/$(@:fate-%=%).mp4 ; \
+  run ffprobe$(PROGSSUF)$(EXESUF) -v trace $(TARGET_PATH)/tests/data/fate/$(@:fate-%=%).mp4 2>&1 | grep "parent:.root." | cut -d "]" -f 2- ; \
+  framecrc -i $(TARGET_PATH)/tests/data/fate/$(@:fate-%=%).mp4 -map 0 -c copy
+fate-mov-reserve-moov-overflow: MOOV_SIZE = -moov_size 100
+
 FATE_FFMPEG += $(FATE_MOV_FFMPEG-yes)
 FATE_FFMPEG_FFPROBE += $(FATE_MOV_FFMPEG_FFPROBE-yes)
 
@@ -0,0 +1,163 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the cost of the afir filter for impulse responses of increasing
+ * length. For every length, DURATION seconds of noise are convolved and the
+ * tool reports the time spent per channel and per second of audio, the time
+ * needed to load the impulse response and the realtime factor.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/time.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+#define SAMPLE_RATE 48000
+#define DURATION    20
+
+static const double ir_lengths[] = { 0.5, 1, 2, 5, 10, 20 };
+
+/* run the graph to the end, the first output comes after the impulse
+ * response is loaded */
+static int run_graph(const char *desc, int threads, int64_t *load, int64_t *total)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFrame *frame = av_frame_alloc();
+    AVFilterContext *sink;
+    int64_t start, first = 0;
+    int ret;
+
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = threads;
+
+    ret = avfilter_graph_parse_ptr(graph, desc, NULL, NULL, NULL);
+    if (ret < 0)
+        goto end;
+    ret = avfilter_graph_config(graph, NULL);
+    if (ret < 0)
+        goto end;
+    sink = avfilter_graph_get_filter(graph, "abuffersink@out");
+
+    start = av_gettime_relative();
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        if (!first)
+            first = av_gettime_relative();
+        av_frame_unref(frame);
+    }
+    if (ret != AVERROR_EOF)
+        goto end;
+
+    *total = av_gettime_relative() - first;
+    *load  = first - start;
+    ret = 0;
+
+end:
+    if (ret < 0)
+        fprintf(stderr, "Error running '%s': %s\n", desc, av_err2str(ret));
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static int run(int channels, double ir_length, const char *afir_opts, int threads)
+{
+    AVBPrint desc;
+    int64_t load, total, src_load, src_total;
+    unsigned sources_len;
+    int ret;
+
+    av_bprint_init(&desc, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprintf(&desc, "aevalsrc=");
+    for (int ch = 0; ch < channels; ch++)
+        av_bprintf(&desc, "%srandom(0)-0.5", ch ? "|" : "");
+    av_bprintf(&desc, ":s=%d:d=%d[in];", SAMPLE_RATE, DURATION);
+    av_bprintf(&desc, "aevalsrc=exp(-6*t/%f)*(random(0)-0.5):s=%d:d=%f[ir];",
+               ir_length, SAMPLE_RATE, ir_length);
+    if (!av_bprint_is_complete(&desc)) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    /* time the sources alone, to leave them out of the results */
+    sources_len = desc.len;
+    av_bprintf(&desc, "[ir]anullsink;[in]abuffersink@out");
+    ret = run_graph(desc.str, threads, &src_load, &src_total);
+    if (ret < 0)
+        goto end;
+
+    desc.len = sources_len;
+    av_bprintf(&desc, "[in][ir]afir=%s,abuffersink@out", afir_opts);
+    ret = run_graph(desc.str, threads, &load, &total);
+    if (ret < 0)
+        goto end;
+    total = FFMAX(total - src_total, 1);
+
+    printf("%6.1f s  %8.1f us/channel/s  load %8.1f ms  %7.1fx realtime\n",
+           ir_length, total / (double)(channels * DURATION),
+           load / 1000.0, DURATION * 1e6 / total);
+
+end:
+    av_bprint_finalize(&desc, NULL);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    const char *afir_opts = "minp=256:maxp=8192";
+    int channels = 2, threads = 0;
+
+    if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
+        fprintf(stderr,
+                "Usage: %s [<channels> [<afir options> [<threads>]]]\n"
+                "Report the cost of the afir filter per channel for impulse\n"
+                "responses of increasing length, e.g.\n"
+                "%s 16 minp=64:maxp=65536 8\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+    if (argc > 1)
+        channels = atoi(argv[1]);
+    if (argc > 2)
+        afir_opts = argv[2];
+    if (argc > 3)
+        threads = atoi(argv[3]);
+    if (channels <= 0 || threads < 0) {
+        fprintf(stderr, "Invalid number of channels or threads\n");
+        return 1;
+    }
+
+    printf("%d channels, %s, %d threads, %d s of audio at %d Hz\n",
+           channels, afir_opts, threads, DURATION, SAMPLE_RATE);
+    for (int i = 0; i < FF_ARRAY_ELEMS(ir_lengths); i++)
+        if (run(channels, ir_lengths[i], afir_opts, threads) < 0)
+            return 1;
+
+    return 0;
+}
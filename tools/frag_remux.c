@@ -0,0 +1,581 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Parallel remuxer for seekable, fragmented MP4 inputs.
+ *
+ * The input is split at movie fragment (moof) boundaries into segments,
+ * which are demuxed independently by worker threads, each with its own
+ * demuxer instance. A segment holds the samples stored between its first
+ * moof and the moof of the next segment, counted per track from the trun
+ * boxes, so that packets are assigned to segments by their position in the
+ * file. The packets of each segment are then written in order by the main
+ * thread, so the output is identical to a sequential remux.
+ *
+ * Inputs without movie fragments are remuxed as a single segment.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavformat/avformat.h"
+#include "libavformat/avio.h"
+#include "libavcodec/packet.h"
+#include "libavutil/avassert.h"
+#include "libavutil/error.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+typedef struct Segment {
+    int64_t pos;          ///< position of the first moof, 0 for the first segment
+    int64_t seek_ts;      ///< earliest tfdt of the first moof, in AV_TIME_BASE
+    int64_t *nb_samples;  ///< samples of each stream, -1 if unknown
+
+    AVPacket **pkts;
+    int nb_pkts;
+    int ret;
+    int done;
+} Segment;
+
+typedef struct RemuxContext {
+    const char *input;
+    int nb_streams;
+
+    Segment *segments;
+    int nb_segments;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int next_segment;     ///< next segment to be demuxed
+    int next_output;      ///< next segment to be written
+    int max_pending;
+} RemuxContext;
+
+/* Fragment index built from the top level boxes of the input. */
+typedef struct FragmentIndex {
+    AVFormatContext *ic;
+    int stream;           ///< stream of the current trak or traf, -1 if unknown
+
+    int64_t *moov_samples;
+    Segment *frags;       ///< one entry per moof
+    int nb_frags;
+} FragmentIndex;
+
+static void usage(int ret)
+{
+    fprintf(ret ? stderr : stdout,
+            "usage: frag_remux [-j threads] [-s segments] input output\n"
+            "Remux a seekable, fragmented input by demuxing segments of it in parallel.\n");
+    exit(ret);
+}
+
+static int open_input(const char *url, AVFormatContext **pic)
+{
+    int ret;
+
+    *pic = NULL;
+    if ((ret = avformat_open_input(pic, url, NULL, NULL)) < 0)
+        return ret;
+    if ((ret = avformat_find_stream_info(*pic, NULL)) < 0)
+        avformat_close_input(pic);
+    return ret;
+}
+
+static int track_stream(AVFormatContext *ic, unsigned track_id)
+{
+    for (int i = 0; i < ic->nb_streams; i++)
+        if (ic->streams[i]->id == track_id)
+            return i;
+    return -1;
+}
+
+static Segment *add_fragment(FragmentIndex *fi, int64_t pos)
+{
+    Segment *frag = av_realloc_array(fi->frags, fi->nb_frags + 1, sizeof(*fi->frags));
+    if (!frag)
+        return NULL;
+    fi->frags = frag;
+    frag = &fi->frags[fi->nb_frags];
+    memset(frag, 0, sizeof(*frag));
+    frag->nb_samples = av_calloc(fi->ic->nb_streams, sizeof(*frag->nb_samples));
+    if (!frag->nb_samples)
+        return NULL;
+    frag->pos     = pos;
+    frag->seek_ts = INT64_MAX;
+    fi->nb_frags++;
+    return frag;
+}
+
+/**
+ * Parse the boxes between the current position and end, collecting the
+ * track ids, sample counts and fragment decode times into fi. At the top
+ * level, nb_samples and ts are NULL, and are set for each moov and moof.
+ */
+static int parse_boxes(FragmentIndex *fi, AVIOContext *pb, int64_t end,
+                       int64_t *nb_samples, int64_t *ts)
+{
+    while (avio_tell(pb) + 8 <= end) {
+        int64_t pos = avio_tell(pb);
+        int64_t size = avio_rb32(pb);
+        uint32_t type = avio_rl32(pb);
+        unsigned version;
+        int ret = 0;
+
+        if (size == 1)
+            size = avio_rb64(pb);
+        else if (!size)
+            size = end - pos;
+        if (avio_feof(pb) || size < 8 || size > end - pos)
+            return AVERROR_INVALIDDATA;
+
+        switch (type) {
+        case MKTAG('m','o','o','v'): {
+            int64_t moov_ts = INT64_MAX;
+            ret = parse_boxes(fi, pb, pos + size, fi->moov_samples, &moov_ts);
+            break;
+        }
+        case MKTAG('m','o','o','f'): {
+            Segment *frag = add_fragment(fi, pos);
+            if (!frag)
+                return AVERROR(ENOMEM);
+            ret = parse_boxes(fi, pb, pos + size, frag->nb_samples, &frag->seek_ts);
+            if (frag->seek_ts == INT64_MAX)
+                frag->seek_ts = INT64_MIN;
+            break;
+        }
+        case MKTAG('t','r','a','k'):
+        case MKTAG('t','r','a','f'):
+            fi->stream = -1;
+            /* fall through */
+        case MKTAG('m','d','i','a'):
+        case MKTAG('m','i','n','f'):
+        case MKTAG('s','t','b','l'):
+            if (nb_samples)
+                ret = parse_boxes(fi, pb, pos + size, nb_samples, ts);
+            break;
+        case MKTAG('t','k','h','d'):
+            version = avio_r8(pb);
+            avio_skip(pb, version == 1 ? 3 + 16 : 3 + 8);
+            fi->stream = track_stream(fi->ic, avio_rb32(pb));
+            break;
+        case MKTAG('t','f','h','d'):
+            avio_skip(pb, 4);
+            fi->stream = track_stream(fi->ic, avio_rb32(pb));
+            break;
+        case MKTAG('s','t','s','z'):
+        case MKTAG('s','t','z','2'):
+            avio_skip(pb, 8);
+            if (nb_samples && fi->stream >= 0)
+                nb_samples[fi->stream] += avio_rb32(pb);
+            break;
+        case MKTAG('t','r','u','n'):
+            avio_skip(pb, 4);
+            if (nb_samples && fi->stream >= 0)
+                nb_samples[fi->stream] += avio_rb32(pb);
+            break;
+        case MKTAG('t','f','d','t'):
+            version = avio_r8(pb);
+            avio_skip(pb, 3);
+            if (ts && fi->stream >= 0) {
+                uint64_t dts = version == 1 ? avio_rb64(pb) : avio_rb32(pb);
+                if (dts <= INT64_MAX)
+                    *ts = FFMIN(*ts, av_rescale_q(dts, fi->ic->streams[fi->stream]->time_base,
+                                                  AV_TIME_BASE_Q));
+            }
+            break;
+        }
+        if (ret < 0)
+            return ret;
+        if (avio_seek(pb, pos + size, SEEK_SET) < 0)
+            return AVERROR_INVALIDDATA;
+    }
+    return 0;
+}
+
+/**
+ * Build the fragment index from the moov and moof boxes of the input.
+ */
+static int read_fragment_index(FragmentIndex *fi, const char *url)
+{
+    AVIOContext *pb = NULL;
+    int64_t size;
+    int ret;
+
+    fi->moov_samples = av_calloc(fi->ic->nb_streams, sizeof(*fi->moov_samples));
+    if (!fi->moov_samples)
+        return AVERROR(ENOMEM);
+
+    if ((ret = avio_open2(&pb, url, AVIO_FLAG_READ, NULL, NULL)) < 0)
+        return ret;
+    size = avio_size(pb);
+    ret = size < 0 ? size : parse_boxes(fi, pb, size, NULL, NULL);
+    avio_closep(&pb);
+    return ret;
+}
+
+/**
+ * Split the input into segments of evenly spread movie fragments.
+ */
+static int find_segments(RemuxContext *rc, AVFormatContext *ic, int nb_segments)
+{
+    FragmentIndex fi = { .ic = ic };
+    int nb_frags, ret;
+
+    /* without a complete fragment index, the input is remuxed sequentially */
+    ret = read_fragment_index(&fi, rc->input);
+    if (ret < 0)
+        fprintf(stderr, "Could not read the fragment index: %s\n", av_err2str(ret));
+    nb_frags    = ret < 0 ? 0 : fi.nb_frags;
+    nb_segments = FFMAX(FFMIN(nb_segments, nb_frags), 1);
+
+    rc->segments = av_calloc(nb_segments, sizeof(*rc->segments));
+    if (!rc->segments) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (int i = 0; i < nb_segments; i++) {
+        Segment *seg = &rc->segments[i];
+        int first = av_rescale(nb_frags, i, nb_segments);
+        int last  = av_rescale(nb_frags, i + 1, nb_segments);
+
+        seg->nb_samples = av_malloc_array(rc->nb_streams, sizeof(*seg->nb_samples));
+        if (!seg->nb_samples) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        rc->nb_segments++;
+
+        /* the first segment also holds the samples of the moov */
+        seg->pos     = i ? fi.frags[first].pos     : 0;
+        seg->seek_ts = i ? fi.frags[first].seek_ts : INT64_MIN;
+        for (int j = 0; j < rc->nb_streams; j++) {
+            seg->nb_samples[j] = nb_frags ? (i ? 0 : fi.moov_samples[j]) : -1;
+            for (int k = first; k < last; k++)
+                seg->nb_samples[j] += fi.frags[k].nb_samples[j];
+        }
+    }
+    ret = 0;
+
+end:
+    for (int i = 0; i < fi.nb_frags; i++)
+        av_free(fi.frags[i].nb_samples);
+    av_free(fi.frags);
+    av_free(fi.moov_samples);
+    return ret;
+}
+
+static void free_packets(Segment *seg)
+{
+    for (int j = 0; j < seg->nb_pkts; j++)
+        av_packet_free(&seg->pkts[j]);
+    av_freep(&seg->pkts);
+    seg->nb_pkts = 0;
+}
+
+/**
+ * Read the packets stored between the start of the segment and the start
+ * of the next one. Returns 1 if packets of the segment were missed because
+ * the demuxer started reading after them.
+ */
+static int read_segment(RemuxContext *rc, AVFormatContext *ic, int idx,
+                        int64_t seek_ts, int64_t *nb_read, uint8_t *done)
+{
+    Segment *seg = &rc->segments[idx];
+    int64_t next_pos = idx + 1 < rc->nb_segments ? rc->segments[idx + 1].pos : INT64_MAX;
+    int nb_done = 0, ret;
+    AVPacket *pkt;
+
+    for (int i = 0; i < rc->nb_streams; i++) {
+        nb_read[i] = 0;
+        done[i] = !seg->nb_samples[i];
+        nb_done += done[i];
+    }
+
+    pkt = av_packet_alloc();
+    if (!pkt)
+        return AVERROR(ENOMEM);
+
+    ret = avformat_seek_file(ic, -1, INT64_MIN, seek_ts, seek_ts, 0);
+    if (ret < 0)
+        goto end;
+
+    while (nb_done < rc->nb_streams) {
+        int i;
+
+        ret = av_read_frame(ic, pkt);
+        if (ret == AVERROR_EOF) {
+            ret = 0;
+            break;
+        }
+        if (ret < 0)
+            goto end;
+        i = pkt->stream_index;
+
+        if (done[i] || (pkt->pos >= 0 && pkt->pos < seg->pos)) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        if (pkt->pos >= next_pos) {
+            done[i] = 1;
+            nb_done++;
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        ret = av_dynarray_add_nofree(&seg->pkts, &seg->nb_pkts, pkt);
+        if (ret < 0)
+            goto end;
+        pkt = av_packet_alloc();
+        if (!pkt) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        if (++nb_read[i] == seg->nb_samples[i]) {
+            done[i] = 1;
+            nb_done++;
+        }
+    }
+
+    for (int i = 0; i < rc->nb_streams; i++)
+        if (nb_read[i] < seg->nb_samples[i])
+            ret = 1;
+
+end:
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int demux_segment(RemuxContext *rc, AVFormatContext *ic, int idx)
+{
+    Segment *seg = &rc->segments[idx];
+    int64_t seek_ts = seg->seek_ts, *nb_read;
+    uint8_t *done;
+    int ret;
+
+    nb_read = av_calloc(rc->nb_streams, sizeof(*nb_read));
+    done    = av_calloc(rc->nb_streams, sizeof(*done));
+    if (!nb_read || !done) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    /* The demuxer starts reading each stream at the last sample before the
+     * seek timestamp, which may follow the first samples of the segment of
+     * streams whose decode times do not match the tfdt, e.g. due to edit
+     * lists. Read again from earlier until all samples were found. */
+    for (int64_t step = AV_TIME_BASE;; step *= 2) {
+        ret = read_segment(rc, ic, idx, seek_ts, nb_read, done);
+        if (ret <= 0 || seek_ts == INT64_MIN)
+            break;
+        free_packets(seg);
+        seek_ts = seek_ts > INT64_MIN + step ? seek_ts - step : INT64_MIN;
+    }
+    ret = FFMIN(ret, 0);
+
+end:
+    av_free(nb_read);
+    av_free(done);
+    return ret;
+}
+
+static void *worker_thread(void *arg)
+{
+    RemuxContext *rc = arg;
+    AVFormatContext *ic = NULL;
+    int ret = open_input(rc->input, &ic);
+
+    pthread_mutex_lock(&rc->lock);
+    while (rc->next_segment < rc->nb_segments) {
+        int idx = rc->next_segment;
+
+        /* bound the amount of demuxed data waiting to be written */
+        if (idx >= rc->next_output + rc->max_pending) {
+            pthread_cond_wait(&rc->cond, &rc->lock);
+            continue;
+        }
+        rc->next_segment++;
+        pthread_mutex_unlock(&rc->lock);
+
+        if (ret >= 0)
+            ret = demux_segment(rc, ic, idx);
+
+        pthread_mutex_lock(&rc->lock);
+        rc->segments[idx].ret  = ret;
+        rc->segments[idx].done = 1;
+        pthread_cond_broadcast(&rc->cond);
+    }
+    pthread_mutex_unlock(&rc->lock);
+
+    avformat_close_input(&ic);
+    return NULL;
+}
+
+static int open_output(AVFormatContext **poc, const char *url, AVFormatContext *ic)
+{
+    AVFormatContext *oc;
+    int ret;
+
+    if ((ret = avformat_alloc_output_context2(poc, NULL, NULL, url)) < 0)
+        return ret;
+    oc = *poc;
+
+    for (int i = 0; i < ic->nb_streams; i++) {
+        AVStream *ist = ic->streams[i];
+        AVStream *ost = avformat_new_stream(oc, NULL);
+        if (!ost)
+            return AVERROR(ENOMEM);
+        if ((ret = avcodec_parameters_copy(ost->codecpar, ist->codecpar)) < 0)
+            return ret;
+        ost->codecpar->codec_tag = 0;
+        ost->time_base           = ist->time_base;
+        ost->disposition         = ist->disposition;
+        ost->avg_frame_rate      = ist->avg_frame_rate;
+        ost->sample_aspect_ratio = ist->sample_aspect_ratio;
+        av_dict_copy(&ost->metadata, ist->metadata, 0);
+    }
+    av_dict_copy(&oc->metadata, ic->metadata, 0);
+
+    if (!(oc->oformat->flags & AVFMT_NOFILE) &&
+        (ret = avio_open(&oc->pb, url, AVIO_FLAG_WRITE)) < 0)
+        return ret;
+
+    return avformat_write_header(oc, NULL);
+}
+
+int main(int argc, char **argv)
+{
+    RemuxContext rc = { 0 };
+    AVFormatContext *ic = NULL, *oc = NULL;
+    pthread_t *threads = NULL;
+    int nb_threads = 4, nb_segments = 0, nb_started = 0;
+    int ret, i;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            nb_threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            nb_segments = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-h"))
+            usage(0);
+        else
+            usage(1);
+    }
+    if (argc - i != 2 || nb_threads <= 0 || nb_segments < 0)
+        usage(1);
+    if (!nb_segments)
+        nb_segments = 4 * nb_threads;
+
+    rc.input       = argv[i];
+    rc.max_pending = 2 * nb_threads;
+
+    if ((ret = open_input(rc.input, &ic)) < 0) {
+        fprintf(stderr, "Could not open '%s': %s\n", rc.input, av_err2str(ret));
+        return 1;
+    }
+    rc.nb_streams = ic->nb_streams;
+    if (!rc.nb_streams) {
+        ret = AVERROR_INVALIDDATA;
+        goto end;
+    }
+
+    if ((ret = find_segments(&rc, ic, nb_segments)) < 0) {
+        fprintf(stderr, "Could not split the input: %s\n", av_err2str(ret));
+        goto end;
+    }
+
+    if ((ret = open_output(&oc, argv[i + 1], ic)) < 0) {
+        fprintf(stderr, "Could not open '%s': %s\n", argv[i + 1], av_err2str(ret));
+        goto end;
+    }
+
+    pthread_mutex_init(&rc.lock, NULL);
+    pthread_cond_init(&rc.cond, NULL);
+    threads = av_calloc(nb_threads, sizeof(*threads));
+    if (!threads) {
+        ret = AVERROR(ENOMEM);
+        goto join;
+    }
+    for (; nb_started < nb_threads; nb_started++)
+        if (pthread_create(&threads[nb_started], NULL, worker_thread, &rc))
+            break;
+    if (!nb_started)
+        fprintf(stderr, "Could not start worker threads, remuxing sequentially\n");
+    fprintf(stderr, "Remuxing %d segments on %d threads\n", rc.nb_segments, nb_started);
+
+    for (int idx = 0; idx < rc.nb_segments; idx++) {
+        Segment *seg = &rc.segments[idx];
+
+        if (nb_started) {
+            pthread_mutex_lock(&rc.lock);
+            while (!seg->done)
+                pthread_cond_wait(&rc.cond, &rc.lock);
+            pthread_mutex_unlock(&rc.lock);
+        } else {
+            seg->ret = demux_segment(&rc, ic, idx);
+        }
+
+        ret = seg->ret;
+        for (int j = 0; j < seg->nb_pkts; j++) {
+            AVPacket *pkt = seg->pkts[j];
+            if (ret >= 0) {
+                av_packet_rescale_ts(pkt, ic->streams[pkt->stream_index]->time_base,
+                                     oc->streams[pkt->stream_index]->time_base);
+                pkt->pos = -1;
+                ret = av_interleaved_write_frame(oc, pkt);
+            }
+        }
+        free_packets(seg);
+
+        pthread_mutex_lock(&rc.lock);
+        rc.next_output = ret < 0 ? rc.nb_segments : idx + 1;
+        if (ret < 0)
+            rc.next_segment = rc.nb_segments;
+        pthread_cond_broadcast(&rc.cond);
+        pthread_mutex_unlock(&rc.lock);
+
+        if (ret < 0) {
+            fprintf(stderr, "Error remuxing segment %d: %s\n", idx, av_err2str(ret));
+            break;
+        }
+    }
+    if (ret >= 0)
+        ret = av_write_trailer(oc);
+
+join:
+    for (i = 0; i < nb_started; i++)
+        pthread_join(threads[i], NULL);
+    av_freep(&threads);
+    pthread_cond_destroy(&rc.cond);
+    pthread_mutex_destroy(&rc.lock);
+
+end:
+    for (i = 0; i < rc.nb_segments; i++) {
+        free_packets(&rc.segments[i]);
+        av_freep(&rc.segments[i].nb_samples);
+    }
+    av_freep(&rc.segments);
+    if (oc && !(oc->oformat->flags & AVFMT_NOFILE))
+        avio_closep(&oc->pb);
+    avformat_free_context(oc);
+    avformat_close_input(&ic);
+    return ret < 0;
+}
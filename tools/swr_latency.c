@@ -0,0 +1,171 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the latency added by libswresample when audio is converted in
+ * small blocks, as done for live streams.
+ *
+ * For every set of options given on the command line, a stream holding a
+ * single impulse is converted block by block and the tool reports:
+ *  - the range of swr_get_delay() after each block
+ *  - the input needed before the first output sample is returned
+ *  - the largest lag between the input fed and the output returned
+ *  - where the impulse shows up in the output, relative to its timestamp
+ *  - the time spent in swr_convert() per block
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
+
+#include "libswresample/swresample.h"
+
+#define MIN_SAMPLES 96000
+#define IMPULSE_POS 4800
+
+static int run(int in_rate, int out_rate, int block_size, const char *opts)
+{
+    SwrContext *swr = NULL;
+    AVChannelLayout layout = AV_CHANNEL_LAYOUT_MONO;
+    float *in = NULL, *out = NULL;
+    int max_out = av_rescale_rnd(block_size, out_rate, in_rate, AV_ROUND_UP) + 256;
+    /* feed enough blocks for the impulse and the filter response to pass */
+    int nb_blocks = (MIN_SAMPLES + block_size - 1) / block_size;
+    int64_t fed = 0, produced = 0, first_in = -1, time = 0;
+    int64_t min_delay = INT64_MAX, max_delay = INT64_MIN;
+    double max_lag = 0, peak = 0, peak_pos = 0;
+    int ret;
+
+    ret = swr_alloc_set_opts2(&swr, &layout, AV_SAMPLE_FMT_FLT, out_rate,
+                                    &layout, AV_SAMPLE_FMT_FLT, in_rate, 0, NULL);
+    if (ret < 0)
+        goto end;
+    if (opts && (ret = av_opt_set_from_string(swr, opts, NULL, "=", ":")) < 0) {
+        fprintf(stderr, "Failed to set options '%s'\n", opts);
+        goto end;
+    }
+    if ((ret = swr_init(swr)) < 0)
+        goto end;
+
+    in  = av_calloc(block_size, sizeof(*in));
+    out = av_calloc(max_out, sizeof(*out));
+    if (!in || !out) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (int b = 0; b <= nb_blocks; b++) {
+        const uint8_t *src = (const uint8_t *)in;
+        int64_t t;
+        int64_t delay;
+        double lag;
+
+        memset(in, 0, block_size * sizeof(*in));
+        if (fed <= IMPULSE_POS && IMPULSE_POS < fed + block_size)
+            in[IMPULSE_POS - fed] = 1.0;
+
+        t = av_gettime_relative();
+        /* the last call flushes */
+        ret = swr_convert(swr, (uint8_t **)&out, max_out,
+                          b < nb_blocks ? &src : NULL, b < nb_blocks ? block_size : 0);
+        time += av_gettime_relative() - t;
+        if (ret < 0)
+            goto end;
+
+        for (int i = 0; i < ret; i++) {
+            if (fabs(out[i]) > peak) {
+                peak     = fabs(out[i]);
+                peak_pos = (produced + i) * (double)in_rate / out_rate;
+            }
+        }
+        produced += ret;
+        if (b == nb_blocks)
+            break;
+
+        fed += block_size;
+        if (ret && first_in < 0)
+            first_in = fed;
+
+        delay     = swr_get_delay(swr, in_rate);
+        min_delay = FFMIN(min_delay, delay);
+        max_delay = FFMAX(max_delay, delay);
+        lag       = fed - produced * (double)in_rate / out_rate;
+        max_lag   = FFMAX(max_lag, lag);
+    }
+
+    if (peak == 0) {
+        fprintf(stderr, "The impulse was not found in the output\n");
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    printf("%-32s delay %4"PRId64"-%-4"PRId64" first output after %5"PRId64"  "
+           "max lag %7.2f  impulse %+6.2f  (in samples), %6.2f us/block\n",
+           opts ? opts : "default", min_delay, max_delay, first_in,
+           max_lag, peak_pos - IMPULSE_POS, time / (double)nb_blocks);
+    ret = 0;
+
+end:
+    av_free(in);
+    av_free(out);
+    swr_free(&swr);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *default_opts[] = { NULL, "low_delay=1" };
+    int in_rate, out_rate, block_size;
+
+    if (argc < 4) {
+        fprintf(stderr,
+                "Usage: %s <in_rate> <out_rate> <block_size> [<swr options> ...]\n"
+                "Convert an impulse in blocks of <block_size> input samples and\n"
+                "report the latency, for each set of options, e.g.\n"
+                "%s 48000 44100 64 filter_size=16 filter_size=16:low_delay=1\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+    in_rate    = atoi(argv[1]);
+    out_rate   = atoi(argv[2]);
+    block_size = atoi(argv[3]);
+    if (in_rate <= 0 || out_rate <= 0 || block_size <= 0) {
+        fprintf(stderr, "Invalid rates or block size\n");
+        return 1;
+    }
+
+    printf("%d Hz -> %d Hz in blocks of %d samples\n", in_rate, out_rate, block_size);
+    if (argc == 4) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(default_opts); i++)
+            if (run(in_rate, out_rate, block_size, default_opts[i]) < 0)
+                return 1;
+    }
+    for (int i = 4; i < argc; i++)
+        if (run(in_rate, out_rate, block_size, argv[i]) < 0)
+            return 1;
+
+    return 0;
+}